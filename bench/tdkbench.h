@@ -0,0 +1,375 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: benchmark harness.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_BENCH_H
+#define TDK_BENCH_H
+
+#include "base/tdkbaseutl.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Minimal benchmark harness. Runs every registered function with a growing
+// iteration count until it takes at least --benchmark_min_time seconds and
+// reports per-iteration times. The JSON output follows the google-benchmark
+// layout, so its compare tools can diff two runs.
+
+//-----------------------------------------------------------------------------
+// State passed to a benchmark function. Typical use:
+//
+//	static void BM_something(tdk_bench_state& state)
+//	{
+//		while (state.keep_running())
+//		{
+//			... code to measure, state.range() is the argument ...
+//		}
+//		state.set_items_processed(state.iterations() * state.range());
+//	}
+//	TDK_BENCHMARK(BM_something, 1024);
+
+class tdk_bench_state
+{
+public:
+	using clock_type = std::chrono::steady_clock;
+
+	tdk_bench_state(tdk_size nIterations, tdk_size nArg)
+		: m_nIterations(nIterations)
+		, m_nLeft(nIterations)
+		, m_nArg(nArg)
+	{
+	}
+
+	bool keep_running()
+	{
+		if (!m_bStarted)
+		{
+			m_bStarted = true;
+			resume_timing();
+		}
+
+		if (m_nLeft)
+		{
+			--m_nLeft;
+			return true;
+		}
+
+		pause_timing();
+		return false;
+	}
+
+	void pause_timing()
+	{
+		m_realTime += clock_type::now() - m_realStart;
+		m_nCpuTime += std::clock() - m_nCpuStart;
+	}
+
+	void resume_timing()
+	{
+		m_realStart = clock_type::now();
+		m_nCpuStart = std::clock();
+	}
+
+	tdk_size range() const
+	{
+		return m_nArg;
+	}
+
+	tdk_size iterations() const
+	{
+		return m_nIterations;
+	}
+
+	void set_items_processed(tdk_size nItems)
+	{
+		m_nItems = nItems;
+	}
+
+	tdk_size items_processed() const
+	{
+		return m_nItems;
+	}
+
+	double real_seconds() const
+	{
+		return std::chrono::duration<double>(m_realTime).count();
+	}
+
+	double cpu_seconds() const
+	{
+		return double(m_nCpuTime) / CLOCKS_PER_SEC;
+	}
+
+private:
+	tdk_size m_nIterations;
+	tdk_size m_nLeft;
+	tdk_size m_nArg;
+	tdk_size m_nItems{};
+	bool m_bStarted{};
+	clock_type::time_point m_realStart{};
+	clock_type::duration m_realTime{};
+	std::clock_t m_nCpuStart{};
+	std::clock_t m_nCpuTime{};
+};
+
+using tdk_bench_func = void (*)(tdk_bench_state&);
+
+struct tdk_bench_entry
+{
+	std::string name;
+	tdk_bench_func func;
+	tdk_size nArg;
+};
+
+inline std::vector<tdk_bench_entry>& tdk_bench_registry()
+{
+	static std::vector<tdk_bench_entry> entries;
+	return entries;
+}
+
+struct tdk_bench_registrar
+{
+	tdk_bench_registrar(const char* szName, tdk_bench_func func, tdk_size nArg)
+	{
+		tdk_bench_registry().push_back(
+			{ std::string(szName) + "/" + std::to_string(nArg), func, nArg });
+	}
+};
+
+#define TDK_BENCH_CONCAT_IMPL(a, b) a##b
+#define TDK_BENCH_CONCAT(a, b) TDK_BENCH_CONCAT_IMPL(a, b)
+#define TDK_BENCHMARK(func, nArg) \
+	static tdk_bench_registrar TDK_BENCH_CONCAT(s_benchRegistrar, __LINE__)( \
+		#func, func, nArg)
+
+// Keeps the compiler from dropping a computation whose result is unused.
+template<typename T>
+inline void tdk_bench_do_not_optimize(const T& val)
+{
+#ifdef TDK_GNUC_VER
+	asm volatile("" : : "r,m"(val) : "memory");
+#else
+	static const void* volatile s_pSink;
+	s_pSink = &val;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Command line:
+//	--benchmark_filter=<substring>   run only benchmarks whose name contains it
+//	--benchmark_min_time=<seconds>   minimal measured time per benchmark
+//	--benchmark_format=console|json  format of the standard output
+//	--benchmark_out=<file>           also write the JSON report to a file
+
+struct tdk_bench_result
+{
+	std::string name;
+	tdk_size nIterations;
+	double realNs;
+	double cpuNs;
+	double itemsPerSecond;
+};
+
+// Writes sz as a quoted JSON string. Paths and names may hold quotes,
+// backslashes (Windows paths) or control characters.
+inline void tdk_bench_write_json_string(std::FILE* pFile, const char* sz)
+{
+	std::fputc('"', pFile);
+	for (; *sz; ++sz)
+	{
+		unsigned char ch = static_cast<unsigned char>(*sz);
+		if ('"' == ch || '\\' == ch)
+			std::fprintf(pFile, "\\%c", ch);
+		else if ('\n' == ch)
+			std::fputs("\\n", pFile);
+		else if ('\t' == ch)
+			std::fputs("\\t", pFile);
+		else if (ch < 0x20)
+			std::fprintf(pFile, "\\u%04x", ch);
+		else
+			std::fputc(ch, pFile);
+	}
+	std::fputc('"', pFile);
+}
+
+inline void tdk_bench_write_json(std::FILE* pFile, const char* szExecutable,
+	const std::vector<tdk_bench_result>& results)
+{
+	char szDate[64] = {};
+	std::time_t now = std::time(nullptr);
+	std::strftime(szDate, sizeof(szDate), "%Y-%m-%dT%H:%M:%S",
+		std::localtime(&now));
+
+	std::fprintf(pFile, "{\n  \"context\": {\n");
+	std::fprintf(pFile, "    \"date\": \"%s\",\n", szDate);
+	std::fprintf(pFile, "    \"executable\": ");
+	tdk_bench_write_json_string(pFile, szExecutable);
+	std::fprintf(pFile, ",\n");
+	std::fprintf(pFile, "    \"num_cpus\": %u,\n",
+		std::thread::hardware_concurrency());
+#ifdef NDEBUG
+	std::fprintf(pFile, "    \"library_build_type\": \"release\"\n");
+#else
+	std::fprintf(pFile, "    \"library_build_type\": \"debug\"\n");
+#endif
+	std::fprintf(pFile, "  },\n  \"benchmarks\": [\n");
+	for (tdk_size i = 0; i < results.size(); ++i)
+	{
+		const tdk_bench_result& res = results[i];
+		std::fprintf(pFile, "    {\n");
+		std::fprintf(pFile, "      \"name\": ");
+		tdk_bench_write_json_string(pFile, res.name.c_str());
+		std::fprintf(pFile, ",\n      \"run_name\": ");
+		tdk_bench_write_json_string(pFile, res.name.c_str());
+		std::fprintf(pFile, ",\n");
+		std::fprintf(pFile, "      \"run_type\": \"iteration\",\n");
+		std::fprintf(pFile, "      \"iterations\": %zu,\n", res.nIterations);
+		std::fprintf(pFile, "      \"real_time\": %.4f,\n", res.realNs);
+		std::fprintf(pFile, "      \"cpu_time\": %.4f,\n", res.cpuNs);
+		std::fprintf(pFile, "      \"time_unit\": \"ns\"");
+		if (res.itemsPerSecond > 0.0)
+			std::fprintf(pFile, ",\n      \"items_per_second\": %.4f", res.itemsPerSecond);
+		std::fprintf(pFile, "\n    }%s\n", i + 1 < results.size() ? "," : "");
+	}
+	std::fprintf(pFile, "  ]\n}\n");
+}
+
+inline int tdk_bench_main(int argc, char** argv)
+{
+	const char* szFilter = "";
+	const char* szOutFile = nullptr;
+	double minTime = 0.5;
+	bool bJson = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* szArg = argv[i];
+		if (0 == std::strncmp(szArg, "--benchmark_filter=", 19))
+			szFilter = szArg + 19;
+		else if (0 == std::strncmp(szArg, "--benchmark_min_time=", 21))
+			minTime = std::atof(szArg + 21);
+		else if (0 == std::strcmp(szArg, "--benchmark_format=json"))
+			bJson = true;
+		else if (0 == std::strcmp(szArg, "--benchmark_format=console"))
+			bJson = false;
+		else if (0 == std::strncmp(szArg, "--benchmark_out=", 16))
+			szOutFile = szArg + 16;
+		else
+		{
+			std::fprintf(stderr, "unknown argument: %s\n", szArg);
+			return 1;
+		}
+	}
+
+	if (!bJson)
+	{
+		std::printf("%-48s %14s %14s %12s\n", "Benchmark", "Time(ns)", "CPU(ns)",
+			"Iterations");
+	}
+
+	std::vector<tdk_bench_result> results;
+	for (const tdk_bench_entry& entry : tdk_bench_registry())
+	{
+		if (!std::strstr(entry.name.c_str(), szFilter))
+			continue;
+
+		tdk_size nIterations = 1;
+		for (;;)
+		{
+			tdk_bench_state state(nIterations, entry.nArg);
+			entry.func(state);
+
+			double realSeconds = state.real_seconds();
+			if (realSeconds >= minTime || nIterations >= 1000000000)
+			{
+				tdk_bench_result res;
+				res.name = entry.name;
+				res.nIterations = nIterations;
+				res.realNs = realSeconds * 1e9 / double(nIterations);
+				res.cpuNs = state.cpu_seconds() * 1e9 / double(nIterations);
+				res.itemsPerSecond = realSeconds > 0.0 ?
+					double(state.items_processed()) / realSeconds : 0.0;
+				results.push_back(res);
+
+				if (!bJson)
+				{
+					std::printf("%-48s %14.1f %14.1f %12zu\n", res.name.c_str(),
+						res.realNs, res.cpuNs, res.nIterations);
+					std::fflush(stdout);
+				}
+				break;
+			}
+
+			// aim a bit above the minimal time, grow at most tenfold per step
+			double multiplier = realSeconds > 0.0 ? 1.4 * minTime / realSeconds : 10.0;
+			multiplier = tdk_min(tdk_max(multiplier, 2.0), 10.0);
+			nIterations = tdk_size(double(nIterations) * multiplier);
+		}
+	}
+
+	if (bJson)
+		tdk_bench_write_json(stdout, argv[0], results);
+
+	if (szOutFile)
+	{
+		std::FILE* pFile = std::fopen(szOutFile, "w");
+		if (!pFile)
+		{
+			std::fprintf(stderr, "cannot open %s\n", szOutFile);
+			return 1;
+		}
+		tdk_bench_write_json(pFile, argv[0], results);
+		std::fclose(pFile);
+	}
+	return 0;
+}
+
+#endif //TDK_BENCH_H
@@ -0,0 +1,1502 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: benchmarks of containers and allocators.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#include "tdkbench.h"
+
+#include "base/tdkbitset.h"
+#include "base/tdkconcurrentdarray.h"
+#include "base/tdkdarray.h"
+#include "base/tdkflatmap.h"
+#include "base/tdkhashmap.h"
+#include "base/tdklist.h"
+#include "base/tdkmap.h"
+#include "base/tdkringbuffer.h"
+#include "base/tdkslotmap.h"
+#include "base/tdksparseset.h"
+#include "base/tdkspan.h"
+#include "base/tdkmemalloc.h"
+#include "base/tdkmemorypool.h"
+#include "base/tdkpackedarray.h"
+#include "base/tdkpoddarray.h"
+#include "base/tdkpriorityqueue.h"
+#include "base/tdkradixsort.h"
+#include "base/tdkstaticmemorypool.h"
+#include "base/tdkstring.h"
+#include "base/tdkstringpool.h"
+#include "system/tdkparallel.h"
+#include "system/tdktaskscheduler.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+
+struct Object32
+{
+	tdk_byte bytes[32];
+};
+
+// Fixed pseudo-random sequence, so every run churns the same way.
+class Lcg
+{
+public:
+	tdk_u32 next()
+	{
+		m_nState = m_nState * 1664525u + 1013904223u;
+		return m_nState >> 8;
+	}
+
+private:
+	tdk_u32 m_nState{ 12345 };
+};
+
+//-----------------------------------------------------------------------------
+// tdk_darray
+
+void BM_tdk_darray_push_back(tdk_bench_state& state)
+{
+	while (state.keep_running())
+	{
+		tdk_darray<int> arr;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			arr.push_back(int(i));
+		tdk_bench_do_not_optimize(arr.begin());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_darray_push_back, 1 << 10);
+TDK_BENCHMARK(BM_tdk_darray_push_back, 1 << 16);
+TDK_BENCHMARK(BM_tdk_darray_push_back, 1 << 20);
+
+void BM_std_vector_push_back(tdk_bench_state& state)
+{
+	while (state.keep_running())
+	{
+		std::vector<int> arr;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			arr.push_back(int(i));
+		tdk_bench_do_not_optimize(arr.data());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_std_vector_push_back, 1 << 10);
+TDK_BENCHMARK(BM_std_vector_push_back, 1 << 16);
+TDK_BENCHMARK(BM_std_vector_push_back, 1 << 20);
+
+void BM_tdk_darray_reserve_push_back(tdk_bench_state& state)
+{
+	while (state.keep_running())
+	{
+		tdk_darray<int> arr;
+		arr.reserve(state.range());
+		for (tdk_size i = 0; i < state.range(); ++i)
+			arr.push_back(int(i));
+		tdk_bench_do_not_optimize(arr.begin());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_darray_reserve_push_back, 1 << 16);
+
+void BM_std_vector_reserve_push_back(tdk_bench_state& state)
+{
+	while (state.keep_running())
+	{
+		std::vector<int> arr;
+		arr.reserve(state.range());
+		for (tdk_size i = 0; i < state.range(); ++i)
+			arr.push_back(int(i));
+		tdk_bench_do_not_optimize(arr.data());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_std_vector_reserve_push_back, 1 << 16);
+
+void BM_tdk_darray_insert_front(tdk_bench_state& state)
+{
+	while (state.keep_running())
+	{
+		tdk_darray<int> arr;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			arr.insert(arr.begin(), int(i));
+		tdk_bench_do_not_optimize(arr.begin());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_darray_insert_front, 1 << 10);
+
+void BM_std_vector_insert_front(tdk_bench_state& state)
+{
+	while (state.keep_running())
+	{
+		std::vector<int> arr;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			arr.insert(arr.begin(), int(i));
+		tdk_bench_do_not_optimize(arr.data());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_std_vector_insert_front, 1 << 10);
+
+//-----------------------------------------------------------------------------
+// tdk_podarray
+
+void BM_tdk_podarray_push_back(tdk_bench_state& state)
+{
+	while (state.keep_running())
+	{
+		tdk_podarray<int> arr;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			arr.push_back(int(i));
+		tdk_bench_do_not_optimize(arr.begin());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_podarray_push_back, 1 << 16);
+TDK_BENCHMARK(BM_tdk_podarray_push_back, 1 << 20);
+
+void BM_tdk_podarray_insert_front(tdk_bench_state& state)
+{
+	while (state.keep_running())
+	{
+		tdk_podarray<int> arr;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			arr.insert(arr.begin(), int(i));
+		tdk_bench_do_not_optimize(arr.begin());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_podarray_insert_front, 1 << 10);
+
+void BM_tdk_podarray_find(tdk_bench_state& state)
+{
+	tdk_podarray<int> arr;
+	for (tdk_size i = 0; i < state.range(); ++i)
+		arr.push_back(int(i));
+
+	// the last element, so the whole array is scanned
+	const int nKey = int(state.range() - 1);
+	while (state.keep_running())
+	{
+		tdk_size idx = arr.find(nKey,
+			[](const int& a, const int& b) { return a == b; });
+		tdk_bench_do_not_optimize(idx);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_podarray_find, 1 << 10);
+TDK_BENCHMARK(BM_tdk_podarray_find, 1 << 17);
+
+void BM_tdk_podarray_find_value(tdk_bench_state& state)
+{
+	tdk_podarray<int> arr;
+	for (tdk_size i = 0; i < state.range(); ++i)
+		arr.push_back(int(i));
+
+	const int nKey = int(state.range() - 1);
+	while (state.keep_running())
+	{
+		tdk_size idx = arr.find(nKey);
+		tdk_bench_do_not_optimize(idx);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_podarray_find_value, 1 << 10);
+TDK_BENCHMARK(BM_tdk_podarray_find_value, 1 << 17);
+
+void BM_tdk_podarray_count(tdk_bench_state& state)
+{
+	tdk_podarray<int> arr;
+	for (tdk_size i = 0; i < state.range(); ++i)
+		arr.push_back(int(i & 15));
+
+	while (state.keep_running())
+	{
+		tdk_size nFound = arr.count(7);
+		tdk_bench_do_not_optimize(nFound);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_podarray_count, 1 << 17);
+
+void BM_tdk_podarray_lower_bound(tdk_bench_state& state)
+{
+	tdk_podarray<int> arr;
+	for (tdk_size i = 0; i < state.range(); ++i)
+		arr.push_back(int(i * 2));
+
+	Lcg rng;
+	while (state.keep_running())
+	{
+		tdk_size idx = arr.lower_bound(int(rng.next() % (state.range() * 2)));
+		tdk_bench_do_not_optimize(idx);
+	}
+	state.set_items_processed(state.iterations());
+}
+TDK_BENCHMARK(BM_tdk_podarray_lower_bound, 1 << 20);
+
+void BM_std_lower_bound(tdk_bench_state& state)
+{
+	std::vector<int> arr;
+	for (tdk_size i = 0; i < state.range(); ++i)
+		arr.push_back(int(i * 2));
+
+	Lcg rng;
+	while (state.keep_running())
+	{
+		auto it = std::lower_bound(arr.begin(), arr.end(),
+			int(rng.next() % (state.range() * 2)));
+		tdk_bench_do_not_optimize(it);
+	}
+	state.set_items_processed(state.iterations());
+}
+TDK_BENCHMARK(BM_std_lower_bound, 1 << 20);
+
+
+void BM_std_find(tdk_bench_state& state)
+{
+	std::vector<int> arr;
+	for (tdk_size i = 0; i < state.range(); ++i)
+		arr.push_back(int(i));
+
+	const int nKey = int(state.range() - 1);
+	while (state.keep_running())
+	{
+		auto it = std::find(arr.begin(), arr.end(), nKey);
+		tdk_bench_do_not_optimize(it);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_std_find, 1 << 10);
+TDK_BENCHMARK(BM_std_find, 1 << 17);
+
+//-----------------------------------------------------------------------------
+// tdk_memorypool: allocate a batch then free it all
+
+void BM_tdk_memorypool_alloc_free(tdk_bench_state& state)
+{
+	tdk_memorypool<sizeof(Object32)> pool;
+	std::vector<void*> ptrs(state.range());
+	while (state.keep_running())
+	{
+		for (tdk_size i = 0; i < state.range(); ++i)
+			ptrs[i] = pool.allocate();
+		for (tdk_size i = 0; i < state.range(); ++i)
+			pool.free(ptrs[i]);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_memorypool_alloc_free, 1 << 10);
+TDK_BENCHMARK(BM_tdk_memorypool_alloc_free, 1 << 16);
+
+void BM_malloc_alloc_free(tdk_bench_state& state)
+{
+	std::vector<void*> ptrs(state.range());
+	while (state.keep_running())
+	{
+		for (tdk_size i = 0; i < state.range(); ++i)
+			ptrs[i] = std::malloc(sizeof(Object32));
+		for (tdk_size i = 0; i < state.range(); ++i)
+			std::free(ptrs[i]);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_malloc_alloc_free, 1 << 10);
+TDK_BENCHMARK(BM_malloc_alloc_free, 1 << 16);
+
+//-----------------------------------------------------------------------------
+// Churn: a live set of range() objects, every step frees a random one and
+// allocates a replacement.
+
+void BM_tdk_memorypool_churn(tdk_bench_state& state)
+{
+	tdk_memorypool<sizeof(Object32)> pool;
+	std::vector<void*> ptrs(state.range());
+	for (tdk_size i = 0; i < state.range(); ++i)
+		ptrs[i] = pool.allocate();
+
+	Lcg rng;
+	while (state.keep_running())
+	{
+		for (tdk_size i = 0; i < state.range(); ++i)
+		{
+			void*& p = ptrs[rng.next() % state.range()];
+			pool.free(p);
+			p = pool.allocate();
+		}
+	}
+
+	for (void* p : ptrs)
+		pool.free(p);
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_memorypool_churn, 1 << 12);
+TDK_BENCHMARK(BM_tdk_memorypool_churn, 1 << 18);
+
+void BM_tdk_static_memorypool_churn(tdk_bench_state& state)
+{
+	enum Constants { kNODES = 1 << 12 };
+	static tdk_static_memorypool<sizeof(Object32), kNODES> s_pool;
+	assert(state.range() <= kNODES);
+
+	std::vector<void*> ptrs(state.range());
+	for (tdk_size i = 0; i < state.range(); ++i)
+		ptrs[i] = s_pool.allocate();
+
+	Lcg rng;
+	while (state.keep_running())
+	{
+		for (tdk_size i = 0; i < state.range(); ++i)
+		{
+			void*& p = ptrs[rng.next() % state.range()];
+			s_pool.free(p);
+			p = s_pool.allocate();
+		}
+	}
+
+	for (void* p : ptrs)
+		s_pool.free(p);
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_static_memorypool_churn, 1 << 12);
+
+void BM_malloc_churn(tdk_bench_state& state)
+{
+	std::vector<void*> ptrs(state.range());
+	for (tdk_size i = 0; i < state.range(); ++i)
+		ptrs[i] = std::malloc(sizeof(Object32));
+
+	Lcg rng;
+	while (state.keep_running())
+	{
+		for (tdk_size i = 0; i < state.range(); ++i)
+		{
+			void*& p = ptrs[rng.next() % state.range()];
+			std::free(p);
+			p = std::malloc(sizeof(Object32));
+		}
+	}
+
+	for (void* p : ptrs)
+		std::free(p);
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_malloc_churn, 1 << 12);
+TDK_BENCHMARK(BM_malloc_churn, 1 << 18);
+
+void BM_std_allocator_churn(tdk_bench_state& state)
+{
+	std::allocator<Object32> alloc;
+	std::vector<Object32*> ptrs(state.range());
+	for (tdk_size i = 0; i < state.range(); ++i)
+		ptrs[i] = alloc.allocate(1);
+
+	Lcg rng;
+	while (state.keep_running())
+	{
+		for (tdk_size i = 0; i < state.range(); ++i)
+		{
+			Object32*& p = ptrs[rng.next() % state.range()];
+			alloc.deallocate(p, 1);
+			p = alloc.allocate(1);
+		}
+	}
+
+	for (Object32* p : ptrs)
+		alloc.deallocate(p, 1);
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_std_allocator_churn, 1 << 12);
+TDK_BENCHMARK(BM_std_allocator_churn, 1 << 18);
+
+//-----------------------------------------------------------------------------
+// Raw buffer allocation of range() ints
+
+void BM_tdk_allocator(tdk_bench_state& state)
+{
+	tdk_allocator<int> alloc;
+	while (state.keep_running())
+	{
+		int* p = alloc.allocate(state.range());
+		p[0] = 1;
+		tdk_bench_do_not_optimize(p);
+		alloc.deallocate(p, state.range());
+	}
+	state.set_items_processed(state.iterations());
+}
+TDK_BENCHMARK(BM_tdk_allocator, 16);
+TDK_BENCHMARK(BM_tdk_allocator, 1 << 16);
+
+void BM_std_allocator(tdk_bench_state& state)
+{
+	std::allocator<int> alloc;
+	while (state.keep_running())
+	{
+		int* p = alloc.allocate(state.range());
+		p[0] = 1;
+		tdk_bench_do_not_optimize(p);
+		alloc.deallocate(p, state.range());
+	}
+	state.set_items_processed(state.iterations());
+}
+TDK_BENCHMARK(BM_std_allocator, 16);
+TDK_BENCHMARK(BM_std_allocator, 1 << 16);
+
+void BM_malloc(tdk_bench_state& state)
+{
+	while (state.keep_running())
+	{
+		int* p = static_cast<int*>(std::malloc(state.range() * sizeof(int)));
+		p[0] = 1;
+		tdk_bench_do_not_optimize(p);
+		std::free(p);
+	}
+	state.set_items_processed(state.iterations());
+}
+TDK_BENCHMARK(BM_malloc, 16);
+TDK_BENCHMARK(BM_malloc, 1 << 16);
+
+//-----------------------------------------------------------------------------
+// tdk_hashmap: range() random keys
+
+void BM_tdk_hashmap_insert(tdk_bench_state& state)
+{
+	while (state.keep_running())
+	{
+		Lcg rng;
+		tdk_hashmap<tdk_u32, tdk_u32> map;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			map.insert(rng.next(), tdk_u32(i));
+		tdk_bench_do_not_optimize(map.size());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_hashmap_insert, 1 << 10);
+TDK_BENCHMARK(BM_tdk_hashmap_insert, 1 << 18);
+
+void BM_std_unordered_map_insert(tdk_bench_state& state)
+{
+	while (state.keep_running())
+	{
+		Lcg rng;
+		std::unordered_map<tdk_u32, tdk_u32> map;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			map.emplace(rng.next(), tdk_u32(i));
+		tdk_bench_do_not_optimize(map.size());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_std_unordered_map_insert, 1 << 10);
+TDK_BENCHMARK(BM_std_unordered_map_insert, 1 << 18);
+
+// Every other lookup misses.
+void BM_tdk_hashmap_find(tdk_bench_state& state)
+{
+	Lcg rng;
+	tdk_hashmap<tdk_u32, tdk_u32> map;
+	for (tdk_size i = 0; i < state.range(); ++i)
+		map.insert(rng.next() & ~1u, tdk_u32(i));
+
+	Lcg lookupRng;
+	while (state.keep_running())
+	{
+		tdk_size nFound = 0;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			nFound += map.contains(lookupRng.next() & ~tdk_u32(i & 1));
+		tdk_bench_do_not_optimize(nFound);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_hashmap_find, 1 << 10);
+TDK_BENCHMARK(BM_tdk_hashmap_find, 1 << 18);
+
+void BM_std_unordered_map_find(tdk_bench_state& state)
+{
+	Lcg rng;
+	std::unordered_map<tdk_u32, tdk_u32> map;
+	for (tdk_size i = 0; i < state.range(); ++i)
+		map.emplace(rng.next() & ~1u, tdk_u32(i));
+
+	Lcg lookupRng;
+	while (state.keep_running())
+	{
+		tdk_size nFound = 0;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			nFound += map.count(lookupRng.next() & ~tdk_u32(i & 1));
+		tdk_bench_do_not_optimize(nFound);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_std_unordered_map_find, 1 << 10);
+TDK_BENCHMARK(BM_std_unordered_map_find, 1 << 18);
+
+//-----------------------------------------------------------------------------
+// tdk_map: range() random keys
+
+void BM_tdk_map_insert(tdk_bench_state& state)
+{
+	while (state.keep_running())
+	{
+		Lcg rng;
+		tdk_map<tdk_u32, tdk_u32> map;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			map.insert(rng.next(), tdk_u32(i));
+		tdk_bench_do_not_optimize(map.size());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_map_insert, 1 << 10);
+TDK_BENCHMARK(BM_tdk_map_insert, 1 << 18);
+
+void BM_std_map_insert(tdk_bench_state& state)
+{
+	while (state.keep_running())
+	{
+		Lcg rng;
+		std::map<tdk_u32, tdk_u32> map;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			map.emplace(rng.next(), tdk_u32(i));
+		tdk_bench_do_not_optimize(map.size());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_std_map_insert, 1 << 10);
+TDK_BENCHMARK(BM_std_map_insert, 1 << 18);
+
+void BM_tdk_map_find(tdk_bench_state& state)
+{
+	Lcg rng;
+	tdk_map<tdk_u32, tdk_u32> map;
+	for (tdk_size i = 0; i < state.range(); ++i)
+		map.insert(rng.next(), tdk_u32(i));
+
+	while (state.keep_running())
+	{
+		Lcg lookupRng;
+		tdk_size nFound = 0;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			nFound += map.contains(lookupRng.next());
+		tdk_bench_do_not_optimize(nFound);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_map_find, 1 << 10);
+TDK_BENCHMARK(BM_tdk_map_find, 1 << 18);
+
+void BM_std_map_find(tdk_bench_state& state)
+{
+	Lcg rng;
+	std::map<tdk_u32, tdk_u32> map;
+	for (tdk_size i = 0; i < state.range(); ++i)
+		map.emplace(rng.next(), tdk_u32(i));
+
+	while (state.keep_running())
+	{
+		Lcg lookupRng;
+		tdk_size nFound = 0;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			nFound += map.count(lookupRng.next());
+		tdk_bench_do_not_optimize(nFound);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_std_map_find, 1 << 10);
+TDK_BENCHMARK(BM_std_map_find, 1 << 18);
+
+void BM_tdk_flat_map_find(tdk_bench_state& state)
+{
+	Lcg rng;
+	std::vector<std::pair<tdk_u32, tdk_u32>> items(state.range());
+	for (tdk_size i = 0; i < state.range(); ++i)
+		items[i] = { rng.next(), tdk_u32(i) };
+	tdk_flat_map<tdk_u32, tdk_u32> map;
+	map.build(items.begin(), items.end());
+
+	while (state.keep_running())
+	{
+		Lcg lookupRng;
+		tdk_size nFound = 0;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			nFound += map.contains(lookupRng.next());
+		tdk_bench_do_not_optimize(nFound);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_flat_map_find, 1 << 10);
+TDK_BENCHMARK(BM_tdk_flat_map_find, 1 << 18);
+
+// In order walk over all elements.
+void BM_tdk_map_iterate(tdk_bench_state& state)
+{
+	Lcg rng;
+	tdk_map<tdk_u32, tdk_u32> map;
+	for (tdk_size i = 0; i < state.range(); ++i)
+		map.insert(rng.next(), tdk_u32(i));
+
+	while (state.keep_running())
+	{
+		tdk_u32 nSum = 0;
+		for (const auto& val : map)
+			nSum += val.second;
+		tdk_bench_do_not_optimize(nSum);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_map_iterate, 1 << 18);
+
+void BM_std_map_iterate(tdk_bench_state& state)
+{
+	Lcg rng;
+	std::map<tdk_u32, tdk_u32> map;
+	for (tdk_size i = 0; i < state.range(); ++i)
+		map.emplace(rng.next(), tdk_u32(i));
+
+	while (state.keep_running())
+	{
+		tdk_u32 nSum = 0;
+		for (const auto& val : map)
+			nSum += val.second;
+		tdk_bench_do_not_optimize(nSum);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_std_map_iterate, 1 << 18);
+
+//-----------------------------------------------------------------------------
+// tdk_list: a queue of range() orders, every step retires the oldest one and
+// appends a new one.
+
+void BM_tdk_list_churn(tdk_bench_state& state)
+{
+	tdk_list<Object32> list;
+	for (tdk_size i = 0; i < state.range(); ++i)
+		list.push_back(Object32());
+
+	while (state.keep_running())
+	{
+		list.pop_front();
+		list.push_back(Object32());
+		tdk_bench_do_not_optimize(list.back());
+	}
+	state.set_items_processed(state.iterations());
+}
+TDK_BENCHMARK(BM_tdk_list_churn, 1 << 12);
+
+void BM_std_list_churn(tdk_bench_state& state)
+{
+	std::list<Object32> list;
+	for (tdk_size i = 0; i < state.range(); ++i)
+		list.push_back(Object32());
+
+	while (state.keep_running())
+	{
+		list.pop_front();
+		list.push_back(Object32());
+		tdk_bench_do_not_optimize(list.back());
+	}
+	state.set_items_processed(state.iterations());
+}
+TDK_BENCHMARK(BM_std_list_churn, 1 << 12);
+
+//-----------------------------------------------------------------------------
+// Queues: a producer thread hands range() items to the measuring thread.
+
+void BM_tdk_spsc_ringbuffer_handoff(tdk_bench_state& state)
+{
+	tdk_spsc_ringbuffer<tdk_u64> queue;
+	queue.initialize(1024);
+	while (state.keep_running())
+	{
+		const tdk_size nCount = state.range();
+		std::thread producer([&queue, nCount]()
+		{
+			tdk_u64 batch[32];
+			for (tdk_size i = 0; i < nCount;)
+			{
+				tdk_size n = tdk_min(nCount - i, tdk_size(32));
+				for (tdk_size k = 0; k < n; ++k)
+					batch[k] = i + k;
+				tdk_size nPushed = queue.push_batch(batch, n);
+				if (!nPushed)
+					std::this_thread::yield();
+				i += nPushed;
+			}
+		});
+
+		tdk_u64 batch[32];
+		tdk_u64 nSum = 0;
+		for (tdk_size i = 0; i < nCount;)
+		{
+			tdk_size nPopped = queue.pop_batch(batch, 32);
+			if (!nPopped)
+				std::this_thread::yield();
+			for (tdk_size k = 0; k < nPopped; ++k)
+				nSum += batch[k];
+			i += nPopped;
+		}
+		producer.join();
+		tdk_bench_do_not_optimize(nSum);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_spsc_ringbuffer_handoff, 1 << 20);
+
+void BM_tdk_mpmc_ringbuffer_handoff(tdk_bench_state& state)
+{
+	tdk_mpmc_ringbuffer<tdk_u64> queue;
+	queue.initialize(1024);
+	while (state.keep_running())
+	{
+		const tdk_size nCount = state.range();
+		std::thread producer([&queue, nCount]()
+		{
+			for (tdk_size i = 0; i < nCount;)
+			{
+				if (kTDK_OK == queue.push(tdk_u64(i)))
+					++i;
+				else
+					std::this_thread::yield();
+			}
+		});
+
+		tdk_u64 nSum = 0;
+		for (tdk_size i = 0; i < nCount;)
+		{
+			tdk_u64 nVal = 0;
+			if (kTDK_OK == queue.pop(nVal))
+			{
+				nSum += nVal;
+				++i;
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+		producer.join();
+		tdk_bench_do_not_optimize(nSum);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_mpmc_ringbuffer_handoff, 1 << 20);
+
+void BM_mutex_deque_handoff(tdk_bench_state& state)
+{
+	std::mutex mutex;
+	std::deque<tdk_u64> queue;
+	while (state.keep_running())
+	{
+		const tdk_size nCount = state.range();
+		std::thread producer([&mutex, &queue, nCount]()
+		{
+			for (tdk_size i = 0; i < nCount; ++i)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				queue.push_back(tdk_u64(i));
+			}
+		});
+
+		tdk_u64 nSum = 0;
+		for (tdk_size i = 0; i < nCount;)
+		{
+			bool bPopped = false;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!queue.empty())
+				{
+					nSum += queue.front();
+					queue.pop_front();
+					bPopped = true;
+				}
+			}
+			if (bPopped)
+				++i;
+			else
+				std::this_thread::yield();
+		}
+		producer.join();
+		tdk_bench_do_not_optimize(nSum);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_mutex_deque_handoff, 1 << 20);
+
+//-----------------------------------------------------------------------------
+// Slot map: range() live elements behind handles.
+
+void BM_tdk_slot_map_churn(tdk_bench_state& state)
+{
+	tdk_slot_map<Object32> map;
+	std::vector<tdk_slot_handle64> handles(state.range());
+	for (tdk_size i = 0; i < state.range(); ++i)
+		map.insert(Object32(), handles[i]);
+
+	Lcg rng;
+	while (state.keep_running())
+	{
+		for (tdk_size i = 0; i < state.range(); ++i)
+		{
+			tdk_slot_handle64& handle = handles[rng.next() % state.range()];
+			map.erase(handle);
+			map.insert(Object32(), handle);
+		}
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_slot_map_churn, 1 << 16);
+
+void BM_tdk_slot_map_lookup(tdk_bench_state& state)
+{
+	tdk_slot_map<Object32> map;
+	std::vector<tdk_slot_handle64> handles(state.range());
+	for (tdk_size i = 0; i < state.range(); ++i)
+		map.insert(Object32(), handles[i]);
+
+	Lcg rng;
+	while (state.keep_running())
+	{
+		tdk_u64 nSum = 0;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			nSum += map.at(handles[rng.next() % state.range()])->bytes[0];
+		tdk_bench_do_not_optimize(nSum);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_slot_map_lookup, 1 << 16);
+
+//-----------------------------------------------------------------------------
+// Sparse set: membership checks of random 24-bit IDs, range() of them are
+// members.
+
+template<typename Set>
+void sparse_set_contains(tdk_bench_state& state, Set& set)
+{
+	Lcg fill;
+	for (tdk_size i = 0; i < state.range(); ++i)
+		set.insert(fill.next());
+
+	Lcg rng;
+	while (state.keep_running())
+	{
+		tdk_size nFound = 0;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			nFound += set.count(rng.next()) ? 1 : 0;
+		tdk_bench_do_not_optimize(nFound);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+
+struct SparseSetCount : tdk_sparse_set<>
+{
+	bool count(tdk_u32 nId) const
+	{
+		return contains(nId);
+	}
+};
+
+void BM_tdk_sparse_set_contains(tdk_bench_state& state)
+{
+	SparseSetCount set;
+	sparse_set_contains(state, set);
+}
+TDK_BENCHMARK(BM_tdk_sparse_set_contains, 1 << 16);
+
+void BM_std_unordered_set_contains(tdk_bench_state& state)
+{
+	std::unordered_set<tdk_u32> set;
+	sparse_set_contains(state, set);
+}
+TDK_BENCHMARK(BM_std_unordered_set_contains, 1 << 16);
+
+//-----------------------------------------------------------------------------
+// Bit sets: AND of two range()-bit masks with every third bit set, then the
+// number of bits left.
+
+void BM_tdk_bitset_and_count(tdk_bench_state& state)
+{
+	tdk_bitset<> mask, filter, result;
+	mask.resize(state.range());
+	filter.resize(state.range());
+	Lcg rng;
+	for (tdk_size i = 0; i < state.range(); ++i)
+	{
+		mask.set(i, 0 == rng.next() % 3);
+		filter.set(i, 0 == rng.next() % 3);
+	}
+
+	while (state.keep_running())
+	{
+		result.assign(mask);
+		result &= filter;
+		tdk_bench_do_not_optimize(result.count());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_bitset_and_count, 1 << 20);
+
+void BM_std_vector_bool_and_count(tdk_bench_state& state)
+{
+	std::vector<bool> mask(state.range()), filter(state.range()), result;
+	Lcg rng;
+	for (tdk_size i = 0; i < state.range(); ++i)
+	{
+		mask[i] = 0 == rng.next() % 3;
+		filter[i] = 0 == rng.next() % 3;
+	}
+
+	while (state.keep_running())
+	{
+		result = mask;
+		tdk_size nCount = 0;
+		for (tdk_size i = 0; i < state.range(); ++i)
+		{
+			result[i] = result[i] && filter[i];
+			nCount += result[i];
+		}
+		tdk_bench_do_not_optimize(nCount);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_std_vector_bool_and_count, 1 << 20);
+
+void BM_tdk_bitset_count_and(tdk_bench_state& state)
+{
+	tdk_bitset<> mask, filter;
+	mask.resize(state.range());
+	filter.resize(state.range());
+	Lcg rng;
+	for (tdk_size i = 0; i < state.range(); ++i)
+	{
+		mask.set(i, 0 == rng.next() % 3);
+		filter.set(i, 0 == rng.next() % 3);
+	}
+
+	while (state.keep_running())
+		tdk_bench_do_not_optimize(mask.count_and(filter));
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_bitset_count_and, 1 << 20);
+
+//-----------------------------------------------------------------------------
+// Priority queues: push range() random keys, then pop them all.
+
+template<typename Queue>
+void push_pop_all(tdk_bench_state& state)
+{
+	while (state.keep_running())
+	{
+		Lcg rng;
+		Queue queue;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			queue.push(rng.next());
+
+		tdk_u64 nSum = 0;
+		while (!queue.empty())
+		{
+			nSum += queue.top();
+			queue.pop();
+		}
+		tdk_bench_do_not_optimize(nSum);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+
+void BM_tdk_priority_queue4_push_pop(tdk_bench_state& state)
+{
+	push_pop_all<tdk_priority_queue<tdk_u32, std::less<tdk_u32>, 4>>(state);
+}
+TDK_BENCHMARK(BM_tdk_priority_queue4_push_pop, 1 << 10);
+TDK_BENCHMARK(BM_tdk_priority_queue4_push_pop, 1 << 20);
+
+void BM_tdk_priority_queue8_push_pop(tdk_bench_state& state)
+{
+	push_pop_all<tdk_priority_queue<tdk_u32, std::less<tdk_u32>, 8>>(state);
+}
+TDK_BENCHMARK(BM_tdk_priority_queue8_push_pop, 1 << 10);
+TDK_BENCHMARK(BM_tdk_priority_queue8_push_pop, 1 << 20);
+
+void BM_std_priority_queue_push_pop(tdk_bench_state& state)
+{
+	push_pop_all<std::priority_queue<tdk_u32>>(state);
+}
+TDK_BENCHMARK(BM_std_priority_queue_push_pop, 1 << 10);
+TDK_BENCHMARK(BM_std_priority_queue_push_pop, 1 << 20);
+
+//-----------------------------------------------------------------------------
+// Packed arrays: range() sorted IDs with small random gaps.
+
+tdk_podarray<tdk_u32> sorted_ids(tdk_size nCount)
+{
+	tdk_podarray<tdk_u32> ids;
+	ids.resize(nCount);
+	Lcg rng;
+	tdk_u32 nId = 1000000;
+	for (tdk_size i = 0; i < nCount; ++i)
+	{
+		nId += rng.next() % 16;
+		ids[i] = nId;
+	}
+	return ids;
+}
+
+void BM_tdk_packed_delta_decode(tdk_bench_state& state)
+{
+	tdk_podarray<tdk_u32> ids = sorted_ids(state.range());
+	tdk_packed_delta_array packed;
+	packed.build(ids.data(), ids.size());
+
+	tdk_podarray<tdk_u32> out;
+	out.resize(state.range());
+	while (state.keep_running())
+	{
+		packed.decode(0, packed.size(), out.data());
+		tdk_bench_do_not_optimize(out[0]);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_packed_delta_decode, 1 << 20);
+
+void BM_tdk_packed_array_get(tdk_bench_state& state)
+{
+	tdk_podarray<tdk_u32> ids = sorted_ids(state.range());
+	tdk_packed_array packed;
+	packed.assign(ids.data(), ids.size());
+
+	Lcg rng;
+	while (state.keep_running())
+	{
+		tdk_u64 nSum = 0;
+		for (tdk_size i = 0; i < state.range(); ++i)
+			nSum += packed[rng.next() % state.range()];
+		tdk_bench_do_not_optimize(nSum);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_packed_array_get, 1 << 20);
+
+//-----------------------------------------------------------------------------
+// Strings: symbol names of 12 to 22 characters, a quarter of them distinct.
+
+std::vector<std::string> symbol_names(tdk_size nCount)
+{
+	std::vector<std::string> names;
+	names.reserve(nCount);
+	Lcg rng;
+	for (tdk_size i = 0; i < nCount; ++i)
+	{
+		std::string name = "sym::" + std::to_string(rng.next() % (nCount / 4 + 1));
+		name.resize(12 + rng.next() % 11, '_');
+		names.push_back(name);
+	}
+	return names;
+}
+
+template<typename String>
+void string_copies(tdk_bench_state& state)
+{
+	std::vector<std::string> names = symbol_names(state.range());
+	std::vector<String> copies(names.size());
+	while (state.keep_running())
+	{
+		for (tdk_size i = 0; i < names.size(); ++i)
+			copies[i] = String(names[i].c_str());
+		tdk_bench_do_not_optimize(copies.data());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+
+void BM_tdk_string_copy(tdk_bench_state& state)
+{
+	string_copies<tdk_string>(state);
+}
+TDK_BENCHMARK(BM_tdk_string_copy, 1 << 16);
+
+void BM_std_string_copy(tdk_bench_state& state)
+{
+	string_copies<std::string>(state);
+}
+TDK_BENCHMARK(BM_std_string_copy, 1 << 16);
+
+void BM_tdk_string_pool_intern(tdk_bench_state& state)
+{
+	std::vector<std::string> names = symbol_names(state.range());
+	while (state.keep_running())
+	{
+		tdk_string_pool pool;
+		tdk_string_pool::id_type nId = 0;
+		for (const std::string& name : names)
+			pool.intern(name, nId);
+		tdk_bench_do_not_optimize(nId);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_string_pool_intern, 1 << 16);
+
+void BM_std_unordered_set_intern(tdk_bench_state& state)
+{
+	std::vector<std::string> names = symbol_names(state.range());
+	while (state.keep_running())
+	{
+		std::unordered_set<std::string> pool;
+		const std::string* pName = nullptr;
+		for (const std::string& name : names)
+			pName = &*pool.insert(name).first;
+		tdk_bench_do_not_optimize(pName);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_std_unordered_set_intern, 1 << 16);
+
+//-----------------------------------------------------------------------------
+// Slicing: a stage sums every 256-element window of an array.
+
+tdk_u64 sum_window(tdk_span<const tdk_u32> window)
+{
+	tdk_u64 nSum = 0;
+	for (tdk_u32 nVal : window)
+		nSum += nVal;
+	return nSum;
+}
+
+void BM_tdk_span_windows(tdk_bench_state& state)
+{
+	tdk_podarray<tdk_u32> ids = sorted_ids(state.range());
+	while (state.keep_running())
+	{
+		tdk_span<const tdk_u32> all(ids);
+		tdk_u64 nSum = 0;
+		for (tdk_size i = 0; i < all.size(); i += 256)
+			nSum += sum_window(all.subspan(i, tdk_min(tdk_size(256), all.size() - i)));
+		tdk_bench_do_not_optimize(nSum);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_span_windows, 1 << 20);
+
+void BM_podarray_copy_windows(tdk_bench_state& state)
+{
+	tdk_podarray<tdk_u32> ids = sorted_ids(state.range());
+	while (state.keep_running())
+	{
+		tdk_u64 nSum = 0;
+		for (tdk_size i = 0; i < ids.size(); i += 256)
+		{
+			tdk_podarray<tdk_u32> window;
+			window.assign(ids.data() + i, tdk_min(tdk_size(256), ids.size() - i));
+			nSum += sum_window(window);
+		}
+		tdk_bench_do_not_optimize(nSum);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_podarray_copy_windows, 1 << 20);
+
+//-----------------------------------------------------------------------------
+// Task scheduler, one thread per hardware thread.
+
+tdk_task_scheduler& bench_scheduler()
+{
+	static tdk_task_scheduler s_scheduler;
+	static bool s_bInitialized = kTDK_OK == s_scheduler.initialize();
+	TDK_UNUSED(s_bInitialized);
+	return s_scheduler;
+}
+
+void BM_tdk_task_group_spawn(tdk_bench_state& state)
+{
+	tdk_task_scheduler& scheduler = bench_scheduler();
+	std::atomic<tdk_size> nDone(0);
+	while (state.keep_running())
+	{
+		tdk_task_group group(scheduler);
+		for (tdk_size i = 0; i < state.range(); ++i)
+			group.run([&nDone]() { nDone.fetch_add(1, std::memory_order_relaxed); });
+		group.wait();
+	}
+	tdk_bench_do_not_optimize(nDone.load());
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_task_group_spawn, 1 << 10);
+
+void BM_tdk_parallel_for(tdk_bench_state& state)
+{
+	tdk_task_scheduler& scheduler = bench_scheduler();
+	tdk_darray<float> arr;
+	arr.reserve(state.range());
+	for (tdk_size i = 0; i < state.range(); ++i)
+		arr.push_back(float(i));
+
+	while (state.keep_running())
+	{
+		scheduler.parallel_for(arr, [](float& val) { val = val * 0.5f + 1.0f; });
+		tdk_bench_do_not_optimize(*arr.begin());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_parallel_for, 1 << 20);
+
+void BM_serial_for(tdk_bench_state& state)
+{
+	tdk_darray<float> arr;
+	arr.reserve(state.range());
+	for (tdk_size i = 0; i < state.range(); ++i)
+		arr.push_back(float(i));
+
+	while (state.keep_running())
+	{
+		for (float* pVal = arr.begin(); pVal != arr.end(); ++pVal)
+			*pVal = *pVal * 0.5f + 1.0f;
+		tdk_bench_do_not_optimize(*arr.begin());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_serial_for, 1 << 20);
+
+//-----------------------------------------------------------------------------
+// Parallel algorithms against their serial std counterparts.
+
+void BM_tdk_parallel_reduce(tdk_bench_state& state)
+{
+	tdk_task_scheduler& scheduler = bench_scheduler();
+	tdk_podarray<tdk_u32> arr;
+	arr.resize(state.range(), 3);
+	while (state.keep_running())
+	{
+		tdk_u64 nSum = tdk_parallel_reduce(scheduler, arr, tdk_u64(0),
+			[](tdk_u64 a, tdk_u64 b) { return a + b; });
+		tdk_bench_do_not_optimize(nSum);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_parallel_reduce, 1 << 22);
+
+void BM_std_accumulate(tdk_bench_state& state)
+{
+	tdk_podarray<tdk_u32> arr;
+	arr.resize(state.range(), 3);
+	while (state.keep_running())
+	{
+		tdk_u64 nSum = std::accumulate(arr.begin(), arr.end(), tdk_u64(0));
+		tdk_bench_do_not_optimize(nSum);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_std_accumulate, 1 << 22);
+
+void BM_tdk_parallel_sort(tdk_bench_state& state)
+{
+	tdk_task_scheduler& scheduler = bench_scheduler();
+	tdk_podarray<tdk_u32> source;
+	source.resize(state.range());
+	for (tdk_size i = 0; i < state.range(); ++i)
+		source[i] = tdk_u32(i * 2654435761u);
+
+	tdk_podarray<tdk_u32> arr;
+	while (state.keep_running())
+	{
+		state.pause_timing();
+		arr = source;
+		state.resume_timing();
+		tdk_parallel_sort(scheduler, arr);
+		tdk_bench_do_not_optimize(arr[0]);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_parallel_sort, 1 << 20);
+
+void BM_std_sort(tdk_bench_state& state)
+{
+	tdk_podarray<tdk_u32> source;
+	source.resize(state.range());
+	for (tdk_size i = 0; i < state.range(); ++i)
+		source[i] = tdk_u32(i * 2654435761u);
+
+	tdk_podarray<tdk_u32> arr;
+	while (state.keep_running())
+	{
+		state.pause_timing();
+		arr = source;
+		state.resume_timing();
+		std::sort(arr.begin(), arr.end());
+		tdk_bench_do_not_optimize(arr[0]);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_std_sort, 1 << 20);
+
+void BM_tdk_radix_sort(tdk_bench_state& state)
+{
+	tdk_podarray<tdk_u32> source;
+	source.resize(state.range());
+	for (tdk_size i = 0; i < state.range(); ++i)
+		source[i] = tdk_u32(i * 2654435761u);
+
+	tdk_podarray<tdk_u32> arr;
+	while (state.keep_running())
+	{
+		state.pause_timing();
+		arr = source;
+		state.resume_timing();
+		tdk_radix_sort(arr);
+		tdk_bench_do_not_optimize(arr[0]);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_radix_sort, 1 << 20);
+
+void BM_tdk_parallel_radix_sort(tdk_bench_state& state)
+{
+	tdk_task_scheduler& scheduler = bench_scheduler();
+	tdk_podarray<tdk_u32> source;
+	source.resize(state.range());
+	for (tdk_size i = 0; i < state.range(); ++i)
+		source[i] = tdk_u32(i * 2654435761u);
+
+	tdk_podarray<tdk_u32> arr;
+	while (state.keep_running())
+	{
+		state.pause_timing();
+		arr = source;
+		state.resume_timing();
+		tdk_parallel_radix_sort(scheduler, arr);
+		tdk_bench_do_not_optimize(arr[0]);
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_parallel_radix_sort, 1 << 20);
+
+//-----------------------------------------------------------------------------
+// Fan-in: parallel_for chunks push one result per index into a shared array.
+
+void BM_tdk_concurrent_darray_fan_in(tdk_bench_state& state)
+{
+	tdk_task_scheduler& scheduler = bench_scheduler();
+	tdk_concurrent_darray<tdk_u32> results;
+	while (state.keep_running())
+	{
+		results.clear();
+		scheduler.parallel_for(0, state.range(), [&results](tdk_size nFirst, tdk_size nLast)
+		{
+			for (tdk_size i = nFirst; i < nLast; ++i)
+				results.push_back(tdk_u32(i * 3));
+		}, 1024);
+		results.seal();
+		tdk_bench_do_not_optimize(results.data());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_concurrent_darray_fan_in, 1 << 20);
+
+void BM_tdk_concurrent_darray_fan_in_batched(tdk_bench_state& state)
+{
+	tdk_task_scheduler& scheduler = bench_scheduler();
+	tdk_concurrent_darray<tdk_u32> results;
+	while (state.keep_running())
+	{
+		results.clear();
+		scheduler.parallel_for(0, state.range(), [&results](tdk_size nFirst, tdk_size nLast)
+		{
+			tdk_u32 batch[256];
+			tdk_size nBatch = 0;
+			for (tdk_size i = nFirst; i < nLast; ++i)
+			{
+				batch[nBatch++] = tdk_u32(i * 3);
+				if (256 == nBatch)
+				{
+					results.append(batch, nBatch);
+					nBatch = 0;
+				}
+			}
+			results.append(batch, nBatch);
+		}, 1024);
+		results.seal();
+		tdk_bench_do_not_optimize(results.data());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_tdk_concurrent_darray_fan_in_batched, 1 << 20);
+
+void BM_mutex_darray_fan_in(tdk_bench_state& state)
+{
+	tdk_task_scheduler& scheduler = bench_scheduler();
+	tdk_darray<tdk_u32> results;
+	std::mutex mutex;
+	while (state.keep_running())
+	{
+		results.clear();
+		scheduler.parallel_for(0, state.range(),
+			[&results, &mutex](tdk_size nFirst, tdk_size nLast)
+		{
+			for (tdk_size i = nFirst; i < nLast; ++i)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				results.push_back(tdk_u32(i * 3));
+			}
+		}, 1024);
+		tdk_bench_do_not_optimize(results.data());
+	}
+	state.set_items_processed(state.iterations() * state.range());
+}
+TDK_BENCHMARK(BM_mutex_darray_fan_in, 1 << 20);
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	return tdk_bench_main(argc, argv);
+}
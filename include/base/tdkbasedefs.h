@@ -86,6 +86,21 @@ Purpose: compiler-specific macro definitions.
 #define TDK_CPP03
 #endif
 
+//-----------------------------------------------------------------------------
+// Architecture detection
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TDK_X86
+#endif
+
+// Compiles a single function for an instruction set extension, e.g.
+// TDK_TARGET("avx2"). Only call it after checking the CPU at runtime.
+#if defined(TDK_GNUC_VER)
+#	define TDK_TARGET(isa) __attribute__((target(isa)))
+#else
+#	define TDK_TARGET(isa)
+#endif
+
 // Integers
 #include <cstdint>
 #include <cstddef>
@@ -93,9 +108,14 @@ Purpose: compiler-specific macro definitions.
 using tdk_byte = std::uint8_t;
 using tdk_size = std::size_t;
 using tdk_diff = std::ptrdiff_t;
+using tdk_u64 = std::uint64_t;
 using tdk_u32 = std::uint32_t;
 using tdk_u16 = std::uint16_t;
 
+// Data written by different threads goes to different cache lines of this
+// size, otherwise the cores keep stealing the line from each other.
+const tdk_size kTDK_CACHE_LINE_SIZE = 64;
+
 // Reals
 using tdk_real32 = float;
 using tdk_real64 = double;
@@ -122,6 +142,9 @@ enum tdk_error_codes
 {
 	kTDK_BAD_ALLOC,
 	kTDK_BAD_SIZE,
+	kTDK_BAD_FILE, // cannot open, create, map or resize a file
+	kTDK_BAD_FORMAT, // the data is not what the reader expects
+	kTDK_BAD_CHECKSUM,
 };
 
 #define TDK_UNUSED(x) ((void)x)
@@ -49,8 +49,12 @@ Purpose: base utils.
 
 #include "base/tdkbasedefs.h"
 
+#ifdef _MSC_VER
+#	include <intrin.h>
+#endif
+
 // Error processing
-inline void tdk_set_error_code(tdk_err* pErrorCode, const tdk_err val)
+constexpr void tdk_set_error_code(tdk_err* pErrorCode, const tdk_err val)
 {
 	if (pErrorCode)
 		*pErrorCode = val;
@@ -69,5 +73,93 @@ constexpr T tdk_max(const T& a, const T& b)
 	return a >= b ? a : b;
 }
 
+// Bits
+// Index of the lowest set bit, nMask must not be zero.
+inline tdk_u32 tdk_count_trailing_zeros(tdk_u32 nMask)
+{
+#ifdef _MSC_VER
+	unsigned long nIdx;
+	_BitScanForward(&nIdx, nMask);
+	return nIdx;
+#else
+	return __builtin_ctz(nMask);
+#endif
+}
+
+inline tdk_u32 tdk_count_trailing_zeros(tdk_u64 nMask)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	unsigned long nIdx;
+	_BitScanForward64(&nIdx, nMask);
+	return nIdx;
+#elif defined(_MSC_VER)
+	tdk_u32 nLow = tdk_u32(nMask);
+	return nLow ? tdk_count_trailing_zeros(nLow) :
+		32 + tdk_count_trailing_zeros(tdk_u32(nMask >> 32));
+#else
+	return __builtin_ctzll(nMask);
+#endif
+}
+
+// Bits needed to hold n: 0 for 0, index of the highest set bit plus one.
+inline tdk_u32 tdk_bit_width(tdk_u32 n)
+{
+	if (!n)
+		return 0;
+#ifdef _MSC_VER
+	unsigned long nIdx;
+	_BitScanReverse(&nIdx, n);
+	return nIdx + 1;
+#else
+	return 32 - __builtin_clz(n);
+#endif
+}
+
+inline tdk_u32 tdk_bit_width(tdk_u64 n)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	unsigned long nIdx;
+	return _BitScanReverse64(&nIdx, n) ? nIdx + 1 : 0;
+#elif defined(_MSC_VER)
+	tdk_u32 nHigh = tdk_u32(n >> 32);
+	return nHigh ? 32 + tdk_bit_width(nHigh) : tdk_bit_width(tdk_u32(n));
+#else
+	return n ? 64 - __builtin_clzll(n) : 0;
+#endif
+}
+
+inline tdk_u32 tdk_count_bits(tdk_u32 n)
+{
+#ifdef _MSC_VER
+	n = n - ((n >> 1) & 0x55555555u);
+	n = (n & 0x33333333u) + ((n >> 2) & 0x33333333u);
+	return (((n + (n >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+#else
+	return __builtin_popcount(n);
+#endif
+}
+
+inline tdk_u32 tdk_count_bits(tdk_u64 n)
+{
+#ifdef _MSC_VER
+	return tdk_count_bits(tdk_u32(n)) + tdk_count_bits(tdk_u32(n >> 32));
+#else
+	return __builtin_popcountll(n);
+#endif
+}
+
+// Cache hints
+// Starts loading the line of p into the cache, never faults.
+inline void tdk_prefetch(const void* p)
+{
+#if defined(TDK_GNUC_VER)
+	__builtin_prefetch(p);
+#elif defined(_MSC_VER) && defined(TDK_X86)
+	_mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+	TDK_UNUSED(p);
+#endif
+}
+
 
 #endif //TDK_BASEUTL_H
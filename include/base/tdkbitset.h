@@ -0,0 +1,473 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: dynamic bit set.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_BITSET_H
+#define TDK_BITSET_H
+
+#include "base/tdkbasedefs.h"
+#include "base/tdkbaseutl.h"
+#include "base/tdkmemalloc.h"
+#include "system/tdksimd.h"
+
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+// Dynamic bit set over 64-bit words. The words start on a cache line and
+// the capacity is a whole number of cache lines, so the SIMD kernels run on
+// full lines. Bits past size() are always zero: count() and the bulk
+// operations may read whole words without masking.
+template <typename Allocator = tdk_allocator<tdk_u64, kTDK_CACHE_LINE_SIZE>>
+class tdk_bitset
+{
+	using AllocatorForWord = typename
+		std::allocator_traits<Allocator>::template rebind_alloc<tdk_u64>;
+public:
+	typedef tdk_size size_type;
+	typedef Allocator allocator_type;
+
+	enum Constants
+	{
+		kWORD_BITS = 64,
+		kLINE_WORDS = kTDK_CACHE_LINE_SIZE / sizeof(tdk_u64)
+	};
+
+	tdk_bitset()
+		: m_pWords(nullptr)
+		, m_nBits(0)
+		, m_nCapacity(0)
+	{
+	}
+
+	// Leaves the set empty if the memory cannot be allocated, use assign()
+	// to get the error.
+	tdk_bitset(const tdk_bitset& oth)
+		: tdk_bitset()
+	{
+		assign(oth);
+	}
+
+	tdk_bitset(tdk_bitset&& oth) noexcept
+		: m_pWords(oth.m_pWords)
+		, m_nBits(oth.m_nBits)
+		, m_nCapacity(oth.m_nCapacity)
+	{
+		oth.m_pWords = nullptr;
+		oth.m_nBits = 0;
+		oth.m_nCapacity = 0;
+	}
+
+	~tdk_bitset()
+	{
+		if (m_pWords)
+			AllocatorForWord().deallocate(m_pWords, m_nCapacity);
+	}
+
+	tdk_bitset& operator=(const tdk_bitset& oth)
+	{
+		if (this != &oth)
+			assign(oth);
+		return *this;
+	}
+
+	tdk_bitset& operator=(tdk_bitset&& oth) noexcept
+	{
+		tdk_bitset tmp(std::move(oth));
+		swap(tmp);
+		return *this;
+	}
+
+	void swap(tdk_bitset& oth) noexcept
+	{
+		std::swap(m_pWords, oth.m_pWords);
+		std::swap(m_nBits, oth.m_nBits);
+		std::swap(m_nCapacity, oth.m_nCapacity);
+	}
+
+	tdk_ret assign(const tdk_bitset& oth, tdk_err* pErrorCode = nullptr)
+	{
+		size_type nWords = oth.word_count();
+		if (nWords > m_nCapacity)
+		{
+			tdk_ret retVal = reserve_words(nWords, pErrorCode);
+			if (kTDK_OK != retVal)
+				return retVal;
+		}
+
+		clear_words(0, word_count());
+		if (nWords)
+			std::memcpy(m_pWords, oth.m_pWords, nWords * sizeof(tdk_u64));
+		m_nBits = oth.m_nBits;
+		return kTDK_OK;
+	}
+
+	// New bits get bVal.
+	tdk_ret resize(size_type nBits, bool bVal = false,
+		tdk_err* pErrorCode = nullptr)
+	{
+		if (nBits > max_size())
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+			return kTDK_FATAL;
+		}
+
+		size_type nWords = words_for(nBits);
+		if (nWords > m_nCapacity)
+		{
+			tdk_ret retVal = reserve_words(nWords, pErrorCode);
+			if (kTDK_OK != retVal)
+				return retVal;
+		}
+
+		size_type nOldBits = m_nBits;
+		if (nBits < nOldBits)
+		{
+			size_type nOldWords = word_count();
+			m_nBits = nBits;
+			clear_words(nWords, nOldWords);
+			clear_tail();
+			return kTDK_OK;
+		}
+
+		m_nBits = nBits;
+		if (bVal)
+			set_range(nOldBits, nBits);
+		return kTDK_OK;
+	}
+
+	tdk_ret reserve(size_type nBits, tdk_err* pErrorCode = nullptr)
+	{
+		if (nBits > max_size())
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+			return kTDK_FATAL;
+		}
+
+		size_type nWords = words_for(nBits);
+		if (nWords <= m_nCapacity)
+			return kTDK_OK;
+		return reserve_words(nWords, pErrorCode);
+	}
+
+	void clear()
+	{
+		clear_words(0, word_count());
+		m_nBits = 0;
+	}
+
+	bool test(size_type nPos) const
+	{
+		assert(nPos < m_nBits);
+		return 0 != (m_pWords[nPos / kWORD_BITS] & bit_mask(nPos));
+	}
+
+	bool operator[](size_type nPos) const
+	{
+		return test(nPos);
+	}
+
+	void set(size_type nPos)
+	{
+		assert(nPos < m_nBits);
+		m_pWords[nPos / kWORD_BITS] |= bit_mask(nPos);
+	}
+
+	void set(size_type nPos, bool bVal)
+	{
+		assert(nPos < m_nBits);
+		tdk_u64& nWord = m_pWords[nPos / kWORD_BITS];
+		nWord = (nWord & ~bit_mask(nPos)) | (tdk_u64(bVal) << (nPos % kWORD_BITS));
+	}
+
+	void reset(size_type nPos)
+	{
+		assert(nPos < m_nBits);
+		m_pWords[nPos / kWORD_BITS] &= ~bit_mask(nPos);
+	}
+
+	void flip(size_type nPos)
+	{
+		assert(nPos < m_nBits);
+		m_pWords[nPos / kWORD_BITS] ^= bit_mask(nPos);
+	}
+
+	void set_all()
+	{
+		if (m_nBits)
+			std::memset(m_pWords, 0xFF, word_count() * sizeof(tdk_u64));
+		clear_tail();
+	}
+
+	void reset_all()
+	{
+		clear_words(0, word_count());
+	}
+
+	void flip_all()
+	{
+		for (size_type i = 0; i < word_count(); ++i)
+			m_pWords[i] = ~m_pWords[i];
+		clear_tail();
+	}
+
+	// Bulk operations, both sets must have the same size.
+
+	tdk_bitset& operator&=(const tdk_bitset& oth)
+	{
+		return apply(oth, kTDK_BIT_AND);
+	}
+
+	tdk_bitset& operator|=(const tdk_bitset& oth)
+	{
+		return apply(oth, kTDK_BIT_OR);
+	}
+
+	tdk_bitset& operator^=(const tdk_bitset& oth)
+	{
+		return apply(oth, kTDK_BIT_XOR);
+	}
+
+	// Clears the bits set in oth.
+	tdk_bitset& and_not(const tdk_bitset& oth)
+	{
+		return apply(oth, kTDK_BIT_ANDNOT);
+	}
+
+	size_type count() const
+	{
+		return tdk_simd_popcount(m_pWords, word_count());
+	}
+
+	// Size of the intersection, the sets stay untouched.
+	size_type count_and(const tdk_bitset& oth) const
+	{
+		assert(m_nBits == oth.m_nBits);
+		return tdk_simd_popcount_and(m_pWords, oth.m_pWords, word_count());
+	}
+
+	bool any() const
+	{
+		return find_first() != m_nBits;
+	}
+
+	bool none() const
+	{
+		return !any();
+	}
+
+	// Index of the first set bit, size() if there is none.
+	size_type find_first() const
+	{
+		return scan_from(0, word_count() ? m_pWords[0] : 0);
+	}
+
+	// Index of the first set bit after nPos, size() if there is none.
+	size_type find_next(size_type nPos) const
+	{
+		size_type nNext = nPos + 1;
+		if (nNext >= m_nBits)
+			return m_nBits;
+
+		size_type nWord = nNext / kWORD_BITS;
+		return scan_from(nWord, m_pWords[nWord] & (~tdk_u64(0) << (nNext % kWORD_BITS)));
+	}
+
+	// Calls func(index) for every set bit in ascending order.
+	template<typename Func>
+	void for_each_set(Func&& func) const
+	{
+		for (size_type i = 0, nWords = word_count(); i < nWords; ++i)
+		{
+			for (tdk_u64 nWord = m_pWords[i]; nWord; nWord &= nWord - 1)
+				func(i * kWORD_BITS + tdk_count_trailing_zeros(nWord));
+		}
+	}
+
+	bool operator==(const tdk_bitset& oth) const
+	{
+		return m_nBits == oth.m_nBits && (!m_nBits ||
+			0 == std::memcmp(m_pWords, oth.m_pWords, word_count() * sizeof(tdk_u64)));
+	}
+
+	bool operator!=(const tdk_bitset& oth) const
+	{
+		return !(*this == oth);
+	}
+
+	tdk_u64* data()
+	{
+		return m_pWords;
+	}
+
+	const tdk_u64* data() const
+	{
+		return m_pWords;
+	}
+
+	size_type word_count() const
+	{
+		return words_for(m_nBits);
+	}
+
+	size_type size() const
+	{
+		return m_nBits;
+	}
+
+	bool empty() const
+	{
+		return 0 == m_nBits;
+	}
+
+	size_type capacity() const
+	{
+		return m_nCapacity * kWORD_BITS;
+	}
+
+	// the byte size of the words cannot overflow, even rounded up to a line
+	size_type max_size() const
+	{
+		return size_type(-1) / 16;
+	}
+
+	allocator_type get_allocator() const
+	{
+		return allocator_type();
+	}
+
+private:
+	static size_type words_for(size_type nBits)
+	{
+		return (nBits + kWORD_BITS - 1) / kWORD_BITS;
+	}
+
+	static tdk_u64 bit_mask(size_type nPos)
+	{
+		return tdk_u64(1) << (nPos % kWORD_BITS);
+	}
+
+	size_type scan_from(size_type nWord, tdk_u64 nBitsLeft) const
+	{
+		for (size_type nWords = word_count();;)
+		{
+			if (nBitsLeft)
+				return nWord * kWORD_BITS + tdk_count_trailing_zeros(nBitsLeft);
+			if (++nWord >= nWords)
+				return m_nBits;
+			nBitsLeft = m_pWords[nWord];
+		}
+	}
+
+	tdk_bitset& apply(const tdk_bitset& oth, tdk_simd_bit_op op)
+	{
+		assert(m_nBits == oth.m_nBits);
+		tdk_simd_bits_apply(m_pWords, oth.m_pWords, word_count(), op);
+		return *this;
+	}
+
+	// Sets the bits in [nFirst, nLast).
+	void set_range(size_type nFirst, size_type nLast)
+	{
+		for (; nFirst < nLast && nFirst % kWORD_BITS; ++nFirst)
+			set(nFirst);
+
+		size_type nFullWords = (nLast - nFirst) / kWORD_BITS;
+		if (nFullWords)
+		{
+			std::memset(m_pWords + nFirst / kWORD_BITS, 0xFF,
+				nFullWords * sizeof(tdk_u64));
+			nFirst += nFullWords * kWORD_BITS;
+		}
+
+		for (; nFirst < nLast; ++nFirst)
+			set(nFirst);
+	}
+
+	void clear_words(size_type nFirst, size_type nLast)
+	{
+		if (nFirst < nLast)
+			std::memset(m_pWords + nFirst, 0, (nLast - nFirst) * sizeof(tdk_u64));
+	}
+
+	// Zeroes the bits of the last word past size().
+	void clear_tail()
+	{
+		if (m_nBits % kWORD_BITS)
+			m_pWords[m_nBits / kWORD_BITS] &= ~(~tdk_u64(0) << (m_nBits % kWORD_BITS));
+	}
+
+	tdk_ret reserve_words(size_type nWords, tdk_err* pErrorCode)
+	{
+		size_type nNewCap = tdk_max(m_nCapacity + m_nCapacity / 2, nWords);
+		nNewCap = (nNewCap + kLINE_WORDS - 1) & ~size_type(kLINE_WORDS - 1);
+
+		AllocatorForWord memAlloc;
+		tdk_u64* pMem = memAlloc.allocate(nNewCap);
+		if (!pMem)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+			return kTDK_FATAL;
+		}
+
+		size_type nUsed = word_count();
+		if (nUsed)
+			std::memcpy(pMem, m_pWords, nUsed * sizeof(tdk_u64));
+		std::memset(pMem + nUsed, 0, (nNewCap - nUsed) * sizeof(tdk_u64));
+
+		if (m_pWords)
+			memAlloc.deallocate(m_pWords, m_nCapacity);
+		m_pWords = pMem;
+		m_nCapacity = nNewCap;
+		return kTDK_OK;
+	}
+
+	tdk_u64* m_pWords;
+	size_type m_nBits;
+	size_type m_nCapacity; // in words
+};
+
+#endif //TDK_BITSET_H
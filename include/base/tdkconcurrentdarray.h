@@ -0,0 +1,448 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: append-only array for concurrent producers.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_CONCURRENTDARRAY_H
+#define TDK_CONCURRENTDARRAY_H
+
+#include "base/tdkbasedefs.h"
+#include "base/tdkbaseutl.h"
+#include "base/tdkmemalloc.h"
+#include "base/tdkmemutl.h"
+#include "base/tdkspan.h"
+
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Append-only array for many producer threads. push_back() takes its slot
+// with one fetch_add and writes it without a lock. The storage is a list of
+// segments, segment k holds first_segment_size() << k elements, so nothing
+// moves while other threads write. The thread that first needs a segment
+// allocates it and publishes it with a CAS, a loser frees its copy.
+//
+// Everything except push_back(), append() and operator[] on a written
+// element must not run concurrently with producers: wait for them (join,
+// tdk_task_group::wait()) first. seal() then moves the elements into one
+// block, after which data(), begin() and end() give a contiguous view.
+//
+// If a segment cannot be allocated it is marked as failed, the slots that
+// fall into it stay empty and seal() reports kTDK_BAD_ALLOC until clear().
+//
+// A slot is counted before its element is built, and there is no way to take
+// it back from the other producers, so pushing and appending require the
+// copy or move that builds the element not to throw.
+template<typename T, typename Allocator = tdk_allocator<T>>
+class tdk_concurrent_darray
+{
+	using AllocatorForT =
+		typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+public:
+	typedef T value_type;
+	typedef tdk_size size_type;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+	typedef Allocator allocator_type;
+
+	enum Constants
+	{
+		kDEFAULT_FIRST_BITS = 10,
+		kMAX_SEGMENTS = sizeof(size_type) * 8
+	};
+
+	tdk_concurrent_darray()
+	{
+		for (std::atomic<T*>& segment : m_segments)
+			segment.store(nullptr, std::memory_order_relaxed);
+	}
+
+	tdk_concurrent_darray(const tdk_concurrent_darray&) = delete;
+	tdk_concurrent_darray& operator=(const tdk_concurrent_darray&) = delete;
+
+	~tdk_concurrent_darray()
+	{
+		destroy_all();
+		free_segments();
+	}
+
+	// Thread safe.
+	tdk_ret push_back(const T& val, tdk_err* pErrorCode = nullptr)
+	{
+		return emplace_back(val, pErrorCode);
+	}
+
+	// Thread safe.
+	tdk_ret push_back(T&& val, tdk_err* pErrorCode = nullptr)
+	{
+		return emplace_back(std::move(val), pErrorCode);
+	}
+
+	// Thread safe. Reserves nCount adjacent slots with a single fetch_add,
+	// a producer that appends its results in batches does not share cache
+	// lines with the others.
+	tdk_ret append(const T* pValues, size_type nCount, tdk_err* pErrorCode = nullptr)
+	{
+		static_assert(std::is_nothrow_copy_constructible_v<T>,
+			"a slot is counted before the copy that fills it");
+
+		if (!nCount)
+			return kTDK_OK;
+
+		size_type idx = m_counter.nCount.fetch_add(nCount, std::memory_order_relaxed);
+		tdk_ret retVal = kTDK_OK;
+		// every segment that got allocated is filled, even after a failure,
+		// so only the slots of failed segments stay empty
+		while (nCount)
+		{
+			tdk_u32 nSegment = segment_of(idx);
+			size_type nOffset = idx - segment_base(nSegment);
+			size_type nPiece = tdk_min(nCount, segment_size(nSegment) - nOffset);
+			T* pSegment = acquire_segment(nSegment, pErrorCode);
+			if (pSegment)
+				tdk_uninitialized_copy_n(pValues, nPiece, pSegment + nOffset);
+			else
+				retVal = kTDK_FATAL;
+
+			idx += nPiece;
+			pValues += nPiece;
+			nCount -= nPiece;
+		}
+		return retVal;
+	}
+
+	// Thread safe for elements whose producer has returned.
+	T& operator[](size_type idx)
+	{
+		return *element(idx);
+	}
+
+	const T& operator[](size_type idx) const
+	{
+		return *element(idx);
+	}
+
+	// Moves the elements into the first segment, growing it to a power of
+	// two that holds all of them. Free when they are there already. The
+	// array stays usable, later elements go to new segments again.
+	tdk_ret seal(tdk_err* pErrorCode = nullptr)
+	{
+		size_type nCount = size();
+		tdk_u32 nUsedSegments = nCount ? segment_of(nCount - 1) + 1 : 0;
+		for (tdk_u32 k = 0; k < nUsedSegments; ++k)
+		{
+			if (failed_segment() == m_segments[k].load(std::memory_order_relaxed))
+			{
+				tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+				return kTDK_FATAL;
+			}
+		}
+
+		if (nUsedSegments <= 1)
+			return kTDK_OK;
+
+		tdk_u32 nBits = tdk_bit_width(tdk_u64(nCount - 1));
+		AllocatorForT memAlloc;
+		T* pMem = memAlloc.allocate(size_type(1) << nBits);
+		if (!pMem)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+			return kTDK_FATAL;
+		}
+
+		T* pDst = pMem;
+		for (tdk_u32 k = 0; k < nUsedSegments; ++k)
+		{
+			T* pSegment = m_segments[k].load(std::memory_order_relaxed);
+			pDst = tdk_uninitialized_relocate_n(pSegment, used_in_segment(k, nCount),
+				pDst);
+		}
+
+		free_segments();
+		m_nFirstBits = nBits;
+		m_segments[0].store(pMem, std::memory_order_relaxed);
+		return kTDK_OK;
+	}
+
+	// The elements sit in one block: always after seal(), or when they fit
+	// the first segment.
+	bool is_contiguous() const
+	{
+		size_type nCount = size();
+		return nCount <= first_segment_size() &&
+			failed_segment() != m_segments[0].load(std::memory_order_relaxed);
+	}
+
+	T* data()
+	{
+		assert(is_contiguous());
+		return m_segments[0].load(std::memory_order_relaxed);
+	}
+
+	const T* data() const
+	{
+		assert(is_contiguous());
+		return m_segments[0].load(std::memory_order_relaxed);
+	}
+
+	iterator begin()
+	{
+		return data();
+	}
+
+	const_iterator begin() const
+	{
+		return data();
+	}
+
+	iterator end()
+	{
+		return data() + size();
+	}
+
+	const_iterator end() const
+	{
+		return data() + size();
+	}
+
+	tdk_span<T> span()
+	{
+		return tdk_span<T>(data(), size());
+	}
+
+	tdk_span<const T> span() const
+	{
+		return tdk_span<const T>(data(), size());
+	}
+
+	// With nothing pushed yet, sizes the first segment to hold nCount
+	// elements, so seal() has nothing to move. Otherwise allocates the
+	// segments up to nCount.
+	tdk_ret reserve(size_type nCount, tdk_err* pErrorCode = nullptr)
+	{
+		if (!nCount)
+			return kTDK_OK;
+
+		if (empty() && nCount > first_segment_size())
+		{
+			free_segments();
+			m_nFirstBits = tdk_bit_width(tdk_u64(nCount - 1));
+		}
+
+		for (tdk_u32 k = 0, nLast = segment_of(nCount - 1); k <= nLast; ++k)
+		{
+			if (!acquire_segment(k, pErrorCode))
+				return kTDK_FATAL;
+		}
+		return kTDK_OK;
+	}
+
+	// Keeps the segments, forgets an allocation failure.
+	void clear()
+	{
+		destroy_all();
+		for (std::atomic<T*>& segment : m_segments)
+		{
+			if (failed_segment() == segment.load(std::memory_order_relaxed))
+				segment.store(nullptr, std::memory_order_relaxed);
+		}
+		m_counter.nCount.store(0, std::memory_order_relaxed);
+	}
+
+	// Slots taken so far, some may still be in the middle of being written
+	// while producers run.
+	size_type size() const
+	{
+		return m_counter.nCount.load(std::memory_order_acquire);
+	}
+
+	bool empty() const
+	{
+		return 0 == size();
+	}
+
+	size_type first_segment_size() const
+	{
+		return size_type(1) << m_nFirstBits;
+	}
+
+	allocator_type get_allocator() const
+	{
+		return allocator_type();
+	}
+private:
+	struct alignas(kTDK_CACHE_LINE_SIZE) Counter
+	{
+		std::atomic<size_type> nCount{ 0 };
+	};
+
+	template<typename Arg>
+	tdk_ret emplace_back(Arg&& val, tdk_err* pErrorCode)
+	{
+		static_assert(std::is_nothrow_constructible_v<T, Arg&&>,
+			"a slot is counted before the constructor that fills it");
+
+		size_type idx = m_counter.nCount.fetch_add(1, std::memory_order_relaxed);
+		tdk_u32 nSegment = segment_of(idx);
+		T* pSegment = acquire_segment(nSegment, pErrorCode);
+		if (!pSegment)
+			return kTDK_FATAL;
+
+		::new (static_cast<void*>(pSegment + (idx - segment_base(nSegment))))
+			T(std::forward<Arg>(val));
+		return kTDK_OK;
+	}
+
+	// Never dereferenced, marks a segment whose allocation failed.
+	static T* failed_segment()
+	{
+		static tdk_byte s_failed;
+		return reinterpret_cast<T*>(&s_failed);
+	}
+
+	// The last one ends at the top of size_type.
+	tdk_u32 segment_count() const
+	{
+		return kMAX_SEGMENTS - m_nFirstBits;
+	}
+
+	// Segment k starts at first_segment_size() * (2^k - 1).
+	tdk_u32 segment_of(size_type idx) const
+	{
+		return tdk_bit_width(tdk_u64((idx >> m_nFirstBits) + 1)) - 1;
+	}
+
+	size_type segment_base(tdk_u32 nSegment) const
+	{
+		return ((size_type(1) << nSegment) - 1) << m_nFirstBits;
+	}
+
+	size_type segment_size(tdk_u32 nSegment) const
+	{
+		return size_type(1) << (m_nFirstBits + nSegment);
+	}
+
+	size_type used_in_segment(tdk_u32 nSegment, size_type nCount) const
+	{
+		size_type nBase = segment_base(nSegment);
+		return nCount > nBase ? tdk_min(nCount - nBase, segment_size(nSegment)) : 0;
+	}
+
+	T* element(size_type idx) const
+	{
+		assert(idx < size());
+		tdk_u32 nSegment = segment_of(idx);
+		T* pSegment = m_segments[nSegment].load(std::memory_order_acquire);
+		assert(pSegment && failed_segment() != pSegment);
+		return pSegment + (idx - segment_base(nSegment));
+	}
+
+	T* acquire_segment(tdk_u32 nSegment, tdk_err* pErrorCode)
+	{
+		if (nSegment >= segment_count())
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+			return nullptr;
+		}
+
+		T* pSegment = m_segments[nSegment].load(std::memory_order_acquire);
+		if (!pSegment)
+		{
+			AllocatorForT memAlloc;
+			T* pMem = memAlloc.allocate(segment_size(nSegment));
+			T* pDesired = pMem ? pMem : failed_segment();
+			if (m_segments[nSegment].compare_exchange_strong(pSegment, pDesired,
+				std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				pSegment = pDesired;
+			}
+			else if (pMem)
+			{
+				memAlloc.deallocate(pMem, segment_size(nSegment));
+			}
+		}
+
+		if (failed_segment() == pSegment)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+			return nullptr;
+		}
+		return pSegment;
+	}
+
+	void destroy_all()
+	{
+		if constexpr (!std::is_trivially_destructible_v<T>)
+		{
+			size_type nCount = size();
+			for (tdk_u32 k = 0; k < segment_count(); ++k)
+			{
+				T* pSegment = m_segments[k].load(std::memory_order_relaxed);
+				if (pSegment && failed_segment() != pSegment)
+					tdk_destroy(pSegment, pSegment + used_in_segment(k, nCount));
+			}
+		}
+	}
+
+	void free_segments()
+	{
+		AllocatorForT memAlloc;
+		for (tdk_u32 k = 0; k < segment_count(); ++k)
+		{
+			T* pSegment = m_segments[k].load(std::memory_order_relaxed);
+			if (pSegment && failed_segment() != pSegment)
+				memAlloc.deallocate(pSegment, segment_size(k));
+			m_segments[k].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	Counter m_counter;
+	std::atomic<T*> m_segments[kMAX_SEGMENTS];
+	tdk_u32 m_nFirstBits{ kDEFAULT_FIRST_BITS };
+};
+
+#endif //TDK_CONCURRENTDARRAY_H
@@ -51,7 +51,9 @@ Purpose: dynamic array.
 #include "base/tdkmemalloc.h"
 #include "base/tdkmemutl.h"
 
+#include <algorithm>
 #include <memory>
+#include <functional>
 #include <cassert>
 
 template <typename T, typename Allocator = tdk_allocator<T>>
@@ -104,40 +106,92 @@ public:
 
 	tdk_ret push_back(const T& val, tdk_err* pErrorCode = nullptr)
 	{
-		tdk_ret retVal = grow_memory(1, pErrorCode);
-		if (retVal != kTDK_OK)
+		return emplace_back(val, pErrorCode);
+	}
+
+	tdk_ret push_back(T&& val, tdk_err* pErrorCode = nullptr)
+	{
+		return emplace_back(std::move(val), pErrorCode);
+	}
+
+	void pop_back()
+	{
+		assert(m_nCount);
+		--m_nCount;
+		tdk_destroy_at(m_pData + m_nCount);
+	}
+
+	iterator erase(const_iterator firstIt, const_iterator lastIt)
+	{
+		size_type nFirst = firstIt - begin();
+		size_type nErased = lastIt - firstIt;
+		assert(nFirst + nErased <= m_nCount);
+
+		if (nErased)
 		{
-			return retVal;
+			if constexpr (std::is_nothrow_move_constructible_v<T>)
+			{
+				tdk_destroy(m_pData + nFirst, m_pData + nFirst + nErased);
+				tdk_relocate_forward_n(m_pData + nFirst + nErased,
+					m_nCount - nFirst - nErased, m_pData + nFirst);
+			}
+			else
+			{
+				// a throwing move cannot be shifted in place, so the tail is
+				// assigned down and the leftovers die once that succeeded
+				T* pNewEnd = std::move(m_pData + nFirst + nErased,
+					m_pData + m_nCount, m_pData + nFirst);
+				tdk_destroy(pNewEnd, m_pData + m_nCount);
+			}
+			m_nCount -= nErased;
 		}
-		tdk_uninitialized_copy_n(std::addressof(val), 1, m_pData + m_nCount);
-		++m_nCount;
-		return kTDK_OK;
+		return m_pData + nFirst;
+	}
+
+	iterator erase(const_iterator pos)
+	{
+		return erase(pos, pos + 1);
+	}
+
+	void swap(tdk_darray& oth) noexcept
+	{
+		std::swap(m_pData, oth.m_pData);
+		std::swap(m_nCount, oth.m_nCount);
+		std::swap(m_nCapacity, oth.m_nCapacity);
 	}
 
 	template< typename InputIt >
-	iterator insert(const_iterator pos, InputIt firstIt, InputIt lastIt, 
+	tdk_ret insert(const_iterator pos, InputIt firstIt, InputIt lastIt, 
 			 tdk_err* pErrorCode = nullptr)
 	{
 		size_type nGrowBy = std::distance(firstIt, lastIt);
 		size_type nNewCount = m_nCount + nGrowBy;
+		size_type nBeforeGap = pos - begin();
 
-		if (nNewCount > m_nCapacity)
+		// a range of our own elements would be moved by the in-place shift,
+		// it goes the reallocating way that copies it before the old buffer
+		// changes; so does a type whose move may throw, as only a new buffer
+		// leaves the old one intact when it does
+		if constexpr (std::is_nothrow_move_constructible_v<T>)
 		{
-			size_type nNewCap = suggest_capacity(nNewCount, m_nCapacity);
-
-			tdk_ret retVal = resize_memory_for_insert(pos - begin(), nGrowBy, 
-					nNewCap, pErrorCode);
-			if (retVal != kTDK_OK)
+			if (nNewCount <= m_nCapacity && !is_own_range(firstIt, nGrowBy))
 			{
-				return retVal;
+				insert_in_place(nBeforeGap, firstIt, nGrowBy);
+				m_nCount = nNewCount;
+				return kTDK_OK;
 			}
 		}
-		else
+
+		size_type nNewCap = suggest_capacity(nNewCount, m_nCapacity);
+
+		tdk_ret retVal = resize_memory_for_insert(nBeforeGap, firstIt,
+				nGrowBy, nNewCap, pErrorCode);
+		if (retVal != kTDK_OK)
 		{
-			make_gap(pos - begin(), nGrowBy);
+			return retVal;
 		}
 
-		tdk_uninitialized_copy_n(firstIt, nGrowBy, pos);
+		m_nCount = nNewCount;
 		return kTDK_OK;
 	}
 
@@ -169,6 +223,40 @@ public:
 		return m_pData + idx;
 	}
 
+	T& operator[](size_type idx)
+	{
+		assert(idx < m_nCount);
+		return m_pData[idx];
+	}
+
+	const T& operator[](size_type idx) const
+	{
+		assert(idx < m_nCount);
+		return m_pData[idx];
+	}
+
+	T& back()
+	{
+		assert(m_nCount);
+		return m_pData[m_nCount - 1];
+	}
+
+	const T& back() const
+	{
+		assert(m_nCount);
+		return m_pData[m_nCount - 1];
+	}
+
+	T* data()
+	{
+		return m_pData;
+	}
+
+	const T* data() const
+	{
+		return m_pData;
+	}
+
 	iterator begin()
 	{
 		return m_pData;
@@ -194,6 +282,11 @@ public:
 		return m_nCount;
 	}
 
+	bool empty() const
+	{
+		return 0 == m_nCount;
+	}
+
 	size_type capacity() const
 	{
 		return m_nCapacity;
@@ -204,6 +297,42 @@ public:
 		return allocator(*get_allocator_for_T());
 	}
 private:
+	// tdk_uninitialized_relocate_n cannot fail half way
+	static constexpr bool kNOTHROW_RELOCATE =
+		std::is_nothrow_move_constructible_v<T> ||
+		std::is_nothrow_copy_constructible_v<T>;
+
+	// Returns a new buffer to the allocator on scope exit unless release()
+	// was called, so an element constructor that throws does not leak it.
+	class MemoryGuard
+	{
+	public:
+		MemoryGuard(AllocatorForT* pAllocator, T* pData, size_type nCapacity) noexcept
+			: m_pAllocator(pAllocator)
+			, m_pData(pData)
+			, m_nCapacity(nCapacity)
+		{
+		}
+
+		~MemoryGuard()
+		{
+			if (m_pData)
+				m_pAllocator->deallocate(m_pData, m_nCapacity);
+		}
+
+		MemoryGuard(const MemoryGuard&) = delete;
+		MemoryGuard& operator=(const MemoryGuard&) = delete;
+
+		void release() noexcept
+		{
+			m_pData = nullptr;
+		}
+
+	private:
+		AllocatorForT* m_pAllocator;
+		T* m_pData;
+		size_type m_nCapacity;
+	};
 
 	template<typename A>
 	std::enable_if_t<tdk_is_static_creatable<A>::value, bool>
@@ -251,6 +380,53 @@ private:
 		return pResult;
 	}
 		
+	template<typename Arg>
+	tdk_ret emplace_back(Arg&& val, tdk_err* pErrorCode)
+	{
+		if (m_nCount < m_nCapacity)
+		{
+			::new (static_cast<void*>(m_pData + m_nCount)) T(std::forward<Arg>(val));
+			++m_nCount;
+			return kTDK_OK;
+		}
+
+		AllocatorForT* pAllocatorForT = get_allocator_for_T();
+		assert(pAllocatorForT);
+
+		size_type nNewCap = suggest_capacity(m_nCount + 1, m_nCapacity);
+		T* pNewData = pAllocatorForT->allocate(nNewCap);
+		if (!pNewData)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+			return kTDK_FATAL;
+		}
+
+		// val may be an element of the old buffer (a.push_back(a[0])), so it
+		// is copied before the old elements move out and their buffer goes
+		MemoryGuard newDataGuard(pAllocatorForT, pNewData, nNewCap);
+		T* pNewElem = pNewData + m_nCount;
+		::new (static_cast<void*>(pNewElem)) T(std::forward<Arg>(val));
+		if (m_nCount)
+		{
+			assert(m_pData);
+			T* pNewElemEnd = pNewElem + 1;
+			tdk_construct_rollback<T*> rollback(pNewElem, pNewElemEnd);
+			tdk_uninitialized_relocate_n(m_pData, m_nCount, pNewData);
+			rollback.release();
+		}
+		newDataGuard.release();
+
+		if (m_pData)
+		{
+			pAllocatorForT->deallocate(m_pData, m_nCapacity);
+		}
+
+		m_pData = pNewData;
+		m_nCapacity = nNewCap;
+		++m_nCount;
+		return kTDK_OK;
+	}
+
 	size_type suggest_capacity(size_type nNewCount, size_type nCurrentCap)
 	{
 		nCurrentCap = tdk_max(nCurrentCap, size_type(4));
@@ -301,8 +477,9 @@ private:
 		if (m_nCount)
 		{
 			assert(m_pData);
-			tdk_uninitialized_copy_n(m_pData, m_nCount, pNewData);
-			tdk_destroy(m_pData, m_pData + m_nCount);
+			MemoryGuard newDataGuard(pAllocatorForT, pNewData, nNewCap);
+			tdk_uninitialized_relocate_n(m_pData, m_nCount, pNewData);
+			newDataGuard.release();
 		}
 
 		if (m_pData)
@@ -315,20 +492,41 @@ private:
 		return kTDK_OK;
 	}
 
-	void make_gap(size_type nBeforeGap, size_type nGapSize) noexcept
+	// Shifts the tail right by nGrowBy and copies the range into the gap. A
+	// copy that throws moves the tail back, so the array is left unchanged.
+	template<typename InputIt>
+	void insert_in_place(size_type nBeforeGap, InputIt firstIt, size_type nGrowBy)
 	{
-		if (nBeforeGap >= m_nCount)
-			return;
-
+		T* pGap = m_pData + nBeforeGap;
 		size_type nAfterGap = m_nCount - nBeforeGap;
-		tdk_uninitialized_copy_backward_n(m_pData + m_nCount, nAfterGap,
-			m_pData + m_nCount + nGapSize);
+		tdk_relocate_backward_n(m_pData + m_nCount, nAfterGap,
+			m_pData + m_nCount + nGrowBy);
+
+		tdk_gap_rollback<T, size_type> gapRollback(pGap, pGap + nGrowBy, nAfterGap);
+		tdk_uninitialized_copy_n(firstIt, nGrowBy, pGap);
+		gapRollback.release();
+	}
 
-		tdk_destroy(m_pData + nBeforeGap, m_pData + m_nCount);
+	template<typename InputIt>
+	bool is_own_range(InputIt firstIt, size_type nCount) const
+	{
+		if constexpr (std::is_convertible_v<InputIt, const T*>)
+		{
+			const T* pFirst = firstIt;
+			std::less<const T*> less;
+			return nCount && !less(pFirst + nCount - 1, m_pData) &&
+				less(pFirst, m_pData + m_nCount);
+		}
+		else
+		{
+			return false;
+		}
 	}
 
-	tdk_ret resize_memory_for_insert(size_type nBeforeGap, size_type nGapSize,
-		size_type nNewCap, tdk_err* pErrorCode = nullptr)
+	// the range goes into the gap first, it may lie in the old buffer
+	template<typename InputIt>
+	tdk_ret resize_memory_for_insert(size_type nBeforeGap, InputIt firstIt,
+		size_type nGapSize, size_type nNewCap, tdk_err* pErrorCode = nullptr)
 	{
 		AllocatorForT* pAllocatorForT = get_allocator_for_T();
 		assert(pAllocatorForT);
@@ -342,16 +540,34 @@ private:
 			return kTDK_FATAL;
 		}
 
+		MemoryGuard newDataGuard(pAllocatorForT, pNewData, nNewCap);
+		T* pGap = pNewData + nBeforeGap;
+		T* pAfterGap = pGap + nGapSize;
+		tdk_uninitialized_copy_n(firstIt, nGapSize, pGap);
+		tdk_construct_rollback<T*> gapRollback(pGap, pAfterGap);
 		if (m_nCount)
 		{
 			assert(m_pData);
-			tdk_uninitialized_copy_n(m_pData, nBeforeGap, pNewData);
 			size_type nAfterGap = m_nCount - nBeforeGap;
-			size_type nDestPos = nBeforeGap + nGapSize;
-			tdk_uninitialized_copy_n(m_pData + nBeforeGap, nAfterGap, 
-				pNewData + nDestPos);
-			tdk_destroy(m_pData, m_pData + m_nCount);
+			if constexpr (kNOTHROW_RELOCATE)
+			{
+				tdk_uninitialized_relocate_n(m_pData, nBeforeGap, pNewData);
+				tdk_uninitialized_relocate_n(m_pData + nBeforeGap, nAfterGap,
+					pAfterGap);
+			}
+			else
+			{
+				// the old elements stay intact until both parts are copied
+				T* pBeforeGapEnd = pNewData + nBeforeGap;
+				tdk_uninitialized_copy_n(m_pData, nBeforeGap, pNewData);
+				tdk_construct_rollback<T*> rollback(pNewData, pBeforeGapEnd);
+				tdk_uninitialized_copy_n(m_pData + nBeforeGap, nAfterGap, pAfterGap);
+				rollback.release();
+				tdk_destroy(m_pData, m_pData + m_nCount);
+			}
 		}
+		gapRollback.release();
+		newDataGuard.release();
 
 		if (m_pData)
 		{
@@ -380,7 +596,7 @@ private:
 		return kTDK_OK;
 	}
 
-	tdk_ret destroy_all(tdk_err* pErrorCode = nullptr)
+	tdk_ret destroy_all(tdk_err* /*pErrorCode*/ = nullptr)
 	{
 		if (m_nCount)
 		{
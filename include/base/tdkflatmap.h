@@ -0,0 +1,528 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: sorted flat map and set.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_FLATMAP_H
+#define TDK_FLATMAP_H
+
+#include "base/tdkbaseutl.h"
+#include "base/tdkdarray.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+// First element of the sorted range [pFirst, pFirst + nCount) that is not
+// less than key. The loop has no data dependent branch: the comparison
+// becomes a mask on the step (compilers keep the ?: form as a jump), and
+// both positions the next step may probe are prefetched, so a large table
+// costs about one cache miss per level instead of a miss plus a mispredict.
+template<typename T, typename Key, typename Less>
+const T* tdk_branchless_lower_bound(const T* pFirst, tdk_size nCount,
+	const Key& key, Less less)
+{
+	if (0 == nCount)
+		return pFirst;
+
+	const T* pBase = pFirst;
+	while (nCount > 1)
+	{
+		tdk_size nHalf = nCount / 2;
+		nCount -= nHalf;
+		tdk_prefetch(pBase + nCount / 2);
+		tdk_prefetch(pBase + nHalf + nCount / 2);
+		pBase += nHalf & (tdk_size(0) - tdk_size(less(pBase[nHalf - 1], key)));
+	}
+	return pBase + (less(*pBase, key) ? 1 : 0);
+}
+
+//-----------------------------------------------------------------------------
+// Sorted map for read-mostly tables. Keys and values live in two parallel
+// tdk_darrays, so a lookup only touches the keys. A single insert or erase
+// shifts the tail; fill big tables with build() and later batches with
+// merge(), both sort their input once.
+template<typename K, typename V, typename Less = std::less<K>>
+class tdk_flat_map
+{
+public:
+	typedef tdk_size size_type;
+	typedef K key_type;
+	typedef V mapped_type;
+
+	tdk_flat_map() = default;
+
+	explicit tdk_flat_map(const Less& less)
+		: m_less(less)
+	{
+	}
+
+	tdk_flat_map(const tdk_flat_map&) = delete;
+	tdk_flat_map& operator=(const tdk_flat_map&) = delete;
+
+	// Returns kTDK_OK if the pair was inserted, kTDK_NO if key was there.
+	tdk_ret insert(const K& key, const V& val, tdk_err* pErrorCode = nullptr)
+	{
+		size_type idx = lower_index(key);
+		if (idx < size() && !m_less(key, m_keys[idx]))
+			return kTDK_NO;
+		return insert_at(idx, key, val, pErrorCode);
+	}
+
+	// Returns kTDK_OK if the pair was inserted, kTDK_NO if an existing
+	// value was replaced.
+	tdk_ret insert_or_assign(const K& key, const V& val,
+		tdk_err* pErrorCode = nullptr)
+	{
+		size_type idx = lower_index(key);
+		if (idx < size() && !m_less(key, m_keys[idx]))
+		{
+			m_values[idx] = val;
+			return kTDK_NO;
+		}
+		return insert_at(idx, key, val, pErrorCode);
+	}
+
+	// Returns kTDK_OK if key was erased, kTDK_NO if it was not there.
+	tdk_ret erase(const K& key)
+	{
+		size_type idx = index_of(key);
+		if (idx == size())
+			return kTDK_NO;
+
+		m_keys.erase(m_keys.begin() + idx);
+		m_values.erase(m_values.begin() + idx);
+		return kTDK_OK;
+	}
+
+	V* at(const K& key)
+	{
+		size_type idx = index_of(key);
+		return idx < size() ? &m_values[idx] : nullptr;
+	}
+
+	const V* at(const K& key) const
+	{
+		size_type idx = index_of(key);
+		return idx < size() ? &m_values[idx] : nullptr;
+	}
+
+	bool contains(const K& key) const
+	{
+		return index_of(key) < size();
+	}
+
+	// Position of key in keys() and values(), size() if it is absent.
+	size_type index_of(const K& key) const
+	{
+		size_type idx = lower_index(key);
+		return idx < size() && !m_less(key, m_keys[idx]) ? idx : size();
+	}
+
+	// Position of the first key not less than key.
+	size_type lower_index(const K& key) const
+	{
+		return size_type(tdk_branchless_lower_bound(m_keys.data(), m_keys.size(),
+			key, m_less) - m_keys.data());
+	}
+
+	// Replaces the content with the (key, value) pairs of [firstIt, lastIt).
+	// Of equal keys the last one wins. The range is walked twice, once to
+	// count it, so ForwardIt must be at least a forward iterator; the same
+	// holds for merge().
+	template<typename ForwardIt>
+	tdk_ret build(ForwardIt firstIt, ForwardIt lastIt, tdk_err* pErrorCode = nullptr)
+	{
+		tdk_flat_map batch(m_less);
+		tdk_ret retVal = batch.build_sorted(firstIt, lastIt, pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		swap(batch);
+		return kTDK_OK;
+	}
+
+	// Adds the (key, value) pairs of [firstIt, lastIt) in one pass over the
+	// map. Values of keys already present are replaced, of equal keys in
+	// the batch the last one wins.
+	template<typename ForwardIt>
+	tdk_ret merge(ForwardIt firstIt, ForwardIt lastIt, tdk_err* pErrorCode = nullptr)
+	{
+		tdk_flat_map batch(m_less);
+		tdk_ret retVal = batch.build_sorted(firstIt, lastIt, pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		tdk_flat_map result(m_less);
+		retVal = result.reserve(size() + batch.size(), pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		size_type i = 0;
+		size_type j = 0;
+		while (i < size() && j < batch.size())
+		{
+			if (m_less(m_keys[i], batch.m_keys[j]))
+			{
+				result.append(m_keys[i], m_values[i]);
+				++i;
+			}
+			else
+			{
+				// equal keys take the value from the batch
+				if (!m_less(batch.m_keys[j], m_keys[i]))
+					++i;
+				result.append(batch.m_keys[j], batch.m_values[j]);
+				++j;
+			}
+		}
+		for (; i < size(); ++i)
+			result.append(m_keys[i], m_values[i]);
+		for (; j < batch.size(); ++j)
+			result.append(batch.m_keys[j], batch.m_values[j]);
+
+		swap(result);
+		return kTDK_OK;
+	}
+
+	tdk_ret reserve(size_type nCount, tdk_err* pErrorCode = nullptr)
+	{
+		tdk_ret retVal = m_keys.reserve(nCount, pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+		return m_values.reserve(nCount, pErrorCode);
+	}
+
+	void clear()
+	{
+		m_keys.clear();
+		m_values.clear();
+	}
+
+	void swap(tdk_flat_map& oth) noexcept
+	{
+		m_keys.swap(oth.m_keys);
+		m_values.swap(oth.m_values);
+		std::swap(m_less, oth.m_less);
+	}
+
+	// sorted keys, values[i] belongs to keys[i]
+	const tdk_darray<K>& keys() const
+	{
+		return m_keys;
+	}
+
+	const tdk_darray<V>& values() const
+	{
+		return m_values;
+	}
+
+	V& value_at(size_type idx)
+	{
+		return m_values[idx];
+	}
+
+	const V& value_at(size_type idx) const
+	{
+		return m_values[idx];
+	}
+
+	size_type size() const
+	{
+		return m_keys.size();
+	}
+
+	bool empty() const
+	{
+		return m_keys.empty();
+	}
+
+private:
+	tdk_ret insert_at(size_type idx, const K& key, const V& val,
+		tdk_err* pErrorCode)
+	{
+		tdk_ret retVal = m_keys.insert(m_keys.begin() + idx, &key, &key + 1,
+			pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		retVal = m_values.insert(m_values.begin() + idx, &val, &val + 1,
+			pErrorCode);
+		if (kTDK_OK != retVal)
+			m_keys.erase(m_keys.begin() + idx);
+		return retVal;
+	}
+
+	// only after reserve()
+	void append(const K& key, const V& val)
+	{
+		m_keys.push_back(key);
+		m_values.push_back(val);
+	}
+
+	template<typename ForwardIt>
+	tdk_ret build_sorted(ForwardIt firstIt, ForwardIt lastIt, tdk_err* pErrorCode)
+	{
+		static_assert(std::is_base_of_v<std::forward_iterator_tag,
+			typename std::iterator_traits<ForwardIt>::iterator_category>,
+			"the range is counted before it is copied");
+
+		tdk_darray<std::pair<K, V>> items;
+		tdk_ret retVal = items.reserve(std::distance(firstIt, lastIt), pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		for (; firstIt != lastIt; ++firstIt)
+			items.push_back(std::pair<K, V>(firstIt->first, firstIt->second));
+
+		// stable, so "the last one wins" holds for equal keys
+		std::stable_sort(items.begin(), items.end(),
+			[this](const std::pair<K, V>& a, const std::pair<K, V>& b)
+			{
+				return m_less(a.first, b.first);
+			});
+
+		retVal = reserve(items.size(), pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		for (size_type i = 0; i < items.size(); ++i)
+		{
+			if (i + 1 < items.size() && !m_less(items[i].first, items[i + 1].first))
+				continue;
+			m_keys.push_back(std::move(items[i].first));
+			m_values.push_back(std::move(items[i].second));
+		}
+		return kTDK_OK;
+	}
+
+	tdk_darray<K> m_keys;
+	tdk_darray<V> m_values;
+	Less m_less;
+};
+
+//-----------------------------------------------------------------------------
+// Sorted set on the same scheme as tdk_flat_map.
+template<typename K, typename Less = std::less<K>>
+class tdk_flat_set
+{
+public:
+	typedef tdk_size size_type;
+	typedef K key_type;
+	typedef const K* const_iterator;
+
+	tdk_flat_set() = default;
+
+	explicit tdk_flat_set(const Less& less)
+		: m_less(less)
+	{
+	}
+
+	tdk_flat_set(const tdk_flat_set&) = delete;
+	tdk_flat_set& operator=(const tdk_flat_set&) = delete;
+
+	// Returns kTDK_OK if key was inserted, kTDK_NO if it was there already.
+	tdk_ret insert(const K& key, tdk_err* pErrorCode = nullptr)
+	{
+		size_type idx = lower_index(key);
+		if (idx < size() && !m_less(key, m_keys[idx]))
+			return kTDK_NO;
+		return m_keys.insert(m_keys.begin() + idx, &key, &key + 1, pErrorCode);
+	}
+
+	// Returns kTDK_OK if key was erased, kTDK_NO if it was not there.
+	tdk_ret erase(const K& key)
+	{
+		size_type idx = index_of(key);
+		if (idx == size())
+			return kTDK_NO;
+
+		m_keys.erase(m_keys.begin() + idx);
+		return kTDK_OK;
+	}
+
+	bool contains(const K& key) const
+	{
+		return index_of(key) < size();
+	}
+
+	// Position of key in begin()..end(), size() if it is absent.
+	size_type index_of(const K& key) const
+	{
+		size_type idx = lower_index(key);
+		return idx < size() && !m_less(key, m_keys[idx]) ? idx : size();
+	}
+
+	// Position of the first key not less than key.
+	size_type lower_index(const K& key) const
+	{
+		return size_type(tdk_branchless_lower_bound(m_keys.data(), m_keys.size(),
+			key, m_less) - m_keys.data());
+	}
+
+	// Replaces the content with the keys of [firstIt, lastIt), which is
+	// walked twice as in tdk_flat_map::build().
+	template<typename ForwardIt>
+	tdk_ret build(ForwardIt firstIt, ForwardIt lastIt, tdk_err* pErrorCode = nullptr)
+	{
+		tdk_flat_set batch(m_less);
+		tdk_ret retVal = batch.build_sorted(firstIt, lastIt, pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		swap(batch);
+		return kTDK_OK;
+	}
+
+	// Adds the keys of [firstIt, lastIt) in one pass over the set.
+	template<typename ForwardIt>
+	tdk_ret merge(ForwardIt firstIt, ForwardIt lastIt, tdk_err* pErrorCode = nullptr)
+	{
+		tdk_flat_set batch(m_less);
+		tdk_ret retVal = batch.build_sorted(firstIt, lastIt, pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		tdk_flat_set result(m_less);
+		retVal = result.reserve(size() + batch.size(), pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		size_type i = 0;
+		size_type j = 0;
+		while (i < size() && j < batch.size())
+		{
+			if (m_less(m_keys[i], batch.m_keys[j]))
+			{
+				result.m_keys.push_back(m_keys[i++]);
+			}
+			else
+			{
+				if (!m_less(batch.m_keys[j], m_keys[i]))
+					++i;
+				result.m_keys.push_back(batch.m_keys[j++]);
+			}
+		}
+		for (; i < size(); ++i)
+			result.m_keys.push_back(m_keys[i]);
+		for (; j < batch.size(); ++j)
+			result.m_keys.push_back(batch.m_keys[j]);
+
+		swap(result);
+		return kTDK_OK;
+	}
+
+	tdk_ret reserve(size_type nCount, tdk_err* pErrorCode = nullptr)
+	{
+		return m_keys.reserve(nCount, pErrorCode);
+	}
+
+	void clear()
+	{
+		m_keys.clear();
+	}
+
+	void swap(tdk_flat_set& oth) noexcept
+	{
+		m_keys.swap(oth.m_keys);
+		std::swap(m_less, oth.m_less);
+	}
+
+	const K* data() const
+	{
+		return m_keys.data();
+	}
+
+	const_iterator begin() const
+	{
+		return m_keys.begin();
+	}
+
+	const_iterator end() const
+	{
+		return m_keys.end();
+	}
+
+	size_type size() const
+	{
+		return m_keys.size();
+	}
+
+	bool empty() const
+	{
+		return m_keys.empty();
+	}
+
+private:
+	template<typename ForwardIt>
+	tdk_ret build_sorted(ForwardIt firstIt, ForwardIt lastIt, tdk_err* pErrorCode)
+	{
+		static_assert(std::is_base_of_v<std::forward_iterator_tag,
+			typename std::iterator_traits<ForwardIt>::iterator_category>,
+			"the range is counted before it is copied");
+
+		tdk_ret retVal = m_keys.reserve(std::distance(firstIt, lastIt), pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		for (; firstIt != lastIt; ++firstIt)
+			m_keys.push_back(*firstIt);
+
+		std::sort(m_keys.begin(), m_keys.end(), m_less);
+		auto itUnique = std::unique(m_keys.begin(), m_keys.end(),
+			[this](const K& a, const K& b)
+			{
+				return !m_less(a, b);
+			});
+		m_keys.erase(itUnique, m_keys.end());
+		return kTDK_OK;
+	}
+
+	tdk_darray<K> m_keys;
+	Less m_less;
+};
+
+#endif //TDK_FLATMAP_H
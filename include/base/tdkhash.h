@@ -0,0 +1,164 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: hash functions and functors.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_HASH_H
+#define TDK_HASH_H
+
+#include "base/tdkbasedefs.h"
+
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Final mixer of MurmurHash3. Spreads every input bit over the whole result,
+// so the low bits are usable even for sequential integer keys.
+constexpr tdk_u64 tdk_hash_mix(tdk_u64 h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+inline tdk_u64 tdk_hash_combine(tdk_u64 seed, tdk_u64 h)
+{
+	return tdk_hash_mix(seed ^ (h + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2)));
+}
+
+// Hash of a byte range, 8 bytes per step. Not cryptographic, also fine as a
+// checksum against accidental damage.
+inline tdk_u64 tdk_hash_bytes(const void* pData, tdk_size nBytes, tdk_u64 seed = 0)
+{
+	const tdk_u64 kMUL = 0x9e3779b97f4a7c15ull;
+	const tdk_byte* pBytes = static_cast<const tdk_byte*>(pData);
+	tdk_u64 h = seed ^ (nBytes * kMUL);
+
+	for (; nBytes >= 8; nBytes -= 8, pBytes += 8)
+	{
+		tdk_u64 chunk;
+		std::memcpy(&chunk, pBytes, 8);
+		h = (h ^ tdk_hash_mix(chunk)) * kMUL;
+		h = (h << 31) | (h >> 33);
+	}
+
+	if (nBytes)
+	{
+		tdk_u64 chunk = 0;
+		std::memcpy(&chunk, pBytes, nBytes);
+		h = (h ^ tdk_hash_mix(chunk)) * kMUL;
+	}
+	return tdk_hash_mix(h);
+}
+
+//-----------------------------------------------------------------------------
+// Hash functors for tdk containers. std::hash of an integer is the integer
+// itself, open addressing needs the extra mixing.
+
+template<typename T>
+struct tdk_hash
+{
+	tdk_size operator()(const T& val) const
+	{
+		return tdk_size(tdk_hash_mix(std::hash<T>()(val)));
+	}
+};
+
+// Strings hash their characters. Transparent: a map keyed by std::string is
+// searched with a string_view or a literal without building a std::string.
+struct tdk_string_hash
+{
+	using is_transparent = void;
+
+	tdk_size operator()(std::string_view str) const
+	{
+		return tdk_size(tdk_hash_bytes(str.data(), str.size()));
+	}
+};
+
+template<>
+struct tdk_hash<std::string> : tdk_string_hash
+{
+};
+
+template<>
+struct tdk_hash<std::string_view> : tdk_string_hash
+{
+};
+
+template<typename T>
+struct tdk_equal_to
+{
+	bool operator()(const T& a, const T& b) const
+	{
+		return a == b;
+	}
+};
+
+struct tdk_string_equal_to
+{
+	using is_transparent = void;
+
+	bool operator()(std::string_view a, std::string_view b) const
+	{
+		return a == b;
+	}
+};
+
+template<>
+struct tdk_equal_to<std::string> : tdk_string_equal_to
+{
+};
+
+template<>
+struct tdk_equal_to<std::string_view> : tdk_string_equal_to
+{
+};
+
+#endif //TDK_HASH_H
@@ -0,0 +1,840 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: open addressing hash map.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_HASHMAP_H
+#define TDK_HASHMAP_H
+
+#include "base/tdkbasedefs.h"
+#include "base/tdkbaseutl.h"
+#include "base/tdkhash.h"
+#include "base/tdkmemalloc.h"
+
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	include <emmintrin.h>
+#	define TDK_HASHMAP_SSE2
+#endif
+
+//-----------------------------------------------------------------------------
+// Control bytes of tdk_hashmap. A full slot keeps the low 7 bits of its hash
+// (high bit clear), free slots have the high bit set.
+
+enum tdk_hashmap_ctrl : tdk_byte
+{
+	kTDK_CTRL_EMPTY = 0x80,
+	kTDK_CTRL_DELETED = 0xFE,
+};
+
+// 16 control bytes examined at once. Every match function returns a bit
+// mask, bit i stands for byte i.
+class tdk_hashmap_group
+{
+public:
+	enum Constants
+	{
+		kWIDTH = 16
+	};
+
+	explicit tdk_hashmap_group(const tdk_byte* pCtrl)
+	{
+#ifdef TDK_HASHMAP_SSE2
+		m_ctrl = _mm_load_si128(reinterpret_cast<const __m128i*>(pCtrl));
+#else
+		std::memcpy(m_ctrl, pCtrl, kWIDTH);
+#endif
+	}
+
+	tdk_u32 match(tdk_byte h2) const
+	{
+#ifdef TDK_HASHMAP_SSE2
+		return tdk_u32(_mm_movemask_epi8(
+			_mm_cmpeq_epi8(_mm_set1_epi8(char(h2)), m_ctrl)));
+#else
+		return match_scalar([h2](tdk_byte c) { return c == h2; });
+#endif
+	}
+
+	tdk_u32 match_empty() const
+	{
+		return match(kTDK_CTRL_EMPTY);
+	}
+
+	tdk_u32 match_empty_or_deleted() const
+	{
+#ifdef TDK_HASHMAP_SSE2
+		return tdk_u32(_mm_movemask_epi8(m_ctrl));
+#else
+		return match_scalar([](tdk_byte c) { return 0 != (c & 0x80); });
+#endif
+	}
+
+private:
+#ifdef TDK_HASHMAP_SSE2
+	__m128i m_ctrl;
+#else
+	template<typename Pred>
+	tdk_u32 match_scalar(const Pred& pred) const
+	{
+		tdk_u32 nMask = 0;
+		for (tdk_u32 i = 0; i < kWIDTH; ++i)
+			nMask |= tdk_u32(pred(m_ctrl[i])) << i;
+		return nMask;
+	}
+
+	tdk_byte m_ctrl[kWIDTH];
+#endif
+};
+
+// Control bytes of a map without memory: lookups see one empty group and
+// stop without a special case for the empty table.
+struct tdk_hashmap_empty_group
+{
+	alignas(16) static constexpr tdk_byte kCTRL[tdk_hashmap_group::kWIDTH] = {
+		kTDK_CTRL_EMPTY, kTDK_CTRL_EMPTY, kTDK_CTRL_EMPTY, kTDK_CTRL_EMPTY,
+		kTDK_CTRL_EMPTY, kTDK_CTRL_EMPTY, kTDK_CTRL_EMPTY, kTDK_CTRL_EMPTY,
+		kTDK_CTRL_EMPTY, kTDK_CTRL_EMPTY, kTDK_CTRL_EMPTY, kTDK_CTRL_EMPTY,
+		kTDK_CTRL_EMPTY, kTDK_CTRL_EMPTY, kTDK_CTRL_EMPTY, kTDK_CTRL_EMPTY };
+};
+
+// Lookup argument type: the caller's type for a transparent Hash and KeyEq,
+// the key type otherwise. Two aliases of a plain parameter instead of one
+// std::conditional_t, so that the caller's type is still deduced.
+template<bool kTransparent>
+struct tdk_hashmap_key_arg
+{
+	template<typename LookupKey, typename Key>
+	using type = LookupKey;
+};
+
+template<>
+struct tdk_hashmap_key_arg<false>
+{
+	template<typename LookupKey, typename Key>
+	using type = Key;
+};
+
+//-----------------------------------------------------------------------------
+// Open addressing hash map (Swiss table). Control bytes and slots share one
+// buffer: [capacity control bytes][slots]. A lookup reads one 16-byte group
+// of control bytes, compares 7 hash bits of all 16 entries at once and
+// touches a slot only on a hash match, so a hit usually costs two cache
+// misses and a miss one.
+//
+// The capacity is a power of two, at least one group. Up to 7/8 of it is
+// used before the table grows. Erased entries become tombstones unless their
+// group still has an empty byte; tombstones are reused by inserts and
+// dropped on rehash.
+//
+// Hash and KeyEq with an is_transparent member allow lookups by any type
+// they accept (a string_view for std::string keys, see tdk_hash).
+//
+// Any insert may rehash and invalidates iterators and pointers to elements.
+// Erase invalidates only the erased element.
+template<typename K, typename V, typename Hash = tdk_hash<K>,
+	typename KeyEq = tdk_equal_to<K>, typename Allocator = tdk_allocator<tdk_byte>>
+class tdk_hashmap
+{
+public:
+	typedef tdk_size size_type;
+	typedef tdk_diff difference_type;
+
+	typedef K key_type;
+	typedef V mapped_type;
+	typedef std::pair<const K, V> value_type;
+	typedef Hash hasher;
+	typedef KeyEq key_equal;
+	typedef Allocator allocator_type;
+
+	typedef value_type& reference;
+	typedef const value_type& const_reference;
+	typedef value_type* pointer;
+	typedef const value_type* const_pointer;
+
+private:
+	using AllocatorForBytes = typename
+		std::allocator_traits<Allocator>::template rebind_alloc<tdk_byte>;
+
+	static_assert(alignof(value_type) <= tdk_hashmap_group::kWIDTH,
+		"tdk_hashmap does not support over-aligned elements");
+
+	template<typename T, typename = void>
+	struct is_transparent : std::false_type
+	{
+	};
+
+	template<typename T>
+	struct is_transparent<T, std::void_t<typename T::is_transparent>> : std::true_type
+	{
+	};
+
+	static constexpr bool kTRANSPARENT =
+		is_transparent<Hash>::value && is_transparent<KeyEq>::value;
+
+	template<typename LookupKey>
+	using key_arg = typename tdk_hashmap_key_arg<kTRANSPARENT>::template
+		type<LookupKey, K>;
+
+	template<bool kConst>
+	class iterator_base
+	{
+		friend class tdk_hashmap;
+		friend class iterator_base<!kConst>;
+
+		using Slot = typename tdk_hashmap::value_type;
+		using SlotPointer = std::conditional_t<kConst, const Slot*, Slot*>;
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef Slot value_type;
+		typedef tdk_diff difference_type;
+		typedef SlotPointer pointer;
+		typedef std::conditional_t<kConst, const Slot&, Slot&> reference;
+
+		iterator_base() = default;
+
+		// iterator to const_iterator
+		template<bool kOthConst, typename = std::enable_if_t<kConst && !kOthConst>>
+		iterator_base(const iterator_base<kOthConst>& oth)
+			: m_pCtrl(oth.m_pCtrl)
+			, m_pSlot(oth.m_pSlot)
+			, m_pCtrlEnd(oth.m_pCtrlEnd)
+		{
+		}
+
+		reference operator*() const
+		{
+			return *m_pSlot;
+		}
+
+		pointer operator->() const
+		{
+			return m_pSlot;
+		}
+
+		iterator_base& operator++()
+		{
+			++m_pCtrl;
+			++m_pSlot;
+			skip_free();
+			return *this;
+		}
+
+		iterator_base operator++(int)
+		{
+			iterator_base tmp = *this;
+			++*this;
+			return tmp;
+		}
+
+		friend bool operator==(const iterator_base& a, const iterator_base& b)
+		{
+			return a.m_pCtrl == b.m_pCtrl;
+		}
+
+		friend bool operator!=(const iterator_base& a, const iterator_base& b)
+		{
+			return a.m_pCtrl != b.m_pCtrl;
+		}
+
+	private:
+		iterator_base(const tdk_byte* pCtrl, SlotPointer pSlot, const tdk_byte* pCtrlEnd)
+			: m_pCtrl(pCtrl)
+			, m_pSlot(pSlot)
+			, m_pCtrlEnd(pCtrlEnd)
+		{
+		}
+
+		void skip_free()
+		{
+			while (m_pCtrl != m_pCtrlEnd && is_free(*m_pCtrl))
+			{
+				++m_pCtrl;
+				++m_pSlot;
+			}
+		}
+
+		const tdk_byte* m_pCtrl = nullptr;
+		SlotPointer m_pSlot = nullptr;
+		const tdk_byte* m_pCtrlEnd = nullptr;
+	};
+
+public:
+	typedef iterator_base<false> iterator;
+	typedef iterator_base<true> const_iterator;
+
+	tdk_hashmap()
+		: m_pCtrl(const_cast<tdk_byte*>(tdk_hashmap_empty_group::kCTRL))
+		, m_pSlots(nullptr)
+		, m_nCapacity(0)
+		, m_nCount(0)
+		, m_nGrowthLeft(0)
+	{
+
+	}
+
+	// Leaves the map empty if the memory cannot be allocated, use assign()
+	// to get the error.
+	tdk_hashmap(const tdk_hashmap& oth)
+		: tdk_hashmap()
+	{
+		assign(oth);
+	}
+
+	tdk_hashmap(tdk_hashmap&& oth) noexcept
+		: tdk_hashmap()
+	{
+		swap(oth);
+	}
+
+	~tdk_hashmap()
+	{
+		clear();
+		free_table(m_pCtrl, m_nCapacity);
+	}
+
+	tdk_hashmap& operator=(const tdk_hashmap& oth)
+	{
+		if (this != &oth)
+			assign(oth);
+		return *this;
+	}
+
+	tdk_hashmap& operator=(tdk_hashmap&& oth) noexcept
+	{
+		tdk_hashmap tmp(std::move(oth));
+		swap(tmp);
+		return *this;
+	}
+
+	void swap(tdk_hashmap& oth) noexcept
+	{
+		std::swap(m_pCtrl, oth.m_pCtrl);
+		std::swap(m_pSlots, oth.m_pSlots);
+		std::swap(m_nCapacity, oth.m_nCapacity);
+		std::swap(m_nCount, oth.m_nCount);
+		std::swap(m_nGrowthLeft, oth.m_nGrowthLeft);
+	}
+
+	tdk_ret assign(const tdk_hashmap& oth, tdk_err* pErrorCode = nullptr)
+	{
+		if (this == &oth)
+			return kTDK_OK;
+
+		tdk_hashmap tmp;
+		tdk_ret retVal = tmp.reserve(oth.m_nCount, pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		for (const value_type& val : oth)
+		{
+			size_type nHash = hasher()(val.first);
+			tmp.construct_slot(tmp.find_free_slot(nHash), nHash, val.first, val.second);
+		}
+		swap(tmp);
+		return kTDK_OK;
+	}
+
+	// Destroys the elements, keeps the memory.
+	void clear()
+	{
+		if (!m_nCount && m_nGrowthLeft == growth_limit(m_nCapacity))
+			return;
+
+		for (size_type idx = 0; idx < m_nCapacity; ++idx)
+		{
+			if (!is_free(m_pCtrl[idx]))
+				m_pSlots[idx].~value_type();
+		}
+		if (m_nCapacity)
+			std::memset(m_pCtrl, kTDK_CTRL_EMPTY, m_nCapacity);
+		m_nCount = 0;
+		m_nGrowthLeft = growth_limit(m_nCapacity);
+	}
+
+	// Makes room for nCount elements without rehashing.
+	tdk_ret reserve(size_type nCount, tdk_err* pErrorCode = nullptr)
+	{
+		if (nCount <= m_nCount + m_nGrowthLeft)
+			return kTDK_OK;
+		return rehash(capacity_for(nCount, pErrorCode), pErrorCode);
+	}
+
+	// Returns kTDK_OK if the element was inserted, kTDK_NO if the key was
+	// already there (val is not used then).
+	template<typename KeyArg, typename ValArg>
+	tdk_ret insert(KeyArg&& key, ValArg&& val, tdk_err* pErrorCode = nullptr)
+	{
+		size_type idx = 0;
+		size_type nHash = 0;
+		tdk_ret retVal = find_or_prepare_insert(key, idx, nHash, pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		construct_slot(idx, nHash, std::forward<KeyArg>(key), std::forward<ValArg>(val));
+		return kTDK_OK;
+	}
+
+	// Returns kTDK_OK if the element was inserted, kTDK_NO if the value of an
+	// existing key was replaced.
+	template<typename KeyArg, typename ValArg>
+	tdk_ret insert_or_assign(KeyArg&& key, ValArg&& val, tdk_err* pErrorCode = nullptr)
+	{
+		size_type idx = 0;
+		size_type nHash = 0;
+		tdk_ret retVal = find_or_prepare_insert(key, idx, nHash, pErrorCode);
+		if (kTDK_NO == retVal)
+		{
+			m_pSlots[idx].second = std::forward<ValArg>(val);
+			return kTDK_NO;
+		}
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		construct_slot(idx, nHash, std::forward<KeyArg>(key), std::forward<ValArg>(val));
+		return kTDK_OK;
+	}
+
+	// The value of key, a value-initialized one is inserted if there is none.
+	// nullptr if the memory cannot be allocated.
+	template<typename KeyArg>
+	V* find_or_insert(KeyArg&& key, tdk_err* pErrorCode = nullptr)
+	{
+		size_type idx = 0;
+		size_type nHash = 0;
+		tdk_ret retVal = find_or_prepare_insert(key, idx, nHash, pErrorCode);
+		if (kTDK_OK == retVal)
+			construct_slot(idx, nHash, std::forward<KeyArg>(key));
+		else if (kTDK_NO != retVal)
+			return nullptr;
+		return &m_pSlots[idx].second;
+	}
+
+	template<typename LookupKey = K>
+	iterator find(const key_arg<LookupKey>& key)
+	{
+		size_type idx = find_index(key, hasher()(key));
+		if (idx == m_nCapacity)
+			return end();
+		return iterator(m_pCtrl + idx, m_pSlots + idx, m_pCtrl + m_nCapacity);
+	}
+
+	template<typename LookupKey = K>
+	const_iterator find(const key_arg<LookupKey>& key) const
+	{
+		return const_cast<tdk_hashmap*>(this)->template find<LookupKey>(key);
+	}
+
+	// Pointer to the value of key, nullptr if there is no such key.
+	template<typename LookupKey = K>
+	V* at(const key_arg<LookupKey>& key)
+	{
+		size_type idx = find_index(key, hasher()(key));
+		return idx == m_nCapacity ? nullptr : &m_pSlots[idx].second;
+	}
+
+	template<typename LookupKey = K>
+	const V* at(const key_arg<LookupKey>& key) const
+	{
+		return const_cast<tdk_hashmap*>(this)->template at<LookupKey>(key);
+	}
+
+	template<typename LookupKey = K>
+	bool contains(const key_arg<LookupKey>& key) const
+	{
+		return find_index(key, hasher()(key)) != m_nCapacity;
+	}
+
+	// Returns kTDK_OK if the key was erased, kTDK_NO if there was no such key.
+	template<typename LookupKey = K>
+	tdk_ret erase(const key_arg<LookupKey>& key)
+	{
+		size_type idx = find_index(key, hasher()(key));
+		if (idx == m_nCapacity)
+			return kTDK_NO;
+		erase_slot(idx);
+		return kTDK_OK;
+	}
+
+	// Returns the iterator to the element that followed the erased one.
+	iterator erase(const_iterator pos)
+	{
+		assert(pos != end());
+		size_type idx = pos.m_pCtrl - m_pCtrl;
+		erase_slot(idx);
+		iterator next(m_pCtrl + idx, m_pSlots + idx, m_pCtrl + m_nCapacity);
+		next.skip_free();
+		return next;
+	}
+
+	iterator begin()
+	{
+		iterator it(m_pCtrl, m_pSlots, m_pCtrl + m_nCapacity);
+		it.skip_free();
+		return it;
+	}
+
+	const_iterator begin() const
+	{
+		return const_cast<tdk_hashmap*>(this)->begin();
+	}
+
+	const_iterator cbegin() const
+	{
+		return begin();
+	}
+
+	iterator end()
+	{
+		return iterator(m_pCtrl + m_nCapacity, m_pSlots + m_nCapacity,
+			m_pCtrl + m_nCapacity);
+	}
+
+	const_iterator end() const
+	{
+		return const_cast<tdk_hashmap*>(this)->end();
+	}
+
+	const_iterator cend() const
+	{
+		return end();
+	}
+
+	bool empty() const
+	{
+		return 0 == m_nCount;
+	}
+
+	size_type size() const
+	{
+		return m_nCount;
+	}
+
+	size_type capacity() const
+	{
+		return m_nCapacity;
+	}
+
+	static constexpr size_type max_size()
+	{
+		return growth_limit(max_capacity());
+	}
+
+	hasher hash_function() const
+	{
+		return hasher();
+	}
+
+	key_equal key_eq() const
+	{
+		return key_equal();
+	}
+
+	allocator_type get_allocator() const
+	{
+		return allocator_type();
+	}
+private:
+	enum
+	{
+		kGROUP = tdk_hashmap_group::kWIDTH
+	};
+
+	static bool is_free(tdk_byte ctrl)
+	{
+		return 0 != (ctrl & 0x80);
+	}
+
+	// The high hash bits pick the group, the low 7 bits go to the control byte.
+	static size_type h1(size_type nHash)
+	{
+		return nHash >> 7;
+	}
+
+	static tdk_byte h2(size_type nHash)
+	{
+		return tdk_byte(nHash & 0x7F);
+	}
+
+	static constexpr size_type growth_limit(size_type nCapacity)
+	{
+		return nCapacity - nCapacity / 8;
+	}
+
+	static constexpr size_type slots_offset(size_type nCapacity)
+	{
+		return (nCapacity + alignof(value_type) - 1) & ~(alignof(value_type) - 1);
+	}
+
+	static constexpr size_type max_capacity()
+	{
+		// the largest power of two whose buffer size does not overflow
+		size_type nCap = kGROUP;
+		while (nCap <= (size_type(-1) / 2 - kGROUP) / (sizeof(value_type) + 1) / 2)
+			nCap *= 2;
+		return nCap;
+	}
+
+	static size_type buffer_bytes(size_type nCapacity)
+	{
+		return slots_offset(nCapacity) + nCapacity * sizeof(value_type);
+	}
+
+	// The smallest capacity that holds nCount elements below the load limit,
+	// 0 on overflow.
+	static size_type capacity_for(size_type nCount, tdk_err* pErrorCode)
+	{
+		size_type nCap = kGROUP;
+		while (growth_limit(nCap) < nCount)
+		{
+			if (nCap >= max_capacity())
+			{
+				tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+				return 0;
+			}
+			nCap *= 2;
+		}
+		return nCap;
+	}
+
+	// Visits every group once: group offsets 0, 1, 3, 6, 10... over a power of
+	// two group count.
+	class probe_seq
+	{
+	public:
+		probe_seq(size_type nHash, size_type nGroupMask)
+			: m_nGroup(h1(nHash) & nGroupMask)
+			, m_nGroupMask(nGroupMask)
+			, m_nStep(0)
+		{
+		}
+
+		size_type offset() const
+		{
+			return m_nGroup * kGROUP;
+		}
+
+		void next()
+		{
+			++m_nStep;
+			m_nGroup = (m_nGroup + m_nStep) & m_nGroupMask;
+		}
+
+	private:
+		size_type m_nGroup;
+		size_type m_nGroupMask;
+		size_type m_nStep;
+	};
+
+	size_type group_mask() const
+	{
+		// an empty map probes the single static group
+		return m_nCapacity ? m_nCapacity / kGROUP - 1 : 0;
+	}
+
+	// Slot index of key, m_nCapacity if there is none.
+	template<typename LookupKey>
+	size_type find_index(const LookupKey& key, size_type nHash) const
+	{
+		tdk_byte nH2 = h2(nHash);
+		for (probe_seq seq(nHash, group_mask());; seq.next())
+		{
+			tdk_hashmap_group group(m_pCtrl + seq.offset());
+			for (tdk_u32 nMask = group.match(nH2); nMask; nMask &= nMask - 1)
+			{
+				size_type idx = seq.offset() + tdk_count_trailing_zeros(nMask);
+				if (key_equal()(m_pSlots[idx].first, key))
+					return idx;
+			}
+			if (group.match_empty())
+				return m_nCapacity;
+		}
+	}
+
+	// First empty or deleted slot on the probe sequence of nHash.
+	size_type find_free_slot(size_type nHash) const
+	{
+		for (probe_seq seq(nHash, group_mask());; seq.next())
+		{
+			tdk_u32 nMask = tdk_hashmap_group(m_pCtrl + seq.offset()).match_empty_or_deleted();
+			if (nMask)
+				return seq.offset() + tdk_count_trailing_zeros(nMask);
+		}
+	}
+
+	// kTDK_NO and the slot of key if it is there, kTDK_OK and a free slot
+	// to construct it in otherwise.
+	template<typename LookupKey>
+	tdk_ret find_or_prepare_insert(const LookupKey& key, size_type& idx,
+		size_type& nHash, tdk_err* pErrorCode)
+	{
+		nHash = hasher()(key);
+		idx = find_index(key, nHash);
+		if (idx != m_nCapacity)
+			return kTDK_NO;
+
+		idx = find_free_slot(nHash);
+		if (!m_nGrowthLeft && kTDK_CTRL_DELETED != m_pCtrl[idx])
+		{
+			// many tombstones: clean up in place, otherwise double
+			size_type nNewCap = m_nCount + 1 <= growth_limit(m_nCapacity) / 2 ?
+				m_nCapacity : capacity_for(m_nCount + 1, pErrorCode);
+			tdk_ret retVal = rehash(nNewCap, pErrorCode);
+			if (kTDK_OK != retVal)
+				return retVal;
+			idx = find_free_slot(nHash);
+		}
+		return kTDK_OK;
+	}
+
+	template<typename KeyArg, typename... Args>
+	void construct_slot(size_type idx, size_type nHash, KeyArg&& key, Args&&... args)
+	{
+		assert(is_free(m_pCtrl[idx]));
+		::new (static_cast<void*>(m_pSlots + idx)) value_type(std::piecewise_construct,
+			std::forward_as_tuple(std::forward<KeyArg>(key)),
+			std::forward_as_tuple(std::forward<Args>(args)...));
+		if (kTDK_CTRL_EMPTY == m_pCtrl[idx])
+			--m_nGrowthLeft;
+		m_pCtrl[idx] = h2(nHash);
+		++m_nCount;
+	}
+
+	void erase_slot(size_type idx)
+	{
+		m_pSlots[idx].~value_type();
+		--m_nCount;
+
+		// A probe passes a group only if the group has no empty byte. If ours
+		// has one, nobody probed past it and the slot can become empty again.
+		size_type nGroupStart = idx & ~size_type(kGROUP - 1);
+		if (tdk_hashmap_group(m_pCtrl + nGroupStart).match_empty())
+		{
+			m_pCtrl[idx] = kTDK_CTRL_EMPTY;
+			++m_nGrowthLeft;
+		}
+		else
+		{
+			m_pCtrl[idx] = kTDK_CTRL_DELETED;
+		}
+	}
+
+	tdk_ret rehash(size_type nNewCap, tdk_err* pErrorCode)
+	{
+		if (!nNewCap)
+			return kTDK_FATAL;
+
+		tdk_byte* pNewCtrl = AllocatorForBytes().allocate(buffer_bytes(nNewCap));
+		if (!pNewCtrl)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+			return kTDK_FATAL;
+		}
+		assert(0 == reinterpret_cast<uintptr_t>(pNewCtrl) % kGROUP);
+		std::memset(pNewCtrl, kTDK_CTRL_EMPTY, nNewCap);
+
+		tdk_byte* pOldCtrl = m_pCtrl;
+		value_type* pOldSlots = m_pSlots;
+		size_type nOldCap = m_nCapacity;
+
+		m_pCtrl = pNewCtrl;
+		m_pSlots = reinterpret_cast<value_type*>(pNewCtrl + slots_offset(nNewCap));
+		m_nCapacity = nNewCap;
+		m_nGrowthLeft = growth_limit(nNewCap) - m_nCount;
+
+		for (size_type idxOld = 0; idxOld < nOldCap; ++idxOld)
+		{
+			if (is_free(pOldCtrl[idxOld]))
+				continue;
+
+			value_type* pOld = pOldSlots + idxOld;
+			size_type nHash = hasher()(pOld->first);
+			size_type idx = find_free_slot(nHash);
+			m_pCtrl[idx] = h2(nHash);
+			relocate_slot(m_pSlots + idx, pOld);
+		}
+
+		free_table(pOldCtrl, nOldCap);
+		return kTDK_OK;
+	}
+
+	static void relocate_slot(value_type* pDst, value_type* pSrc)
+	{
+		if constexpr (std::is_trivially_copy_constructible_v<value_type> &&
+			std::is_trivially_destructible_v<value_type>)
+		{
+			std::memcpy(static_cast<void*>(pDst), pSrc, sizeof(value_type));
+		}
+		else
+		{
+			// the key is const only for the users, the old slot is dead
+			::new (static_cast<void*>(pDst)) value_type(std::piecewise_construct,
+				std::forward_as_tuple(std::move(const_cast<K&>(pSrc->first))),
+				std::forward_as_tuple(std::move(pSrc->second)));
+			pSrc->~value_type();
+		}
+	}
+
+	static void free_table(tdk_byte* pCtrl, size_type nCapacity)
+	{
+		if (nCapacity)
+			AllocatorForBytes().deallocate(pCtrl, buffer_bytes(nCapacity));
+	}
+
+	tdk_byte* m_pCtrl;
+	value_type* m_pSlots;
+	size_type m_nCapacity;
+	size_type m_nCount;
+	size_type m_nGrowthLeft; // inserts into empty slots left before a rehash
+};
+
+#endif //TDK_HASHMAP_H
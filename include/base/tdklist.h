@@ -0,0 +1,459 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: doubly linked list on a memory pool.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_LIST_H
+#define TDK_LIST_H
+
+#include "base/tdkbasedefs.h"
+#include "base/tdkbaseutl.h"
+#include "base/tdkmemorypool.h"
+
+#include <cassert>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Doubly linked list. Nodes come from a tdk_memorypool owned by the list, so
+// an insert is a free list pop and the nodes of one list stay packed in a few
+// pool blocks. Iterators and pointers stay valid until their element is
+// erased. The pool keeps the memory of erased nodes until the list dies.
+template<typename T>
+class tdk_list
+{
+	struct Links
+	{
+		Links* pPrev;
+		Links* pNext;
+	};
+
+	struct Node : Links
+	{
+		T value;
+	};
+
+	static_assert(alignof(Node) <= alignof(void*),
+		"tdk_memorypool does not align nodes beyond a pointer");
+
+	using NodePool = tdk_memorypool<sizeof(Node)>;
+
+	template<bool kConst>
+	class iterator_base
+	{
+		friend class tdk_list;
+		friend class iterator_base<!kConst>;
+
+		using LinksPointer = std::conditional_t<kConst, const Links*, Links*>;
+	public:
+		typedef std::bidirectional_iterator_tag iterator_category;
+		typedef T value_type;
+		typedef tdk_diff difference_type;
+		typedef std::conditional_t<kConst, const T*, T*> pointer;
+		typedef std::conditional_t<kConst, const T&, T&> reference;
+
+		iterator_base() = default;
+
+		// iterator to const_iterator
+		template<bool kOthConst, typename = std::enable_if_t<kConst && !kOthConst>>
+		iterator_base(const iterator_base<kOthConst>& oth)
+			: m_pLinks(oth.m_pLinks)
+		{
+		}
+
+		reference operator*() const
+		{
+			return static_cast<std::conditional_t<kConst, const Node*, Node*>>(
+				m_pLinks)->value;
+		}
+
+		pointer operator->() const
+		{
+			return &**this;
+		}
+
+		iterator_base& operator++()
+		{
+			m_pLinks = m_pLinks->pNext;
+			return *this;
+		}
+
+		iterator_base operator++(int)
+		{
+			iterator_base tmp = *this;
+			m_pLinks = m_pLinks->pNext;
+			return tmp;
+		}
+
+		iterator_base& operator--()
+		{
+			m_pLinks = m_pLinks->pPrev;
+			return *this;
+		}
+
+		iterator_base operator--(int)
+		{
+			iterator_base tmp = *this;
+			m_pLinks = m_pLinks->pPrev;
+			return tmp;
+		}
+
+		friend bool operator==(const iterator_base& a, const iterator_base& b)
+		{
+			return a.m_pLinks == b.m_pLinks;
+		}
+
+		friend bool operator!=(const iterator_base& a, const iterator_base& b)
+		{
+			return a.m_pLinks != b.m_pLinks;
+		}
+
+	private:
+		explicit iterator_base(LinksPointer pLinks)
+			: m_pLinks(pLinks)
+		{
+		}
+
+		LinksPointer m_pLinks = nullptr;
+	};
+
+public:
+	typedef tdk_size size_type;
+	typedef tdk_diff difference_type;
+
+	typedef T value_type;
+
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef iterator_base<false> iterator;
+	typedef iterator_base<true> const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	explicit tdk_list(tdk_u32 nMemoryFlags = kTDK_MEMORY_DEFAULT)
+		: m_pool(nMemoryFlags)
+		, m_nCount(0)
+	{
+		m_head.pPrev = &m_head;
+		m_head.pNext = &m_head;
+	}
+
+	// Leaves the list empty if the memory cannot be allocated, use assign()
+	// to get the error.
+	tdk_list(const tdk_list& oth)
+		: tdk_list()
+	{
+		assign(oth);
+	}
+
+	tdk_list(tdk_list&& oth) noexcept
+		: tdk_list()
+	{
+		swap(oth);
+	}
+
+	~tdk_list()
+	{
+		clear();
+	}
+
+	tdk_list& operator=(const tdk_list& oth)
+	{
+		if (this != &oth)
+			assign(oth);
+		return *this;
+	}
+
+	tdk_list& operator=(tdk_list&& oth) noexcept
+	{
+		tdk_list tmp(std::move(oth));
+		swap(tmp);
+		return *this;
+	}
+
+	// The end() iterators of both lists are invalidated.
+	void swap(tdk_list& oth) noexcept
+	{
+		m_pool.swap(oth.m_pool);
+		std::swap(m_head, oth.m_head);
+		std::swap(m_nCount, oth.m_nCount);
+		oth.fix_head();
+		fix_head();
+	}
+
+	tdk_ret assign(const tdk_list& oth, tdk_err* pErrorCode = nullptr)
+	{
+		if (this == &oth)
+			return kTDK_OK;
+
+		tdk_list tmp;
+		for (const T& val : oth)
+		{
+			tdk_ret retVal = tmp.push_back(val, pErrorCode);
+			if (kTDK_OK != retVal)
+				return retVal;
+		}
+		clear();
+		swap(tmp);
+		return kTDK_OK;
+	}
+
+	// Destroys the elements, the pool keeps the memory.
+	void clear()
+	{
+		Links* pLinks = m_head.pNext;
+		while (pLinks != &m_head)
+		{
+			Links* pNext = pLinks->pNext;
+			destroy_node(static_cast<Node*>(pLinks));
+			pLinks = pNext;
+		}
+		m_head.pPrev = &m_head;
+		m_head.pNext = &m_head;
+		m_nCount = 0;
+	}
+
+	template<typename ValArg>
+	tdk_ret push_back(ValArg&& val, tdk_err* pErrorCode = nullptr)
+	{
+		return end() != insert(end(), std::forward<ValArg>(val), pErrorCode) ?
+			kTDK_OK : kTDK_FATAL;
+	}
+
+	template<typename ValArg>
+	tdk_ret push_front(ValArg&& val, tdk_err* pErrorCode = nullptr)
+	{
+		return end() != insert(begin(), std::forward<ValArg>(val), pErrorCode) ?
+			kTDK_OK : kTDK_FATAL;
+	}
+
+	void pop_back()
+	{
+		assert(m_nCount);
+		erase(const_iterator(m_head.pPrev));
+	}
+
+	void pop_front()
+	{
+		assert(m_nCount);
+		erase(const_iterator(m_head.pNext));
+	}
+
+	// Inserts before pos. Returns the iterator to the new element, end() if
+	// the memory cannot be allocated.
+	template<typename ValArg>
+	iterator insert(const_iterator pos, ValArg&& val, tdk_err* pErrorCode = nullptr)
+	{
+		void* pMem = m_pool.allocate(pErrorCode);
+		if (!pMem)
+			return end();
+
+		Node* pNode = static_cast<Node*>(pMem);
+		::new (static_cast<void*>(&pNode->value)) T(std::forward<ValArg>(val));
+		link_before(const_cast<Links*>(pos.m_pLinks), pNode);
+		++m_nCount;
+		return iterator(pNode);
+	}
+
+	// Returns the iterator to the element that followed the erased one.
+	iterator erase(const_iterator pos)
+	{
+		assert(pos != end());
+		Links* pLinks = const_cast<Links*>(pos.m_pLinks);
+		Links* pNext = pLinks->pNext;
+		unlink(pLinks);
+		destroy_node(static_cast<Node*>(pLinks));
+		--m_nCount;
+		return iterator(pNext);
+	}
+
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		while (first != last)
+			first = erase(first);
+		return iterator(const_cast<Links*>(last.m_pLinks));
+	}
+
+	// Moves the element at it before pos. Both belong to this list: the nodes
+	// of another list live in its own pool.
+	void splice(const_iterator pos, const_iterator it)
+	{
+		assert(it != end());
+		if (pos == it)
+			return;
+
+		Links* pLinks = const_cast<Links*>(it.m_pLinks);
+		unlink(pLinks);
+		link_before(const_cast<Links*>(pos.m_pLinks), pLinks);
+	}
+
+	T& front()
+	{
+		assert(m_nCount);
+		return *begin();
+	}
+
+	const T& front() const
+	{
+		assert(m_nCount);
+		return *begin();
+	}
+
+	T& back()
+	{
+		assert(m_nCount);
+		return *iterator(m_head.pPrev);
+	}
+
+	const T& back() const
+	{
+		assert(m_nCount);
+		return *const_iterator(m_head.pPrev);
+	}
+
+	iterator begin()
+	{
+		return iterator(m_head.pNext);
+	}
+
+	const_iterator begin() const
+	{
+		return const_iterator(m_head.pNext);
+	}
+
+	const_iterator cbegin() const
+	{
+		return begin();
+	}
+
+	iterator end()
+	{
+		return iterator(&m_head);
+	}
+
+	const_iterator end() const
+	{
+		return const_iterator(&m_head);
+	}
+
+	const_iterator cend() const
+	{
+		return end();
+	}
+
+	reverse_iterator rbegin()
+	{
+		return reverse_iterator(end());
+	}
+
+	const_reverse_iterator rbegin() const
+	{
+		return const_reverse_iterator(end());
+	}
+
+	reverse_iterator rend()
+	{
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator rend() const
+	{
+		return const_reverse_iterator(begin());
+	}
+
+	bool empty() const
+	{
+		return 0 == m_nCount;
+	}
+
+	size_type size() const
+	{
+		return m_nCount;
+	}
+
+private:
+	static void link_before(Links* pPos, Links* pLinks)
+	{
+		pLinks->pPrev = pPos->pPrev;
+		pLinks->pNext = pPos;
+		pPos->pPrev->pNext = pLinks;
+		pPos->pPrev = pLinks;
+	}
+
+	static void unlink(Links* pLinks)
+	{
+		pLinks->pPrev->pNext = pLinks->pNext;
+		pLinks->pNext->pPrev = pLinks->pPrev;
+	}
+
+	void destroy_node(Node* pNode)
+	{
+		tdk_destroy_at(&pNode->value);
+		m_pool.free(pNode);
+	}
+
+	// the first and the last node point to the head, which has just moved
+	void fix_head()
+	{
+		if (m_nCount)
+		{
+			m_head.pNext->pPrev = &m_head;
+			m_head.pPrev->pNext = &m_head;
+		}
+		else
+		{
+			m_head.pPrev = &m_head;
+			m_head.pNext = &m_head;
+		}
+	}
+
+	NodePool m_pool;
+	Links m_head; // pNext is the first node, pPrev the last
+	size_type m_nCount;
+};
+
+#endif //TDK_LIST_H
@@ -0,0 +1,997 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: ordered map on a B-tree.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_MAP_H
+#define TDK_MAP_H
+
+#include "base/tdkbasedefs.h"
+#include "base/tdkbaseutl.h"
+#include "base/tdkmemorypool.h"
+
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Ordered map on a B-tree. A node keeps up to kMAX_VALUES sorted elements in
+// one array of about kNODE_BYTES, so a search does a binary search in a few
+// cache lines per level instead of chasing a pointer per element. Leaves and
+// inner nodes come from two tdk_memorypool instances owned by the map.
+//
+// Unlike std::map elements move between nodes: every insert and erase
+// invalidates all iterators and pointers to elements. Use tdk_list, or keep
+// keys instead of iterators, where positions must survive modification.
+template<typename K, typename V, typename Less = std::less<K>>
+class tdk_map
+{
+public:
+	typedef tdk_size size_type;
+	typedef tdk_diff difference_type;
+
+	typedef K key_type;
+	typedef V mapped_type;
+	typedef std::pair<const K, V> value_type;
+	typedef Less key_compare;
+
+	typedef value_type& reference;
+	typedef const value_type& const_reference;
+	typedef value_type* pointer;
+	typedef const value_type* const_pointer;
+
+private:
+	enum Constants
+	{
+		kNODE_BYTES = 256,
+		kMAX_VALUES = (kNODE_BYTES - 16) / sizeof(value_type) > 3 ?
+			(kNODE_BYTES - 16) / sizeof(value_type) : 3,
+		kMIN_VALUES = kMAX_VALUES / 2 // for all nodes but the root after an erase
+	};
+
+	struct Node
+	{
+		Node* pParent;
+		tdk_u16 nPos; // index in the children of the parent
+		tdk_u16 nCount;
+		bool bLeaf;
+		alignas(value_type) tdk_byte slots[kMAX_VALUES * sizeof(value_type)];
+
+		value_type* slot(size_type idx)
+		{
+			return reinterpret_cast<value_type*>(slots) + idx;
+		}
+
+		Node*& child(size_type idx);
+	};
+
+	struct InnerNode : Node
+	{
+		Node* children[kMAX_VALUES + 1];
+	};
+
+	static_assert(alignof(InnerNode) <= alignof(void*),
+		"tdk_memorypool does not align nodes beyond a pointer");
+
+	using LeafPool = tdk_memorypool<sizeof(Node)>;
+	using InnerPool = tdk_memorypool<sizeof(InnerNode)>;
+
+	// Past the last element of a leaf: moves up to the ancestor that holds
+	// the next element. Stays put at the end of the rightmost leaf, which is
+	// end().
+	static void climb_from_end(Node*& pNode, size_type& nPos)
+	{
+		Node* pCur = pNode;
+		size_type nCur = nPos;
+		while (nCur == pCur->nCount && pCur->pParent)
+		{
+			nCur = pCur->nPos;
+			pCur = pCur->pParent;
+		}
+		if (nCur != pCur->nCount)
+		{
+			pNode = pCur;
+			nPos = nCur;
+		}
+	}
+
+	template<bool kConst>
+	class iterator_base
+	{
+		friend class tdk_map;
+		friend class iterator_base<!kConst>;
+
+		using Slot = typename tdk_map::value_type;
+	public:
+		typedef std::bidirectional_iterator_tag iterator_category;
+		typedef Slot value_type;
+		typedef tdk_diff difference_type;
+		typedef std::conditional_t<kConst, const Slot*, Slot*> pointer;
+		typedef std::conditional_t<kConst, const Slot&, Slot&> reference;
+
+		iterator_base() = default;
+
+		// iterator to const_iterator
+		template<bool kOthConst, typename = std::enable_if_t<kConst && !kOthConst>>
+		iterator_base(const iterator_base<kOthConst>& oth)
+			: m_pNode(oth.m_pNode)
+			, m_nPos(oth.m_nPos)
+		{
+		}
+
+		reference operator*() const
+		{
+			return *m_pNode->slot(m_nPos);
+		}
+
+		pointer operator->() const
+		{
+			return m_pNode->slot(m_nPos);
+		}
+
+		iterator_base& operator++()
+		{
+			if (m_pNode->bLeaf)
+			{
+				if (++m_nPos == m_pNode->nCount)
+					climb_from_end(m_pNode, m_nPos);
+				return *this;
+			}
+
+			m_pNode = m_pNode->child(m_nPos + 1);
+			while (!m_pNode->bLeaf)
+				m_pNode = m_pNode->child(0);
+			m_nPos = 0;
+			return *this;
+		}
+
+		iterator_base operator++(int)
+		{
+			iterator_base tmp = *this;
+			++*this;
+			return tmp;
+		}
+
+		iterator_base& operator--()
+		{
+			if (!m_pNode->bLeaf)
+			{
+				m_pNode = m_pNode->child(m_nPos);
+				while (!m_pNode->bLeaf)
+					m_pNode = m_pNode->child(m_pNode->nCount);
+				m_nPos = m_pNode->nCount - 1;
+				return *this;
+			}
+
+			if (m_nPos)
+			{
+				--m_nPos;
+				return *this;
+			}
+
+			while (!m_nPos && m_pNode->pParent)
+			{
+				m_nPos = m_pNode->nPos;
+				m_pNode = m_pNode->pParent;
+			}
+			assert(m_nPos); // not begin()
+			--m_nPos;
+			return *this;
+		}
+
+		iterator_base operator--(int)
+		{
+			iterator_base tmp = *this;
+			--*this;
+			return tmp;
+		}
+
+		friend bool operator==(const iterator_base& a, const iterator_base& b)
+		{
+			return a.m_pNode == b.m_pNode && a.m_nPos == b.m_nPos;
+		}
+
+		friend bool operator!=(const iterator_base& a, const iterator_base& b)
+		{
+			return !(a == b);
+		}
+
+	private:
+		iterator_base(Node* pNode, size_type nPos)
+			: m_pNode(pNode)
+			, m_nPos(nPos)
+		{
+		}
+
+		Node* m_pNode = nullptr;
+		size_type m_nPos = 0;
+	};
+
+public:
+	typedef iterator_base<false> iterator;
+	typedef iterator_base<true> const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	explicit tdk_map(tdk_u32 nMemoryFlags = kTDK_MEMORY_DEFAULT)
+		: m_leafPool(nMemoryFlags)
+		, m_innerPool(nMemoryFlags)
+		, m_pRoot(nullptr)
+		, m_pLeftmost(nullptr)
+		, m_pRightmost(nullptr)
+		, m_nCount(0)
+	{
+
+	}
+
+	// Leaves the map empty if the memory cannot be allocated, use assign()
+	// to get the error.
+	tdk_map(const tdk_map& oth)
+		: tdk_map()
+	{
+		assign(oth);
+	}
+
+	tdk_map(tdk_map&& oth) noexcept
+		: tdk_map()
+	{
+		swap(oth);
+	}
+
+	~tdk_map()
+	{
+		clear();
+	}
+
+	tdk_map& operator=(const tdk_map& oth)
+	{
+		if (this != &oth)
+			assign(oth);
+		return *this;
+	}
+
+	tdk_map& operator=(tdk_map&& oth) noexcept
+	{
+		tdk_map tmp(std::move(oth));
+		swap(tmp);
+		return *this;
+	}
+
+	void swap(tdk_map& oth) noexcept
+	{
+		m_leafPool.swap(oth.m_leafPool);
+		m_innerPool.swap(oth.m_innerPool);
+		std::swap(m_pRoot, oth.m_pRoot);
+		std::swap(m_pLeftmost, oth.m_pLeftmost);
+		std::swap(m_pRightmost, oth.m_pRightmost);
+		std::swap(m_nCount, oth.m_nCount);
+	}
+
+	tdk_ret assign(const tdk_map& oth, tdk_err* pErrorCode = nullptr)
+	{
+		if (this == &oth)
+			return kTDK_OK;
+
+		// ascending inserts split at the right end and fill the nodes
+		tdk_map tmp;
+		for (const value_type& val : oth)
+		{
+			tdk_ret retVal = tmp.insert(val.first, val.second, pErrorCode);
+			if (kTDK_OK != retVal)
+				return retVal;
+		}
+		clear();
+		swap(tmp);
+		return kTDK_OK;
+	}
+
+	// Destroys the elements, the pools keep the memory.
+	void clear()
+	{
+		if (m_pRoot)
+			destroy_subtree(m_pRoot);
+		m_pRoot = nullptr;
+		m_pLeftmost = nullptr;
+		m_pRightmost = nullptr;
+		m_nCount = 0;
+	}
+
+	// Returns kTDK_OK if the element was inserted, kTDK_NO if the key was
+	// already there (val is not used then).
+	template<typename KeyArg, typename ValArg>
+	tdk_ret insert(KeyArg&& key, ValArg&& val, tdk_err* pErrorCode = nullptr)
+	{
+		Node* pNode = nullptr;
+		size_type nPos = 0;
+		tdk_ret retVal = find_or_prepare_insert(key, pNode, nPos, pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		construct_value(pNode, nPos, std::forward<KeyArg>(key), std::forward<ValArg>(val));
+		return kTDK_OK;
+	}
+
+	// Returns kTDK_OK if the element was inserted, kTDK_NO if the value of an
+	// existing key was replaced.
+	template<typename KeyArg, typename ValArg>
+	tdk_ret insert_or_assign(KeyArg&& key, ValArg&& val, tdk_err* pErrorCode = nullptr)
+	{
+		Node* pNode = nullptr;
+		size_type nPos = 0;
+		tdk_ret retVal = find_or_prepare_insert(key, pNode, nPos, pErrorCode);
+		if (kTDK_NO == retVal)
+		{
+			pNode->slot(nPos)->second = std::forward<ValArg>(val);
+			return kTDK_NO;
+		}
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		construct_value(pNode, nPos, std::forward<KeyArg>(key), std::forward<ValArg>(val));
+		return kTDK_OK;
+	}
+
+	// The value of key, a value-initialized one is inserted if there is none.
+	// nullptr if the memory cannot be allocated.
+	template<typename KeyArg>
+	V* find_or_insert(KeyArg&& key, tdk_err* pErrorCode = nullptr)
+	{
+		Node* pNode = nullptr;
+		size_type nPos = 0;
+		tdk_ret retVal = find_or_prepare_insert(key, pNode, nPos, pErrorCode);
+		if (kTDK_OK == retVal)
+			construct_value(pNode, nPos, std::forward<KeyArg>(key));
+		else if (kTDK_NO != retVal)
+			return nullptr;
+		return &pNode->slot(nPos)->second;
+	}
+
+	iterator find(const K& key)
+	{
+		Node* pNode = nullptr;
+		size_type nPos = 0;
+		if (!locate(key, pNode, nPos))
+			return end();
+		return iterator(pNode, nPos);
+	}
+
+	const_iterator find(const K& key) const
+	{
+		return const_cast<tdk_map*>(this)->find(key);
+	}
+
+	// Pointer to the value of key, nullptr if there is no such key.
+	V* at(const K& key)
+	{
+		Node* pNode = nullptr;
+		size_type nPos = 0;
+		return locate(key, pNode, nPos) ? &pNode->slot(nPos)->second : nullptr;
+	}
+
+	const V* at(const K& key) const
+	{
+		return const_cast<tdk_map*>(this)->at(key);
+	}
+
+	bool contains(const K& key) const
+	{
+		Node* pNode = nullptr;
+		size_type nPos = 0;
+		return locate(key, pNode, nPos);
+	}
+
+	// The first element whose key is not less than key.
+	iterator lower_bound(const K& key)
+	{
+		Node* pNode = nullptr;
+		size_type nPos = 0;
+		if (!locate(key, pNode, nPos) && pNode)
+			climb_from_end(pNode, nPos);
+		return iterator(pNode, nPos);
+	}
+
+	const_iterator lower_bound(const K& key) const
+	{
+		return const_cast<tdk_map*>(this)->lower_bound(key);
+	}
+
+	// The first element whose key is greater than key.
+	iterator upper_bound(const K& key)
+	{
+		Node* pNode = m_pRoot;
+		if (!pNode)
+			return end();
+
+		for (;;)
+		{
+			size_type nPos = upper_bound_in(pNode, key);
+			if (pNode->bLeaf)
+			{
+				climb_from_end(pNode, nPos);
+				return iterator(pNode, nPos);
+			}
+			pNode = pNode->child(nPos);
+		}
+	}
+
+	const_iterator upper_bound(const K& key) const
+	{
+		return const_cast<tdk_map*>(this)->upper_bound(key);
+	}
+
+	// Returns kTDK_OK if the key was erased, kTDK_NO if there was no such key.
+	tdk_ret erase(const K& key)
+	{
+		iterator it = find(key);
+		if (it == end())
+			return kTDK_NO;
+		erase(it);
+		return kTDK_OK;
+	}
+
+	// Returns the iterator to the element that followed the erased one.
+	iterator erase(const_iterator pos)
+	{
+		assert(pos != end());
+		Node* pNode = pos.m_pNode;
+		size_type nPos = pos.m_nPos;
+		bool bInner = !pNode->bLeaf;
+
+		if (bInner)
+		{
+			// replace it with its predecessor, the last value of a leaf
+			Node* pLeaf = pNode->child(nPos);
+			while (!pLeaf->bLeaf)
+				pLeaf = pLeaf->child(pLeaf->nCount);
+
+			tdk_destroy_at(pNode->slot(nPos));
+			relocate_value(pNode->slot(nPos), pLeaf->slot(pLeaf->nCount - 1));
+			--pLeaf->nCount;
+			pNode = pLeaf;
+			nPos = pLeaf->nCount; // right after the predecessor
+		}
+		else
+		{
+			tdk_destroy_at(pNode->slot(nPos));
+			shift_left(pNode, nPos + 1);
+		}
+		--m_nCount;
+
+		// (pNode, nPos) follows the same place in the order while nodes are
+		// merged and rotated
+		rebalance_after_erase(pNode, nPos);
+		if (!m_pRoot)
+			return end();
+
+		climb_from_end(pNode, nPos);
+		iterator next(pNode, nPos);
+		if (bInner)
+			++next; // skip the predecessor
+		return next;
+	}
+
+	iterator begin()
+	{
+		return m_pLeftmost ? iterator(m_pLeftmost, 0) : end();
+	}
+
+	const_iterator begin() const
+	{
+		return const_cast<tdk_map*>(this)->begin();
+	}
+
+	const_iterator cbegin() const
+	{
+		return begin();
+	}
+
+	iterator end()
+	{
+		return iterator(m_pRightmost, m_pRightmost ? m_pRightmost->nCount : 0);
+	}
+
+	const_iterator end() const
+	{
+		return const_cast<tdk_map*>(this)->end();
+	}
+
+	const_iterator cend() const
+	{
+		return end();
+	}
+
+	reverse_iterator rbegin()
+	{
+		return reverse_iterator(end());
+	}
+
+	const_reverse_iterator rbegin() const
+	{
+		return const_reverse_iterator(end());
+	}
+
+	reverse_iterator rend()
+	{
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator rend() const
+	{
+		return const_reverse_iterator(begin());
+	}
+
+	bool empty() const
+	{
+		return 0 == m_nCount;
+	}
+
+	size_type size() const
+	{
+		return m_nCount;
+	}
+
+	key_compare key_comp() const
+	{
+		return key_compare();
+	}
+
+private:
+	static bool less(const K& a, const K& b)
+	{
+		return key_compare()(a, b);
+	}
+
+	// Index of the first value not less than key. Branchless like
+	// tdk_podarray::lower_bound: random keys would mispredict every step.
+	static size_type lower_bound_in(Node* pNode, const K& key)
+	{
+		size_type n = pNode->nCount;
+		if (!n)
+			return 0;
+
+		const value_type* pBase = pNode->slot(0);
+		while (n > 1)
+		{
+			size_type nHalf = n / 2;
+			pBase = less(pBase[nHalf].first, key) ? pBase + nHalf : pBase;
+			n -= nHalf;
+		}
+		return (pBase - pNode->slot(0)) + (less(pBase->first, key) ? 1 : 0);
+	}
+
+	// index of the first value greater than key
+	static size_type upper_bound_in(Node* pNode, const K& key)
+	{
+		size_type n = pNode->nCount;
+		if (!n)
+			return 0;
+
+		const value_type* pBase = pNode->slot(0);
+		while (n > 1)
+		{
+			size_type nHalf = n / 2;
+			pBase = less(key, pBase[nHalf].first) ? pBase : pBase + nHalf;
+			n -= nHalf;
+		}
+		return (pBase - pNode->slot(0)) + (less(key, pBase->first) ? 0 : 1);
+	}
+
+	// true and the place of key if it is there, false and the leaf position
+	// where it would go otherwise (a null node for the empty map)
+	bool locate(const K& key, Node*& pNode, size_type& nPos) const
+	{
+		pNode = m_pRoot;
+		nPos = 0;
+		if (!pNode)
+			return false;
+
+		for (;;)
+		{
+			nPos = lower_bound_in(pNode, key);
+			if (nPos < pNode->nCount && !less(key, pNode->slot(nPos)->first))
+				return true;
+			if (pNode->bLeaf)
+				return false;
+			pNode = pNode->child(nPos);
+		}
+	}
+
+	// kTDK_NO and the place of key if it is there, kTDK_OK and a leaf
+	// position with a free slot otherwise.
+	tdk_ret find_or_prepare_insert(const K& key, Node*& pNode, size_type& nPos,
+		tdk_err* pErrorCode)
+	{
+		if (locate(key, pNode, nPos))
+			return kTDK_NO;
+
+		if (!pNode)
+		{
+			pNode = new_node(true, pErrorCode);
+			if (!pNode)
+				return kTDK_FATAL;
+			m_pRoot = pNode;
+			m_pLeftmost = pNode;
+			m_pRightmost = pNode;
+			return kTDK_OK;
+		}
+
+		if (kMAX_VALUES == pNode->nCount)
+		{
+			tdk_ret retVal = reserve_split_nodes(pNode, pErrorCode);
+			if (kTDK_OK != retVal)
+				return retVal;
+			split(pNode, nPos);
+		}
+		return kTDK_OK;
+	}
+
+	template<typename KeyArg, typename... Args>
+	void construct_value(Node* pNode, size_type nPos, KeyArg&& key, Args&&... args)
+	{
+		shift_right(pNode, nPos);
+		::new (static_cast<void*>(pNode->slot(nPos))) value_type(std::piecewise_construct,
+			std::forward_as_tuple(std::forward<KeyArg>(key)),
+			std::forward_as_tuple(std::forward<Args>(args)...));
+		++m_nCount;
+	}
+
+	//-------------------------------------------------------------------------
+	// Nodes
+
+	Node* new_node(bool bLeaf, tdk_err* pErrorCode = nullptr)
+	{
+		void* pMem = bLeaf ? m_leafPool.allocate(pErrorCode) :
+			m_innerPool.allocate(pErrorCode);
+		if (!pMem)
+			return nullptr;
+
+		Node* pNode = bLeaf ? static_cast<Node*>(::new (pMem) Node) : ::new (pMem) InnerNode;
+		pNode->pParent = nullptr;
+		pNode->nPos = 0;
+		pNode->nCount = 0;
+		pNode->bLeaf = bLeaf;
+		return pNode;
+	}
+
+	void free_node(Node* pNode)
+	{
+		if (pNode->bLeaf)
+			m_leafPool.free(pNode);
+		else
+			m_innerPool.free(pNode);
+	}
+
+	void destroy_subtree(Node* pNode)
+	{
+		if (!pNode->bLeaf)
+		{
+			for (size_type idx = 0; idx <= pNode->nCount; ++idx)
+				destroy_subtree(pNode->child(idx));
+		}
+		for (size_type idx = 0; idx < pNode->nCount; ++idx)
+			tdk_destroy_at(pNode->slot(idx));
+		free_node(pNode);
+	}
+
+	static void set_child(Node* pParent, size_type idx, Node* pChild)
+	{
+		pParent->child(idx) = pChild;
+		pChild->pParent = pParent;
+		pChild->nPos = tdk_u16(idx);
+	}
+
+	static void relocate_value(value_type* pDst, value_type* pSrc)
+	{
+		if constexpr (std::is_trivially_copy_constructible_v<value_type> &&
+			std::is_trivially_destructible_v<value_type>)
+		{
+			std::memcpy(static_cast<void*>(pDst), pSrc, sizeof(value_type));
+		}
+		else
+		{
+			// the key is const only for the users, the old slot is dead
+			::new (static_cast<void*>(pDst)) value_type(std::piecewise_construct,
+				std::forward_as_tuple(std::move(const_cast<K&>(pSrc->first))),
+				std::forward_as_tuple(std::move(pSrc->second)));
+			pSrc->~value_type();
+		}
+	}
+
+	// Moves the values [nPos, nCount) one slot to the right.
+	static void shift_right(Node* pNode, size_type nPos)
+	{
+		for (size_type idx = pNode->nCount; idx > nPos; --idx)
+			relocate_value(pNode->slot(idx), pNode->slot(idx - 1));
+		++pNode->nCount;
+	}
+
+	// Moves the values [nPos, nCount) one slot to the left, over a dead one.
+	static void shift_left(Node* pNode, size_type nPos)
+	{
+		for (size_type idx = nPos; idx < pNode->nCount; ++idx)
+			relocate_value(pNode->slot(idx - 1), pNode->slot(idx));
+		--pNode->nCount;
+	}
+
+	// Makes sure that splitting the full pLeaf cannot fail: allocates the
+	// nodes the split will take and returns them to the free lists, where
+	// the split finds them again.
+	tdk_ret reserve_split_nodes(Node* pLeaf, tdk_err* pErrorCode)
+	{
+		size_type nInner = 0;
+		Node* pNode = pLeaf->pParent;
+		while (pNode && kMAX_VALUES == pNode->nCount)
+		{
+			++nInner;
+			pNode = pNode->pParent;
+		}
+		if (!pNode)
+			++nInner; // new root
+
+		void* pLeafMem = m_leafPool.allocate(pErrorCode);
+		if (!pLeafMem)
+			return kTDK_FATAL;
+
+		void* inner[64];
+		assert(nInner <= 64);
+		tdk_ret retVal = kTDK_OK;
+		size_type nAllocated = 0;
+		for (; nAllocated < nInner; ++nAllocated)
+		{
+			inner[nAllocated] = m_innerPool.allocate(pErrorCode);
+			if (!inner[nAllocated])
+			{
+				retVal = kTDK_FATAL;
+				break;
+			}
+		}
+
+		while (nAllocated)
+			m_innerPool.free(inner[--nAllocated]);
+		m_leafPool.free(pLeafMem);
+		return retVal;
+	}
+
+	// Splits the full pNode in two and the median goes to the parent. nPos is
+	// where a value is about to be inserted, it is updated to the node that
+	// gets it. A split at either end leaves that end nearly empty and the
+	// other side full, so ascending or descending inserts fill the nodes.
+	void split(Node*& pNode, size_type& nPos)
+	{
+		if (pNode->pParent && kMAX_VALUES == pNode->pParent->nCount)
+		{
+			Node* pParent = pNode->pParent;
+			size_type nParentPos = pNode->nPos;
+			split(pParent, nParentPos);
+		}
+
+		if (!pNode->pParent)
+		{
+			Node* pRoot = new_node(false);
+			assert(pRoot);
+			set_child(pRoot, 0, pNode);
+			m_pRoot = pRoot;
+		}
+
+		size_type nMid = kMAX_VALUES / 2;
+		if (kMAX_VALUES == nPos)
+			nMid = kMAX_VALUES - 1;
+		else if (0 == nPos)
+			nMid = 0;
+
+		Node* pRight = new_node(pNode->bLeaf);
+		assert(pRight);
+		size_type nRight = kMAX_VALUES - nMid - 1;
+		for (size_type idx = 0; idx < nRight; ++idx)
+			relocate_value(pRight->slot(idx), pNode->slot(nMid + 1 + idx));
+		if (!pNode->bLeaf)
+		{
+			for (size_type idx = 0; idx <= nRight; ++idx)
+				set_child(pRight, idx, pNode->child(nMid + 1 + idx));
+		}
+		pRight->nCount = tdk_u16(nRight);
+		pNode->nCount = tdk_u16(nMid);
+
+		// the median goes between pNode and pRight in the parent
+		Node* pParent = pNode->pParent;
+		size_type nSep = pNode->nPos;
+		for (size_type idx = pParent->nCount; idx > nSep; --idx)
+			set_child(pParent, idx + 1, pParent->child(idx));
+		shift_right(pParent, nSep);
+		relocate_value(pParent->slot(nSep), pNode->slot(nMid));
+		set_child(pParent, nSep + 1, pRight);
+
+		if (m_pRightmost == pNode)
+			m_pRightmost = pRight;
+
+		if (nPos > nMid)
+		{
+			pNode = pRight;
+			nPos -= nMid + 1;
+		}
+	}
+
+	// Restores the minimal fill from pNode up. (pTrack, nTrack) is a place
+	// in a leaf that is kept pointing at the same place in the order.
+	void rebalance_after_erase(Node*& pTrack, size_type& nTrack)
+	{
+		Node* pNode = pTrack;
+		while (pNode != m_pRoot && pNode->nCount < kMIN_VALUES)
+		{
+			Node* pParent = pNode->pParent;
+			size_type nIdx = pNode->nPos;
+
+			Node* pLeft = nIdx ? pParent->child(nIdx - 1) : nullptr;
+			if (pLeft && pLeft->nCount > kMIN_VALUES)
+			{
+				rotate_right(pLeft, pNode, pParent, nIdx - 1);
+				if (pTrack == pNode)
+					++nTrack;
+				break;
+			}
+
+			Node* pRight = nIdx < pParent->nCount ? pParent->child(nIdx + 1) : nullptr;
+			if (pRight && pRight->nCount > kMIN_VALUES)
+			{
+				rotate_left(pNode, pRight, pParent, nIdx);
+				break;
+			}
+
+			if (pLeft)
+			{
+				if (pTrack == pNode)
+				{
+					pTrack = pLeft;
+					nTrack += pLeft->nCount + 1;
+				}
+				merge(pLeft, pNode);
+			}
+			else
+			{
+				merge(pNode, pRight);
+			}
+			pNode = pParent;
+		}
+
+		if (m_pRoot->nCount)
+			return;
+
+		Node* pOldRoot = m_pRoot;
+		if (pOldRoot->bLeaf)
+		{
+			m_pRoot = nullptr;
+			m_pLeftmost = nullptr;
+			m_pRightmost = nullptr;
+			pTrack = nullptr;
+			nTrack = 0;
+		}
+		else
+		{
+			m_pRoot = pOldRoot->child(0);
+			m_pRoot->pParent = nullptr;
+			m_pRoot->nPos = 0;
+		}
+		free_node(pOldRoot);
+	}
+
+	// Moves the last value of pLeft up to the parent and the separator down
+	// to the front of pNode.
+	void rotate_right(Node* pLeft, Node* pNode, Node* pParent, size_type nSep)
+	{
+		if (!pNode->bLeaf)
+		{
+			for (size_type idx = pNode->nCount + 1; idx > 0; --idx)
+				set_child(pNode, idx, pNode->child(idx - 1));
+			set_child(pNode, 0, pLeft->child(pLeft->nCount));
+		}
+		shift_right(pNode, 0);
+		relocate_value(pNode->slot(0), pParent->slot(nSep));
+		relocate_value(pParent->slot(nSep), pLeft->slot(pLeft->nCount - 1));
+		--pLeft->nCount;
+	}
+
+	// Moves the separator down to the end of pNode and the first value of
+	// pRight up to the parent.
+	void rotate_left(Node* pNode, Node* pRight, Node* pParent, size_type nSep)
+	{
+		relocate_value(pNode->slot(pNode->nCount), pParent->slot(nSep));
+		++pNode->nCount;
+		relocate_value(pParent->slot(nSep), pRight->slot(0));
+		if (!pNode->bLeaf)
+		{
+			set_child(pNode, pNode->nCount, pRight->child(0));
+			for (size_type idx = 0; idx < pRight->nCount; ++idx)
+				set_child(pRight, idx, pRight->child(idx + 1));
+		}
+		shift_left(pRight, 1);
+	}
+
+	// Appends the separator and pRight to pLeft and frees pRight.
+	void merge(Node* pLeft, Node* pRight)
+	{
+		Node* pParent = pLeft->pParent;
+		size_type nSep = pLeft->nPos;
+		size_type nBase = pLeft->nCount;
+
+		relocate_value(pLeft->slot(nBase), pParent->slot(nSep));
+		for (size_type idx = 0; idx < pRight->nCount; ++idx)
+			relocate_value(pLeft->slot(nBase + 1 + idx), pRight->slot(idx));
+		if (!pLeft->bLeaf)
+		{
+			for (size_type idx = 0; idx <= pRight->nCount; ++idx)
+				set_child(pLeft, nBase + 1 + idx, pRight->child(idx));
+		}
+		pLeft->nCount = tdk_u16(nBase + 1 + pRight->nCount);
+
+		shift_left(pParent, nSep + 1);
+		for (size_type idx = nSep + 1; idx <= pParent->nCount; ++idx)
+			set_child(pParent, idx, pParent->child(idx + 1));
+
+		if (m_pRightmost == pRight)
+			m_pRightmost = pLeft;
+		pRight->nCount = 0;
+		free_node(pRight);
+	}
+
+	LeafPool m_leafPool;
+	InnerPool m_innerPool;
+	Node* m_pRoot;
+	Node* m_pLeftmost; // begin() is there
+	Node* m_pRightmost; // end() is past its last value
+	size_type m_nCount;
+};
+
+template<typename K, typename V, typename Less>
+typename tdk_map<K, V, Less>::Node*&
+tdk_map<K, V, Less>::Node::child(size_type idx)
+{
+	assert(!bLeaf);
+	return static_cast<InnerNode*>(this)->children[idx];
+}
+
+#endif //TDK_MAP_H
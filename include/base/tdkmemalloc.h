@@ -103,5 +103,62 @@ template <typename T, tdk_size kAlign>
 struct tdk_is_static_creatable<tdk_allocator<T, kAlign>> : public std::true_type
 {
 
+};
+
+// Buffers of kTDK_HUGE_PAGE_SIZE and more are placed on huge pages, smaller
+// ones behave like tdk_allocator.
+template<typename T, tdk_size kAlign = 16>
+class tdk_huge_page_allocator
+{
+public:
+    using size_type = tdk_size;
+    using difference_type = tdk_diff;
+
+    using value_type = T;
+
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = T*;
+    using const_pointer = const T*;
+
+    template<typename U>
+    struct rebind
+    {
+        using other = tdk_huge_page_allocator<U, kAlign>;
+    };
+
+    tdk_huge_page_allocator() noexcept = default;
+
+    tdk_huge_page_allocator(const tdk_huge_page_allocator& oth) noexcept = default;
+
+    tdk_huge_page_allocator& operator=(const tdk_huge_page_allocator&) noexcept = default;
+
+    template<typename U>
+    tdk_huge_page_allocator(const tdk_huge_page_allocator<U, kAlign>&) noexcept { }
+
+    ~tdk_huge_page_allocator() noexcept { }
+
+    T* allocate(size_type n)
+    {
+        size_type nBytes = n * sizeof(T);
+        if (nBytes >= kTDK_HUGE_PAGE_SIZE)
+            return static_cast<T*>(tdk_allocate_memory_huge(nBytes));
+        return static_cast<T*>(tdk_allocate_memory_aligned(nBytes, kAlign));
+    }
+
+    void deallocate(T* p, size_type n)
+    {
+        size_type nBytes = n * sizeof(T);
+        if (nBytes >= kTDK_HUGE_PAGE_SIZE)
+            tdk_free_memory_huge(p, nBytes);
+        else
+            tdk_free_memory_aligned(p, kAlign);
+    }
+};
+
+template <typename T, tdk_size kAlign>
+struct tdk_is_static_creatable<tdk_huge_page_allocator<T, kAlign>> : public std::true_type
+{
+
 };
 #endif //TDK_MEMALLOC_H
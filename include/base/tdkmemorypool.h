@@ -48,7 +48,12 @@ Purpose: memory utilities.
 #define TDK_MEMORYPOOL_H_INCLUDED
 
 #include "base/tdkbasedefs.h"
+#include "base/tdkmemutl.h"
 #include "system/tdkmemory.h"
+#include "system/tdkmemoryregion.h"
+
+#include <cassert>
+#include <utility>
 
 #define TDK_MEMORY_POOL_DEBUG_MODE 0
 
@@ -87,7 +92,7 @@ private:
 			return m_pNext;
 		}
 
-		const NodePtr get_next() const
+		const Node* get_next() const
 		{
 			return m_pNext;
 		}
@@ -136,7 +141,7 @@ private:
 #endif
         }
 
-		tdk_ret initialize(void* pNodeMem, size_type nCapacity, tdk_err* pErrorCode = 0)
+		tdk_ret initialize(void* pNodeMem, size_type nCapacity, tdk_err* /*pErrorCode*/ = 0)
 		{
 			assert(!m_pNodes);
 			m_pNodes = reinterpret_cast<NodePtr>(pNodeMem);
@@ -145,6 +150,11 @@ private:
 			return kTDK_OK;
 		}
 
+		BlockPtr get_next()
+		{
+			return m_pNext;
+		}
+
 		void set_next(BlockPtr pNext)
 		{
 			m_pNext = pNext;
@@ -170,28 +180,45 @@ public:
 	void *allocate(tdk_err* pErrorCode = 0);
 	void free(void *);
     size_type capacity() const { return m_nCapacity; }
+	void swap(tdk_memorypool& oth);
 
     virtual ~tdk_memorypool();
-	tdk_memorypool();
+	explicit tdk_memorypool(tdk_u32 nMemoryFlags = kTDK_MEMORY_DEFAULT);
+
+	// Blocks come from region and count against its budget, allocate()
+	// fails with kTDK_BAD_ALLOC past it. kTDK_MEMORY_HUGE_PAGES is ignored.
+	explicit tdk_memorypool(tdk_memory_region& region,
+		tdk_u32 nMemoryFlags = kTDK_MEMORY_DEFAULT);
+
+	// the blocks are owned by one pool
+	tdk_memorypool(const tdk_memorypool&) = delete;
+	tdk_memorypool& operator=(const tdk_memorypool&) = delete;
 
 private:
 	size_type suggest_capacity(size_type nCurrentCap);
 	tdk_ret reserve(tdk_err* pErrorCode = 0);
 	NodePtr convert(void*);
+	void* allocate_block_memory(size_type nBytes);
+	void free_block_memory(void* pMem, size_type nBytes);
+	static size_type block_bytes(size_type nCapacity);
 
 	BlockPtr m_pFirstBlock;
 	NodePtr m_pFirstUnusedNode;
 	size_type m_nCapacity;
+	tdk_u32 m_nMemoryFlags;
+	tdk_memory_region* m_pRegion;
 };
 
 
 //-----------------------------------------------------------------------------
 
 template <tdk_size kTypeSize>
-tdk_memorypool<kTypeSize>::tdk_memorypool()
+tdk_memorypool<kTypeSize>::tdk_memorypool(tdk_u32 nMemoryFlags)
 	: m_pFirstBlock(0)
 	, m_pFirstUnusedNode(0)
 	, m_nCapacity(0)
+	, m_nMemoryFlags(nMemoryFlags)
+	, m_pRegion(nullptr)
 {
 #if CPK_MEMORY_POOL_DEBUG_MODE
     std::cout << "tdk_memorypool<" << kTypeSize << ">::tdk_memorypool()\n";
@@ -201,6 +228,16 @@ tdk_memorypool<kTypeSize>::tdk_memorypool()
 
 //-----------------------------------------------------------------------------
 
+template <tdk_size kTypeSize>
+tdk_memorypool<kTypeSize>::tdk_memorypool(tdk_memory_region& region,
+	tdk_u32 nMemoryFlags)
+	: tdk_memorypool(nMemoryFlags)
+{
+	m_pRegion = &region;
+}
+
+//-----------------------------------------------------------------------------
+
 template <tdk_size kTypeSize>
 tdk_memorypool<kTypeSize>::~tdk_memorypool()
 {
@@ -208,6 +245,63 @@ tdk_memorypool<kTypeSize>::~tdk_memorypool()
     std::cout << "tdk_memorypool<" << kTypeSize << ">::~tdk_memorypool()\n";
     
 #endif
+	while (m_pFirstBlock)
+	{
+		BlockPtr pNext = m_pFirstBlock->get_next();
+		free_block_memory(m_pFirstBlock, block_bytes(m_pFirstBlock->capacity()));
+		m_pFirstBlock = pNext;
+	}
+	m_pFirstUnusedNode = 0;
+	m_nCapacity = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+template <tdk_size kTypeSize>
+void
+tdk_memorypool<kTypeSize>::swap(tdk_memorypool& oth)
+{
+	std::swap(m_pFirstBlock, oth.m_pFirstBlock);
+	std::swap(m_pFirstUnusedNode, oth.m_pFirstUnusedNode);
+	std::swap(m_nCapacity, oth.m_nCapacity);
+	std::swap(m_nMemoryFlags, oth.m_nMemoryFlags);
+	std::swap(m_pRegion, oth.m_pRegion);
+}
+
+//-----------------------------------------------------------------------------
+
+template <tdk_size kTypeSize>
+typename tdk_memorypool<kTypeSize>::size_type
+tdk_memorypool<kTypeSize>::block_bytes(size_type nCapacity)
+{
+	return sizeof(Block) + sizeof(Node) * nCapacity;
+}
+
+//-----------------------------------------------------------------------------
+
+template <tdk_size kTypeSize>
+void*
+tdk_memorypool<kTypeSize>::allocate_block_memory(size_type nBytes)
+{
+	if (m_pRegion)
+		return m_pRegion->allocate(nBytes, 16);
+	if ((m_nMemoryFlags & kTDK_MEMORY_HUGE_PAGES) && nBytes >= kTDK_HUGE_PAGE_SIZE)
+		return tdk_allocate_memory_huge(nBytes);
+	return tdk_allocate_memory_aligned(nBytes, 16);
+}
+
+//-----------------------------------------------------------------------------
+
+template <tdk_size kTypeSize>
+void
+tdk_memorypool<kTypeSize>::free_block_memory(void* pMem, size_type nBytes)
+{
+	if (m_pRegion)
+		m_pRegion->free(pMem);
+	else if ((m_nMemoryFlags & kTDK_MEMORY_HUGE_PAGES) && nBytes >= kTDK_HUGE_PAGE_SIZE)
+		tdk_free_memory_huge(pMem, nBytes);
+	else
+		tdk_free_memory_aligned(pMem, 16);
 }
 
 //-----------------------------------------------------------------------------
@@ -227,7 +321,15 @@ tdk_ret
 tdk_memorypool<kTypeSize>::reserve(tdk_err* pErrorCode)
 {
 	size_type nNewCapacity = suggest_capacity(m_nCapacity);
-	void* pMem = tdk_allocate_memory_aligned(sizeof(Block) + sizeof(Node) * nNewCapacity, 16);
+	size_type nBlockBytes = block_bytes(nNewCapacity);
+	if ((m_nMemoryFlags & kTDK_MEMORY_HUGE_PAGES) && nBlockBytes >= kTDK_HUGE_PAGE_SIZE)
+	{
+		// huge pages are mapped whole, so fill the tail with nodes too
+		nBlockBytes = tdk_huge_page_round_up(nBlockBytes);
+		nNewCapacity = (nBlockBytes - sizeof(Block)) / sizeof(Node);
+	}
+
+	void* pMem = allocate_block_memory(nBlockBytes);
 	if (!pMem)
 	{
 		tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
@@ -49,7 +49,11 @@ Purpose: memory utilities.
 
 
 #include "base/tdkbasedefs.h"
+
+#include <cstring>
+#include <iterator>
 #include <memory>
+#include <type_traits>
 
 template <typename T>
 struct tdk_is_static_creatable : public std::false_type
@@ -57,21 +61,53 @@ struct tdk_is_static_creatable : public std::false_type
 
 };
 
-// construct
-template<typename NoThrowForwardIt, typename Size, typename T>
-constexpr NoThrowForwardIt tdk_uninitialized_fill_n(NoThrowForwardIt itFirst,
-	Size nCount, const T& value) noexcept
+// traits
+
+// Iterators over contiguous memory, they can be turned into raw pointers.
+template<typename It>
+struct tdk_is_contiguous_iterator
+#ifdef TDK_CPP20
+	: public std::bool_constant<std::contiguous_iterator<It>>
+#else
+	: public std::is_pointer<It>
+#endif
 {
-	using DestinationValueType = typename std::iterator_traits<NoThrowForwardIt>::value_type;
-	NoThrowForwardIt itCurrent = itFirst;
 
-	for (; nCount > 0; ++itCurrent, (void) --nCount)
+};
+
+template<typename It>
+constexpr auto tdk_to_address(It it) noexcept
+{
+#ifdef TDK_CPP20
+	return std::to_address(it);
+#else
+	return it;
+#endif
+}
+
+// Copying from SrcIt to DstIt may be done with memcpy/memmove.
+template<typename SrcIt, typename DstIt>
+struct tdk_is_bitwise_copyable : public std::bool_constant<
+	tdk_is_contiguous_iterator<SrcIt>::value &&
+	tdk_is_contiguous_iterator<DstIt>::value &&
+	std::is_same_v<typename std::iterator_traits<SrcIt>::value_type,
+		typename std::iterator_traits<DstIt>::value_type> &&
+	std::is_trivially_copyable_v<typename std::iterator_traits<DstIt>::value_type>>
+{
+
+};
+
+// Fill value is one byte repeated sizeof(T) times, so memset can write it.
+template<typename T>
+bool tdk_is_byte_pattern(const T& value) noexcept
+{
+	const tdk_byte* pBytes = reinterpret_cast<const tdk_byte*>(std::addressof(value));
+	for (tdk_size i = 1; i < sizeof(T); ++i)
 	{
-		void* pDestMem = static_cast<void*>(std::addressof(*itCurrent));
-		::new (pDestMem) DestinationValueType(value);
+		if (pBytes[i] != pBytes[0])
+			return false;
 	}
-			
-	return itCurrent;
+	return true;
 }
 
 // destroy
@@ -90,51 +126,315 @@ template<typename ForwardIt>
 constexpr
 void tdk_destroy(ForwardIt first, ForwardIt last) noexcept
 {
-	for (; first != last; ++first)
-		tdk_destroy_at(std::addressof(*first));
+	using ValueType = typename std::iterator_traits<ForwardIt>::value_type;
+	if constexpr (!std::is_trivially_destructible_v<ValueType>)
+	{
+		for (; first != last; ++first)
+			tdk_destroy_at(std::addressof(*first));
+	}
+}
+
+// Destroys [first, current) on scope exit unless release() was called. Undoes
+// a partially constructed range when a constructor throws; without exceptions
+// it is always released and compiles to nothing.
+template<typename ForwardIt>
+class tdk_construct_rollback
+{
+public:
+	tdk_construct_rollback(ForwardIt first, const ForwardIt& current) noexcept
+		: m_first(first)
+		, m_current(current)
+	{
+	}
+
+	~tdk_construct_rollback()
+	{
+		if (!m_bReleased)
+			tdk_destroy(m_first, m_current);
+	}
+
+	tdk_construct_rollback(const tdk_construct_rollback&) = delete;
+	tdk_construct_rollback& operator=(const tdk_construct_rollback&) = delete;
+
+	void release() noexcept
+	{
+		m_bReleased = true;
+	}
+
+private:
+	ForwardIt m_first;
+	const ForwardIt& m_current;
+	bool m_bReleased{};
+};
+
+// construct
+template<typename NoThrowForwardIt, typename Size, typename T>
+constexpr NoThrowForwardIt tdk_uninitialized_fill_n(NoThrowForwardIt itFirst,
+	Size nCount, const T& value)
+	noexcept(std::is_nothrow_constructible_v<
+		typename std::iterator_traits<NoThrowForwardIt>::value_type, const T&>)
+{
+	using DestinationValueType = typename std::iterator_traits<NoThrowForwardIt>::value_type;
+
+	if constexpr (tdk_is_contiguous_iterator<NoThrowForwardIt>::value &&
+		std::is_trivially_copyable_v<DestinationValueType> &&
+		std::is_same_v<DestinationValueType, std::remove_cv_t<T>>)
+	{
+		if (nCount <= 0)
+			return itFirst;
+
+		if (tdk_is_byte_pattern(value))
+		{
+			std::memset(static_cast<void*>(tdk_to_address(itFirst)),
+				*reinterpret_cast<const tdk_byte*>(std::addressof(value)),
+				sizeof(DestinationValueType) * tdk_size(nCount));
+			return itFirst + nCount;
+		}
+	}
+
+	NoThrowForwardIt itCurrent = itFirst;
+	tdk_construct_rollback<NoThrowForwardIt> rollback(itFirst, itCurrent);
+
+	for (; nCount > 0; ++itCurrent, (void) --nCount)
+	{
+		void* pDestMem = static_cast<void*>(std::addressof(*itCurrent));
+		::new (pDestMem) DestinationValueType(value);
+	}
+
+	rollback.release();
+	return itCurrent;
 }
 
 // copy
 template<typename InputIt, typename Size, typename NoThrowForwardIt>
 constexpr NoThrowForwardIt tdk_uninitialized_copy_n(
 	InputIt itSrcFirst, Size nSrcCount,
-	NoThrowForwardIt itDstFirst) noexcept
+	NoThrowForwardIt itDstFirst)
+	noexcept(std::is_nothrow_constructible_v<
+		typename std::iterator_traits<NoThrowForwardIt>::value_type,
+		typename std::iterator_traits<InputIt>::reference>)
 {
 	using DestinationValueType = typename std::iterator_traits<NoThrowForwardIt>::value_type;
-	NoThrowForwardIt itDstCurrent = itDstFirst;
 
-	for (; nSrcCount > 0; --nSrcCount, (void)++itSrcFirst, (void) ++itDstCurrent)
+	if constexpr (tdk_is_bitwise_copyable<InputIt, NoThrowForwardIt>::value)
+	{
+		if (nSrcCount <= 0)
+			return itDstFirst;
+
+		std::memcpy(static_cast<void*>(tdk_to_address(itDstFirst)),
+			tdk_to_address(itSrcFirst), sizeof(DestinationValueType) * tdk_size(nSrcCount));
+		return itDstFirst + nSrcCount;
+	}
+	else
 	{
-		void* pDstMem = static_cast<void*>(std::addressof(*itDstCurrent));
-		::new (pDstMem) DestinationValueType(*itSrcFirst);
+		NoThrowForwardIt itDstCurrent = itDstFirst;
+		tdk_construct_rollback<NoThrowForwardIt> rollback(itDstFirst, itDstCurrent);
+
+		for (; nSrcCount > 0; --nSrcCount, (void)++itSrcFirst, (void) ++itDstCurrent)
+		{
+			void* pDstMem = static_cast<void*>(std::addressof(*itDstCurrent));
+			::new (pDstMem) DestinationValueType(*itSrcFirst);
+		}
+
+		rollback.release();
+		return itDstCurrent;
 	}
-	
-	return itDstCurrent;
 }
 
+// The ranges may overlap when copying to the left.
 template<typename InputIt, typename OutputIt>
-OutputIt tdk_copy(InputIt itSrcFirst, InputIt itSrcLast, OutputIt itDstFirst) noexcept
+OutputIt tdk_copy(InputIt itSrcFirst, InputIt itSrcLast, OutputIt itDstFirst)
+	noexcept(std::is_nothrow_assignable_v<
+		typename std::iterator_traits<OutputIt>::reference,
+		typename std::iterator_traits<InputIt>::reference>)
 {
-	for (; itSrcFirst != itSrcLast; (void)++itSrcFirst, (void)++itDstFirst)
-		*itDstFirst = *itSrcFirst;
+	using DestinationValueType = typename std::iterator_traits<OutputIt>::value_type;
+
+	if constexpr (tdk_is_bitwise_copyable<InputIt, OutputIt>::value &&
+		std::is_trivially_copy_assignable_v<DestinationValueType>)
+	{
+		tdk_diff nCount = itSrcLast - itSrcFirst;
+		if (nCount <= 0)
+			return itDstFirst;
+
+		std::memmove(static_cast<void*>(tdk_to_address(itDstFirst)),
+			tdk_to_address(itSrcFirst), sizeof(DestinationValueType) * tdk_size(nCount));
+		return itDstFirst + nCount;
+	}
+	else
+	{
+		for (; itSrcFirst != itSrcLast; (void)++itSrcFirst, (void)++itDstFirst)
+			*itDstFirst = *itSrcFirst;
 
-	return itDstFirst;
+		return itDstFirst;
+	}
 }
 
 template<typename BidirIt, typename Size, typename NoThrowBidirIt>
 NoThrowBidirIt tdk_uninitialized_copy_backward_n(BidirIt itSrcLast, Size nSrcCount,
-	NoThrowBidirIt itDstLast) noexcept
+	NoThrowBidirIt itDstLast)
+	noexcept(std::is_nothrow_constructible_v<
+		typename std::iterator_traits<NoThrowBidirIt>::value_type,
+		typename std::iterator_traits<BidirIt>::reference>)
 {
 	using DestinationValueType = typename std::iterator_traits<NoThrowBidirIt>::value_type;
-	NoThrowBidirIt itDstCurrent = itDstLast;
-	
-	for (; nSrcCount > 0; --nSrcCount)
+
+	if constexpr (tdk_is_bitwise_copyable<BidirIt, NoThrowBidirIt>::value)
 	{
-		void* pDstMem = static_cast<void*>(std::addressof(*(--itDstCurrent)));
-		::new (pDstMem) DestinationValueType(*(--itSrcLast));
+		if (nSrcCount <= 0)
+			return itDstLast;
+
+		std::memmove(static_cast<void*>(tdk_to_address(itDstLast - nSrcCount)),
+			tdk_to_address(itSrcLast - nSrcCount),
+			sizeof(DestinationValueType) * tdk_size(nSrcCount));
+		return itDstLast - nSrcCount;
 	}
+	else
+	{
+		// walks the destination backwards, constructed part is [first, current)
+		std::reverse_iterator<NoThrowBidirIt> itDstCurrent(itDstLast);
+		tdk_construct_rollback<std::reverse_iterator<NoThrowBidirIt>> rollback(
+			itDstCurrent, itDstCurrent);
 
-	return itDstCurrent;
+		for (; nSrcCount > 0; --nSrcCount, (void) ++itDstCurrent)
+		{
+			void* pDstMem = static_cast<void*>(std::addressof(*itDstCurrent));
+			::new (pDstMem) DestinationValueType(*(--itSrcLast));
+		}
+
+		rollback.release();
+		return itDstCurrent.base();
+	}
 }
 
+// relocate
+
+// Moves nCount objects from pSrc into raw memory at pDst and destroys the
+// sources. A type whose move constructor may throw is copied instead, so
+// after an exception the sources are intact and nothing is left in pDst.
+template<typename T, typename Size>
+T* tdk_uninitialized_relocate_n(T* pSrc, Size nCount, T* pDst)
+	noexcept(std::is_nothrow_move_constructible_v<T> ||
+		std::is_nothrow_copy_constructible_v<T>)
+{
+	if constexpr (std::is_trivially_copyable_v<T>)
+	{
+		if (nCount <= 0)
+			return pDst;
+
+		std::memcpy(static_cast<void*>(pDst), pSrc, sizeof(T) * tdk_size(nCount));
+		return pDst + nCount;
+	}
+	else
+	{
+		T* pDstCurrent = pDst;
+		tdk_construct_rollback<T*> rollback(pDst, pDstCurrent);
+
+		for (Size i = 0; i < nCount; ++i, ++pDstCurrent)
+			::new (static_cast<void*>(pDstCurrent)) T(std::move_if_noexcept(pSrc[i]));
+
+		rollback.release();
+		tdk_destroy(pSrc, pSrc + nCount);
+		return pDstCurrent;
+	}
+}
+
+// Shifts nCount objects that end at pSrcLast to end at pDstLast, to the right
+// and possibly overlapping. The vacated slots are left destroyed. A move that
+// throws half way could not be undone, since its destination slots held
+// sources that are gone, so T must move without throwing.
+template<typename T, typename Size>
+T* tdk_relocate_backward_n(T* pSrcLast, Size nCount, T* pDstLast) noexcept
+{
+	static_assert(std::is_nothrow_move_constructible_v<T>,
+		"an in-place shift cannot roll back a throwing move");
+
+	if constexpr (std::is_trivially_copyable_v<T>)
+	{
+		if (nCount <= 0)
+			return pDstLast;
+
+		std::memmove(static_cast<void*>(pDstLast - nCount), pSrcLast - nCount,
+			sizeof(T) * tdk_size(nCount));
+		return pDstLast - nCount;
+	}
+	else
+	{
+		// back to front, so every destination is either raw memory or a slot
+		// whose object has already been moved out and destroyed
+		for (; nCount > 0; --nCount)
+		{
+			--pSrcLast;
+			--pDstLast;
+			::new (static_cast<void*>(pDstLast)) T(std::move(*pSrcLast));
+			tdk_destroy_at(pSrcLast);
+		}
+		return pDstLast;
+	}
+}
+
+// Shifts nCount objects that start at pSrc to start at pDst, to the left and
+// possibly overlapping. The vacated slots are left destroyed. T must move
+// without throwing, as for tdk_relocate_backward_n.
+template<typename T, typename Size>
+T* tdk_relocate_forward_n(T* pSrc, Size nCount, T* pDst) noexcept
+{
+	static_assert(std::is_nothrow_move_constructible_v<T>,
+		"an in-place shift cannot roll back a throwing move");
+
+	if constexpr (std::is_trivially_copyable_v<T>)
+	{
+		if (nCount <= 0)
+			return pDst;
+
+		std::memmove(static_cast<void*>(pDst), pSrc, sizeof(T) * tdk_size(nCount));
+		return pDst + nCount;
+	}
+	else
+	{
+		// front to back, the mirror of tdk_relocate_backward_n
+		for (; nCount > 0; --nCount, ++pSrc, ++pDst)
+		{
+			::new (static_cast<void*>(pDst)) T(std::move(*pSrc));
+			tdk_destroy_at(pSrc);
+		}
+		return pDst;
+	}
+}
+
+// Closes a gap opened by tdk_relocate_backward_n on scope exit unless
+// release() was called: the nCount objects that start at pGapLast move back
+// to pGapFirst. Filling the gap may throw, and this puts the tail back.
+template<typename T, typename Size>
+class tdk_gap_rollback
+{
+public:
+	tdk_gap_rollback(T* pGapFirst, T* pGapLast, Size nCount) noexcept
+		: m_pGapFirst(pGapFirst)
+		, m_pGapLast(pGapLast)
+		, m_nCount(nCount)
+	{
+	}
+
+	~tdk_gap_rollback()
+	{
+		if (!m_bReleased)
+			tdk_relocate_forward_n(m_pGapLast, m_nCount, m_pGapFirst);
+	}
+
+	tdk_gap_rollback(const tdk_gap_rollback&) = delete;
+	tdk_gap_rollback& operator=(const tdk_gap_rollback&) = delete;
+
+	void release() noexcept
+	{
+		m_bReleased = true;
+	}
+
+private:
+	T* m_pGapFirst;
+	T* m_pGapLast;
+	Size m_nCount;
+	bool m_bReleased{};
+};
+
 #endif //TDK_MEMUTL_H
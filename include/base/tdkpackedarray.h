@@ -0,0 +1,459 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: bit packed integer arrays.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_PACKEDARRAY_H
+#define TDK_PACKEDARRAY_H
+
+#include "base/tdkbasedefs.h"
+#include "base/tdkbaseutl.h"
+#include "base/tdkpoddarray.h"
+#include "system/tdksimd.h"
+
+#include <cassert>
+#include <cstring>
+
+// Array of tdk_u32 values stored with bit_width() bits each. The width
+// starts at 0 and grows to fit the largest value written, every growth
+// repacks the array once. A spare word after the last value lets a read
+// take two words without checking whether the value crosses a boundary.
+class tdk_packed_array
+{
+public:
+	typedef tdk_size size_type;
+	typedef tdk_u32 value_type;
+
+	tdk_packed_array() = default;
+
+	tdk_ret push_back(tdk_u32 nVal, tdk_err* pErrorCode = nullptr)
+	{
+		tdk_ret retVal = fit(nVal, pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		retVal = m_words.resize(words_for(m_nCount + 1, m_nWidth), 0, pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		put(m_nCount++, nVal);
+		return kTDK_OK;
+	}
+
+	// Fails only when a wider value needs a repack that cannot be allocated.
+	tdk_ret set(size_type idx, tdk_u32 nVal, tdk_err* pErrorCode = nullptr)
+	{
+		assert(idx < m_nCount);
+		tdk_ret retVal = fit(nVal, pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		put(idx, nVal);
+		return kTDK_OK;
+	}
+
+	tdk_u32 get(size_type idx) const
+	{
+		assert(idx < m_nCount);
+		if (!m_nWidth)
+			return 0;
+
+		tdk_u64 nBit = tdk_u64(idx) * m_nWidth;
+		const tdk_u64* pWord = m_words.data() + nBit / 64;
+		tdk_u32 nShift = tdk_u32(nBit % 64);
+		// two shifts, so a zero nShift does not shift by 64
+		tdk_u64 nVal = (pWord[0] >> nShift) | ((pWord[1] << 1) << (63 - nShift));
+		return tdk_u32(nVal) & mask();
+	}
+
+	tdk_u32 operator[](size_type idx) const
+	{
+		return get(idx);
+	}
+
+	// Replaces the content, the width is taken from the largest value.
+	tdk_ret assign(const tdk_u32* pValues, size_type nCount,
+		tdk_err* pErrorCode = nullptr)
+	{
+		tdk_u32 nAll = 0;
+		for (size_type i = 0; i < nCount; ++i)
+			nAll |= pValues[i];
+
+		tdk_packed_array tmp;
+		tmp.m_nWidth = tdk_bit_width(nAll);
+		tdk_ret retVal = tmp.m_words.resize(words_for(nCount, tmp.m_nWidth), 0,
+			pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		for (size_type i = 0; i < nCount; ++i)
+			tmp.put(i, pValues[i]);
+		tmp.m_nCount = nCount;
+		swap(tmp);
+		return kTDK_OK;
+	}
+
+	// New values are zero.
+	tdk_ret resize(size_type nCount, tdk_err* pErrorCode = nullptr)
+	{
+		// dropped values may share the last kept word, clear them while it
+		// and the words after it are still there
+		if (nCount < m_nCount)
+		{
+			for (size_type i = nCount; i < m_nCount; ++i)
+				put(i, 0);
+			m_nCount = nCount;
+		}
+
+		tdk_ret retVal = m_words.resize(words_for(nCount, m_nWidth), 0, pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		m_nCount = nCount;
+		return kTDK_OK;
+	}
+
+	tdk_ret reserve(size_type nCount, tdk_err* pErrorCode = nullptr)
+	{
+		return m_words.reserve(words_for(nCount, m_nWidth), pErrorCode);
+	}
+
+	// Keeps the width.
+	void clear()
+	{
+		m_words.clear();
+		m_nCount = 0;
+	}
+
+	void swap(tdk_packed_array& oth) noexcept
+	{
+		m_words.swap(oth.m_words);
+		std::swap(m_nCount, oth.m_nCount);
+		std::swap(m_nWidth, oth.m_nWidth);
+	}
+
+	// pOut[i] = get(nFirst + i) for nCount values.
+	void unpack(size_type nFirst, size_type nCount, tdk_u32* pOut) const
+	{
+		assert(nFirst + nCount <= m_nCount);
+		for (size_type i = 0; i < nCount; ++i)
+			pOut[i] = get(nFirst + i);
+	}
+
+	size_type size() const
+	{
+		return m_nCount;
+	}
+
+	bool empty() const
+	{
+		return 0 == m_nCount;
+	}
+
+	tdk_u32 bit_width() const
+	{
+		return m_nWidth;
+	}
+
+	// bytes held by the packed values
+	size_type byte_size() const
+	{
+		return m_words.size() * sizeof(tdk_u64);
+	}
+
+private:
+	static size_type words_for(size_type nCount, tdk_u32 nWidth)
+	{
+		return (tdk_u64(nCount) * nWidth + 63) / 64 + 1;
+	}
+
+	tdk_u32 mask() const
+	{
+		return m_nWidth >= 32 ? ~tdk_u32(0) : (tdk_u32(1) << m_nWidth) - 1;
+	}
+
+	tdk_ret fit(tdk_u32 nVal, tdk_err* pErrorCode)
+	{
+		tdk_u32 nWidth = tdk_bit_width(nVal);
+		if (nWidth <= m_nWidth)
+			return kTDK_OK;
+
+		tdk_packed_array tmp;
+		tmp.m_nWidth = nWidth;
+		tdk_ret retVal = tmp.m_words.resize(words_for(m_nCount, nWidth), 0,
+			pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		for (size_type i = 0; i < m_nCount; ++i)
+			tmp.put(i, get(i));
+		tmp.m_nCount = m_nCount;
+		swap(tmp);
+		return kTDK_OK;
+	}
+
+	void put(size_type idx, tdk_u32 nVal)
+	{
+		if (!m_nWidth)
+			return;
+
+		tdk_u64 nBit = tdk_u64(idx) * m_nWidth;
+		tdk_u64* pWord = m_words.data() + nBit / 64;
+		tdk_u32 nShift = tdk_u32(nBit % 64);
+		tdk_u64 nMask = mask();
+		pWord[0] = (pWord[0] & ~(nMask << nShift)) | (tdk_u64(nVal) << nShift);
+		if (nShift + m_nWidth > 64)
+		{
+			tdk_u32 nSpill = 64 - nShift;
+			pWord[1] = (pWord[1] & ~(nMask >> nSpill)) | (tdk_u64(nVal) >> nSpill);
+		}
+	}
+
+	tdk_podarray<tdk_u64> m_words;
+	size_type m_nCount{};
+	tdk_u32 m_nWidth{};
+};
+
+//-----------------------------------------------------------------------------
+// Read only compressed copy of a tdk_u32 column, built once by build(). The
+// values are cut in blocks of kTDK_PACK_BLOCK, each packed by
+// tdk_simd_pack128 in one of two ways, whichever is narrower:
+//	frame of reference: value - block minimum;
+//	delta: value - value four positions earlier, for blocks that grow in
+//	each of the four lanes, as sorted IDs do.
+// The block table is the skip index: it holds the base value, the width
+// and the word offset of every block. get() reads one value of a frame of
+// reference block, a delta block sums at most 32 deltas of one lane;
+// decode() unpacks whole blocks with the SIMD kernels.
+class tdk_packed_delta_array
+{
+public:
+	typedef tdk_size size_type;
+	typedef tdk_u32 value_type;
+
+	tdk_packed_delta_array() = default;
+
+	tdk_ret build(const tdk_u32* pValues, size_type nCount,
+		tdk_err* pErrorCode = nullptr)
+	{
+		size_type nBlocks = (nCount + kTDK_PACK_BLOCK - 1) / kTDK_PACK_BLOCK;
+		tdk_podarray<Block> blocks;
+		tdk_podarray<tdk_u32> words;
+		tdk_ret retVal = blocks.resize(nBlocks, Block(), pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		tdk_u32 block[kTDK_PACK_BLOCK];
+		tdk_u32 packed[4 * 32];
+		for (size_type nBlock = 0; nBlock < nBlocks; ++nBlock)
+		{
+			// the last block is padded with its last value
+			size_type nFirst = nBlock * kTDK_PACK_BLOCK;
+			size_type nTaken = tdk_min(size_type(kTDK_PACK_BLOCK), nCount - nFirst);
+			std::memcpy(block, pValues + nFirst, nTaken * sizeof(tdk_u32));
+			for (size_type i = nTaken; i < kTDK_PACK_BLOCK; ++i)
+				block[i] = block[nTaken - 1];
+
+			Block& info = blocks[nBlock];
+			encode_block(block, info);
+
+			if (words.size() > tdk_u32(-1) - 4 * 32)
+			{
+				tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+				return kTDK_FATAL;
+			}
+			info.nWordOffset = tdk_u32(words.size());
+			tdk_simd_pack128(block, info.nWidth, packed);
+			retVal = words.insert(words.end(), packed, packed + 4 * info.nWidth,
+				pErrorCode);
+			if (kTDK_OK != retVal)
+				return retVal;
+		}
+
+		m_blocks.swap(blocks);
+		m_words.swap(words);
+		m_nCount = nCount;
+		return kTDK_OK;
+	}
+
+	tdk_u32 get(size_type idx) const
+	{
+		assert(idx < m_nCount);
+		const Block& info = m_blocks[idx / kTDK_PACK_BLOCK];
+		const tdk_u32* pWords = m_words.data() + info.nWordOffset;
+		tdk_u32 nInBlock = tdk_u32(idx % kTDK_PACK_BLOCK);
+		if (!info.bDelta)
+			return info.nBase + extract(pWords, info.nWidth, nInBlock);
+
+		tdk_u32 nVal = info.nBase;
+		for (tdk_u32 i = nInBlock % 4; i <= nInBlock; i += 4)
+			nVal += extract(pWords, info.nWidth, i);
+		return nVal;
+	}
+
+	tdk_u32 operator[](size_type idx) const
+	{
+		return get(idx);
+	}
+
+	// pOut[i] = get(nFirst + i) for nCount values.
+	void decode(size_type nFirst, size_type nCount, tdk_u32* pOut) const
+	{
+		assert(nFirst + nCount <= m_nCount);
+		tdk_u32 block[kTDK_PACK_BLOCK];
+		while (nCount)
+		{
+			size_type nBlock = nFirst / kTDK_PACK_BLOCK;
+			size_type nSkip = nFirst % kTDK_PACK_BLOCK;
+			size_type nTaken = tdk_min(size_type(kTDK_PACK_BLOCK) - nSkip, nCount);
+
+			// whole blocks go straight to the caller's buffer
+			tdk_u32* pBlockOut = nTaken == kTDK_PACK_BLOCK ? pOut : block;
+			const Block& info = m_blocks[nBlock];
+			const tdk_u32* pWords = m_words.data() + info.nWordOffset;
+			if (info.bDelta)
+				tdk_simd_unpack128_delta(pWords, info.nWidth, info.nBase, pBlockOut);
+			else
+				tdk_simd_unpack128(pWords, info.nWidth, info.nBase, pBlockOut);
+			if (pBlockOut == block)
+				std::memcpy(pOut, block + nSkip, nTaken * sizeof(tdk_u32));
+
+			pOut += nTaken;
+			nFirst += nTaken;
+			nCount -= nTaken;
+		}
+	}
+
+	void clear()
+	{
+		m_blocks.clear();
+		m_words.clear();
+		m_nCount = 0;
+	}
+
+	size_type size() const
+	{
+		return m_nCount;
+	}
+
+	bool empty() const
+	{
+		return 0 == m_nCount;
+	}
+
+	// bytes held by the packed values and the block table
+	size_type byte_size() const
+	{
+		return m_words.size() * sizeof(tdk_u32) + m_blocks.size() * sizeof(Block);
+	}
+
+private:
+	struct Block
+	{
+		tdk_u32 nBase;
+		tdk_u32 nWordOffset;
+		tdk_byte nWidth;
+		tdk_byte bDelta;
+	};
+
+	static tdk_u32 extract(const tdk_u32* pWords, tdk_u32 nWidth, tdk_u32 nIndex)
+	{
+		if (!nWidth)
+			return 0;
+
+		tdk_u32 nBit = (nIndex / 4) * nWidth;
+		const tdk_u32* pLane = pWords + nIndex % 4;
+		tdk_u32 nShift = nBit % 32;
+		tdk_u32 nVal = pLane[4 * (nBit / 32)] >> nShift;
+		if (nShift + nWidth > 32)
+			nVal |= pLane[4 * (nBit / 32 + 1)] << (32 - nShift);
+		return nWidth >= 32 ? nVal : nVal & ((tdk_u32(1) << nWidth) - 1);
+	}
+
+	// Picks the encoding and turns block into the values to pack.
+	static void encode_block(tdk_u32* pBlock, Block& info)
+	{
+		tdk_u32 nMin = pBlock[0];
+		tdk_u32 nMax = pBlock[0];
+		for (tdk_size i = 1; i < kTDK_PACK_BLOCK; ++i)
+		{
+			nMin = tdk_min(nMin, pBlock[i]);
+			nMax = tdk_max(nMax, pBlock[i]);
+		}
+
+		tdk_u32 nLaneMin = tdk_min(tdk_min(pBlock[0], pBlock[1]),
+			tdk_min(pBlock[2], pBlock[3]));
+		bool bGrows = true;
+		tdk_u32 nDeltas = 0;
+		for (tdk_size i = 0; i < kTDK_PACK_BLOCK && bGrows; ++i)
+		{
+			tdk_u32 nPrev = i < 4 ? nLaneMin : pBlock[i - 4];
+			bGrows = pBlock[i] >= nPrev;
+			nDeltas |= pBlock[i] - nPrev;
+		}
+
+		tdk_u32 nForWidth = tdk_bit_width(nMax - nMin);
+		info.bDelta = bGrows && tdk_bit_width(nDeltas) < nForWidth;
+		if (info.bDelta)
+		{
+			info.nBase = nLaneMin;
+			info.nWidth = tdk_byte(tdk_bit_width(nDeltas));
+			for (tdk_size i = kTDK_PACK_BLOCK; i-- > 0;)
+				pBlock[i] -= i < 4 ? nLaneMin : pBlock[i - 4];
+		}
+		else
+		{
+			info.nBase = nMin;
+			info.nWidth = tdk_byte(nForWidth);
+			for (tdk_size i = 0; i < kTDK_PACK_BLOCK; ++i)
+				pBlock[i] -= nMin;
+		}
+	}
+
+	tdk_podarray<Block> m_blocks;
+	tdk_podarray<tdk_u32> m_words;
+	size_type m_nCount{};
+};
+
+#endif //TDK_PACKEDARRAY_H
@@ -36,7 +36,7 @@ SOFTWARE.
 -------------
  Description
 -------------
-Purpose: compiler-specific macro definitions.
+Purpose: dynamic array of trivially copyable elements.
 
 ----------------------
  For developers notes
@@ -48,15 +48,41 @@ Purpose: compiler-specific macro definitions.
 #define TDK_PODARRAY_H
 
 
-#include "tdkbasedefs.h"
-#include "tdkmemalloc.h"
+#include "base/tdkbasedefs.h"
+#include "base/tdkmemalloc.h"
+#include "system/tdksimd.h"
 
-template <typename TElem, typename TMemAlloc>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+// Dynamic array for trivially copyable elements. Elements are never
+// constructed or destroyed, all bulk moves are memcpy/memmove.
+template <typename TElem, typename Allocator = tdk_allocator<TElem>>
 class tdk_podarray
 {
+	static_assert(std::is_trivially_copyable_v<TElem>,
+		"tdk_podarray requires a trivially copyable type, use tdk_darray");
+
+	using AllocatorForT = typename
+		  std::allocator_traits<Allocator>::template rebind_alloc<TElem>;
 public:
 	typedef tdk_size size_type;
+	typedef tdk_diff difference_type;
+
+	typedef TElem value_type;
+	typedef Allocator allocator_type;
+
+	typedef TElem& reference;
+	typedef const TElem& const_reference;
+	typedef TElem* pointer;
+	typedef const TElem* const_pointer;
 	typedef TElem* iterator;
+	typedef const TElem* const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
 
 	enum Constants
 	{
@@ -64,63 +90,217 @@ public:
 	};
 
 	tdk_podarray()
-		: m_pData(TDK_NULL)
+		: m_pData(nullptr)
 		, m_nCount(0)
 		, m_nCapacity(0)
 	{
 
 	}
 
+	// Leaves the array empty if the memory cannot be allocated, use assign()
+	// to get the error.
+	tdk_podarray(const tdk_podarray& oth)
+		: tdk_podarray()
+	{
+		assign(oth.m_pData, oth.m_nCount);
+	}
+
+	tdk_podarray(tdk_podarray&& oth) noexcept
+		: m_pData(oth.m_pData)
+		, m_nCount(oth.m_nCount)
+		, m_nCapacity(oth.m_nCapacity)
+	{
+		oth.m_pData = nullptr;
+		oth.m_nCount = 0;
+		oth.m_nCapacity = 0;
+	}
+
 	~tdk_podarray()
 	{
 		clear();
 		resize_memory(0);
 	}
 
+	tdk_podarray& operator=(const tdk_podarray& oth)
+	{
+		if (this != &oth)
+			assign(oth.m_pData, oth.m_nCount);
+		return *this;
+	}
+
+	tdk_podarray& operator=(tdk_podarray&& oth) noexcept
+	{
+		tdk_podarray tmp(std::move(oth));
+		swap(tmp);
+		return *this;
+	}
+
+	void swap(tdk_podarray& oth) noexcept
+	{
+		std::swap(m_pData, oth.m_pData);
+		std::swap(m_nCount, oth.m_nCount);
+		std::swap(m_nCapacity, oth.m_nCapacity);
+	}
+
 	void clear()
 	{
 		m_nCount = 0;
 	}
 
-	tdk_u32 push_back(const TElem& val)
+	tdk_ret assign(const TElem* pSrc, size_type nCount,
+		tdk_err* pErrorCode = nullptr)
 	{
-		size_type nNewCount = m_nCount + 1;
-	
-		if (nNewCount > m_nCapacity)
+		if (nCount > m_nCapacity)
 		{
-			size_type nNewCap = m_nCapacity;
-			if (nNewCap < kMIN_CAP)
-				nNewCap = kMIN_CAP;
-			
-			while (nNewCap < nNewCount)
-			{
-				nNewCap *= 2;
-			}
+			// the source may live in our own buffer, keep it until copied
+			tdk_podarray tmp;
+			tdk_ret retVal = tmp.resize_memory(nCount, pErrorCode);
+			if (kTDK_OK != retVal)
+				return retVal;
 
-			tdk_u32 retVal = resize_memory(nNewCap);
+			copy_elements(tmp.m_pData, pSrc, nCount);
+			tmp.m_nCount = nCount;
+			swap(tmp);
+			return kTDK_OK;
+		}
+
+		move_elements(m_pData, pSrc, nCount);
+		m_nCount = nCount;
+		return kTDK_OK;
+	}
+
+	tdk_ret push_back(const TElem& val, tdk_err* pErrorCode = nullptr)
+	{
+		if (m_nCount == m_nCapacity)
+		{
+			// val may be one of our elements
+			const TElem valCopy = val;
+			tdk_ret retVal = grow_memory(1, pErrorCode);
 			if (kTDK_OK != retVal)
 			{
 				return retVal;
 			}
+			m_pData[m_nCount++] = valCopy;
+			return kTDK_OK;
+		}
+
+		m_pData[m_nCount++] = val;
+		return kTDK_OK;
+	}
+
+	void pop_back()
+	{
+		assert(m_nCount);
+		--m_nCount;
+	}
+
+	tdk_ret insert(const_iterator pos, const TElem& val,
+		tdk_err* pErrorCode = nullptr)
+	{
+		return insert(pos, std::addressof(val), std::addressof(val) + 1,
+			pErrorCode);
+	}
+
+	tdk_ret insert(const_iterator pos, const TElem* pFirst, const TElem* pLast,
+		tdk_err* pErrorCode = nullptr)
+	{
+		assert(pos >= begin() && pos <= end());
+		size_type nBeforeGap = pos - begin();
+		size_type nGap = pLast - pFirst;
+		if (!nGap)
+			return kTDK_OK;
+
+		if (pFirst < end() && pLast > begin())
+		{
+			// inserting a part of ourselves, copy it out first
+			tdk_podarray tmp;
+			tdk_ret retVal = tmp.assign(pFirst, nGap, pErrorCode);
+			if (kTDK_OK != retVal)
+				return retVal;
+			return insert(begin() + nBeforeGap, tmp.begin(), tmp.end(), pErrorCode);
+		}
+
+		tdk_ret retVal = grow_memory(nGap, pErrorCode);
+		if (kTDK_OK != retVal)
+		{
+			return retVal;
+		}
+
+		move_elements(m_pData + nBeforeGap + nGap, m_pData + nBeforeGap,
+			m_nCount - nBeforeGap);
+		copy_elements(m_pData + nBeforeGap, pFirst, nGap);
+		m_nCount += nGap;
+		return kTDK_OK;
+	}
+
+	// Returns the iterator to the element that followed the erased ones.
+	iterator erase(const_iterator pos)
+	{
+		return erase(pos, pos + 1);
+	}
+
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		assert(first >= begin() && first <= last && last <= end());
+		size_type nFirst = first - begin();
+		size_type nLast = last - begin();
+		move_elements(m_pData + nFirst, m_pData + nLast, m_nCount - nLast);
+		m_nCount -= nLast - nFirst;
+		return m_pData + nFirst;
+	}
+
+	// New elements are copies of val.
+	tdk_ret resize(size_type nNewCount, const TElem& val = TElem(),
+		tdk_err* pErrorCode = nullptr)
+	{
+		size_type nOldCount = m_nCount;
+		if (nNewCount > nOldCount)
+		{
+			const TElem valCopy = val;
+			tdk_ret retVal = resize_uninitialized(nNewCount, pErrorCode);
+			if (kTDK_OK != retVal)
+				return retVal;
+			fill_elements(m_pData + nOldCount, nNewCount - nOldCount, valCopy);
+			return kTDK_OK;
+		}
+
+		m_nCount = nNewCount;
+		return kTDK_OK;
+	}
+
+	// New elements keep whatever bytes the memory had. For buffers that are
+	// overwritten right away (file reads, memcpy targets, SIMD output).
+	tdk_ret resize_uninitialized(size_type nNewCount, tdk_err* pErrorCode = nullptr)
+	{
+		if (nNewCount > m_nCount)
+		{
+			tdk_ret retVal = grow_memory(nNewCount - m_nCount, pErrorCode);
+			if (kTDK_OK != retVal)
+				return retVal;
 		}
 
-		TElem* pNewElem = m_pData + m_nCount;
-		if (pNewElem)
-			*pNewElem = val;
-		++m_nCount;
+		m_nCount = nNewCount;
 		return kTDK_OK;
 	}
 
-	tdk_u32 reserve(size_type nNewCap)
+	tdk_ret reserve(size_type nNewCap, tdk_err* pErrorCode = nullptr)
 	{
 		if (nNewCap <= m_nCapacity)
 			return kTDK_OK;
-		return resize_memory(nNewCap);
-	} 
+		return resize_memory(nNewCap, pErrorCode);
+	}
 
-	template<typename EqPred>
+	tdk_ret shrink_to_fit(tdk_err* pErrorCode = nullptr)
+	{
+		if (m_nCount == m_nCapacity)
+			return kTDK_OK;
+		return resize_memory(m_nCount, pErrorCode);
+	}
+
+	template<typename EqPred,
+		typename = std::enable_if_t<!std::is_integral_v<EqPred>>>
 	size_type find(const TElem& val, const EqPred& pred,
-		size_type startIdx = 0, size_type endIdx = m_nCount) const
+		size_type startIdx = 0, size_type endIdx = size_type(-1)) const
 	{
 		if (endIdx > m_nCount)
 			endIdx = m_nCount;
@@ -133,30 +313,198 @@ public:
 		return m_nCount;
 	}
 
+	// operator== search; arithmetic types go to the SIMD kernels
+	size_type find(const TElem& val, size_type startIdx = 0,
+		size_type endIdx = size_type(-1)) const
+	{
+		if (endIdx > m_nCount)
+			endIdx = m_nCount;
+		if (startIdx >= endIdx)
+			return m_nCount;
+
+		size_type nFound = 0;
+		if constexpr (kSIMD_SEARCH)
+		{
+			nFound = tdk_simd_find(simd_data() + startIdx, endIdx - startIdx,
+				simd_value(val));
+		}
+		else
+		{
+			nFound = find(val, [](const TElem& a, const TElem& b) { return a == b; },
+				startIdx, endIdx) - startIdx;
+		}
+		return startIdx + nFound < endIdx ? startIdx + nFound : m_nCount;
+	}
+
+	size_type count(const TElem& val, size_type startIdx = 0,
+		size_type endIdx = size_type(-1)) const
+	{
+		if (endIdx > m_nCount)
+			endIdx = m_nCount;
+		if (startIdx >= endIdx)
+			return 0;
+
+		if constexpr (kSIMD_SEARCH)
+		{
+			return tdk_simd_count(simd_data() + startIdx, endIdx - startIdx,
+				simd_value(val));
+		}
+		else
+		{
+			size_type nFound = 0;
+			for (size_type idx = startIdx; idx < endIdx; ++idx)
+				nFound += m_pData[idx] == val;
+			return nFound;
+		}
+	}
+
+	// Appends the indices of all elements equal to val to indices.
+	template<typename IndexArray>
+	tdk_ret find_all(const TElem& val, IndexArray& indices,
+		size_type startIdx = 0, size_type endIdx = size_type(-1)) const
+	{
+		if (endIdx > m_nCount)
+			endIdx = m_nCount;
+
+		for (size_type idx = find(val, startIdx, endIdx); idx < endIdx;
+			idx = find(val, idx + 1, endIdx))
+		{
+			tdk_ret retVal = indices.push_back(idx);
+			if (kTDK_OK != retVal)
+				return retVal;
+		}
+		return kTDK_OK;
+	}
+
+	// For an array sorted by less: index of the first element that is not
+	// less than val, size() if there is none. The loop has no data-dependent
+	// branches, so it does not stall on mispredictions.
+	template<typename Less>
+	size_type lower_bound(const TElem& val, const Less& less) const
+	{
+		if (!m_nCount)
+			return 0;
+
+		const TElem* pBase = m_pData;
+		size_type n = m_nCount;
+		while (n > 1)
+		{
+			size_type nHalf = n / 2;
+			pBase = less(pBase[nHalf], val) ? pBase + nHalf : pBase;
+			n -= nHalf;
+		}
+		return (pBase - m_pData) + (less(*pBase, val) ? 1 : 0);
+	}
+
+	size_type lower_bound(const TElem& val) const
+	{
+		return lower_bound(val, [](const TElem& a, const TElem& b) { return a < b; });
+	}
+
+
 	TElem* at(size_type idx)
 	{
 		if (idx >= m_nCount)
-			return TDK_NULL;
+			return nullptr;
 		return m_pData + idx;
 	}
 
 	const TElem* at(size_type idx) const
 	{
 		if (idx >= m_nCount)
-			return TDK_NULL;
+			return nullptr;
 		return m_pData + idx;
 	}
 
+	TElem& operator[](size_type idx)
+	{
+		assert(idx < m_nCount);
+		return m_pData[idx];
+	}
+
+	const TElem& operator[](size_type idx) const
+	{
+		assert(idx < m_nCount);
+		return m_pData[idx];
+	}
+
+	TElem& back()
+	{
+		assert(m_nCount);
+		return m_pData[m_nCount - 1];
+	}
+
+	const TElem& back() const
+	{
+		assert(m_nCount);
+		return m_pData[m_nCount - 1];
+	}
+
+	TElem* data()
+	{
+		return m_pData;
+	}
+
+	const TElem* data() const
+	{
+		return m_pData;
+	}
+
 	iterator begin()
 	{
 		return m_pData;
 	}
 
+	const_iterator begin() const
+	{
+		return m_pData;
+	}
+
+	const_iterator cbegin() const
+	{
+		return m_pData;
+	}
+
 	iterator end()
 	{
 		return m_pData + m_nCount;
 	}
 
+	const_iterator end() const
+	{
+		return m_pData + m_nCount;
+	}
+
+	const_iterator cend() const
+	{
+		return m_pData + m_nCount;
+	}
+
+	reverse_iterator rbegin()
+	{
+		return reverse_iterator(end());
+	}
+
+	const_reverse_iterator rbegin() const
+	{
+		return const_reverse_iterator(end());
+	}
+
+	reverse_iterator rend()
+	{
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator rend() const
+	{
+		return const_reverse_iterator(begin());
+	}
+
+	bool empty() const
+	{
+		return 0 == m_nCount;
+	}
+
 	size_type size() const
 	{
 		return m_nCount;
@@ -166,49 +514,147 @@ public:
 	{
 		return m_nCapacity;
 	}
+
+	static constexpr size_type max_size()
+	{
+		return size_type(-1) / sizeof(TElem);
+	}
+
+	allocator_type get_allocator() const
+	{
+		return allocator_type();
+	}
 private:
-	tdk_u32 resize_memory(size_type nNewCap)
+	using SimdType = typename tdk_simd_search_type<TElem>::type;
+	static constexpr bool kSIMD_SEARCH = !std::is_void_v<SimdType>;
+
+	const SimdType* simd_data() const
+	{
+		return reinterpret_cast<const SimdType*>(m_pData);
+	}
+
+	static SimdType simd_value(const TElem& val)
+	{
+		SimdType result;
+		std::memcpy(&result, &val, sizeof(result));
+		return result;
+	}
+
+	static void copy_elements(TElem* pDst, const TElem* pSrc, size_type nCount)
+	{
+		if (nCount)
+			std::memcpy(pDst, pSrc, sizeof(TElem) * nCount);
+	}
+
+	static void move_elements(TElem* pDst, const TElem* pSrc, size_type nCount)
+	{
+		if (nCount)
+			std::memmove(pDst, pSrc, sizeof(TElem) * nCount);
+	}
+
+	static void fill_elements(TElem* pDst, size_type nCount, const TElem& val)
 	{
-		tdk_imemalloc* pMemAlloc = TMemAlloc::instance();
-		//TDK_ASSERT(pMemAlloc);
-    
-		size_type nReqBytes = sizeof(TElem) * nNewCap;
-		void* pMem = TDK_NULL;
+		// a value made of one repeated byte (zero most of the time) is a memset
+		const tdk_byte* pValBytes = reinterpret_cast<const tdk_byte*>(&val);
+		bool bSameBytes = true;
+		for (size_type i = 1; i < sizeof(TElem) && bSameBytes; ++i)
+			bSameBytes = pValBytes[i] == pValBytes[0];
+
+		if (bSameBytes)
+		{
+			std::memset(pDst, pValBytes[0], sizeof(TElem) * nCount);
+			return;
+		}
+
+		for (size_type i = 0; i < nCount; ++i)
+			pDst[i] = val;
+	}
+
+	size_type suggest_capacity(size_type nNewCount) const
+	{
+		size_type nNewCap = m_nCapacity;
+		if (nNewCap < kMIN_CAP)
+			nNewCap = kMIN_CAP;
+
+		// grow_memory() keeps nNewCount within max_size(), so the doubling
+		// stops there instead of wrapping around to 0
+		while (nNewCap < nNewCount)
+		{
+			if (nNewCap > max_size() / 2)
+				return max_size();
+			nNewCap *= 2;
+		}
+
+		return nNewCap;
+	}
+
+	tdk_ret grow_memory(size_type nGrowBy, tdk_err* pErrorCode)
+	{
+		if (nGrowBy > max_size() - m_nCount)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+			return kTDK_FATAL;
+		}
+
+		size_type nNewCount = m_nCount + nGrowBy;
+		if (nNewCount <= m_nCapacity)
+			return kTDK_OK;
+
+		return resize_memory(suggest_capacity(nNewCount), pErrorCode);
+	}
+
+	tdk_ret resize_memory(size_type nNewCap, tdk_err* pErrorCode = nullptr)
+	{
+		if (nNewCap > max_size())
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+			return kTDK_FATAL;
+		}
+
+		AllocatorForT memAlloc;
+
 		if (m_pData)
 		{
 			if (0 == nNewCap)
 			{
-				pMemAlloc->deallocate(m_pData);
-				m_pData = TDK_NULL;
+				memAlloc.deallocate(m_pData, m_nCapacity);
+				m_pData = nullptr;
 				m_nCapacity = 0;
+				m_nCount = 0;
 				return kTDK_OK;
 			}
 
-			pMem = pMemAlloc->reallocate(m_pData, nReqBytes);
+			TElem* pMem = memAlloc.allocate(nNewCap);
 			if (!pMem)
 			{
+				tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
 				return kTDK_FATAL;
 			}
 
-			m_pData = (TElem*)pMem;
+			m_nCount = tdk_min(m_nCount, nNewCap);
+			copy_elements(pMem, m_pData, m_nCount);
+			memAlloc.deallocate(m_pData, m_nCapacity);
+			m_pData = pMem;
 			m_nCapacity = nNewCap;
 			return kTDK_OK;
 		}
 
 		if (nNewCap)
 		{
-			pMem = pMemAlloc->allocate(nReqBytes);
+			TElem* pMem = memAlloc.allocate(nNewCap);
 			if (!pMem)
 			{
+				tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
 				return kTDK_FATAL;
 			}
 
-			m_pData = (TElem*)pMem;
+			m_pData = pMem;
 			m_nCapacity = nNewCap;
 			return kTDK_OK;
 		}
 		return kTDK_OK;
 	}
+
 	TElem* m_pData;
 	size_type m_nCount;
 	size_type m_nCapacity;
@@ -0,0 +1,304 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: d-ary heap priority queue.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_PRIORITYQUEUE_H
+#define TDK_PRIORITYQUEUE_H
+
+#include "base/tdkdarray.h"
+
+#include <cassert>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+// Default move observer of tdk_priority_queue, tracks nothing.
+struct tdk_heap_no_tracking
+{
+	template<typename T>
+	void operator()(const T&, tdk_size) const
+	{
+	}
+};
+
+//-----------------------------------------------------------------------------
+// Priority queue on a D-ary heap in a tdk_darray. With std::less the top is
+// the largest element, as in std::priority_queue. A binary heap touches a
+// new cache line on every level; with 4 or 8 children of a small T in one
+// line the heap is two or three times shallower and the sift down compares
+// siblings that are already loaded.
+//
+// OnMove is called as onMove(elem, nIndex) whenever an element lands on a
+// new index, including its first one. Recording the index in the element's
+// owner lets update() and erase() reach it later, that is the decrease-key
+// operation of timer and scheduler queues.
+template<typename T, typename Compare = std::less<T>, tdk_size D = 4,
+	typename OnMove = tdk_heap_no_tracking>
+class tdk_priority_queue
+{
+	static_assert(D >= 2, "a heap needs at least two children per node");
+public:
+	typedef tdk_size size_type;
+	typedef T value_type;
+	typedef const T* const_iterator;
+
+	explicit tdk_priority_queue(const Compare& comp = Compare(),
+		const OnMove& onMove = OnMove())
+		: m_comp(comp)
+		, m_onMove(onMove)
+	{
+	}
+
+	tdk_priority_queue(const tdk_priority_queue&) = delete;
+	tdk_priority_queue& operator=(const tdk_priority_queue&) = delete;
+
+	tdk_ret push(const T& val, tdk_err* pErrorCode = nullptr)
+	{
+		tdk_ret retVal = m_heap.push_back(val, pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		sift_up(m_heap.size() - 1);
+		return kTDK_OK;
+	}
+
+	tdk_ret push(T&& val, tdk_err* pErrorCode = nullptr)
+	{
+		tdk_ret retVal = m_heap.push_back(std::move(val), pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		sift_up(m_heap.size() - 1);
+		return kTDK_OK;
+	}
+
+	const T& top() const
+	{
+		assert(!empty());
+		return m_heap[0];
+	}
+
+	void pop()
+	{
+		erase(0);
+	}
+
+	// Removes the element at nIndex, as reported to OnMove.
+	void erase(size_type nIndex)
+	{
+		assert(nIndex < size());
+		size_type nLast = m_heap.size() - 1;
+		if (nIndex != nLast)
+		{
+			m_heap[nIndex] = std::move(m_heap[nLast]);
+			m_heap.pop_back();
+			restore(nIndex);
+			return;
+		}
+		m_heap.pop_back();
+	}
+
+	// Replaces the element at nIndex and moves it up or down as needed.
+	void update(size_type nIndex, const T& val)
+	{
+		assert(nIndex < size());
+		m_heap[nIndex] = val;
+		restore(nIndex);
+	}
+
+	void update(size_type nIndex, T&& val)
+	{
+		assert(nIndex < size());
+		m_heap[nIndex] = std::move(val);
+		restore(nIndex);
+	}
+
+	// Adds [firstIt, lastIt) and rebuilds the heap bottom up, O(n) instead
+	// of O(n log n) for pushing one by one.
+	template<typename InputIt>
+	tdk_ret push_range(InputIt firstIt, InputIt lastIt,
+		tdk_err* pErrorCode = nullptr)
+	{
+		tdk_ret retVal = m_heap.insert(m_heap.end(), firstIt, lastIt, pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		heapify();
+		return kTDK_OK;
+	}
+
+	tdk_ret reserve(size_type nCount, tdk_err* pErrorCode = nullptr)
+	{
+		return m_heap.reserve(nCount, pErrorCode);
+	}
+
+	void clear()
+	{
+		m_heap.clear();
+	}
+
+	// elements in heap order
+	const T* data() const
+	{
+		return m_heap.data();
+	}
+
+	const_iterator begin() const
+	{
+		return m_heap.begin();
+	}
+
+	const_iterator end() const
+	{
+		return m_heap.end();
+	}
+
+	size_type size() const
+	{
+		return m_heap.size();
+	}
+
+	bool empty() const
+	{
+		return m_heap.empty();
+	}
+
+private:
+	static size_type parent_of(size_type nIndex)
+	{
+		return (nIndex - 1) / D;
+	}
+
+	void place(size_type nIndex, T&& val)
+	{
+		m_heap[nIndex] = std::move(val);
+		m_onMove(m_heap[nIndex], nIndex);
+	}
+
+	void restore(size_type nIndex)
+	{
+		if (nIndex && m_comp(m_heap[parent_of(nIndex)], m_heap[nIndex]))
+			sift_up(nIndex);
+		else
+			sift_down(nIndex);
+	}
+
+	// The element travels as a hole: parents move down into it and it is
+	// stored once at its final index.
+	void sift_up(size_type nIndex)
+	{
+		T val = std::move(m_heap[nIndex]);
+		while (nIndex)
+		{
+			size_type nParent = parent_of(nIndex);
+			if (!m_comp(m_heap[nParent], val))
+				break;
+			place(nIndex, std::move(m_heap[nParent]));
+			nIndex = nParent;
+		}
+		place(nIndex, std::move(val));
+	}
+
+	void sift_down(size_type nIndex)
+	{
+		size_type nCount = m_heap.size();
+		T val = std::move(m_heap[nIndex]);
+		for (;;)
+		{
+			size_type nFirstChild = nIndex * D + 1;
+			if (nFirstChild >= nCount)
+				break;
+
+			// a full group has a fixed trip count the compiler can unroll
+			size_type nBest = nFirstChild;
+			if (nFirstChild + D <= nCount)
+			{
+				for (size_type k = 1; k < D; ++k)
+				{
+					if (m_comp(m_heap[nBest], m_heap[nFirstChild + k]))
+						nBest = nFirstChild + k;
+				}
+			}
+			else
+			{
+				for (size_type nChild = nFirstChild + 1; nChild < nCount; ++nChild)
+				{
+					if (m_comp(m_heap[nBest], m_heap[nChild]))
+						nBest = nChild;
+				}
+			}
+
+			if (!m_comp(val, m_heap[nBest]))
+				break;
+			place(nIndex, std::move(m_heap[nBest]));
+			nIndex = nBest;
+		}
+		place(nIndex, std::move(val));
+	}
+
+	void heapify()
+	{
+		size_type nCount = m_heap.size();
+		if (nCount < 2)
+		{
+			if (nCount)
+				m_onMove(m_heap[0], 0);
+			return;
+		}
+
+		// sift_down reports only the elements it passes, tell about the leaves
+		size_type nFirstLeaf = parent_of(nCount - 1) + 1;
+		for (size_type i = nFirstLeaf; i < nCount; ++i)
+			m_onMove(m_heap[i], i);
+		for (size_type i = nFirstLeaf; i-- > 0;)
+			sift_down(i);
+	}
+
+	tdk_darray<T> m_heap;
+	Compare m_comp;
+	OnMove m_onMove;
+};
+
+#endif //TDK_PRIORITYQUEUE_H
@@ -0,0 +1,220 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: radix sort.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_RADIXSORT_H
+#define TDK_RADIXSORT_H
+
+#include "base/tdkbasedefs.h"
+#include "base/tdkbaseutl.h"
+#include "base/tdkpoddarray.h"
+
+#include <cstring>
+#include <type_traits>
+
+// Maps a sort key to an unsigned integer of the same width whose unsigned
+// order is the key order. Signed integers flip the sign bit. Floats flip
+// the sign bit of positive values and every bit of negative ones, so -0.0
+// sorts just before 0.0 and NaNs go to the ends by their sign bit.
+template<typename K, typename = void>
+struct tdk_radix_key;
+
+template<typename K>
+struct tdk_radix_key<K, std::enable_if_t<std::is_integral_v<K>>>
+{
+	using bits_type = std::make_unsigned_t<K>;
+
+	static bits_type to_bits(K key)
+	{
+		bits_type nBits = bits_type(key);
+		if constexpr (std::is_signed_v<K>)
+			nBits ^= bits_type(bits_type(1) << (8 * sizeof(K) - 1));
+		return nBits;
+	}
+};
+
+template<typename K>
+struct tdk_radix_key<K, std::enable_if_t<std::is_floating_point_v<K>>>
+{
+	static_assert(sizeof(K) == 4 || sizeof(K) == 8, "float or double keys");
+	using bits_type = std::conditional_t<sizeof(K) == 4, tdk_u32, tdk_u64>;
+
+	static bits_type to_bits(K key)
+	{
+		bits_type nBits;
+		std::memcpy(&nBits, &key, sizeof(nBits));
+		const bits_type nSign = bits_type(1) << (8 * sizeof(K) - 1);
+		bits_type nMask = (nBits & nSign) ? bits_type(~bits_type(0)) : nSign;
+		return nBits ^ nMask;
+	}
+};
+
+// Key of an element that is its own key.
+struct tdk_radix_identity
+{
+	template<typename T>
+	const T& operator()(const T& elem) const
+	{
+		return elem;
+	}
+};
+
+enum tdk_radix_constants
+{
+	kTDK_RADIX_BITS = 8,
+	kTDK_RADIX_BUCKETS = 1 << kTDK_RADIX_BITS,
+	// shorter arrays are insertion sorted, the histograms would dominate
+	kTDK_RADIX_MIN_COUNT = 64
+};
+
+template<typename T, typename KeyOf>
+using tdk_radix_bits_type = typename tdk_radix_key<std::decay_t<
+	decltype(std::declval<const KeyOf&>()(std::declval<const T&>()))>>::bits_type;
+
+template<typename T, typename KeyOf>
+tdk_radix_bits_type<T, KeyOf> tdk_radix_bits(const KeyOf& keyOf, const T& elem)
+{
+	using Key = std::decay_t<decltype(keyOf(elem))>;
+	return tdk_radix_key<Key>::to_bits(keyOf(elem));
+}
+
+template<typename Bits>
+tdk_size tdk_radix_digit(Bits nBits, tdk_size nPass)
+{
+	return tdk_size(nBits >> (nPass * kTDK_RADIX_BITS)) & (kTDK_RADIX_BUCKETS - 1);
+}
+
+template<typename T, typename KeyOf>
+void tdk_radix_insertion_sort(T* pData, tdk_size nCount, const KeyOf& keyOf)
+{
+	for (tdk_size i = 1; i < nCount; ++i)
+	{
+		T elem = pData[i];
+		auto nBits = tdk_radix_bits(keyOf, elem);
+		tdk_size j = i;
+		for (; j && nBits < tdk_radix_bits(keyOf, pData[j - 1]); --j)
+			pData[j] = pData[j - 1];
+		pData[j] = elem;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Stable LSD radix sort by keyOf(elem), an integer or floating point key,
+// one pass per key byte. All byte histograms are taken in one read of the
+// array, and a pass whose byte is equal in every key is skipped, so narrow
+// key ranges cost only the passes they need. The scratch buffer is a second
+// array with the same allocator: when an odd number of passes ran, the two
+// are swapped instead of copying back. Fails only if the scratch memory
+// cannot be allocated, the array is unchanged then.
+template<typename T, typename Allocator, typename KeyOf>
+tdk_ret tdk_radix_sort_by_key(tdk_podarray<T, Allocator>& arr, const KeyOf& keyOf,
+	tdk_err* pErrorCode = nullptr)
+{
+	using Bits = tdk_radix_bits_type<T, KeyOf>;
+	const tdk_size kPasses = sizeof(Bits);
+
+	tdk_size nCount = arr.size();
+	if (nCount <= kTDK_RADIX_MIN_COUNT)
+	{
+		tdk_radix_insertion_sort(arr.data(), nCount, keyOf);
+		return kTDK_OK;
+	}
+
+	tdk_size counts[kPasses][kTDK_RADIX_BUCKETS] = {};
+	const T* pData = arr.data();
+	for (tdk_size idx = 0; idx < nCount; ++idx)
+	{
+		Bits nBits = tdk_radix_bits(keyOf, pData[idx]);
+		for (tdk_size nPass = 0; nPass < kPasses; ++nPass)
+			++counts[nPass][tdk_radix_digit(nBits, nPass)];
+	}
+
+	tdk_podarray<T, Allocator> scratch;
+	tdk_ret retVal = scratch.reserve(nCount, pErrorCode);
+	if (kTDK_OK != retVal)
+		return retVal;
+	scratch.resize_uninitialized(nCount);
+
+	T* pSrc = arr.data();
+	T* pDst = scratch.data();
+	Bits nFirstBits = tdk_radix_bits(keyOf, pSrc[0]);
+	bool bInScratch = false;
+	for (tdk_size nPass = 0; nPass < kPasses; ++nPass)
+	{
+		tdk_size* pCounts = counts[nPass];
+		if (pCounts[tdk_radix_digit(nFirstBits, nPass)] == nCount)
+			continue;
+
+		tdk_size offsets[kTDK_RADIX_BUCKETS];
+		tdk_size nOffset = 0;
+		for (tdk_size nBucket = 0; nBucket < kTDK_RADIX_BUCKETS; ++nBucket)
+		{
+			offsets[nBucket] = nOffset;
+			nOffset += pCounts[nBucket];
+		}
+
+		for (tdk_size idx = 0; idx < nCount; ++idx)
+		{
+			tdk_size nDigit = tdk_radix_digit(tdk_radix_bits(keyOf, pSrc[idx]), nPass);
+			pDst[offsets[nDigit]++] = pSrc[idx];
+		}
+
+		std::swap(pSrc, pDst);
+		bInScratch = !bInScratch;
+	}
+
+	if (bInScratch)
+		arr.swap(scratch);
+	return kTDK_OK;
+}
+
+// Sorts integers or floats by value.
+template<typename T, typename Allocator>
+tdk_ret tdk_radix_sort(tdk_podarray<T, Allocator>& arr, tdk_err* pErrorCode = nullptr)
+{
+	return tdk_radix_sort_by_key(arr, tdk_radix_identity(), pErrorCode);
+}
+
+#endif //TDK_RADIXSORT_H
@@ -0,0 +1,433 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: bounded lock-free queues.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_RINGBUFFER_H
+#define TDK_RINGBUFFER_H
+
+#include "base/tdkbasedefs.h"
+#include "base/tdkbaseutl.h"
+#include "base/tdkmemutl.h"
+#include "system/tdkmemory.h"
+
+#include <atomic>
+#include <cassert>
+#include <new>
+#include <utility>
+
+// Bounded lock-free queues for passing items between threads. The capacity
+// is rounded up to a power of two, so a slot index is a mask of an ever
+// growing counter. Storage is cache line aligned and the counters written by
+// producers and by consumers live on separate cache lines.
+//
+// Call initialize() once before use. push returns kTDK_NO when the queue is
+// full and pop when it is empty, neither blocks.
+
+inline tdk_size tdk_ringbuffer_capacity(tdk_size nCapacity)
+{
+	tdk_size nCap = 2;
+	while (nCap < nCapacity)
+		nCap *= 2;
+	return nCap;
+}
+
+//-----------------------------------------------------------------------------
+// One producer thread, one consumer thread. Each side keeps a copy of the
+// other side's counter and reloads it only when the copy says full/empty, so
+// the shared lines move between the cores about once per lap, not per item.
+template<typename T>
+class tdk_spsc_ringbuffer
+{
+public:
+	typedef tdk_size size_type;
+	typedef T value_type;
+
+	tdk_spsc_ringbuffer()
+		: m_pSlots(nullptr)
+		, m_nMask(0)
+	{
+
+	}
+
+	~tdk_spsc_ringbuffer()
+	{
+		size_type nTail = m_producer.nIndex.load(std::memory_order_acquire);
+		for (size_type n = m_consumer.nIndex.load(std::memory_order_acquire); n != nTail; ++n)
+			tdk_destroy_at(m_pSlots + (n & m_nMask));
+		tdk_free_memory_aligned(m_pSlots, kTDK_CACHE_LINE_SIZE);
+	}
+
+	tdk_spsc_ringbuffer(const tdk_spsc_ringbuffer&) = delete;
+	tdk_spsc_ringbuffer& operator=(const tdk_spsc_ringbuffer&) = delete;
+
+	tdk_ret initialize(size_type nCapacity, tdk_err* pErrorCode = nullptr)
+	{
+		assert(!m_pSlots);
+		nCapacity = tdk_ringbuffer_capacity(nCapacity);
+		if (nCapacity > size_type(-1) / sizeof(T))
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+			return kTDK_FATAL;
+		}
+
+		m_pSlots = static_cast<T*>(tdk_allocate_memory_aligned(nCapacity * sizeof(T),
+			kTDK_CACHE_LINE_SIZE));
+		if (!m_pSlots)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+			return kTDK_FATAL;
+		}
+		m_nMask = nCapacity - 1;
+		return kTDK_OK;
+	}
+
+	// Producer side.
+	template<typename ValArg>
+	tdk_ret push(ValArg&& val)
+	{
+		assert(m_pSlots);
+		size_type nTail = m_producer.nIndex.load(std::memory_order_relaxed);
+		if (nTail - m_producer.nOtherCache > m_nMask)
+		{
+			m_producer.nOtherCache = m_consumer.nIndex.load(std::memory_order_acquire);
+			if (nTail - m_producer.nOtherCache > m_nMask)
+				return kTDK_NO;
+		}
+
+		::new (static_cast<void*>(m_pSlots + (nTail & m_nMask))) T(std::forward<ValArg>(val));
+		m_producer.nIndex.store(nTail + 1, std::memory_order_release);
+		return kTDK_OK;
+	}
+
+	// Producer side. Copies as many of pItems as fit, returns how many.
+	size_type push_batch(const T* pItems, size_type nCount)
+	{
+		assert(m_pSlots);
+		size_type nTail = m_producer.nIndex.load(std::memory_order_relaxed);
+		size_type nFree = capacity() - (nTail - m_producer.nOtherCache);
+		if (nFree < nCount)
+		{
+			m_producer.nOtherCache = m_consumer.nIndex.load(std::memory_order_acquire);
+			nFree = capacity() - (nTail - m_producer.nOtherCache);
+		}
+
+		nCount = tdk_min(nCount, nFree);
+		for (size_type i = 0; i < nCount; ++i)
+			::new (static_cast<void*>(m_pSlots + ((nTail + i) & m_nMask))) T(pItems[i]);
+		// one release publishes the whole batch
+		m_producer.nIndex.store(nTail + nCount, std::memory_order_release);
+		return nCount;
+	}
+
+	// Consumer side.
+	tdk_ret pop(T& val)
+	{
+		size_type nHead = m_consumer.nIndex.load(std::memory_order_relaxed);
+		if (nHead == m_consumer.nOtherCache)
+		{
+			m_consumer.nOtherCache = m_producer.nIndex.load(std::memory_order_acquire);
+			if (nHead == m_consumer.nOtherCache)
+				return kTDK_NO;
+		}
+
+		T* pSlot = m_pSlots + (nHead & m_nMask);
+		val = std::move(*pSlot);
+		tdk_destroy_at(pSlot);
+		m_consumer.nIndex.store(nHead + 1, std::memory_order_release);
+		return kTDK_OK;
+	}
+
+	// Consumer side. Moves up to nCount items to pItems, returns how many.
+	size_type pop_batch(T* pItems, size_type nCount)
+	{
+		size_type nHead = m_consumer.nIndex.load(std::memory_order_relaxed);
+		size_type nReady = m_consumer.nOtherCache - nHead;
+		if (nReady < nCount)
+		{
+			m_consumer.nOtherCache = m_producer.nIndex.load(std::memory_order_acquire);
+			nReady = m_consumer.nOtherCache - nHead;
+		}
+
+		nCount = tdk_min(nCount, nReady);
+		for (size_type i = 0; i < nCount; ++i)
+		{
+			T* pSlot = m_pSlots + ((nHead + i) & m_nMask);
+			pItems[i] = std::move(*pSlot);
+			tdk_destroy_at(pSlot);
+		}
+		m_consumer.nIndex.store(nHead + nCount, std::memory_order_release);
+		return nCount;
+	}
+
+	// Exact only when called by one side while the other is idle.
+	size_type size() const
+	{
+		return m_producer.nIndex.load(std::memory_order_acquire) -
+			m_consumer.nIndex.load(std::memory_order_acquire);
+	}
+
+	bool empty() const
+	{
+		return 0 == size();
+	}
+
+	size_type capacity() const
+	{
+		return m_pSlots ? m_nMask + 1 : 0;
+	}
+
+private:
+	struct alignas(kTDK_CACHE_LINE_SIZE) Side
+	{
+		std::atomic<size_type> nIndex{ 0 }; // written by this side only
+		size_type nOtherCache = 0; // last seen index of the other side
+	};
+
+	T* m_pSlots;
+	size_type m_nMask;
+	Side m_producer; // tail
+	Side m_consumer; // head
+};
+
+//-----------------------------------------------------------------------------
+// Any number of producers and consumers (Dmitry Vyukov's bounded MPMC queue).
+// Every cell has a sequence number that tells whose turn it is: a producer
+// that took ticket n waits for sequence n, a consumer for n + 1. A thread
+// takes a ticket with one CAS and then owns the cell, there is no lock and no
+// ABA problem.
+template<typename T>
+class tdk_mpmc_ringbuffer
+{
+public:
+	typedef tdk_size size_type;
+	typedef T value_type;
+
+	tdk_mpmc_ringbuffer()
+		: m_pCells(nullptr)
+		, m_nMask(0)
+	{
+
+	}
+
+	~tdk_mpmc_ringbuffer()
+	{
+		if (!m_pCells)
+			return;
+
+		size_type nEnqueue = m_enqueue.nPos.load(std::memory_order_acquire);
+		for (size_type n = m_dequeue.nPos.load(std::memory_order_acquire); n != nEnqueue; ++n)
+			tdk_destroy_at(std::launder(reinterpret_cast<T*>(m_pCells[n & m_nMask].storage)));
+		for (size_type idx = 0; idx <= m_nMask; ++idx)
+			tdk_destroy_at(m_pCells + idx);
+		tdk_free_memory_aligned(m_pCells, kTDK_CACHE_LINE_SIZE);
+	}
+
+	tdk_mpmc_ringbuffer(const tdk_mpmc_ringbuffer&) = delete;
+	tdk_mpmc_ringbuffer& operator=(const tdk_mpmc_ringbuffer&) = delete;
+
+	tdk_ret initialize(size_type nCapacity, tdk_err* pErrorCode = nullptr)
+	{
+		assert(!m_pCells);
+		nCapacity = tdk_ringbuffer_capacity(nCapacity);
+		if (nCapacity > size_type(-1) / sizeof(Cell))
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+			return kTDK_FATAL;
+		}
+
+		m_pCells = static_cast<Cell*>(tdk_allocate_memory_aligned(nCapacity * sizeof(Cell),
+			kTDK_CACHE_LINE_SIZE));
+		if (!m_pCells)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+			return kTDK_FATAL;
+		}
+		for (size_type idx = 0; idx < nCapacity; ++idx)
+			::new (static_cast<void*>(m_pCells + idx)) Cell(idx);
+		m_nMask = nCapacity - 1;
+		return kTDK_OK;
+	}
+
+	template<typename ValArg>
+	tdk_ret push(ValArg&& val)
+	{
+		size_type nPos = 0;
+		if (1 != claim(m_enqueue.nPos, 0, 1, nPos))
+			return kTDK_NO;
+
+		Cell& cell = m_pCells[nPos & m_nMask];
+		::new (static_cast<void*>(cell.storage)) T(std::forward<ValArg>(val));
+		cell.nSeq.store(nPos + 1, std::memory_order_release);
+		return kTDK_OK;
+	}
+
+	// Copies as many of pItems as there are free cells in a row, returns how
+	// many. One CAS claims the whole batch.
+	size_type push_batch(const T* pItems, size_type nCount)
+	{
+		size_type nPos = 0;
+		nCount = claim(m_enqueue.nPos, 0, nCount, nPos);
+		for (size_type i = 0; i < nCount; ++i)
+		{
+			Cell& cell = m_pCells[(nPos + i) & m_nMask];
+			::new (static_cast<void*>(cell.storage)) T(pItems[i]);
+			cell.nSeq.store(nPos + i + 1, std::memory_order_release);
+		}
+		return nCount;
+	}
+
+	tdk_ret pop(T& val)
+	{
+		size_type nPos = 0;
+		if (1 != claim(m_dequeue.nPos, 1, 1, nPos))
+			return kTDK_NO;
+
+		release_cell(nPos, val);
+		return kTDK_OK;
+	}
+
+	// Moves up to nCount items that are ready in a row to pItems, returns
+	// how many.
+	size_type pop_batch(T* pItems, size_type nCount)
+	{
+		size_type nPos = 0;
+		nCount = claim(m_dequeue.nPos, 1, nCount, nPos);
+		for (size_type i = 0; i < nCount; ++i)
+			release_cell(nPos + i, pItems[i]);
+		return nCount;
+	}
+
+	// A snapshot, other threads may change it right away.
+	size_type size() const
+	{
+		size_type nEnqueue = m_enqueue.nPos.load(std::memory_order_acquire);
+		size_type nDequeue = m_dequeue.nPos.load(std::memory_order_acquire);
+		return nEnqueue > nDequeue ? nEnqueue - nDequeue : 0;
+	}
+
+	bool empty() const
+	{
+		return 0 == size();
+	}
+
+	size_type capacity() const
+	{
+		return m_pCells ? m_nMask + 1 : 0;
+	}
+
+private:
+	struct Cell
+	{
+		explicit Cell(size_type nInitSeq)
+			: nSeq(nInitSeq)
+		{
+		}
+
+		std::atomic<size_type> nSeq;
+		alignas(T) tdk_byte storage[sizeof(T)];
+	};
+
+	struct alignas(kTDK_CACHE_LINE_SIZE) Counter
+	{
+		std::atomic<size_type> nPos{ 0 };
+	};
+
+	// Takes up to nMax consecutive tickets from counter whose cells have
+	// the sequence ticket + nSeqOffset (0: free for a producer, 1: full for
+	// a consumer). Returns how many, nPos gets the first one.
+	size_type claim(std::atomic<size_type>& counter, size_type nSeqOffset,
+		size_type nMax, size_type& nPos)
+	{
+		assert(m_pCells);
+		nPos = counter.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			size_type nReady = 0;
+			for (; nReady < nMax && nReady <= m_nMask; ++nReady)
+			{
+				size_type nTicket = nPos + nReady;
+				size_type nSeq = m_pCells[nTicket & m_nMask].nSeq.load(
+					std::memory_order_acquire);
+				if (nSeq != nTicket + nSeqOffset)
+					break;
+			}
+
+			if (!nReady)
+			{
+				// The first cell is not ours yet. If the counter has not moved
+				// the queue is full (empty for a consumer), otherwise retry.
+				size_type nNow = counter.load(std::memory_order_relaxed);
+				if (nNow == nPos)
+					return 0;
+				nPos = nNow;
+				continue;
+			}
+
+			if (counter.compare_exchange_weak(nPos, nPos + nReady,
+				std::memory_order_relaxed))
+			{
+				return nReady;
+			}
+		}
+	}
+
+	// Consumer that owns ticket nPos: takes the item and hands the cell to
+	// the producer of the next lap.
+	void release_cell(size_type nPos, T& val)
+	{
+		Cell& cell = m_pCells[nPos & m_nMask];
+		T* pItem = std::launder(reinterpret_cast<T*>(cell.storage));
+		val = std::move(*pItem);
+		tdk_destroy_at(pItem);
+		cell.nSeq.store(nPos + m_nMask + 1, std::memory_order_release);
+	}
+
+	Cell* m_pCells;
+	size_type m_nMask;
+	Counter m_enqueue;
+	Counter m_dequeue;
+};
+
+#endif //TDK_RINGBUFFER_H
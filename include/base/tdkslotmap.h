@@ -0,0 +1,357 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: generational slot map.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_SLOTMAP_H
+#define TDK_SLOTMAP_H
+
+#include "base/tdkbaseutl.h"
+#include "base/tdkdarray.h"
+#include "base/tdkpoddarray.h"
+
+#include <cassert>
+#include <type_traits>
+#include <utility>
+
+// Handle of a tdk_slot_map element: a slot index in the low kIndexBits bits
+// and the generation of the slot above them. A default handle is null, it
+// never refers to an element.
+template<typename Word, tdk_u32 kIndexBits>
+struct tdk_slot_handle
+{
+	static_assert(std::is_unsigned_v<Word> && kIndexBits < sizeof(Word) * 8,
+		"the handle needs bits for the generation");
+
+	static constexpr Word kINDEX_MASK = (Word(1) << kIndexBits) - 1;
+	static constexpr Word kMAX_GENERATION = Word(-1) >> kIndexBits;
+
+	constexpr tdk_slot_handle()
+		: nValue(0)
+	{
+	}
+
+	constexpr tdk_slot_handle(Word nIndex, Word nGeneration)
+		: nValue(Word(nGeneration << kIndexBits) | nIndex)
+	{
+	}
+
+	constexpr Word index() const
+	{
+		return nValue & kINDEX_MASK;
+	}
+
+	constexpr Word generation() const
+	{
+		return nValue >> kIndexBits;
+	}
+
+	constexpr bool is_null() const
+	{
+		return 0 == nValue;
+	}
+
+	friend constexpr bool operator==(tdk_slot_handle a, tdk_slot_handle b)
+	{
+		return a.nValue == b.nValue;
+	}
+
+	friend constexpr bool operator!=(tdk_slot_handle a, tdk_slot_handle b)
+	{
+		return a.nValue != b.nValue;
+	}
+
+	Word nValue;
+};
+
+// 1M slots with 4096 generations each, or 4G slots with 4G generations
+typedef tdk_slot_handle<tdk_u32, 20> tdk_slot_handle32;
+typedef tdk_slot_handle<tdk_u64, 32> tdk_slot_handle64;
+
+//-----------------------------------------------------------------------------
+// Elements behind stable handles. The values are packed in a tdk_darray, so
+// iteration over begin()/end() is linear in memory; erase() moves the last
+// value into the hole. A slot table maps a handle to its value in O(1) and
+// each erase bumps the slot generation, so a stale handle finds nothing
+// instead of another element.
+//
+// A slot whose generation is used up is retired and never reused. Inserting
+// and erasing moves values: pointers to them are valid until the next
+// insert() or erase(), handles until the element is erased.
+template<typename T, typename Handle = tdk_slot_handle64>
+class tdk_slot_map
+{
+	using Word = decltype(Handle::nValue);
+
+	struct Slot
+	{
+		tdk_u32 nGeneration;
+		tdk_u32 nDenseOrNextFree; // value index if live, next free slot if not
+	};
+
+	enum Constants : tdk_u32
+	{
+		kNO_SLOT = tdk_u32(-1)
+	};
+
+	static constexpr tdk_size kMAX_SLOTS = tdk_min(tdk_size(Handle::kINDEX_MASK),
+		tdk_size(kNO_SLOT - 1)) + 1;
+	// one below the tdk_u32 limit: release_slot() increments past the last
+	// live generation, that must not wrap back to a reusable one
+	static constexpr tdk_u32 kMAX_GENERATION = tdk_u32(tdk_min(
+		tdk_u64(Handle::kMAX_GENERATION), tdk_u64(tdk_u32(-1) - 1)));
+public:
+	typedef tdk_size size_type;
+	typedef T value_type;
+	typedef Handle handle_type;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
+	tdk_slot_map()
+		: m_nFreeHead(kNO_SLOT)
+	{
+	}
+
+	tdk_slot_map(const tdk_slot_map&) = delete;
+	tdk_slot_map& operator=(const tdk_slot_map&) = delete;
+
+	// handle is null if the element cannot be inserted: kTDK_BAD_ALLOC or
+	// kTDK_BAD_SIZE when all handle indices are taken.
+	tdk_ret insert(const T& val, Handle& handle, tdk_err* pErrorCode = nullptr)
+	{
+		return emplace(handle, pErrorCode, val);
+	}
+
+	tdk_ret insert(T&& val, Handle& handle, tdk_err* pErrorCode = nullptr)
+	{
+		return emplace(handle, pErrorCode, std::move(val));
+	}
+
+	// Returns kTDK_OK if the element was erased, kTDK_NO for a stale handle.
+	tdk_ret erase(Handle handle)
+	{
+		Slot* pSlot = live_slot(handle);
+		if (!pSlot)
+			return kTDK_NO;
+
+		tdk_u32 nDense = pSlot->nDenseOrNextFree;
+		tdk_u32 nLast = tdk_u32(m_values.size() - 1);
+		if (nDense != nLast)
+		{
+			m_values[nDense] = std::move(m_values[nLast]);
+			m_denseToSlot[nDense] = m_denseToSlot[nLast];
+			m_slots[m_denseToSlot[nDense]].nDenseOrNextFree = nDense;
+		}
+		m_values.pop_back();
+		m_denseToSlot.pop_back();
+
+		release_slot(tdk_u32(handle.index()));
+		return kTDK_OK;
+	}
+
+	T* at(Handle handle)
+	{
+		Slot* pSlot = live_slot(handle);
+		return pSlot ? &m_values[pSlot->nDenseOrNextFree] : nullptr;
+	}
+
+	const T* at(Handle handle) const
+	{
+		const Slot* pSlot = const_cast<tdk_slot_map*>(this)->live_slot(handle);
+		return pSlot ? &m_values[pSlot->nDenseOrNextFree] : nullptr;
+	}
+
+	bool contains(Handle handle) const
+	{
+		return nullptr != at(handle);
+	}
+
+	// Handle of the value at begin() + nDense.
+	Handle handle_at(size_type nDense) const
+	{
+		assert(nDense < m_values.size());
+		tdk_u32 nSlot = m_denseToSlot[nDense];
+		return Handle(Word(nSlot), Word(m_slots[nSlot].nGeneration));
+	}
+
+	// Invalidates all handles.
+	void clear()
+	{
+		for (size_type i = 0; i < m_denseToSlot.size(); ++i)
+			release_slot(m_denseToSlot[i]);
+		m_values.clear();
+		m_denseToSlot.clear();
+	}
+
+	tdk_ret reserve(size_type nCount, tdk_err* pErrorCode = nullptr)
+	{
+		if (nCount > kMAX_SLOTS)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+			return kTDK_FATAL;
+		}
+
+		if (kTDK_OK != m_values.reserve(nCount, pErrorCode) ||
+			kTDK_OK != m_denseToSlot.reserve(nCount, pErrorCode) ||
+			kTDK_OK != m_slots.reserve(nCount, pErrorCode))
+		{
+			return kTDK_FATAL;
+		}
+		return kTDK_OK;
+	}
+
+	T* data()
+	{
+		return m_values.data();
+	}
+
+	const T* data() const
+	{
+		return m_values.data();
+	}
+
+	iterator begin()
+	{
+		return m_values.begin();
+	}
+
+	const_iterator begin() const
+	{
+		return m_values.begin();
+	}
+
+	iterator end()
+	{
+		return m_values.end();
+	}
+
+	const_iterator end() const
+	{
+		return m_values.end();
+	}
+
+	size_type size() const
+	{
+		return m_values.size();
+	}
+
+	bool empty() const
+	{
+		return m_values.empty();
+	}
+
+private:
+	template<typename... Args>
+	tdk_ret emplace(Handle& handle, tdk_err* pErrorCode, Args&&... args)
+	{
+		handle = Handle();
+
+		bool bNewSlot = kNO_SLOT == m_nFreeHead;
+		tdk_u32 nSlot = bNewSlot ? tdk_u32(m_slots.size()) : m_nFreeHead;
+		if (bNewSlot)
+		{
+			if (m_slots.size() >= kMAX_SLOTS)
+			{
+				tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+				return kTDK_FATAL;
+			}
+			if (kTDK_OK != m_slots.push_back(Slot{ 0, kNO_SLOT }, pErrorCode))
+				return kTDK_FATAL;
+		}
+
+		if (kTDK_OK != m_denseToSlot.push_back(nSlot, pErrorCode))
+		{
+			if (bNewSlot)
+				m_slots.pop_back();
+			return kTDK_FATAL;
+		}
+
+		if (kTDK_OK != m_values.push_back(T(std::forward<Args>(args)...), pErrorCode))
+		{
+			m_denseToSlot.pop_back();
+			if (bNewSlot)
+				m_slots.pop_back();
+			return kTDK_FATAL;
+		}
+
+		Slot& slot = m_slots[nSlot];
+		if (!bNewSlot)
+			m_nFreeHead = slot.nDenseOrNextFree;
+		++slot.nGeneration;
+		slot.nDenseOrNextFree = tdk_u32(m_values.size() - 1);
+
+		handle = Handle(Word(nSlot), Word(slot.nGeneration));
+		return kTDK_OK;
+	}
+
+	Slot* live_slot(Handle handle)
+	{
+		Word nIndex = handle.index();
+		if (nIndex >= m_slots.size())
+			return nullptr;
+
+		Slot* pSlot = &m_slots[size_type(nIndex)];
+		return Word(pSlot->nGeneration) == handle.generation() ? pSlot : nullptr;
+	}
+
+	// Even generations are free slots, odd ones live: no handle matches a
+	// free slot, the null handle included.
+	void release_slot(tdk_u32 nSlot)
+	{
+		Slot& slot = m_slots[nSlot];
+		++slot.nGeneration;
+		if (slot.nGeneration >= kMAX_GENERATION)
+			return; // retired, the next live generation has no handle bits
+
+		slot.nDenseOrNextFree = m_nFreeHead;
+		m_nFreeHead = nSlot;
+	}
+
+	tdk_darray<T> m_values;
+	tdk_podarray<tdk_u32> m_denseToSlot;
+	tdk_podarray<Slot> m_slots;
+	tdk_u32 m_nFreeHead;
+};
+
+#endif //TDK_SLOTMAP_H
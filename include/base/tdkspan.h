@@ -0,0 +1,535 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: non-owning span and strided views.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_SPAN_H
+#define TDK_SPAN_H
+
+#include "base/tdkbasedefs.h"
+
+#include <cassert>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+// Non-owning views. tdk_span is a pointer and a count over contiguous
+// elements, its iterators are plain pointers, so the tdkmemutl algorithms
+// take their memcpy paths on it. tdk_strided_span steps a fixed number of
+// bytes per element, which also views one member of an array of structs.
+// Neither keeps the viewed container alive or notices its reallocation.
+
+template<typename T>
+class tdk_span;
+
+// Containers with data() and size() whose elements can be viewed as T:
+// every tdk array, std::vector, std::array, std::string.
+template<typename Container, typename T, typename = void>
+struct tdk_is_span_compatible : public std::false_type
+{
+
+};
+
+template<typename Container, typename T>
+struct tdk_is_span_compatible<Container, T, std::void_t<
+	decltype(std::declval<Container&>().data()),
+	decltype(std::declval<Container&>().size())>>
+	: public std::bool_constant<std::is_convertible_v<
+		std::remove_pointer_t<decltype(std::declval<Container&>().data())>(*)[],
+		T(*)[]>>
+{
+
+};
+
+template<typename T>
+class tdk_span
+{
+public:
+	typedef T element_type;
+	typedef std::remove_cv_t<T> value_type;
+	typedef tdk_size size_type;
+	typedef tdk_diff difference_type;
+	typedef T* pointer;
+	typedef T& reference;
+	typedef T* iterator;
+
+	enum Constants : size_type { kTO_END = size_type(-1) };
+
+	constexpr tdk_span() noexcept = default;
+
+	constexpr tdk_span(T* pData, size_type nCount) noexcept
+		: m_pData(pData)
+		, m_nCount(nCount)
+	{
+	}
+
+	// A template, so a literal 0 as the count picks the constructor above.
+	template<typename It, typename = std::enable_if_t<std::is_same_v<It, T*>>>
+	constexpr tdk_span(It pFirst, It pLast) noexcept
+		: m_pData(pFirst)
+		, m_nCount(size_type(pLast - pFirst))
+	{
+		assert(pFirst <= pLast);
+	}
+
+	template<tdk_size N>
+	constexpr tdk_span(T (&arr)[N]) noexcept
+		: m_pData(arr)
+		, m_nCount(N)
+	{
+	}
+
+	template<typename Container, typename = std::enable_if_t<
+		!std::is_same_v<std::remove_cv_t<Container>, tdk_span> &&
+		tdk_is_span_compatible<Container, T>::value>>
+	constexpr tdk_span(Container& cont) noexcept
+		: m_pData(cont.data())
+		, m_nCount(size_type(cont.size()))
+	{
+	}
+
+	// tdk_span<U> to tdk_span<const U>
+	template<typename U, typename = std::enable_if_t<
+		!std::is_same_v<U, T> && std::is_convertible_v<U(*)[], T(*)[]>>>
+	constexpr tdk_span(const tdk_span<U>& oth) noexcept
+		: m_pData(oth.data())
+		, m_nCount(oth.size())
+	{
+	}
+
+	constexpr tdk_span first(size_type nCount) const
+	{
+		assert(nCount <= m_nCount);
+		return tdk_span(m_pData, nCount);
+	}
+
+	constexpr tdk_span last(size_type nCount) const
+	{
+		assert(nCount <= m_nCount);
+		return tdk_span(m_pData + (m_nCount - nCount), nCount);
+	}
+
+	// kTO_END takes everything after nOffset.
+	constexpr tdk_span subspan(size_type nOffset, size_type nCount = kTO_END) const
+	{
+		assert(nOffset <= m_nCount);
+		if (kTO_END == nCount)
+			nCount = m_nCount - nOffset;
+		assert(nCount <= m_nCount - nOffset);
+		return tdk_span(m_pData + nOffset, nCount);
+	}
+
+	constexpr T& operator[](size_type idx) const
+	{
+		assert(idx < m_nCount);
+		return m_pData[idx];
+	}
+
+	constexpr T& front() const
+	{
+		assert(m_nCount);
+		return m_pData[0];
+	}
+
+	constexpr T& back() const
+	{
+		assert(m_nCount);
+		return m_pData[m_nCount - 1];
+	}
+
+	constexpr T* data() const noexcept
+	{
+		return m_pData;
+	}
+
+	constexpr iterator begin() const noexcept
+	{
+		return m_pData;
+	}
+
+	constexpr iterator end() const noexcept
+	{
+		return m_pData + m_nCount;
+	}
+
+	constexpr size_type size() const noexcept
+	{
+		return m_nCount;
+	}
+
+	constexpr size_type size_bytes() const noexcept
+	{
+		return m_nCount * sizeof(T);
+	}
+
+	constexpr bool empty() const noexcept
+	{
+		return 0 == m_nCount;
+	}
+private:
+	T* m_pData{};
+	size_type m_nCount{};
+};
+
+template<typename T, tdk_size N>
+tdk_span(T (&)[N]) -> tdk_span<T>;
+
+template<typename Container>
+tdk_span(Container&) -> tdk_span<std::remove_pointer_t<
+	decltype(std::declval<Container&>().data())>>;
+
+// The bytes under a span, for hashing, checksums and I/O.
+template<typename T>
+inline tdk_span<const tdk_byte> tdk_as_bytes(tdk_span<T> span) noexcept
+{
+	return tdk_span<const tdk_byte>(
+		reinterpret_cast<const tdk_byte*>(span.data()), span.size_bytes());
+}
+
+//-----------------------------------------------------------------------------
+// Strided view
+
+template<typename T>
+class tdk_strided_iterator
+{
+public:
+	typedef std::random_access_iterator_tag iterator_category;
+	typedef std::remove_cv_t<T> value_type;
+	typedef tdk_diff difference_type;
+	typedef T* pointer;
+	typedef T& reference;
+
+	using BytePtr = std::conditional_t<std::is_const_v<T>, const tdk_byte*, tdk_byte*>;
+
+	tdk_strided_iterator() noexcept = default;
+
+	tdk_strided_iterator(T* pElem, difference_type nStride) noexcept
+		: m_pByte(reinterpret_cast<BytePtr>(pElem))
+		, m_nStride(nStride)
+	{
+	}
+
+	T& operator*() const
+	{
+		return *reinterpret_cast<T*>(m_pByte);
+	}
+
+	T* operator->() const
+	{
+		return reinterpret_cast<T*>(m_pByte);
+	}
+
+	T& operator[](difference_type n) const
+	{
+		return *reinterpret_cast<T*>(m_pByte + n * m_nStride);
+	}
+
+	tdk_strided_iterator& operator++()
+	{
+		m_pByte += m_nStride;
+		return *this;
+	}
+
+	tdk_strided_iterator operator++(int)
+	{
+		tdk_strided_iterator tmp(*this);
+		m_pByte += m_nStride;
+		return tmp;
+	}
+
+	tdk_strided_iterator& operator--()
+	{
+		m_pByte -= m_nStride;
+		return *this;
+	}
+
+	tdk_strided_iterator operator--(int)
+	{
+		tdk_strided_iterator tmp(*this);
+		m_pByte -= m_nStride;
+		return tmp;
+	}
+
+	tdk_strided_iterator& operator+=(difference_type n)
+	{
+		m_pByte += n * m_nStride;
+		return *this;
+	}
+
+	tdk_strided_iterator& operator-=(difference_type n)
+	{
+		m_pByte -= n * m_nStride;
+		return *this;
+	}
+
+	friend tdk_strided_iterator operator+(tdk_strided_iterator it, difference_type n)
+	{
+		return it += n;
+	}
+
+	friend tdk_strided_iterator operator+(difference_type n, tdk_strided_iterator it)
+	{
+		return it += n;
+	}
+
+	friend tdk_strided_iterator operator-(tdk_strided_iterator it, difference_type n)
+	{
+		return it -= n;
+	}
+
+	friend difference_type operator-(const tdk_strided_iterator& a,
+		const tdk_strided_iterator& b)
+	{
+		// equal iterators of an empty view may have no stride
+		if (a.m_pByte == b.m_pByte)
+			return 0;
+		assert(a.m_nStride == b.m_nStride);
+		return (a.m_pByte - b.m_pByte) / a.m_nStride;
+	}
+
+	// Ordered along the stride, which may be negative.
+	friend bool operator==(const tdk_strided_iterator& a, const tdk_strided_iterator& b)
+	{
+		return a.m_pByte == b.m_pByte;
+	}
+
+	friend bool operator!=(const tdk_strided_iterator& a, const tdk_strided_iterator& b)
+	{
+		return a.m_pByte != b.m_pByte;
+	}
+
+	friend bool operator<(const tdk_strided_iterator& a, const tdk_strided_iterator& b)
+	{
+		return a - b < 0;
+	}
+
+	friend bool operator>(const tdk_strided_iterator& a, const tdk_strided_iterator& b)
+	{
+		return b < a;
+	}
+
+	friend bool operator<=(const tdk_strided_iterator& a, const tdk_strided_iterator& b)
+	{
+		return !(b < a);
+	}
+
+	friend bool operator>=(const tdk_strided_iterator& a, const tdk_strided_iterator& b)
+	{
+		return !(a < b);
+	}
+private:
+	BytePtr m_pByte{};
+	difference_type m_nStride{};
+};
+
+// nCount elements nStride bytes apart, starting at pFirst. The stride may be
+// negative for a reversed view, it must not be 0.
+template<typename T>
+class tdk_strided_span
+{
+public:
+	typedef T element_type;
+	typedef std::remove_cv_t<T> value_type;
+	typedef tdk_size size_type;
+	typedef tdk_diff difference_type;
+	typedef T& reference;
+	typedef tdk_strided_iterator<T> iterator;
+
+	enum Constants : size_type { kTO_END = size_type(-1) };
+
+	tdk_strided_span() noexcept = default;
+
+	tdk_strided_span(T* pFirst, size_type nCount, difference_type nStride) noexcept
+		: m_pFirst(pFirst)
+		, m_nCount(nCount)
+		, m_nStride(nStride)
+	{
+		assert(nStride || !nCount);
+	}
+
+	// Every element of a span.
+	tdk_strided_span(tdk_span<T> span) noexcept
+		: tdk_strided_span(span.data(), span.size(), difference_type(sizeof(T)))
+	{
+	}
+
+	template<typename U, typename = std::enable_if_t<
+		!std::is_same_v<U, T> && std::is_convertible_v<U(*)[], T(*)[]>>>
+	tdk_strided_span(const tdk_strided_span<U>& oth) noexcept
+		: tdk_strided_span(oth.data(), oth.size(), oth.stride())
+	{
+	}
+
+	tdk_strided_span first(size_type nCount) const
+	{
+		assert(nCount <= m_nCount);
+		return tdk_strided_span(m_pFirst, nCount, m_nStride);
+	}
+
+	tdk_strided_span last(size_type nCount) const
+	{
+		assert(nCount <= m_nCount);
+		return tdk_strided_span(element(m_nCount - nCount), nCount, m_nStride);
+	}
+
+	tdk_strided_span subspan(size_type nOffset, size_type nCount = kTO_END) const
+	{
+		assert(nOffset <= m_nCount);
+		if (kTO_END == nCount)
+			nCount = m_nCount - nOffset;
+		assert(nCount <= m_nCount - nOffset);
+		return tdk_strided_span(nCount ? element(nOffset) : m_pFirst, nCount,
+			m_nStride);
+	}
+
+	// Every nStep-th element starting with the first.
+	tdk_strided_span step(size_type nStep) const
+	{
+		assert(nStep);
+		return tdk_strided_span(m_pFirst, (m_nCount + nStep - 1) / nStep,
+			m_nStride * difference_type(nStep));
+	}
+
+	// The same elements back to front.
+	tdk_strided_span reversed() const
+	{
+		if (!m_nCount)
+			return *this;
+		return tdk_strided_span(element(m_nCount - 1), m_nCount, -m_nStride);
+	}
+
+	T& operator[](size_type idx) const
+	{
+		assert(idx < m_nCount);
+		return *element(idx);
+	}
+
+	T& front() const
+	{
+		assert(m_nCount);
+		return *m_pFirst;
+	}
+
+	T& back() const
+	{
+		assert(m_nCount);
+		return *element(m_nCount - 1);
+	}
+
+	// The first element.
+	T* data() const noexcept
+	{
+		return m_pFirst;
+	}
+
+	iterator begin() const noexcept
+	{
+		return iterator(m_pFirst, m_nStride);
+	}
+
+	iterator end() const noexcept
+	{
+		return begin() + difference_type(m_nCount);
+	}
+
+	size_type size() const noexcept
+	{
+		return m_nCount;
+	}
+
+	bool empty() const noexcept
+	{
+		return 0 == m_nCount;
+	}
+
+	// In bytes.
+	difference_type stride() const noexcept
+	{
+		return m_nStride;
+	}
+
+	// Adjacent elements, the view can be used as a tdk_span.
+	bool is_contiguous() const noexcept
+	{
+		return difference_type(sizeof(T)) == m_nStride;
+	}
+
+	tdk_span<T> as_span() const
+	{
+		assert(is_contiguous() || m_nCount < 2);
+		return tdk_span<T>(m_pFirst, m_nCount);
+	}
+private:
+	T* element(size_type idx) const
+	{
+		using BytePtr = std::conditional_t<std::is_const_v<T>, const tdk_byte*, tdk_byte*>;
+		return reinterpret_cast<T*>(reinterpret_cast<BytePtr>(m_pFirst) +
+			difference_type(idx) * m_nStride);
+	}
+
+	T* m_pFirst{};
+	size_type m_nCount{};
+	difference_type m_nStride{ difference_type(sizeof(T)) };
+};
+
+// One member of every struct in an array, a span or a container:
+// tdk_member_span(points, &Point::x).
+template<typename Viewed, typename M, typename S>
+inline auto tdk_member_span(Viewed&& viewed, M S::* pMember) noexcept
+{
+	tdk_span span(viewed);
+	static_assert(std::is_lvalue_reference_v<Viewed> ||
+		std::is_same_v<std::remove_cv_t<Viewed>, decltype(span)>,
+		"the viewed container is a temporary");
+	using Elem = typename decltype(span)::element_type;
+	using Member = std::conditional_t<std::is_const_v<Elem>, const M, M>;
+	static_assert(std::is_same_v<std::remove_cv_t<Elem>, S>, "not a member of the element");
+
+	if (span.empty())
+		return tdk_strided_span<Member>();
+	return tdk_strided_span<Member>(&(span.data()->*pMember), span.size(),
+		tdk_diff(sizeof(Elem)));
+}
+
+#endif //TDK_SPAN_H
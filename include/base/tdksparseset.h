@@ -0,0 +1,270 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: paged sparse set of integer IDs.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_SPARSESET_H
+#define TDK_SPARSESET_H
+
+#include "base/tdkbaseutl.h"
+#include "base/tdkmemorypool.h"
+#include "base/tdkpoddarray.h"
+
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
+//-----------------------------------------------------------------------------
+// Set of integer IDs with O(1) insert, erase and contains. The members are
+// packed in a tdk_podarray for linear iteration, erase() moves the last one
+// into the hole. The sparse side maps an ID to its dense index through
+// pages of 2^kPageBits entries: a page comes from a tdk_memorypool when the
+// first ID in its range is inserted and goes back when the last one leaves,
+// so memory follows the IDs in use. The page directory itself is flat and
+// holds one pointer per 2^kPageBits IDs up to the largest one inserted, so
+// IDs are at most 32 bits: wider ones could ask for a directory of 2^52
+// pointers. Dense indices are 32 bits as well.
+template<typename Id = tdk_u32, tdk_u32 kPageBits = 12>
+class tdk_sparse_set
+{
+	static_assert(std::is_unsigned_v<Id>, "IDs are unsigned integers");
+	static_assert(sizeof(Id) <= sizeof(tdk_u32),
+		"the flat page directory is sized by the largest ID");
+
+	enum Constants : tdk_u32
+	{
+		kPAGE_SIZE = tdk_u32(1) << kPageBits,
+		kPAGE_MASK = kPAGE_SIZE - 1,
+		kABSENT = tdk_u32(-1)
+	};
+
+	using PagePool = tdk_memorypool<kPAGE_SIZE * sizeof(tdk_u32)>;
+public:
+	typedef tdk_size size_type;
+	typedef Id value_type;
+	typedef const Id* iterator;
+	typedef const Id* const_iterator;
+
+	explicit tdk_sparse_set(tdk_u32 nMemoryFlags = kTDK_MEMORY_DEFAULT)
+		: m_pagePool(nMemoryFlags)
+	{
+	}
+
+	~tdk_sparse_set()
+	{
+		for (size_type i = 0; i < m_pages.size(); ++i)
+		{
+			if (m_pages[i])
+				m_pagePool.free(m_pages[i]);
+		}
+	}
+
+	tdk_sparse_set(const tdk_sparse_set&) = delete;
+	tdk_sparse_set& operator=(const tdk_sparse_set&) = delete;
+
+	// Returns kTDK_OK if id was inserted, kTDK_NO if it was there already.
+	tdk_ret insert(Id id, tdk_err* pErrorCode = nullptr)
+	{
+		if (m_dense.size() >= kABSENT)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+			return kTDK_FATAL;
+		}
+
+		size_type nPage = page_of(id);
+		if (nPage < m_pages.size() && m_pages[nPage])
+		{
+			if (kABSENT != m_pages[nPage][id & kPAGE_MASK])
+				return kTDK_NO;
+		}
+		else if (kTDK_OK != add_page(nPage, pErrorCode))
+		{
+			return kTDK_FATAL;
+		}
+
+		if (kTDK_OK != m_dense.push_back(id, pErrorCode))
+		{
+			if (!m_pageCounts[nPage])
+				remove_page(nPage);
+			return kTDK_FATAL;
+		}
+
+		m_pages[nPage][id & kPAGE_MASK] = tdk_u32(m_dense.size() - 1);
+		++m_pageCounts[nPage];
+		return kTDK_OK;
+	}
+
+	// Returns kTDK_OK if id was erased, kTDK_NO if it was not there.
+	tdk_ret erase(Id id)
+	{
+		size_type nPage = page_of(id);
+		if (nPage >= m_pages.size() || !m_pages[nPage])
+			return kTDK_NO;
+
+		tdk_u32& nEntry = m_pages[nPage][id & kPAGE_MASK];
+		tdk_u32 nDense = nEntry;
+		if (kABSENT == nDense)
+			return kTDK_NO;
+
+		Id lastId = m_dense.back();
+		m_dense[nDense] = lastId;
+		m_pages[page_of(lastId)][lastId & kPAGE_MASK] = nDense;
+		m_dense.pop_back();
+		nEntry = kABSENT;
+
+		if (!--m_pageCounts[nPage])
+			remove_page(nPage);
+		return kTDK_OK;
+	}
+
+	bool contains(Id id) const
+	{
+		return index_of(id) < m_dense.size();
+	}
+
+	// Position of id in begin()..end(), size() if it is not a member.
+	size_type index_of(Id id) const
+	{
+		size_type nPage = page_of(id);
+		if (nPage >= m_pages.size() || !m_pages[nPage])
+			return m_dense.size();
+
+		tdk_u32 nDense = m_pages[nPage][id & kPAGE_MASK];
+		return kABSENT == nDense ? m_dense.size() : size_type(nDense);
+	}
+
+	// Keeps the dense array, returns the pages.
+	void clear()
+	{
+		for (size_type i = 0; i < m_pages.size(); ++i)
+		{
+			if (m_pages[i])
+				m_pagePool.free(m_pages[i]);
+			m_pages[i] = nullptr;
+			m_pageCounts[i] = 0;
+		}
+		m_dense.clear();
+	}
+
+	tdk_ret reserve(size_type nCount, tdk_err* pErrorCode = nullptr)
+	{
+		return m_dense.reserve(nCount, pErrorCode);
+	}
+
+	const Id* data() const
+	{
+		return m_dense.data();
+	}
+
+	const_iterator begin() const
+	{
+		return m_dense.begin();
+	}
+
+	const_iterator end() const
+	{
+		return m_dense.end();
+	}
+
+	size_type size() const
+	{
+		return m_dense.size();
+	}
+
+	bool empty() const
+	{
+		return m_dense.empty();
+	}
+
+	// pages allocated right now
+	size_type page_count() const
+	{
+		size_type nPages = 0;
+		for (size_type i = 0; i < m_pages.size(); ++i)
+			nPages += m_pages[i] ? 1 : 0;
+		return nPages;
+	}
+
+private:
+	static size_type page_of(Id id)
+	{
+		return size_type(id >> kPageBits);
+	}
+
+	tdk_ret add_page(size_type nPage, tdk_err* pErrorCode)
+	{
+		if (nPage >= m_pages.size())
+		{
+			if (kTDK_OK != m_pages.resize(nPage + 1, nullptr, pErrorCode))
+				return kTDK_FATAL;
+			if (kTDK_OK != m_pageCounts.resize(nPage + 1, 0, pErrorCode))
+			{
+				m_pages.resize(m_pageCounts.size());
+				return kTDK_FATAL;
+			}
+		}
+
+		void* pMem = m_pagePool.allocate(pErrorCode);
+		if (!pMem)
+			return kTDK_FATAL;
+
+		// every byte 0xFF makes every entry kABSENT
+		std::memset(pMem, 0xFF, kPAGE_SIZE * sizeof(tdk_u32));
+		m_pages[nPage] = static_cast<tdk_u32*>(pMem);
+		return kTDK_OK;
+	}
+
+	void remove_page(size_type nPage)
+	{
+		m_pagePool.free(m_pages[nPage]);
+		m_pages[nPage] = nullptr;
+	}
+
+	PagePool m_pagePool;
+	tdk_podarray<tdk_u32*> m_pages; // nullptr for pages without members
+	tdk_podarray<tdk_u32> m_pageCounts;
+	tdk_podarray<Id> m_dense;
+};
+
+#endif //TDK_SPARSESET_H
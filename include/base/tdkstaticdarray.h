@@ -0,0 +1,476 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: dynamic array with inline storage.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_STATICDARRAY_H
+#define TDK_STATICDARRAY_H
+
+#include "base/tdkbaseutl.h"
+#include "base/tdkmemutl.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Storage of tdk_static_darray. Trivial types live in a plain array, which
+// keeps the whole container a literal type: it can be built and changed in
+// constant expressions. Other types get raw bytes and placement new.
+template<typename T, tdk_size N, bool kTrivial = std::is_trivial_v<T>>
+class tdk_static_darray_storage
+{
+protected:
+	constexpr T* ptr()
+	{
+		return m_data;
+	}
+
+	constexpr const T* ptr() const
+	{
+		return m_data;
+	}
+
+	T m_data[N]{};
+	tdk_size m_nCount = 0;
+};
+
+template<typename T, tdk_size N>
+class tdk_static_darray_storage<T, N, false>
+{
+protected:
+	tdk_static_darray_storage() = default;
+
+	tdk_static_darray_storage(const tdk_static_darray_storage& oth)
+	{
+		tdk_uninitialized_copy_n(oth.ptr(), oth.m_nCount, ptr());
+		m_nCount = oth.m_nCount;
+	}
+
+	tdk_static_darray_storage(tdk_static_darray_storage&& oth)
+	{
+		for (tdk_size i = 0; i < oth.m_nCount; ++i)
+			::new (static_cast<void*>(ptr() + i)) T(std::move(oth.ptr()[i]));
+		m_nCount = oth.m_nCount;
+	}
+
+	~tdk_static_darray_storage()
+	{
+		tdk_destroy(ptr(), ptr() + m_nCount);
+	}
+
+	tdk_static_darray_storage& operator=(const tdk_static_darray_storage& oth)
+	{
+		if (this != &oth)
+		{
+			tdk_destroy(ptr(), ptr() + m_nCount);
+			m_nCount = 0;
+			tdk_uninitialized_copy_n(oth.ptr(), oth.m_nCount, ptr());
+			m_nCount = oth.m_nCount;
+		}
+		return *this;
+	}
+
+	tdk_static_darray_storage& operator=(tdk_static_darray_storage&& oth)
+	{
+		if (this != &oth)
+		{
+			tdk_destroy(ptr(), ptr() + m_nCount);
+			m_nCount = 0;
+			for (tdk_size i = 0; i < oth.m_nCount; ++i)
+				::new (static_cast<void*>(ptr() + i)) T(std::move(oth.ptr()[i]));
+			m_nCount = oth.m_nCount;
+		}
+		return *this;
+	}
+
+	T* ptr()
+	{
+		return std::launder(reinterpret_cast<T*>(m_memory));
+	}
+
+	const T* ptr() const
+	{
+		return std::launder(reinterpret_cast<const T*>(m_memory));
+	}
+
+	alignas(T) tdk_byte m_memory[N * sizeof(T)];
+	tdk_size m_nCount = 0;
+};
+
+//-----------------------------------------------------------------------------
+// tdk_darray with the room for N elements inside the object: it never
+// touches the heap. Going past N fails with kTDK_BAD_SIZE where tdk_darray
+// would allocate. For trivial T every operation is constexpr.
+template<typename T, tdk_size N>
+class tdk_static_darray : private tdk_static_darray_storage<T, N>
+{
+	static_assert(N > 0, "tdk_static_darray needs room for an element");
+
+	static constexpr bool kTRIVIAL = std::is_trivial_v<T>;
+	using Storage = tdk_static_darray_storage<T, N>;
+	using Storage::ptr;
+	using Storage::m_nCount;
+public:
+	using size_type = tdk_size;
+	using difference_type = tdk_diff;
+
+	using value_type = T;
+	using reference = value_type&;
+	using const_reference = const value_type&;
+	using pointer = T*;
+	using const_pointer = const T*;
+	using iterator = pointer;
+	using const_iterator = const_pointer;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	constexpr tdk_static_darray() = default;
+
+	constexpr void clear()
+	{
+		destroy_tail(0);
+	}
+
+	// Appends nGrowBy value-initialized elements.
+	constexpr tdk_ret grow(size_type nGrowBy = 1, tdk_err* pErrorCode = nullptr)
+	{
+		if (!has_room(nGrowBy, pErrorCode))
+			return kTDK_FATAL;
+
+		for (size_type i = 0; i < nGrowBy; ++i)
+			construct(m_nCount + i, T());
+		m_nCount += nGrowBy;
+		return kTDK_OK;
+	}
+
+	constexpr tdk_ret push_back(const T& val, tdk_err* pErrorCode = nullptr)
+	{
+		if (!has_room(1, pErrorCode))
+			return kTDK_FATAL;
+
+		construct(m_nCount, val);
+		++m_nCount;
+		return kTDK_OK;
+	}
+
+	constexpr tdk_ret push_back(T&& val, tdk_err* pErrorCode = nullptr)
+	{
+		if (!has_room(1, pErrorCode))
+			return kTDK_FATAL;
+
+		construct(m_nCount, std::move(val));
+		++m_nCount;
+		return kTDK_OK;
+	}
+
+	constexpr void pop_back()
+	{
+		assert(m_nCount);
+		destroy_tail(m_nCount - 1);
+	}
+
+	// The inserted range must not come from this array.
+	template<typename InputIt>
+	constexpr tdk_ret insert(const_iterator pos, InputIt firstIt, InputIt lastIt,
+		tdk_err* pErrorCode = nullptr)
+	{
+		size_type nBeforeGap = size_type(pos - begin());
+		size_type nGap = size_type(std::distance(firstIt, lastIt));
+		assert(nBeforeGap <= m_nCount);
+		if (!has_room(nGap, pErrorCode))
+			return kTDK_FATAL;
+
+		T* pData = ptr();
+		if constexpr (kTRIVIAL)
+		{
+			for (size_type i = m_nCount; i > nBeforeGap; --i)
+				pData[i - 1 + nGap] = pData[i - 1];
+			for (size_type i = 0; i < nGap; ++i, ++firstIt)
+				pData[nBeforeGap + i] = *firstIt;
+			m_nCount += nGap;
+		}
+		else if constexpr (std::is_nothrow_move_constructible_v<T>)
+		{
+			// a copy that throws moves the tail back, leaving no change
+			T* pGap = pData + nBeforeGap;
+			size_type nAfterGap = m_nCount - nBeforeGap;
+			tdk_relocate_backward_n(pData + m_nCount, nAfterGap,
+				pData + m_nCount + nGap);
+
+			tdk_gap_rollback<T, size_type> gapRollback(pGap, pGap + nGap, nAfterGap);
+			tdk_uninitialized_copy_n(firstIt, nGap, pGap);
+			gapRollback.release();
+			m_nCount += nGap;
+		}
+		else
+		{
+			// a throwing move cannot be shifted in place, so this goes the
+			// std::vector way: slots past the end are constructed and counted
+			// one by one, the rest is assigned; after a throw every counted
+			// slot is alive, if perhaps moved from
+			size_type nOldCount = m_nCount;
+			size_type nAfterGap = nOldCount - nBeforeGap;
+			if (nAfterGap > nGap)
+			{
+				for (size_type i = nOldCount - nGap; i < nOldCount; ++i)
+				{
+					construct(m_nCount, std::move(pData[i]));
+					++m_nCount;
+				}
+				std::move_backward(pData + nBeforeGap, pData + nOldCount - nGap,
+					pData + nOldCount);
+				std::copy_n(firstIt, nGap, pData + nBeforeGap);
+			}
+			else
+			{
+				InputIt midIt = std::next(firstIt, nAfterGap);
+				for (InputIt it = midIt; it != lastIt; ++it)
+				{
+					construct(m_nCount, *it);
+					++m_nCount;
+				}
+				for (size_type i = nBeforeGap; i < nOldCount; ++i)
+				{
+					construct(m_nCount, std::move(pData[i]));
+					++m_nCount;
+				}
+				std::copy(firstIt, midIt, pData + nBeforeGap);
+			}
+		}
+		return kTDK_OK;
+	}
+
+	constexpr tdk_ret insert(const_iterator pos, const T& val,
+		tdk_err* pErrorCode = nullptr)
+	{
+		if (!has_room(1, pErrorCode))
+			return kTDK_FATAL;
+
+		// val may be one of ours and move with the tail
+		T valCopy(val);
+		return insert(pos, std::addressof(valCopy), std::addressof(valCopy) + 1,
+			pErrorCode);
+	}
+
+	// Returns the iterator to the element that followed the erased ones.
+	constexpr iterator erase(const_iterator pos)
+	{
+		return erase(pos, pos + 1);
+	}
+
+	constexpr iterator erase(const_iterator first, const_iterator last)
+	{
+		assert(first >= begin() && first <= last && last <= end());
+		size_type nFirst = size_type(first - begin());
+		size_type nLast = size_type(last - begin());
+		T* pData = ptr();
+		// the loop below would move every later element onto itself
+		if (nFirst == nLast)
+			return pData + nFirst;
+
+		for (size_type i = nLast; i < m_nCount; ++i)
+			pData[nFirst + i - nLast] = std::move(pData[i]);
+		destroy_tail(m_nCount - (nLast - nFirst));
+		return pData + nFirst;
+	}
+
+	// New elements are value-initialized.
+	constexpr tdk_ret resize(size_type nNewCount, tdk_err* pErrorCode = nullptr)
+	{
+		if (nNewCount <= m_nCount)
+		{
+			destroy_tail(nNewCount);
+			return kTDK_OK;
+		}
+		return grow(nNewCount - m_nCount, pErrorCode);
+	}
+
+	// Only checks that nNewCap fits, the room is always there.
+	constexpr tdk_ret reserve(size_type nNewCap, tdk_err* pErrorCode = nullptr) const
+	{
+		if (nNewCap > N)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+			return kTDK_FATAL;
+		}
+		return kTDK_OK;
+	}
+
+	constexpr T* at(size_type idx)
+	{
+		if (idx >= m_nCount)
+			return nullptr;
+		return ptr() + idx;
+	}
+
+	constexpr const T* at(size_type idx) const
+	{
+		if (idx >= m_nCount)
+			return nullptr;
+		return ptr() + idx;
+	}
+
+	constexpr T& operator[](size_type idx)
+	{
+		assert(idx < m_nCount);
+		return ptr()[idx];
+	}
+
+	constexpr const T& operator[](size_type idx) const
+	{
+		assert(idx < m_nCount);
+		return ptr()[idx];
+	}
+
+	constexpr T& front()
+	{
+		assert(m_nCount);
+		return ptr()[0];
+	}
+
+	constexpr const T& front() const
+	{
+		assert(m_nCount);
+		return ptr()[0];
+	}
+
+	constexpr T& back()
+	{
+		assert(m_nCount);
+		return ptr()[m_nCount - 1];
+	}
+
+	constexpr const T& back() const
+	{
+		assert(m_nCount);
+		return ptr()[m_nCount - 1];
+	}
+
+	constexpr T* data()
+	{
+		return ptr();
+	}
+
+	constexpr const T* data() const
+	{
+		return ptr();
+	}
+
+	constexpr iterator begin()
+	{
+		return ptr();
+	}
+
+	constexpr const_iterator begin() const
+	{
+		return ptr();
+	}
+
+	constexpr iterator end()
+	{
+		return ptr() + m_nCount;
+	}
+
+	constexpr const_iterator end() const
+	{
+		return ptr() + m_nCount;
+	}
+
+	constexpr size_type size() const
+	{
+		return m_nCount;
+	}
+
+	constexpr bool empty() const
+	{
+		return 0 == m_nCount;
+	}
+
+	constexpr bool full() const
+	{
+		return N == m_nCount;
+	}
+
+	static constexpr size_type capacity()
+	{
+		return N;
+	}
+
+	static constexpr size_type max_size()
+	{
+		return N;
+	}
+
+private:
+	constexpr bool has_room(size_type nGrowBy, tdk_err* pErrorCode) const
+	{
+		if (nGrowBy > N - m_nCount)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+			return false;
+		}
+		return true;
+	}
+
+	template<typename Arg>
+	constexpr void construct(size_type idx, Arg&& arg)
+	{
+		if constexpr (kTRIVIAL)
+			ptr()[idx] = std::forward<Arg>(arg);
+		else
+			::new (static_cast<void*>(ptr() + idx)) T(std::forward<Arg>(arg));
+	}
+
+	constexpr void destroy_tail(size_type nNewCount)
+	{
+		if constexpr (!kTRIVIAL)
+			tdk_destroy(ptr() + nNewCount, ptr() + m_nCount);
+		m_nCount = nNewCount;
+	}
+};
+
+#endif //TDK_STATICDARRAY_H
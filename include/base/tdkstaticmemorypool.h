@@ -0,0 +1,149 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: memory pool with inline storage.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_STATICMEMORYPOOL_H
+#define TDK_STATICMEMORYPOOL_H
+
+#include "base/tdkbaseutl.h"
+
+#include <cassert>
+#include <cstddef>
+
+//-----------------------------------------------------------------------------
+// tdk_memorypool with a fixed number of nodes inside the object, it never
+// touches the heap. Nodes are handed out from the untouched tail first and
+// then from the free list, so construction does not walk the storage.
+// allocate() fails with kTDK_BAD_SIZE when all N nodes are in use.
+// Nodes are aligned for any fundamental type.
+template <tdk_size kTypeSize, tdk_size N>
+class tdk_static_memorypool
+{
+	static_assert(N > 0, "tdk_static_memorypool needs room for a node");
+
+	union Node
+	{
+		Node* pNext;
+		alignas(std::max_align_t) tdk_byte memory[kTypeSize];
+	};
+public:
+	typedef tdk_size size_type;
+
+	tdk_static_memorypool()
+		: m_pFirstFree(nullptr)
+		, m_nTouched(0)
+		, m_nUsed(0)
+	{
+	}
+
+	// nodes point into this object
+	tdk_static_memorypool(const tdk_static_memorypool&) = delete;
+	tdk_static_memorypool& operator=(const tdk_static_memorypool&) = delete;
+
+	void* allocate(tdk_err* pErrorCode = nullptr)
+	{
+		Node* pNode = m_pFirstFree;
+		if (pNode)
+		{
+			m_pFirstFree = pNode->pNext;
+		}
+		else if (m_nTouched < N)
+		{
+			pNode = &m_nodes[m_nTouched++];
+		}
+		else
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+			return nullptr;
+		}
+
+		++m_nUsed;
+		return pNode->memory;
+	}
+
+	void free(void* p)
+	{
+		if (!p)
+			return;
+
+		assert(owns(p));
+		Node* pNode = static_cast<Node*>(p);
+		pNode->pNext = m_pFirstFree;
+		m_pFirstFree = pNode;
+		--m_nUsed;
+	}
+
+	bool owns(const void* p) const
+	{
+		const tdk_byte* pByte = static_cast<const tdk_byte*>(p);
+		const tdk_byte* pFirst = reinterpret_cast<const tdk_byte*>(m_nodes);
+		return pByte >= pFirst && pByte < pFirst + sizeof(m_nodes) &&
+			0 == (pByte - pFirst) % sizeof(Node);
+	}
+
+	size_type capacity() const
+	{
+		return N;
+	}
+
+	// nodes in use
+	size_type size() const
+	{
+		return m_nUsed;
+	}
+
+	bool full() const
+	{
+		return N == m_nUsed;
+	}
+
+private:
+	Node* m_pFirstFree;
+	size_type m_nTouched; // nodes below this index have been handed out once
+	size_type m_nUsed;
+	Node m_nodes[N];
+};
+
+#endif //TDK_STATICMEMORYPOOL_H
@@ -0,0 +1,487 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: small string optimized string.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_STRING_H
+#define TDK_STRING_H
+
+#include "base/tdkbasedefs.h"
+#include "base/tdkbaseutl.h"
+#include "base/tdkhash.h"
+#include "base/tdkmemalloc.h"
+
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+// Byte string with a terminating zero. Up to kSSO_CAPACITY characters are
+// stored inside the object itself, longer strings go to the allocator.
+//
+// The object is 24 bytes on 64-bit targets. The last byte tells the two
+// modes apart: an inline string keeps kSSO_CAPACITY - size() there, which
+// doubles as the terminator when the string is full, a heap string keeps
+// kHEAP_TAG. The heap capacity is encoded with kHEAP_TAG in both its end
+// bytes, so the tag byte is right on either byte order.
+template<typename Allocator = tdk_allocator<char>>
+class tdk_basic_string
+{
+	using AllocatorForT =
+		typename std::allocator_traits<Allocator>::template rebind_alloc<char>;
+public:
+	typedef char value_type;
+	typedef tdk_size size_type;
+	typedef char* iterator;
+	typedef const char* const_iterator;
+	typedef Allocator allocator_type;
+
+	enum Constants { kSSO_CAPACITY = 23 };
+
+	tdk_basic_string()
+	{
+		set_inline_size(0);
+	}
+
+	// Leaves the string empty if the memory cannot be allocated, use
+	// assign() to get the error.
+	tdk_basic_string(std::string_view str)
+		: tdk_basic_string()
+	{
+		assign(str);
+	}
+
+	tdk_basic_string(const char* szStr)
+		: tdk_basic_string(std::string_view(szStr))
+	{
+	}
+
+	tdk_basic_string(const tdk_basic_string& oth)
+		: tdk_basic_string(oth.view())
+	{
+	}
+
+	tdk_basic_string(tdk_basic_string&& oth) noexcept
+	{
+		std::memcpy(m_inline, oth.m_inline, sizeof(m_inline));
+		oth.set_inline_size(0);
+	}
+
+	~tdk_basic_string()
+	{
+		release();
+	}
+
+	tdk_basic_string& operator=(const tdk_basic_string& oth)
+	{
+		if (this != &oth)
+			assign(oth.view());
+		return *this;
+	}
+
+	tdk_basic_string& operator=(tdk_basic_string&& oth) noexcept
+	{
+		tdk_basic_string tmp(std::move(oth));
+		swap(tmp);
+		return *this;
+	}
+
+	void swap(tdk_basic_string& oth) noexcept
+	{
+		char tmp[sizeof(m_inline)];
+		std::memcpy(tmp, m_inline, sizeof(m_inline));
+		std::memcpy(m_inline, oth.m_inline, sizeof(m_inline));
+		std::memcpy(oth.m_inline, tmp, sizeof(m_inline));
+	}
+
+	// pStr may point into this string.
+	tdk_ret assign(const char* pStr, size_type nLen, tdk_err* pErrorCode = nullptr)
+	{
+		if (nLen <= capacity())
+		{
+			std::memmove(data(), pStr, nLen);
+			set_size(nLen);
+			return kTDK_OK;
+		}
+
+		return reallocate(nLen, 0, pStr, nLen, pErrorCode);
+	}
+
+	tdk_ret assign(std::string_view str, tdk_err* pErrorCode = nullptr)
+	{
+		return assign(str.data(), str.size(), pErrorCode);
+	}
+
+	// pStr may point into this string.
+	tdk_ret append(const char* pStr, size_type nLen, tdk_err* pErrorCode = nullptr)
+	{
+		size_type nSize = size();
+		if (nLen > max_size() - nSize)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+			return kTDK_FATAL;
+		}
+
+		size_type nNewSize = nSize + nLen;
+		if (nNewSize <= capacity())
+		{
+			// a source inside the string ends before the copy target
+			std::memcpy(data() + nSize, pStr, nLen);
+			set_size(nNewSize);
+			return kTDK_OK;
+		}
+
+		return reallocate(suggest_capacity(nNewSize), nSize, pStr, nLen, pErrorCode);
+	}
+
+	tdk_ret append(std::string_view str, tdk_err* pErrorCode = nullptr)
+	{
+		return append(str.data(), str.size(), pErrorCode);
+	}
+
+	tdk_ret push_back(char ch, tdk_err* pErrorCode = nullptr)
+	{
+		return append(&ch, 1, pErrorCode);
+	}
+
+	void pop_back()
+	{
+		assert(!empty());
+		set_size(size() - 1);
+	}
+
+	// New characters are ch.
+	tdk_ret resize(size_type nCount, char ch = '\0', tdk_err* pErrorCode = nullptr)
+	{
+		size_type nSize = size();
+		if (nCount > nSize)
+		{
+			tdk_ret retVal = reserve(nCount, pErrorCode);
+			if (kTDK_OK != retVal)
+				return retVal;
+			std::memset(data() + nSize, ch, nCount - nSize);
+		}
+		set_size(nCount);
+		return kTDK_OK;
+	}
+
+	// Exact, the capacity never goes below kSSO_CAPACITY.
+	tdk_ret reserve(size_type nCapacity, tdk_err* pErrorCode = nullptr)
+	{
+		if (nCapacity <= capacity())
+			return kTDK_OK;
+		if (nCapacity > max_size())
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+			return kTDK_FATAL;
+		}
+
+		size_type nSize = size();
+		return reallocate(nCapacity, nSize, nullptr, 0, pErrorCode);
+	}
+
+	// Keeps the memory.
+	void clear()
+	{
+		set_size(0);
+	}
+
+	char& operator[](size_type idx)
+	{
+		assert(idx < size());
+		return data()[idx];
+	}
+
+	const char& operator[](size_type idx) const
+	{
+		assert(idx < size());
+		return data()[idx];
+	}
+
+	char& back()
+	{
+		assert(!empty());
+		return data()[size() - 1];
+	}
+
+	const char& back() const
+	{
+		assert(!empty());
+		return data()[size() - 1];
+	}
+
+	char* data()
+	{
+		return is_inline() ? m_inline : m_heap.pData;
+	}
+
+	const char* data() const
+	{
+		return is_inline() ? m_inline : m_heap.pData;
+	}
+
+	const char* c_str() const
+	{
+		return data();
+	}
+
+	iterator begin()
+	{
+		return data();
+	}
+
+	const_iterator begin() const
+	{
+		return data();
+	}
+
+	iterator end()
+	{
+		return data() + size();
+	}
+
+	const_iterator end() const
+	{
+		return data() + size();
+	}
+
+	std::string_view view() const
+	{
+		return std::string_view(data(), size());
+	}
+
+	operator std::string_view() const
+	{
+		return view();
+	}
+
+	int compare(std::string_view str) const
+	{
+		return view().compare(str);
+	}
+
+	size_type size() const
+	{
+		return is_inline() ? kSSO_CAPACITY - inline_tag() : m_heap.nSize;
+	}
+
+	bool empty() const
+	{
+		return 0 == size();
+	}
+
+	size_type capacity() const
+	{
+		return is_inline() ? size_type(kSSO_CAPACITY) : heap_capacity();
+	}
+
+	// True while the characters live inside the object.
+	bool is_inline() const
+	{
+		return kHEAP_TAG != inline_tag();
+	}
+
+	static constexpr size_type max_size()
+	{
+		// the encoded heap capacity keeps 48 bits
+		return tdk_min(size_type(-1) / 2, size_type(0xffffffffffffull));
+	}
+
+	allocator_type get_allocator() const
+	{
+		return allocator_type();
+	}
+private:
+	enum Tags { kHEAP_TAG = 0x80 };
+
+	struct Heap
+	{
+		char* pData;
+		size_type nSize;
+		tdk_u64 nCapacity;
+	};
+
+	static_assert(sizeof(Heap) <= kSSO_CAPACITY + 1, "heap header does not fit");
+
+	tdk_byte inline_tag() const
+	{
+		return tdk_byte(m_inline[kSSO_CAPACITY]);
+	}
+
+	size_type heap_capacity() const
+	{
+		return size_type((m_heap.nCapacity >> 8) & 0xffffffffffffull);
+	}
+
+	void set_inline_size(size_type nSize)
+	{
+		m_inline[kSSO_CAPACITY] = char(kSSO_CAPACITY - nSize);
+		m_inline[nSize] = '\0';
+	}
+
+	void set_size(size_type nSize)
+	{
+		if (is_inline())
+		{
+			set_inline_size(nSize);
+			return;
+		}
+
+		m_heap.nSize = nSize;
+		m_heap.pData[nSize] = '\0';
+	}
+
+	void set_heap(char* pData, size_type nSize, size_type nCapacity)
+	{
+		m_heap.pData = pData;
+		m_heap.nSize = nSize;
+		m_heap.nCapacity = (tdk_u64(kHEAP_TAG) << 56) | (tdk_u64(nCapacity) << 8) |
+			kHEAP_TAG;
+		// spare on 32-bit targets, where the header ends before it
+		m_inline[kSSO_CAPACITY] = char(kHEAP_TAG);
+		pData[nSize] = '\0';
+	}
+
+	size_type suggest_capacity(size_type nMinCapacity) const
+	{
+		return tdk_max(nMinCapacity, tdk_min(2 * capacity(), max_size()));
+	}
+
+	// Moves the first nKeep characters to a new buffer and appends the
+	// nTail ones at pTail, which may point into the old buffer.
+	tdk_ret reallocate(size_type nCapacity, size_type nKeep, const char* pTail,
+		size_type nTail, tdk_err* pErrorCode)
+	{
+		if (nCapacity > max_size())
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+			return kTDK_FATAL;
+		}
+
+		AllocatorForT memAlloc;
+		char* pMem = memAlloc.allocate(nCapacity + 1);
+		if (!pMem)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+			return kTDK_FATAL;
+		}
+
+		std::memcpy(pMem, data(), nKeep);
+		if (nTail)
+			std::memcpy(pMem + nKeep, pTail, nTail);
+		release();
+		set_heap(pMem, nKeep + nTail, nCapacity);
+		return kTDK_OK;
+	}
+
+	void release()
+	{
+		if (is_inline())
+			return;
+
+		AllocatorForT memAlloc;
+		memAlloc.deallocate(m_heap.pData, heap_capacity() + 1);
+		set_inline_size(0);
+	}
+
+	union
+	{
+		Heap m_heap;
+		char m_inline[kSSO_CAPACITY + 1];
+	};
+};
+
+typedef tdk_basic_string<> tdk_string;
+
+template<typename Allocator>
+inline bool operator==(const tdk_basic_string<Allocator>& a, std::string_view b)
+{
+	return a.view() == b;
+}
+
+template<typename Allocator>
+inline bool operator==(std::string_view a, const tdk_basic_string<Allocator>& b)
+{
+	return a == b.view();
+}
+
+template<typename Allocator>
+inline bool operator==(const tdk_basic_string<Allocator>& a,
+	const tdk_basic_string<Allocator>& b)
+{
+	return a.view() == b.view();
+}
+
+template<typename Allocator>
+inline bool operator!=(const tdk_basic_string<Allocator>& a, std::string_view b)
+{
+	return a.view() != b;
+}
+
+template<typename Allocator>
+inline bool operator!=(std::string_view a, const tdk_basic_string<Allocator>& b)
+{
+	return a != b.view();
+}
+
+template<typename Allocator>
+inline bool operator!=(const tdk_basic_string<Allocator>& a,
+	const tdk_basic_string<Allocator>& b)
+{
+	return a.view() != b.view();
+}
+
+template<typename Allocator>
+inline bool operator<(const tdk_basic_string<Allocator>& a,
+	const tdk_basic_string<Allocator>& b)
+{
+	return a.view() < b.view();
+}
+
+template<typename Allocator>
+struct tdk_hash<tdk_basic_string<Allocator>> : tdk_string_hash
+{
+};
+
+#endif //TDK_STRING_H
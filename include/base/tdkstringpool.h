@@ -0,0 +1,256 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: string interning pool.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_STRINGPOOL_H
+#define TDK_STRINGPOOL_H
+
+#include "base/tdkbasedefs.h"
+#include "base/tdkbaseutl.h"
+#include "base/tdkhash.h"
+#include "base/tdkhashmap.h"
+#include "base/tdkmemalloc.h"
+#include "base/tdkpoddarray.h"
+
+#include <cassert>
+#include <cstring>
+#include <string_view>
+
+// Interner: keeps one copy of every distinct string and names it by a dense
+// tdk_u32 id. The characters are packed into arena chunks with a
+// terminating zero and never move, so the views handed out stay valid until
+// clear() and two of them are equal exactly when their data() pointers are.
+class tdk_string_pool
+{
+	using AllocatorForChar = tdk_allocator<char>;
+public:
+	typedef tdk_size size_type;
+	typedef tdk_u32 id_type;
+
+	enum Constants
+	{
+		kCHUNK_SIZE = 64 * 1024,
+		kINVALID_ID = 0xffffffffu
+	};
+
+	tdk_string_pool() = default;
+	tdk_string_pool(const tdk_string_pool&) = delete;
+	tdk_string_pool& operator=(const tdk_string_pool&) = delete;
+
+	~tdk_string_pool()
+	{
+		free_chunks();
+	}
+
+	// Returns kTDK_OK if the string is new, kTDK_NO if it was interned
+	// before. nId is set in both cases.
+	tdk_ret intern(std::string_view str, id_type& nId, tdk_err* pErrorCode = nullptr)
+	{
+		const id_type* pFound = m_index.at(str);
+		if (pFound)
+		{
+			nId = *pFound;
+			return kTDK_NO;
+		}
+
+		if (m_strings.size() >= kINVALID_ID)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+			return kTDK_FATAL;
+		}
+
+		// on a failure below the copy stays in the arena unused
+		char* pCopy = store(str, pErrorCode);
+		if (!pCopy)
+			return kTDK_FATAL;
+
+		std::string_view copy(pCopy, str.size());
+		id_type nNewId = id_type(m_strings.size());
+		tdk_ret retVal = m_strings.push_back(copy, pErrorCode);
+		if (kTDK_OK != retVal)
+			return retVal;
+
+		retVal = m_index.insert(copy, nNewId, pErrorCode);
+		if (kTDK_OK != retVal)
+		{
+			m_strings.pop_back();
+			return retVal;
+		}
+
+		nId = nNewId;
+		return kTDK_OK;
+	}
+
+	// Same, hands out the pooled view.
+	tdk_ret intern(std::string_view str, std::string_view& pooled,
+		tdk_err* pErrorCode = nullptr)
+	{
+		id_type nId = kINVALID_ID;
+		tdk_ret retVal = intern(str, nId, pErrorCode);
+		if (kTDK_OK == retVal || kTDK_NO == retVal)
+			pooled = m_strings[nId];
+		return retVal;
+	}
+
+	// kINVALID_ID if the string was never interned.
+	id_type find(std::string_view str) const
+	{
+		const id_type* pFound = m_index.at(str);
+		return pFound ? *pFound : id_type(kINVALID_ID);
+	}
+
+	std::string_view view(id_type nId) const
+	{
+		assert(nId < m_strings.size());
+		return m_strings[nId];
+	}
+
+	// Zero terminated.
+	const char* c_str(id_type nId) const
+	{
+		return view(nId).data();
+	}
+
+	// Drops every string, ids and views handed out become invalid.
+	void clear()
+	{
+		free_chunks();
+		m_index.clear();
+		m_strings.clear();
+	}
+
+	size_type size() const
+	{
+		return m_strings.size();
+	}
+
+	bool empty() const
+	{
+		return m_strings.empty();
+	}
+
+	// Characters stored, terminators included.
+	size_type byte_size() const
+	{
+		return m_nBytes;
+	}
+private:
+	struct Chunk
+	{
+		char* pData;
+		size_type nSize;
+	};
+
+	char* store(std::string_view str, tdk_err* pErrorCode)
+	{
+		size_type nBytes = str.size() + 1;
+		char* pCopy;
+		if (nBytes <= m_nLeft)
+		{
+			pCopy = m_pCursor;
+			m_pCursor += nBytes;
+			m_nLeft -= nBytes;
+		}
+		else if (nBytes > kCHUNK_SIZE / 4)
+		{
+			// a long string gets a chunk of its own, the current one keeps
+			// its free tail
+			pCopy = new_chunk(nBytes, pErrorCode);
+			if (!pCopy)
+				return nullptr;
+		}
+		else
+		{
+			pCopy = new_chunk(kCHUNK_SIZE, pErrorCode);
+			if (!pCopy)
+				return nullptr;
+			m_pCursor = pCopy + nBytes;
+			m_nLeft = kCHUNK_SIZE - nBytes;
+		}
+
+		std::memcpy(pCopy, str.data(), str.size());
+		pCopy[str.size()] = '\0';
+		m_nBytes += nBytes;
+		return pCopy;
+	}
+
+	char* new_chunk(size_type nSize, tdk_err* pErrorCode)
+	{
+		AllocatorForChar memAlloc;
+		char* pChunk = memAlloc.allocate(nSize);
+		if (!pChunk)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+			return nullptr;
+		}
+
+		if (kTDK_OK != m_chunks.push_back(Chunk{ pChunk, nSize }, pErrorCode))
+		{
+			memAlloc.deallocate(pChunk, nSize);
+			return nullptr;
+		}
+		return pChunk;
+	}
+
+	void free_chunks()
+	{
+		AllocatorForChar memAlloc;
+		for (const Chunk& chunk : m_chunks)
+			memAlloc.deallocate(chunk.pData, chunk.nSize);
+		m_chunks.clear();
+		m_pCursor = nullptr;
+		m_nLeft = 0;
+		m_nBytes = 0;
+	}
+
+	tdk_hashmap<std::string_view, id_type> m_index;
+	tdk_podarray<std::string_view> m_strings;
+	tdk_podarray<Chunk> m_chunks;
+	char* m_pCursor{};
+	size_type m_nLeft{};
+	size_type m_nBytes{};
+};
+
+#endif //TDK_STRINGPOOL_H
@@ -0,0 +1,69 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: CPU features detection.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_CPU_H
+#define TDK_CPU_H
+
+#include "base/tdkbasedefs.h"
+
+enum tdk_cpu_features_flags
+{
+	kTDK_CPU_SSE2 = 1 << 0,
+	kTDK_CPU_SSE42 = 1 << 1,
+	kTDK_CPU_POPCNT = 1 << 2,
+	kTDK_CPU_AVX2 = 1 << 3, // also means the OS saves the ymm registers
+};
+
+// Features of the running CPU as kTDK_CPU_XXX flags. Detected on the first
+// call, later calls return the cached value.
+tdk_u32 tdk_cpu_features();
+
+inline bool tdk_cpu_has(tdk_u32 nFeatures)
+{
+	return (tdk_cpu_features() & nFeatures) == nFeatures;
+}
+
+#endif //TDK_CPU_H
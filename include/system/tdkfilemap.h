@@ -0,0 +1,130 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: memory mapped files.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_FILEMAP_H
+#define TDK_FILEMAP_H
+
+#include "base/tdkbaseutl.h"
+
+enum tdk_file_map_flags
+{
+	kTDK_FILE_READ = 0,
+	kTDK_FILE_WRITE = 1, // map for reading and writing
+	kTDK_FILE_CREATE = 2, // create the file if it does not exist
+	kTDK_FILE_TRUNCATE = 4, // start from an empty file
+};
+
+// A whole file mapped into memory. Writable mappings are shared: stores
+// reach the file, flush() waits until they are on the disk. An empty file
+// has no mapping and data() returns nullptr.
+class tdk_file_mapping
+{
+public:
+	tdk_file_mapping();
+	~tdk_file_mapping();
+
+	tdk_file_mapping(const tdk_file_mapping&) = delete;
+	tdk_file_mapping& operator=(const tdk_file_mapping&) = delete;
+
+	// nFlags is a combination of tdk_file_map_flags. Fails with
+	// kTDK_BAD_FILE.
+	tdk_ret open(const char* szPath, tdk_u32 nFlags, tdk_err* pErrorCode = nullptr);
+	void close();
+
+	// Sets the file size and maps it again, so data() may change. Writable
+	// mappings only.
+	tdk_ret resize(tdk_size nBytes, tdk_err* pErrorCode = nullptr);
+
+	// Writes the changed pages of [nOffset, nOffset + nBytes) to the disk.
+	tdk_ret flush(tdk_size nOffset, tdk_size nBytes, tdk_err* pErrorCode = nullptr);
+
+	tdk_ret flush(tdk_err* pErrorCode = nullptr)
+	{
+		return flush(0, m_nSize, pErrorCode);
+	}
+
+	bool is_open() const
+	{
+		return m_bOpen;
+	}
+
+	bool is_writable() const
+	{
+		return m_bWritable;
+	}
+
+	tdk_byte* data()
+	{
+		return m_pData;
+	}
+
+	const tdk_byte* data() const
+	{
+		return m_pData;
+	}
+
+	tdk_size size() const
+	{
+		return m_nSize;
+	}
+
+private:
+	tdk_ret map(tdk_err* pErrorCode);
+	void unmap();
+
+	tdk_byte* m_pData;
+	tdk_size m_nSize;
+#ifdef _MSC_VER
+	void* m_hFile;
+	void* m_hMapping;
+#else
+	int m_nFile;
+#endif
+	bool m_bOpen;
+	bool m_bWritable;
+};
+
+#endif //TDK_FILEMAP_H
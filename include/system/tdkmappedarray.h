@@ -0,0 +1,461 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: array of POD elements in a memory mapped file.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_MAPPEDARRAY_H
+#define TDK_MAPPEDARRAY_H
+
+#include "base/tdkbaseutl.h"
+#include "base/tdkhash.h"
+#include "system/tdkfilemap.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
+// File layout: a 64 byte header, then the elements. The magic is written in
+// the byte order of the machine, a file from the other order does not open.
+struct tdk_mapped_array_header
+{
+	enum Constants
+	{
+		kMAGIC = 0x414B4454, // "TDKA" on little endian machines
+		kFORMAT = 1,
+		kHAS_CHECKSUM = 1
+	};
+
+	tdk_u32 nMagic;
+	tdk_u16 nFormat;
+	tdk_u16 nFlags;
+	tdk_u32 nElemSize;
+	tdk_u32 nUserVersion; // the caller's version of the element layout
+	tdk_u64 nCount;
+	tdk_u64 nChecksum; // tdk_hash_bytes of the elements
+	tdk_byte reserved[32];
+};
+
+static_assert(sizeof(tdk_mapped_array_header) == kTDK_CACHE_LINE_SIZE,
+	"elements must start on a cache line");
+
+enum tdk_mapped_array_flags
+{
+	kTDK_MAPPED_DEFAULT = 0,
+	kTDK_MAPPED_CHECKSUM = 1, // verify the checksum on open, write it on flush
+	kTDK_MAPPED_TRUNCATE = 2, // open_write() starts from an empty array
+};
+
+// Array of trivially copyable elements that lives in a mapped file. Opening
+// maps the file and checks the header, the elements are used in place with
+// no parsing or copying, so a large array is ready as soon as it is mapped.
+//
+// open_read() maps the file read-only: writing through data() or
+// operator[] crashes. open_write() also allows appending and resizing, the
+// file grows by ftruncate and a new mapping, which moves the elements to a
+// new address. The count and checksum in the file change on flush() and
+// close() only, a crash before that leaves the last flushed state.
+template<typename TElem>
+class tdk_mapped_podarray
+{
+	static_assert(std::is_trivially_copyable_v<TElem>,
+		"tdk_mapped_podarray requires a trivially copyable type");
+	static_assert(alignof(TElem) <= kTDK_CACHE_LINE_SIZE,
+		"elements are aligned on a cache line at most");
+
+	using Header = tdk_mapped_array_header;
+public:
+	typedef tdk_size size_type;
+	typedef TElem value_type;
+	typedef TElem* iterator;
+	typedef const TElem* const_iterator;
+
+	enum Constants
+	{
+		kGROW_BYTES = 64 * 1024 // file growth granularity
+	};
+
+	tdk_mapped_podarray()
+		: m_nCount(0)
+		, m_nCapacity(0)
+		, m_nFlags(0)
+	{
+	}
+
+	~tdk_mapped_podarray()
+	{
+		close();
+	}
+
+	tdk_mapped_podarray(const tdk_mapped_podarray&) = delete;
+	tdk_mapped_podarray& operator=(const tdk_mapped_podarray&) = delete;
+
+	// Fails with kTDK_BAD_FILE, kTDK_BAD_FORMAT if the header does not match
+	// TElem or nUserVersion, kTDK_BAD_CHECKSUM.
+	tdk_ret open_read(const char* szPath, tdk_u32 nUserVersion = 0,
+		tdk_u32 nFlags = kTDK_MAPPED_DEFAULT, tdk_err* pErrorCode = nullptr)
+	{
+		close();
+		if (kTDK_OK != m_file.open(szPath, kTDK_FILE_READ, pErrorCode))
+			return kTDK_ERR;
+		return attach(nUserVersion, nFlags, pErrorCode);
+	}
+
+	// Creates the file if it does not exist.
+	tdk_ret open_write(const char* szPath, tdk_u32 nUserVersion = 0,
+		tdk_u32 nFlags = kTDK_MAPPED_DEFAULT, tdk_err* pErrorCode = nullptr)
+	{
+		close();
+		tdk_u32 nFileFlags = kTDK_FILE_WRITE | kTDK_FILE_CREATE;
+		if (nFlags & kTDK_MAPPED_TRUNCATE)
+			nFileFlags |= kTDK_FILE_TRUNCATE;
+		if (kTDK_OK != m_file.open(szPath, nFileFlags, pErrorCode))
+			return kTDK_ERR;
+
+		if (!m_file.size())
+		{
+			if (kTDK_OK != m_file.resize(sizeof(Header), pErrorCode))
+			{
+				m_file.close();
+				return kTDK_ERR;
+			}
+
+			Header* pHeader = header();
+			std::memset(static_cast<void*>(pHeader), 0, sizeof(Header));
+			pHeader->nMagic = Header::kMAGIC;
+			pHeader->nFormat = Header::kFORMAT;
+			pHeader->nElemSize = tdk_u32(sizeof(TElem));
+			pHeader->nUserVersion = nUserVersion;
+		}
+		return attach(nUserVersion, nFlags, pErrorCode);
+	}
+
+	// Writes the count and the checksum to the header and waits until the
+	// file is on the disk.
+	tdk_ret flush(tdk_err* pErrorCode = nullptr)
+	{
+		if (!m_file.is_writable())
+			return kTDK_OK;
+		if (!m_file.data())
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_FILE);
+			return kTDK_ERR;
+		}
+
+		update_header();
+		return m_file.flush(0, sizeof(Header) + m_nCount * sizeof(TElem), pErrorCode);
+	}
+
+	// A writable file is flushed and cut to its exact size. If a failed
+	// grow lost the mapping the file is left as of the last flush.
+	tdk_ret close(tdk_err* pErrorCode = nullptr)
+	{
+		tdk_ret retVal = kTDK_OK;
+		if (m_file.is_writable() && !m_file.data())
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_FILE);
+			retVal = kTDK_ERR;
+		}
+		else if (m_file.is_writable())
+		{
+			update_header();
+			retVal = m_file.resize(sizeof(Header) + m_nCount * sizeof(TElem), pErrorCode);
+			if (kTDK_OK == retVal)
+				retVal = m_file.flush(pErrorCode);
+		}
+
+		m_file.close();
+		m_nCount = 0;
+		m_nCapacity = 0;
+		m_nFlags = 0;
+		return retVal;
+	}
+
+	bool is_open() const
+	{
+		return m_file.is_open();
+	}
+
+	tdk_ret push_back(const TElem& val, tdk_err* pErrorCode = nullptr)
+	{
+		return append(std::addressof(val), 1, pErrorCode);
+	}
+
+	tdk_ret append(const TElem* pSrc, size_type nCount, tdk_err* pErrorCode = nullptr)
+	{
+		assert(m_file.is_writable());
+		if (m_nCount + nCount > m_nCapacity)
+		{
+			// pSrc may point into the mapping that is about to move
+			bool bInside = pSrc >= begin() && pSrc < end();
+			size_type nSrcIdx = bInside ? size_type(pSrc - begin()) : 0;
+			tdk_ret retVal = grow(m_nCount + nCount, pErrorCode);
+			if (kTDK_OK != retVal)
+				return retVal;
+			if (bInside)
+				pSrc = begin() + nSrcIdx;
+		}
+
+		if (nCount)
+			std::memcpy(static_cast<void*>(end()), pSrc, nCount * sizeof(TElem));
+		m_nCount += nCount;
+		return kTDK_OK;
+	}
+
+	// New elements are copies of val.
+	tdk_ret resize(size_type nNewCount, const TElem& val = TElem(),
+		tdk_err* pErrorCode = nullptr)
+	{
+		assert(m_file.is_writable());
+		if (nNewCount > m_nCapacity)
+		{
+			const TElem valCopy = val;
+			tdk_ret retVal = grow(nNewCount, pErrorCode);
+			if (kTDK_OK != retVal)
+				return retVal;
+			std::fill(end(), begin() + nNewCount, valCopy);
+		}
+		else if (nNewCount > m_nCount)
+		{
+			std::fill(end(), begin() + nNewCount, val);
+		}
+		m_nCount = nNewCount;
+		return kTDK_OK;
+	}
+
+	tdk_ret reserve(size_type nNewCap, tdk_err* pErrorCode = nullptr)
+	{
+		assert(m_file.is_writable());
+		if (nNewCap <= m_nCapacity)
+			return kTDK_OK;
+		return set_capacity(nNewCap, pErrorCode);
+	}
+
+	void pop_back()
+	{
+		assert(m_nCount && m_file.is_writable());
+		--m_nCount;
+	}
+
+	void clear()
+	{
+		assert(m_file.is_writable());
+		m_nCount = 0;
+	}
+
+	TElem* at(size_type idx)
+	{
+		if (idx >= m_nCount)
+			return nullptr;
+		return begin() + idx;
+	}
+
+	const TElem* at(size_type idx) const
+	{
+		if (idx >= m_nCount)
+			return nullptr;
+		return begin() + idx;
+	}
+
+	TElem& operator[](size_type idx)
+	{
+		assert(idx < m_nCount);
+		return begin()[idx];
+	}
+
+	const TElem& operator[](size_type idx) const
+	{
+		assert(idx < m_nCount);
+		return begin()[idx];
+	}
+
+	TElem* data()
+	{
+		return begin();
+	}
+
+	const TElem* data() const
+	{
+		return begin();
+	}
+
+	iterator begin()
+	{
+		return m_file.data() ?
+			reinterpret_cast<TElem*>(m_file.data() + sizeof(Header)) : nullptr;
+	}
+
+	const_iterator begin() const
+	{
+		return m_file.data() ?
+			reinterpret_cast<const TElem*>(m_file.data() + sizeof(Header)) : nullptr;
+	}
+
+	iterator end()
+	{
+		return begin() + m_nCount;
+	}
+
+	const_iterator end() const
+	{
+		return begin() + m_nCount;
+	}
+
+	size_type size() const
+	{
+		return m_nCount;
+	}
+
+	bool empty() const
+	{
+		return 0 == m_nCount;
+	}
+
+	size_type capacity() const
+	{
+		return m_nCapacity;
+	}
+
+	tdk_u32 user_version() const
+	{
+		return m_file.data() ? header()->nUserVersion : 0;
+	}
+
+private:
+	Header* header()
+	{
+		return reinterpret_cast<Header*>(m_file.data());
+	}
+
+	const Header* header() const
+	{
+		return reinterpret_cast<const Header*>(m_file.data());
+	}
+
+	tdk_u64 checksum() const
+	{
+		return tdk_hash_bytes(begin(), m_nCount * sizeof(TElem));
+	}
+
+	tdk_ret attach(tdk_u32 nUserVersion, tdk_u32 nFlags, tdk_err* pErrorCode)
+	{
+		const Header* pHeader = header();
+		if (m_file.size() < sizeof(Header) ||
+			Header::kMAGIC != pHeader->nMagic ||
+			Header::kFORMAT != pHeader->nFormat ||
+			sizeof(TElem) != pHeader->nElemSize ||
+			nUserVersion != pHeader->nUserVersion ||
+			pHeader->nCount > (m_file.size() - sizeof(Header)) / sizeof(TElem))
+		{
+			m_file.close();
+			tdk_set_error_code(pErrorCode, kTDK_BAD_FORMAT);
+			return kTDK_ERR;
+		}
+
+		m_nCount = size_type(pHeader->nCount);
+		m_nCapacity = (m_file.size() - sizeof(Header)) / sizeof(TElem);
+		m_nFlags = nFlags;
+
+		if ((nFlags & kTDK_MAPPED_CHECKSUM) &&
+			(pHeader->nFlags & Header::kHAS_CHECKSUM) &&
+			pHeader->nChecksum != checksum())
+		{
+			m_file.close();
+			m_nCount = 0;
+			m_nCapacity = 0;
+			tdk_set_error_code(pErrorCode, kTDK_BAD_CHECKSUM);
+			return kTDK_ERR;
+		}
+		return kTDK_OK;
+	}
+
+	void update_header()
+	{
+		Header* pHeader = header();
+		assert(pHeader);
+		pHeader->nCount = m_nCount;
+		if (m_nFlags & kTDK_MAPPED_CHECKSUM)
+		{
+			pHeader->nChecksum = checksum();
+			pHeader->nFlags |= Header::kHAS_CHECKSUM;
+		}
+		else
+		{
+			pHeader->nChecksum = 0;
+			pHeader->nFlags &= tdk_u16(~Header::kHAS_CHECKSUM);
+		}
+	}
+
+	tdk_ret grow(size_type nNeeded, tdk_err* pErrorCode)
+	{
+		return set_capacity(tdk_max(nNeeded, m_nCapacity + m_nCapacity / 2), pErrorCode);
+	}
+
+	tdk_ret set_capacity(size_type nNewCap, tdk_err* pErrorCode)
+	{
+		tdk_size nBytes = sizeof(Header) + nNewCap * sizeof(TElem);
+		nBytes = (nBytes + kGROW_BYTES - 1) & ~tdk_size(kGROW_BYTES - 1);
+		if (kTDK_OK != m_file.resize(nBytes, pErrorCode))
+		{
+			// the file could not be mapped again, the elements are out of
+			// reach until it is reopened
+			if (!m_file.data())
+			{
+				m_nCount = 0;
+				m_nCapacity = 0;
+			}
+			return kTDK_ERR;
+		}
+
+		m_nCapacity = (nBytes - sizeof(Header)) / sizeof(TElem);
+		return kTDK_OK;
+	}
+
+	tdk_file_mapping m_file;
+	size_type m_nCount;
+	size_type m_nCapacity;
+	tdk_u32 m_nFlags;
+};
+
+#endif //TDK_MAPPEDARRAY_H
@@ -50,9 +50,34 @@ Purpose: memory management.
 #include "base/tdkbaseutl.h"
 
 
+// nAlignment is a power of two, 0 means the malloc alignment
 void* tdk_allocate_memory_aligned(tdk_size nBytes, tdk_size nAlignment);
        
 void tdk_free_memory_aligned(void* p, tdk_size nAlignment);
 
+// Huge pages
+const tdk_size kTDK_HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+enum tdk_memory_flags
+{
+	kTDK_MEMORY_DEFAULT = 0,
+	kTDK_MEMORY_HUGE_PAGES = 1, // large blocks go to tdk_allocate_memory_huge
+};
+
+inline tdk_size tdk_huge_page_round_up(tdk_size nBytes)
+{
+	return (nBytes + kTDK_HUGE_PAGE_SIZE - 1) & ~(kTDK_HUGE_PAGE_SIZE - 1);
+}
+
+// Allocates tdk_huge_page_round_up(nBytes) bytes on a kTDK_HUGE_PAGE_SIZE
+// boundary. Tries explicit huge pages first, then asks the kernel for
+// transparent huge pages, then falls back to normal pages. Returns nullptr
+// with kTDK_BAD_SIZE if nBytes cannot be rounded up and mapped, with
+// kTDK_BAD_ALLOC if the system has no memory for it.
+void* tdk_allocate_memory_huge(tdk_size nBytes, tdk_err* pErrorCode = nullptr);
+
+// nBytes must be the same value that was passed to tdk_allocate_memory_huge.
+void tdk_free_memory_huge(void* p, tdk_size nBytes);
+
 
 #endif //TDK_MEMORY_H
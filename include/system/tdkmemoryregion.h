@@ -0,0 +1,192 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: memory regions with byte budgets.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_MEMORYREGION_H
+#define TDK_MEMORYREGION_H
+
+#include "base/tdkbaseutl.h"
+#include "base/tdkmemutl.h"
+
+#include <mutex>
+
+// Memory of one subsystem or tenant. Every allocation is counted against a
+// hard byte budget: past it allocate() returns nullptr and reports
+// kTDK_BAD_ALLOC, like an allocator that ran out of memory. The bytes count
+// the block headers and alignment padding, so they are the real footprint.
+//
+// All live blocks are linked, release_all() frees them in one call. Nothing
+// that still uses them may be destroyed afterwards: drop the containers of
+// the region without running their destructors, or destroy them first.
+//
+// The region is thread safe, the blocks themselves come from
+// tdk_allocate_memory_aligned.
+class tdk_memory_region
+{
+public:
+	typedef tdk_size size_type;
+
+	explicit tdk_memory_region(const char* szName = "",
+		size_type nBudget = size_type(-1));
+	~tdk_memory_region();
+
+	tdk_memory_region(const tdk_memory_region&) = delete;
+	tdk_memory_region& operator=(const tdk_memory_region&) = delete;
+
+	// nAlignment is a power of two, 0 means the malloc alignment
+	void* allocate(size_type nBytes, size_type nAlignment,
+		tdk_err* pErrorCode = nullptr);
+
+	// p must come from this region, nullptr is ignored
+	void free(void* p);
+
+	void release_all();
+
+	// A budget below the live bytes only stops new allocations.
+	void set_budget(size_type nBudget);
+
+	size_type budget() const;
+	size_type live_bytes() const;
+	size_type peak_bytes() const;
+	size_type live_blocks() const;
+
+	const char* name() const
+	{
+		return m_szName;
+	}
+
+private:
+	struct BlockHeader;
+
+	// with m_mutex held
+	bool fits_budget(size_type nBlockBytes) const;
+
+	const char* m_szName;
+	mutable std::mutex m_mutex;
+	BlockHeader* m_pFirstBlock;
+	size_type m_nBudget;
+	size_type m_nLiveBytes;
+	size_type m_nPeakBytes;
+	size_type m_nLiveBlocks;
+};
+
+//-----------------------------------------------------------------------------
+// Stateless allocator for the tdk containers that takes memory from
+// Tag::region(), for example:
+//
+//	struct physics_memory
+//	{
+//		static tdk_memory_region& region()
+//		{
+//			static tdk_memory_region s_region("physics", 64 << 20);
+//			return s_region;
+//		}
+//	};
+//	tdk_darray<body, tdk_region_allocator<body, physics_memory>> bodies;
+//
+// An allocation over the budget makes the container fail with
+// kTDK_BAD_ALLOC.
+template<typename T, typename Tag, tdk_size kAlign = 16>
+class tdk_region_allocator
+{
+public:
+    using size_type = tdk_size;
+    using difference_type = tdk_diff;
+
+    using value_type = T;
+
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = T*;
+    using const_pointer = const T*;
+
+    template<typename U>
+    struct rebind
+    {
+        using other = tdk_region_allocator<U, Tag, kAlign>;
+    };
+
+    tdk_region_allocator() noexcept = default;
+
+    tdk_region_allocator(const tdk_region_allocator& oth) noexcept = default;
+
+    tdk_region_allocator& operator=(const tdk_region_allocator&) noexcept = default;
+
+    template<typename U>
+    tdk_region_allocator(const tdk_region_allocator<U, Tag, kAlign>&) noexcept { }
+
+    ~tdk_region_allocator() noexcept { }
+
+    T* allocate(size_type n)
+    {
+        if (n > size_type(-1) / sizeof(T))
+            return nullptr;
+        return static_cast<T*>(Tag::region().allocate(n * sizeof(T), kAlign));
+    }
+
+    void deallocate(T* p, size_type n)
+    {
+        TDK_UNUSED(n);
+        Tag::region().free(p);
+    }
+
+    friend bool operator==(const tdk_region_allocator&, const tdk_region_allocator&)
+    {
+        return true;
+    }
+
+    friend bool operator!=(const tdk_region_allocator&, const tdk_region_allocator&)
+    {
+        return false;
+    }
+};
+
+template <typename T, typename Tag, tdk_size kAlign>
+struct tdk_is_static_creatable<tdk_region_allocator<T, Tag, kAlign>> : public std::true_type
+{
+
+};
+
+#endif //TDK_MEMORYREGION_H
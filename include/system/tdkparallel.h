@@ -0,0 +1,496 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: parallel algorithms over contiguous arrays.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_PARALLEL_H
+#define TDK_PARALLEL_H
+
+#include "base/tdkbasedefs.h"
+#include "base/tdkbaseutl.h"
+#include "base/tdkpoddarray.h"
+#include "base/tdkradixsort.h"
+#include "system/tdkmemory.h"
+#include "system/tdksimd.h"
+#include "system/tdktaskscheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+// Parallel algorithms over contiguous arrays: tdk_darray, tdk_podarray or
+// anything else with begin() returning a pointer and size().
+//
+// The array is cut into at most 8 chunks per thread, every chunk at least
+// kTDK_PARALLEL_MIN_BYTES long. Chunk bounds are moved down to cache line
+// starts, so two threads never write the same line. Arrays too small for two
+// chunks, and schedulers with one thread, run serially on the caller.
+
+const tdk_size kTDK_PARALLEL_MIN_BYTES = 64 * 1024;
+
+template<typename T>
+tdk_size tdk_parallel_chunk_count(const tdk_task_scheduler& scheduler,
+	tdk_size nCount)
+{
+	tdk_size nThreads = scheduler.thread_count();
+	if (nThreads < 2)
+		return 1;
+
+	tdk_size nChunks = nCount / tdk_max(tdk_size(1), kTDK_PARALLEL_MIN_BYTES / sizeof(T));
+	return tdk_max(tdk_size(1), tdk_min(nChunks, 8 * nThreads));
+}
+
+// First element of chunk nChunk of nChunks.
+template<typename T>
+tdk_size tdk_parallel_chunk_bound(const T* pData, tdk_size nCount,
+	tdk_size nChunks, tdk_size nChunk)
+{
+	if (nChunk >= nChunks)
+		return nCount;
+
+	tdk_size nBound = tdk_size(tdk_u64(nCount) * nChunk / nChunks);
+	if constexpr (kTDK_CACHE_LINE_SIZE % sizeof(T) == 0)
+	{
+		tdk_size nLineOffset = reinterpret_cast<uintptr_t>(pData + nBound) &
+			(kTDK_CACHE_LINE_SIZE - 1);
+		if (0 == nLineOffset % sizeof(T))
+			nBound -= tdk_min(nBound, nLineOffset / sizeof(T));
+	}
+	return nBound;
+}
+
+// Calls func(nFirst, nLast, nChunk) for every chunk of [0, nCount).
+template<typename T, typename F>
+void tdk_parallel_chunks(tdk_task_scheduler& scheduler, const T* pData,
+	tdk_size nCount, const F& func)
+{
+	tdk_size nChunks = tdk_parallel_chunk_count<T>(scheduler, nCount);
+	if (nChunks < 2)
+	{
+		if (nCount)
+			func(tdk_size(0), nCount, tdk_size(0));
+		return;
+	}
+
+	scheduler.parallel_for(0, nChunks, [pData, nCount, nChunks, &func](
+		tdk_size nChunkFirst, tdk_size nChunkLast)
+	{
+		for (tdk_size nChunk = nChunkFirst; nChunk < nChunkLast; ++nChunk)
+		{
+			func(tdk_parallel_chunk_bound(pData, nCount, nChunks, nChunk),
+				tdk_parallel_chunk_bound(pData, nCount, nChunks, nChunk + 1),
+				nChunk);
+		}
+	}, 1);
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename Array, typename T>
+void tdk_parallel_fill(tdk_task_scheduler& scheduler, Array& arr, const T& val)
+{
+	auto* pData = arr.begin();
+	tdk_parallel_chunks(scheduler, pData, arr.size(),
+		[pData, &val](tdk_size nFirst, tdk_size nLast, tdk_size)
+	{
+		std::fill(pData + nFirst, pData + nLast, val);
+	});
+}
+
+// dst[i] = func(src[i]). dst must already hold src.size() elements and may
+// be src itself.
+template<typename SrcArray, typename DstArray, typename F>
+void tdk_parallel_transform(tdk_task_scheduler& scheduler, const SrcArray& src,
+	DstArray& dst, const F& func)
+{
+	assert(dst.size() >= src.size());
+	const auto* pSrc = src.begin();
+	auto* pDst = dst.begin();
+	tdk_parallel_chunks(scheduler, pDst, src.size(),
+		[pSrc, pDst, &func](tdk_size nFirst, tdk_size nLast, tdk_size)
+	{
+		for (tdk_size idx = nFirst; idx < nLast; ++idx)
+			pDst[idx] = func(pSrc[idx]);
+	});
+}
+
+// dst must already hold src.size() elements and must not overlap src.
+template<typename SrcArray, typename DstArray>
+void tdk_parallel_copy(tdk_task_scheduler& scheduler, const SrcArray& src,
+	DstArray& dst)
+{
+	assert(dst.size() >= src.size());
+	const auto* pSrc = src.begin();
+	auto* pDst = dst.begin();
+	using T = std::remove_reference_t<decltype(*pDst)>;
+	tdk_parallel_chunks(scheduler, pDst, src.size(),
+		[pSrc, pDst](tdk_size nFirst, tdk_size nLast, tdk_size)
+	{
+		if constexpr (std::is_trivially_copyable_v<T> &&
+			std::is_same_v<std::remove_const_t<std::remove_reference_t<decltype(*pSrc)>>, T>)
+		{
+			std::memcpy(static_cast<void*>(pDst + nFirst), pSrc + nFirst,
+				(nLast - nFirst) * sizeof(T));
+		}
+		else
+		{
+			std::copy(pSrc + nFirst, pSrc + nLast, pDst + nFirst);
+		}
+	});
+}
+
+// Folds the array with op, which must be associative: every chunk is folded
+// from its first element, then init and the chunk results are folded in
+// order. op is called as op(T, element) and op(T, T).
+template<typename Array, typename T, typename Op>
+T tdk_parallel_reduce(tdk_task_scheduler& scheduler, const Array& arr, T init,
+	const Op& op)
+{
+	const auto* pData = arr.begin();
+	tdk_size nCount = arr.size();
+	tdk_size nChunks = tdk_parallel_chunk_count<std::remove_reference_t<decltype(*pData)>>(
+		scheduler, nCount);
+
+	// one cache line per partial result
+	struct alignas(kTDK_CACHE_LINE_SIZE) Partial
+	{
+		alignas(T) tdk_byte storage[sizeof(T)];
+	};
+	Partial* pPartials = nChunks < 2 ? nullptr : static_cast<Partial*>(
+		tdk_allocate_memory_aligned(nChunks * sizeof(Partial), alignof(Partial)));
+	if (!pPartials)
+	{
+		for (tdk_size idx = 0; idx < nCount; ++idx)
+			init = op(std::move(init), pData[idx]);
+		return init;
+	}
+
+	tdk_parallel_chunks(scheduler, pData, nCount,
+		[pData, pPartials, &op](tdk_size nFirst, tdk_size nLast, tdk_size nChunk)
+	{
+		T acc = T(pData[nFirst]);
+		for (tdk_size idx = nFirst + 1; idx < nLast; ++idx)
+			acc = op(std::move(acc), pData[idx]);
+		::new (static_cast<void*>(pPartials[nChunk].storage)) T(std::move(acc));
+	});
+
+	for (tdk_size nChunk = 0; nChunk < nChunks; ++nChunk)
+	{
+		T* pPartial = std::launder(reinterpret_cast<T*>(pPartials[nChunk].storage));
+		init = op(std::move(init), std::move(*pPartial));
+		pPartial->~T();
+	}
+	tdk_free_memory_aligned(pPartials, alignof(Partial));
+	return init;
+}
+
+// Sorts the chunks in parallel and merges them pairwise, the pairs of each
+// round in parallel. Not stable.
+template<typename Array, typename Less>
+void tdk_parallel_sort(tdk_task_scheduler& scheduler, Array& arr, const Less& less)
+{
+	auto* pData = arr.begin();
+	tdk_size nCount = arr.size();
+	tdk_size nChunks = tdk_parallel_chunk_count<std::remove_reference_t<decltype(*pData)>>(
+		scheduler, nCount);
+
+	tdk_podarray<tdk_size> bounds;
+	if (nChunks < 2 || kTDK_OK != bounds.resize(nChunks + 1))
+	{
+		std::sort(pData, pData + nCount, less);
+		return;
+	}
+
+	for (tdk_size nChunk = 0; nChunk <= nChunks; ++nChunk)
+		bounds[nChunk] = tdk_parallel_chunk_bound(pData, nCount, nChunks, nChunk);
+
+	tdk_size* pBounds = bounds.data();
+	scheduler.parallel_for(0, nChunks, [pData, pBounds, &less](
+		tdk_size nChunkFirst, tdk_size nChunkLast)
+	{
+		for (tdk_size nChunk = nChunkFirst; nChunk < nChunkLast; ++nChunk)
+			std::sort(pData + pBounds[nChunk], pData + pBounds[nChunk + 1], less);
+	}, 1);
+
+	for (tdk_size nWidth = 1; nWidth < nChunks; nWidth *= 2)
+	{
+		tdk_size nPairs = (nChunks + 2 * nWidth - 1) / (2 * nWidth);
+		scheduler.parallel_for(0, nPairs, [pData, pBounds, nChunks, nWidth, &less](
+			tdk_size nPairFirst, tdk_size nPairLast)
+		{
+			for (tdk_size nPair = nPairFirst; nPair < nPairLast; ++nPair)
+			{
+				tdk_size nLo = nPair * 2 * nWidth;
+				tdk_size nMid = tdk_min(nLo + nWidth, nChunks);
+				tdk_size nHi = tdk_min(nLo + 2 * nWidth, nChunks);
+				if (nMid < nHi)
+				{
+					std::inplace_merge(pData + pBounds[nLo], pData + pBounds[nMid],
+						pData + pBounds[nHi], less);
+				}
+			}
+		}, 1);
+	}
+}
+
+template<typename Array>
+void tdk_parallel_sort(tdk_task_scheduler& scheduler, Array& arr)
+{
+	tdk_parallel_sort(scheduler, arr, std::less<>());
+}
+
+// tdk_radix_sort_by_key with the histograms and the scatter of every pass
+// split over the chunks. Each chunk writes a bucket right after the same
+// bucket of the chunks before it, so the sort stays stable. The first read
+// takes the histograms of all passes, later passes count again only the
+// byte they sort by.
+template<typename T, typename Allocator, typename KeyOf>
+tdk_ret tdk_parallel_radix_sort_by_key(tdk_task_scheduler& scheduler,
+	tdk_podarray<T, Allocator>& arr, const KeyOf& keyOf,
+	tdk_err* pErrorCode = nullptr)
+{
+	using Bits = tdk_radix_bits_type<T, KeyOf>;
+	const tdk_size kPasses = sizeof(Bits);
+	const tdk_size kBuckets = kTDK_RADIX_BUCKETS;
+
+	tdk_size nCount = arr.size();
+	tdk_size nChunks = tdk_parallel_chunk_count<T>(scheduler, nCount);
+	tdk_podarray<tdk_size> bounds;
+	tdk_podarray<tdk_size> counts;
+	tdk_podarray<tdk_size> offsets;
+	if (nChunks < 2 || kTDK_OK != bounds.resize(nChunks + 1) ||
+		kTDK_OK != counts.resize(nChunks * kPasses * kBuckets) ||
+		kTDK_OK != offsets.resize(nChunks * kBuckets))
+	{
+		return tdk_radix_sort_by_key(arr, keyOf, pErrorCode);
+	}
+
+	tdk_podarray<T, Allocator> scratch;
+	tdk_ret retVal = scratch.reserve(nCount, pErrorCode);
+	if (kTDK_OK != retVal)
+		return retVal;
+	scratch.resize_uninitialized(nCount);
+
+	for (tdk_size nChunk = 0; nChunk <= nChunks; ++nChunk)
+		bounds[nChunk] = tdk_parallel_chunk_bound(arr.data(), nCount, nChunks, nChunk);
+
+	// counts of chunk c for pass p start at (c * kPasses + p) * kBuckets
+	const tdk_size* pBounds = bounds.data();
+	tdk_size* pCounts = counts.data();
+	tdk_size* pOffsets = offsets.data();
+	const T* pInput = arr.data();
+	scheduler.parallel_for(0, nChunks, [pInput, pBounds, pCounts, &keyOf](
+		tdk_size nChunkFirst, tdk_size nChunkLast)
+	{
+		for (tdk_size nChunk = nChunkFirst; nChunk < nChunkLast; ++nChunk)
+		{
+			tdk_size* pChunkCounts = pCounts + nChunk * kPasses * kBuckets;
+			for (tdk_size idx = pBounds[nChunk]; idx < pBounds[nChunk + 1]; ++idx)
+			{
+				Bits nBits = tdk_radix_bits(keyOf, pInput[idx]);
+				for (tdk_size nPass = 0; nPass < kPasses; ++nPass)
+					++pChunkCounts[nPass * kBuckets + tdk_radix_digit(nBits, nPass)];
+			}
+		}
+	}, 1);
+
+	T* pSrc = arr.data();
+	T* pDst = scratch.data();
+	Bits nFirstBits = tdk_radix_bits(keyOf, pSrc[0]);
+	bool bInScratch = false;
+	bool bScattered = false;
+	for (tdk_size nPass = 0; nPass < kPasses; ++nPass)
+	{
+		tdk_size nFirstDigit = tdk_radix_digit(nFirstBits, nPass);
+		tdk_size nSame = 0;
+		for (tdk_size nChunk = 0; nChunk < nChunks; ++nChunk)
+			nSame += pCounts[(nChunk * kPasses + nPass) * kBuckets + nFirstDigit];
+		if (nSame == nCount)
+			continue;
+
+		// after a scatter the chunks hold other elements, count them again
+		if (bScattered)
+		{
+			scheduler.parallel_for(0, nChunks, [pSrc, pBounds, pCounts, nPass, &keyOf](
+				tdk_size nChunkFirst, tdk_size nChunkLast)
+			{
+				for (tdk_size nChunk = nChunkFirst; nChunk < nChunkLast; ++nChunk)
+				{
+					tdk_size* pChunkCounts = pCounts + (nChunk * kPasses + nPass) * kBuckets;
+					std::memset(pChunkCounts, 0, kBuckets * sizeof(tdk_size));
+					for (tdk_size idx = pBounds[nChunk]; idx < pBounds[nChunk + 1]; ++idx)
+						++pChunkCounts[tdk_radix_digit(tdk_radix_bits(keyOf, pSrc[idx]), nPass)];
+				}
+			}, 1);
+		}
+
+		tdk_size nOffset = 0;
+		for (tdk_size nBucket = 0; nBucket < kBuckets; ++nBucket)
+		{
+			for (tdk_size nChunk = 0; nChunk < nChunks; ++nChunk)
+			{
+				pOffsets[nChunk * kBuckets + nBucket] = nOffset;
+				nOffset += pCounts[(nChunk * kPasses + nPass) * kBuckets + nBucket];
+			}
+		}
+
+		scheduler.parallel_for(0, nChunks, [pSrc, pDst, pBounds, pOffsets, nPass, &keyOf](
+			tdk_size nChunkFirst, tdk_size nChunkLast)
+		{
+			for (tdk_size nChunk = nChunkFirst; nChunk < nChunkLast; ++nChunk)
+			{
+				tdk_size* pChunkOffsets = pOffsets + nChunk * kBuckets;
+				for (tdk_size idx = pBounds[nChunk]; idx < pBounds[nChunk + 1]; ++idx)
+				{
+					tdk_size nDigit = tdk_radix_digit(tdk_radix_bits(keyOf, pSrc[idx]), nPass);
+					pDst[pChunkOffsets[nDigit]++] = pSrc[idx];
+				}
+			}
+		}, 1);
+
+		std::swap(pSrc, pDst);
+		bInScratch = !bInScratch;
+		bScattered = true;
+	}
+
+	if (bInScratch)
+		arr.swap(scratch);
+	return kTDK_OK;
+}
+
+template<typename T, typename Allocator>
+tdk_ret tdk_parallel_radix_sort(tdk_task_scheduler& scheduler,
+	tdk_podarray<T, Allocator>& arr, tdk_err* pErrorCode = nullptr)
+{
+	return tdk_parallel_radix_sort_by_key(scheduler, arr, tdk_radix_identity(),
+		pErrorCode);
+}
+
+// Index of the first match in [0, nCount), nCount if there is none.
+// findInBlock(pBlock, n) returns the index of the first match in a block or
+// n. Chunks are scanned in blocks and stop once an earlier chunk has found
+// a match.
+template<typename T, typename BlockFind>
+tdk_size tdk_parallel_find_blocks(tdk_task_scheduler& scheduler, const T* pData,
+	tdk_size nCount, const BlockFind& findInBlock)
+{
+	enum Constants { kBLOCK = 4096 };
+
+	std::atomic<tdk_size> nFound(nCount);
+	tdk_parallel_chunks(scheduler, pData, nCount,
+		[pData, &findInBlock, &nFound](tdk_size nFirst, tdk_size nLast, tdk_size)
+	{
+		for (tdk_size nBlock = nFirst; nBlock < nLast; nBlock += kBLOCK)
+		{
+			if (nFound.load(std::memory_order_relaxed) < nBlock)
+				return;
+
+			tdk_size nBlockCount = tdk_min(tdk_size(kBLOCK), nLast - nBlock);
+			tdk_size idx = findInBlock(pData + nBlock, nBlockCount);
+			if (idx < nBlockCount)
+			{
+				idx += nBlock;
+				tdk_size nPrev = nFound.load(std::memory_order_relaxed);
+				while (idx < nPrev && !nFound.compare_exchange_weak(nPrev, idx,
+					std::memory_order_relaxed))
+				{
+				}
+				return;
+			}
+		}
+	});
+	return nFound.load(std::memory_order_relaxed);
+}
+
+// Index of the first element for which pred is true, size() if there is
+// none.
+template<typename Array, typename Pred>
+tdk_size tdk_parallel_find_if(tdk_task_scheduler& scheduler, const Array& arr,
+	const Pred& pred)
+{
+	return tdk_parallel_find_blocks(scheduler, arr.begin(), arr.size(),
+		[&pred](const auto* pBlock, tdk_size nBlockCount)
+	{
+		tdk_size idx = 0;
+		while (idx < nBlockCount && !pred(pBlock[idx]))
+			++idx;
+		return idx;
+	});
+}
+
+// Index of the first element equal to val, size() if there is none.
+// Arithmetic elements are searched with the SIMD kernels.
+template<typename Array, typename T>
+tdk_size tdk_parallel_find(tdk_task_scheduler& scheduler, const Array& arr,
+	const T& val)
+{
+	using TElem = std::remove_const_t<std::remove_reference_t<decltype(*arr.begin())>>;
+	using SimdType = typename tdk_simd_search_type<TElem>::type;
+
+	const TElem elemVal = TElem(val);
+	return tdk_parallel_find_blocks(scheduler, arr.begin(), arr.size(),
+		[&elemVal](const TElem* pBlock, tdk_size nBlockCount)
+	{
+		if constexpr (!std::is_void_v<SimdType>)
+		{
+			SimdType simdVal;
+			std::memcpy(&simdVal, &elemVal, sizeof(simdVal));
+			return tdk_simd_find(reinterpret_cast<const SimdType*>(pBlock),
+				nBlockCount, simdVal);
+		}
+		else
+		{
+			tdk_size idx = 0;
+			while (idx < nBlockCount && !(pBlock[idx] == elemVal))
+				++idx;
+			return idx;
+		}
+	});
+}
+
+#endif //TDK_PARALLEL_H
@@ -0,0 +1,136 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: SIMD kernels.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_SIMD_H
+#define TDK_SIMD_H
+
+#include "base/tdkbasedefs.h"
+
+#include <type_traits>
+
+// Element type the search kernels run on for T, void if there is no kernel.
+// Integers are compared by bit pattern, so every integer type maps to the
+// unsigned type of the same width. Floats keep operator== semantics
+// (0.0 equals -0.0, NaN equals nothing).
+template<typename T, typename = void>
+struct tdk_simd_search_type
+{
+	using type = void;
+};
+
+template<typename T>
+struct tdk_simd_search_type<T, std::enable_if_t<std::is_integral_v<T>>>
+{
+	using type =
+		std::conditional_t<sizeof(T) == 1, tdk_byte,
+		std::conditional_t<sizeof(T) == 2, tdk_u16,
+		std::conditional_t<sizeof(T) == 4, tdk_u32,
+		std::conditional_t<sizeof(T) == 8, tdk_u64, void>>>>;
+};
+
+template<>
+struct tdk_simd_search_type<float>
+{
+	using type = float;
+};
+
+template<>
+struct tdk_simd_search_type<double>
+{
+	using type = double;
+};
+
+// Kernels for T = tdk_byte, tdk_u16, tdk_u32, tdk_u64, float and double.
+// The AVX2, SSE2 or scalar version is picked on the first call.
+
+// Index of the first element equal to val, nCount if there is none.
+template<typename T>
+tdk_size tdk_simd_find(const T* pData, tdk_size nCount, T val);
+
+// Number of elements equal to val.
+template<typename T>
+tdk_size tdk_simd_count(const T* pData, tdk_size nCount, T val);
+
+// Word-wise operations for bit sets, also dispatched on the first call.
+
+enum tdk_simd_bit_op
+{
+	kTDK_BIT_AND,
+	kTDK_BIT_OR,
+	kTDK_BIT_XOR,
+	kTDK_BIT_ANDNOT // pDst & ~pSrc
+};
+
+// pDst[i] = pDst[i] op pSrc[i] for nWords words.
+void tdk_simd_bits_apply(tdk_u64* pDst, const tdk_u64* pSrc, tdk_size nWords,
+	tdk_simd_bit_op op);
+
+// Number of set bits in nWords words.
+tdk_size tdk_simd_popcount(const tdk_u64* pWords, tdk_size nWords);
+
+// Number of bits set in both pA[i] and pB[i], without storing the AND.
+tdk_size tdk_simd_popcount_and(const tdk_u64* pA, const tdk_u64* pB,
+	tdk_size nWords);
+
+// Bit packing of 128 values of nWidth (0..32) bits into 4 * nWidth words.
+// The values are spread over 4 interleaved lanes: value i goes to lane
+// i % 4, lane l owns the words l, l + 4, l + 8 ... So one 128-bit vector
+// unpacks 4 values at a time with the same shifts in every lane.
+const tdk_size kTDK_PACK_BLOCK = 128;
+
+// Bits above nWidth of the input values are dropped.
+void tdk_simd_pack128(const tdk_u32* pValues, tdk_u32 nWidth, tdk_u32* pWords);
+
+// pValues[i] = nBase + value i.
+void tdk_simd_unpack128(const tdk_u32* pWords, tdk_u32 nWidth, tdk_u32 nBase,
+	tdk_u32* pValues);
+
+// As above for lane deltas: pValues[i] = pValues[i - 4] + value i, with
+// nBase before the first row.
+void tdk_simd_unpack128_delta(const tdk_u32* pWords, tdk_u32 nWidth,
+	tdk_u32 nBase, tdk_u32* pValues);
+
+#endif //TDK_SIMD_H
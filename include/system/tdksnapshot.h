@@ -0,0 +1,505 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: binary snapshots of containers.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_SNAPSHOT_H
+#define TDK_SNAPSHOT_H
+
+#include "base/tdkbaseutl.h"
+#include "base/tdkdarray.h"
+#include "base/tdkhashmap.h"
+#include "base/tdkpoddarray.h"
+#include "system/tdkfilemap.h"
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// Snapshot file: a header, then sections of one container each. Every
+// section is a 64 byte section header and a payload that starts on a 64 byte
+// boundary.
+//
+// Trivially copyable elements are stored as their raw bytes and written with
+// one writev; the reader maps the file and hands out pointers into the
+// mapping, nothing is decoded. Other types go through tdk_codec<T>.
+//
+// The endian tag records the byte order of the writer. Elements are not
+// swapped: a snapshot from a machine of the other byte order fails to open
+// with kTDK_BAD_FORMAT.
+
+struct tdk_snapshot_header
+{
+	enum Constants
+	{
+		kMAGIC = 0x534B4454, // "TDKS" on little endian machines
+		kENDIAN_TAG = 0x01020304,
+		kFORMAT = 1
+	};
+
+	tdk_u32 nMagic;
+	tdk_u32 nEndianTag;
+	tdk_u32 nFormat;
+	tdk_u32 nUserVersion;
+	tdk_u64 nSectionCount;
+	tdk_byte reserved[40];
+};
+
+struct tdk_snapshot_section
+{
+	enum Kind
+	{
+		kRAW = 1, // nCount elements of nElemSize bytes
+		kCODEC = 2 // nCount elements written by tdk_codec
+	};
+
+	tdk_u32 nKind;
+	tdk_u32 nElemSize;
+	tdk_u64 nCount;
+	tdk_u64 nBytes; // payload bytes, without the padding
+	tdk_u64 nChecksum; // tdk_hash_bytes of the payload
+	tdk_byte reserved[32];
+};
+
+static_assert(sizeof(tdk_snapshot_header) == kTDK_CACHE_LINE_SIZE &&
+	sizeof(tdk_snapshot_section) == kTDK_CACHE_LINE_SIZE,
+	"payloads must start on a cache line");
+
+//-----------------------------------------------------------------------------
+// Codecs
+
+// Bytes of a kCODEC section being written.
+class tdk_snapshot_output
+{
+public:
+	tdk_ret write(const void* pSrc, tdk_size nBytes)
+	{
+		const tdk_byte* pBytes = static_cast<const tdk_byte*>(pSrc);
+		return m_bytes.insert(m_bytes.end(), pBytes, pBytes + nBytes);
+	}
+
+	void clear()
+	{
+		m_bytes.clear();
+	}
+
+	const tdk_byte* data() const
+	{
+		return m_bytes.data();
+	}
+
+	tdk_size size() const
+	{
+		return m_bytes.size();
+	}
+
+private:
+	tdk_podarray<tdk_byte> m_bytes;
+};
+
+// Bytes of a kCODEC section being read, read() fails past the end.
+class tdk_snapshot_input
+{
+public:
+	tdk_snapshot_input(const tdk_byte* pFirst, const tdk_byte* pLast)
+		: m_pCur(pFirst)
+		, m_pEnd(pLast)
+	{
+	}
+
+	tdk_ret read(void* pDst, tdk_size nBytes)
+	{
+		if (tdk_size(m_pEnd - m_pCur) < nBytes)
+			return kTDK_NO;
+		std::memcpy(pDst, m_pCur, nBytes);
+		m_pCur += nBytes;
+		return kTDK_OK;
+	}
+
+	// nBytes in place, nullptr past the end
+	const tdk_byte* skip(tdk_size nBytes)
+	{
+		if (tdk_size(m_pEnd - m_pCur) < nBytes)
+			return nullptr;
+		const tdk_byte* pResult = m_pCur;
+		m_pCur += nBytes;
+		return pResult;
+	}
+
+private:
+	const tdk_byte* m_pCur;
+	const tdk_byte* m_pEnd;
+};
+
+// Specialize for own types:
+//
+//	template<>
+//	struct tdk_codec<my_type>
+//	{
+//		static tdk_ret encode(const my_type& val, tdk_snapshot_output& out);
+//		static tdk_ret decode(tdk_snapshot_input& in, my_type& val);
+//	};
+//
+// Both return kTDK_OK on success. encode fails only when out cannot grow,
+// decode when the input ends early or holds bad data. encode must write at
+// least one byte: a section with more elements than payload bytes does not
+// open.
+template<typename T, typename = void>
+struct tdk_codec;
+
+template<typename T>
+struct tdk_codec<T, std::enable_if_t<std::is_trivially_copyable_v<T>>>
+{
+	static tdk_ret encode(const T& val, tdk_snapshot_output& out)
+	{
+		return out.write(std::addressof(val), sizeof(T));
+	}
+
+	static tdk_ret decode(tdk_snapshot_input& in, T& val)
+	{
+		return in.read(std::addressof(val), sizeof(T));
+	}
+};
+
+template<typename Char, typename Traits, typename Allocator>
+struct tdk_codec<std::basic_string<Char, Traits, Allocator>>
+{
+	using String = std::basic_string<Char, Traits, Allocator>;
+
+	static tdk_ret encode(const String& val, tdk_snapshot_output& out)
+	{
+		tdk_u64 nLength = val.size();
+		if (kTDK_OK != out.write(&nLength, sizeof(nLength)))
+			return kTDK_FATAL;
+		return out.write(val.data(), val.size() * sizeof(Char));
+	}
+
+	static tdk_ret decode(tdk_snapshot_input& in, String& val)
+	{
+		tdk_u64 nLength = 0;
+		if (kTDK_OK != in.read(&nLength, sizeof(nLength)) ||
+			nLength > tdk_u64(tdk_size(-1) / sizeof(Char)))
+		{
+			return kTDK_NO;
+		}
+
+		const tdk_byte* pChars = in.skip(tdk_size(nLength) * sizeof(Char));
+		if (!pChars)
+			return kTDK_NO;
+		val.resize(tdk_size(nLength));
+		std::memcpy(&val[0], pChars, tdk_size(nLength) * sizeof(Char));
+		return kTDK_OK;
+	}
+};
+
+template<typename First, typename Second>
+struct tdk_codec<std::pair<First, Second>,
+	std::enable_if_t<!std::is_trivially_copyable_v<std::pair<First, Second>>>>
+{
+	static tdk_ret encode(const std::pair<First, Second>& val, tdk_snapshot_output& out)
+	{
+		if (kTDK_OK != tdk_codec<First>::encode(val.first, out))
+			return kTDK_FATAL;
+		return tdk_codec<Second>::encode(val.second, out);
+	}
+
+	static tdk_ret decode(tdk_snapshot_input& in, std::pair<First, Second>& val)
+	{
+		if (kTDK_OK != tdk_codec<First>::decode(in, val.first))
+			return kTDK_NO;
+		return tdk_codec<Second>::decode(in, val.second);
+	}
+};
+
+//-----------------------------------------------------------------------------
+
+class tdk_snapshot_writer
+{
+public:
+	tdk_snapshot_writer();
+	~tdk_snapshot_writer();
+
+	tdk_snapshot_writer(const tdk_snapshot_writer&) = delete;
+	tdk_snapshot_writer& operator=(const tdk_snapshot_writer&) = delete;
+
+	// Creates or truncates the file. nUserVersion is the caller's version
+	// of what the sections hold, the reader must ask for the same one.
+	tdk_ret open(const char* szPath, tdk_u32 nUserVersion = 0,
+		tdk_err* pErrorCode = nullptr);
+
+	// Completes the header. A snapshot that was not closed does not open.
+	// After a failed write the header stays incomplete and close() fails.
+	tdk_ret close(tdk_err* pErrorCode = nullptr);
+
+	// Each write() adds one section, sections are read back by their index.
+	template<typename T, typename Allocator>
+	tdk_ret write(const tdk_podarray<T, Allocator>& arr, tdk_err* pErrorCode = nullptr)
+	{
+		return write_section(tdk_snapshot_section::kRAW, tdk_u32(sizeof(T)),
+			arr.size(), arr.data(), arr.size() * sizeof(T), pErrorCode);
+	}
+
+	template<typename T, typename Allocator>
+	tdk_ret write(const tdk_darray<T, Allocator>& arr, tdk_err* pErrorCode = nullptr)
+	{
+		if constexpr (std::is_trivially_copyable_v<T>)
+		{
+			return write_section(tdk_snapshot_section::kRAW, tdk_u32(sizeof(T)),
+				arr.size(), arr.begin(), arr.size() * sizeof(T), pErrorCode);
+		}
+		else
+		{
+			m_buffer.clear();
+			for (const T& val : arr)
+			{
+				if (kTDK_OK != tdk_codec<T>::encode(val, m_buffer))
+					return encode_failed(pErrorCode);
+			}
+			return write_section(tdk_snapshot_section::kCODEC, 0, arr.size(),
+				m_buffer.data(), m_buffer.size(), pErrorCode);
+		}
+	}
+
+	template<typename K, typename V, typename Hash, typename KeyEq, typename Allocator>
+	tdk_ret write(const tdk_hashmap<K, V, Hash, KeyEq, Allocator>& map,
+		tdk_err* pErrorCode = nullptr)
+	{
+		m_buffer.clear();
+		for (const auto& slot : map)
+		{
+			if (kTDK_OK != tdk_codec<K>::encode(slot.first, m_buffer) ||
+				kTDK_OK != tdk_codec<V>::encode(slot.second, m_buffer))
+			{
+				return encode_failed(pErrorCode);
+			}
+		}
+		return write_section(tdk_snapshot_section::kCODEC, 0, map.size(),
+			m_buffer.data(), m_buffer.size(), pErrorCode);
+	}
+
+	tdk_ret write_section(tdk_u32 nKind, tdk_u32 nElemSize, tdk_u64 nCount,
+		const void* pPayload, tdk_size nBytes, tdk_err* pErrorCode = nullptr);
+
+private:
+	tdk_ret encode_failed(tdk_err* pErrorCode)
+	{
+		m_buffer.clear();
+		tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+		return kTDK_FATAL;
+	}
+
+	tdk_snapshot_output m_buffer;
+	tdk_u64 m_nSectionCount;
+	tdk_u32 m_nUserVersion;
+	bool m_bFailed; // a section may be half written, the file is lost
+#ifdef _MSC_VER
+	void* m_hFile;
+#else
+	int m_nFile;
+#endif
+};
+
+//-----------------------------------------------------------------------------
+
+enum tdk_snapshot_flags
+{
+	kTDK_SNAPSHOT_DEFAULT = 0,
+	kTDK_SNAPSHOT_VERIFY = 1, // check the payload checksums on open
+};
+
+// Maps a snapshot read-only. Views point into the mapping and stay valid
+// until close().
+class tdk_snapshot_reader
+{
+public:
+	typedef tdk_size size_type;
+
+	tdk_snapshot_reader() = default;
+
+	tdk_snapshot_reader(const tdk_snapshot_reader&) = delete;
+	tdk_snapshot_reader& operator=(const tdk_snapshot_reader&) = delete;
+
+	// Fails with kTDK_BAD_FILE, kTDK_BAD_FORMAT (including another byte
+	// order or user version) or kTDK_BAD_CHECKSUM.
+	tdk_ret open(const char* szPath, tdk_u32 nUserVersion = 0,
+		tdk_u32 nFlags = kTDK_SNAPSHOT_DEFAULT, tdk_err* pErrorCode = nullptr);
+	void close();
+
+	size_type section_count() const
+	{
+		return m_sections.size();
+	}
+
+	const tdk_snapshot_section* section(size_type nSection) const
+	{
+		if (nSection >= m_sections.size())
+			return nullptr;
+		return reinterpret_cast<const tdk_snapshot_section*>(
+			m_file.data() + m_sections[nSection]);
+	}
+
+	// Zero-copy access to a kRAW section of T.
+	template<typename T>
+	tdk_ret view(size_type nSection, const T*& pData, size_type& nCount,
+		tdk_err* pErrorCode = nullptr) const
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "only raw sections have views");
+		static_assert(alignof(T) <= kTDK_CACHE_LINE_SIZE, "payloads are cache line aligned");
+
+		const tdk_snapshot_section* pSection = section(nSection);
+		if (!pSection || tdk_snapshot_section::kRAW != pSection->nKind ||
+			sizeof(T) != pSection->nElemSize)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_FORMAT);
+			return kTDK_ERR;
+		}
+
+		pData = reinterpret_cast<const T*>(payload(pSection));
+		nCount = size_type(pSection->nCount);
+		return kTDK_OK;
+	}
+
+	template<typename T, typename Allocator>
+	tdk_ret load(size_type nSection, tdk_podarray<T, Allocator>& arr,
+		tdk_err* pErrorCode = nullptr) const
+	{
+		const T* pData = nullptr;
+		size_type nCount = 0;
+		if (kTDK_OK != view(nSection, pData, nCount, pErrorCode))
+			return kTDK_ERR;
+		return arr.assign(pData, nCount, pErrorCode);
+	}
+
+	// Appends the elements to arr.
+	template<typename T, typename Allocator>
+	tdk_ret load(size_type nSection, tdk_darray<T, Allocator>& arr,
+		tdk_err* pErrorCode = nullptr) const
+	{
+		if constexpr (std::is_trivially_copyable_v<T>)
+		{
+			const T* pData = nullptr;
+			size_type nCount = 0;
+			if (kTDK_OK != view(nSection, pData, nCount, pErrorCode))
+				return kTDK_ERR;
+			return arr.insert(arr.end(), pData, pData + nCount, pErrorCode);
+		}
+		else
+		{
+			const tdk_snapshot_section* pSection = codec_section(nSection, pErrorCode);
+			if (!pSection)
+				return kTDK_ERR;
+
+			tdk_snapshot_input in(payload(pSection), payload(pSection) + pSection->nBytes);
+			if (kTDK_OK != arr.reserve(arr.size() + size_type(pSection->nCount), pErrorCode))
+				return kTDK_FATAL;
+			for (tdk_u64 i = 0; i < pSection->nCount; ++i)
+			{
+				T val{};
+				if (kTDK_OK != tdk_codec<T>::decode(in, val))
+					return decode_failed(pErrorCode);
+				if (kTDK_OK != arr.push_back(val, pErrorCode))
+					return kTDK_FATAL;
+			}
+			return kTDK_OK;
+		}
+	}
+
+	// Inserts the elements into map, replacing the values of present keys.
+	template<typename K, typename V, typename Hash, typename KeyEq, typename Allocator>
+	tdk_ret load(size_type nSection, tdk_hashmap<K, V, Hash, KeyEq, Allocator>& map,
+		tdk_err* pErrorCode = nullptr) const
+	{
+		const tdk_snapshot_section* pSection = codec_section(nSection, pErrorCode);
+		if (!pSection)
+			return kTDK_ERR;
+
+		tdk_snapshot_input in(payload(pSection), payload(pSection) + pSection->nBytes);
+		if (kTDK_OK != map.reserve(map.size() + size_type(pSection->nCount), pErrorCode))
+			return kTDK_FATAL;
+		for (tdk_u64 i = 0; i < pSection->nCount; ++i)
+		{
+			K key{};
+			V val{};
+			if (kTDK_OK != tdk_codec<K>::decode(in, key) ||
+				kTDK_OK != tdk_codec<V>::decode(in, val))
+			{
+				return decode_failed(pErrorCode);
+			}
+
+			tdk_ret retVal = map.insert_or_assign(std::move(key), std::move(val), pErrorCode);
+			if (kTDK_OK != retVal && kTDK_NO != retVal)
+				return kTDK_FATAL;
+		}
+		return kTDK_OK;
+	}
+
+private:
+	const tdk_byte* payload(const tdk_snapshot_section* pSection) const
+	{
+		return reinterpret_cast<const tdk_byte*>(pSection) + sizeof(tdk_snapshot_section);
+	}
+
+	const tdk_snapshot_section* codec_section(size_type nSection, tdk_err* pErrorCode) const
+	{
+		const tdk_snapshot_section* pSection = section(nSection);
+		if (!pSection || tdk_snapshot_section::kCODEC != pSection->nKind)
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_FORMAT);
+			return nullptr;
+		}
+		return pSection;
+	}
+
+	static tdk_ret decode_failed(tdk_err* pErrorCode)
+	{
+		tdk_set_error_code(pErrorCode, kTDK_BAD_FORMAT);
+		return kTDK_ERR;
+	}
+
+	tdk_file_mapping m_file;
+	tdk_podarray<tdk_size> m_sections; // offsets of the section headers
+};
+
+#endif //TDK_SNAPSHOT_H
@@ -0,0 +1,246 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: work stealing task scheduler.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_TASKSCHEDULER_H
+#define TDK_TASKSCHEDULER_H
+
+#include "base/tdkbasedefs.h"
+#include "base/tdkbaseutl.h"
+#include "base/tdkdarray.h"
+
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+class tdk_task_scheduler;
+class tdk_task_group;
+
+// Bytes a task keeps for its functor. Tasks are fixed size pool objects, so
+// a lambda must fit here: capture big data by reference or by pointer.
+const tdk_size kTDK_TASK_FUNCTOR_SIZE = 48;
+
+struct tdk_task
+{
+	void (*pfnRun)(tdk_task*); // calls and destroys the functor
+	tdk_task_group* pGroup;
+	void* pOwner; // worker whose pool holds the task, nullptr for the heap
+	tdk_task* pNextFree; // link in the owner's list of tasks freed by others
+	alignas(void*) tdk_byte functor[kTDK_TASK_FUNCTOR_SIZE];
+};
+
+//-----------------------------------------------------------------------------
+// Work stealing scheduler. Every thread has a Chase-Lev deque: it pushes and
+// pops its own tasks at the bottom without locks, idle threads steal from
+// the top of the others. Tasks come from a tdk_memorypool of the spawning
+// thread, so spawning does not touch the heap; a task finished by a thief
+// goes back to its owner through a lock-free list.
+//
+// The thread that calls initialize() is worker 0 and works while it waits
+// for a task group. Tasks spawned by other threads go through a shared queue
+// and use the heap.
+class tdk_task_scheduler
+{
+public:
+	typedef tdk_size size_type;
+
+	tdk_task_scheduler();
+	~tdk_task_scheduler();
+
+	tdk_task_scheduler(const tdk_task_scheduler&) = delete;
+	tdk_task_scheduler& operator=(const tdk_task_scheduler&) = delete;
+
+	// nThreads counts the calling thread, 0 means one per hardware thread.
+	// Until initialize() succeeds every task runs at once on the spawning
+	// thread.
+	tdk_ret initialize(size_type nThreads = 0, tdk_err* pErrorCode = nullptr);
+
+	// Stops and joins the threads. All task groups must be finished.
+	void shutdown();
+
+	size_type thread_count() const;
+
+	// Calls func(nChunkFirst, nChunkLast) for chunks that cover
+	// [nFirst, nLast). Ranges above nGrain are split in halves and one half
+	// is left for thieves, so idle threads take big pieces first. nGrain 0
+	// makes about 8 chunks per thread.
+	template<typename F>
+	void parallel_for(size_type nFirst, size_type nLast, const F& func,
+		size_type nGrain = 0);
+
+	// Calls func(elem) for every element of arr.
+	template<typename T, typename Allocator, typename F>
+	void parallel_for(tdk_darray<T, Allocator>& arr, const F& func,
+		size_type nGrain = 0);
+
+private:
+	friend class tdk_task_group;
+	class Impl;
+
+	tdk_task* allocate_task();
+	void free_task(tdk_task* pTask);
+	void submit(tdk_task* pTask);
+	void execute(tdk_task* pTask);
+	bool run_one();
+
+	template<typename F>
+	static void split_range(tdk_task_group& group, size_type nFirst,
+		size_type nLast, size_type nGrain, const F* pFunc);
+
+	Impl* m_pImpl;
+};
+
+//-----------------------------------------------------------------------------
+// Tasks that are waited for together. wait() runs pending tasks, this
+// group's or others', until the group is done; it never blocks a thread that
+// could be working.
+class tdk_task_group
+{
+public:
+	typedef tdk_size size_type;
+
+	explicit tdk_task_group(tdk_task_scheduler& scheduler)
+		: m_scheduler(scheduler)
+		, m_nPending(0)
+	{
+	}
+
+	~tdk_task_group()
+	{
+		wait();
+	}
+
+	tdk_task_group(const tdk_task_group&) = delete;
+	tdk_task_group& operator=(const tdk_task_group&) = delete;
+
+	// Runs func() on some thread. A task that cannot be allocated or queued
+	// runs right here.
+	template<typename F>
+	void run(F&& func)
+	{
+		using Functor = std::decay_t<F>;
+		static_assert(sizeof(Functor) <= kTDK_TASK_FUNCTOR_SIZE,
+			"the functor does not fit in tdk_task, capture by reference");
+		static_assert(alignof(Functor) <= alignof(void*),
+			"the functor is over-aligned for tdk_task");
+
+		tdk_task* pTask = m_scheduler.allocate_task();
+		if (!pTask)
+		{
+			func();
+			return;
+		}
+
+		::new (static_cast<void*>(pTask->functor)) Functor(std::forward<F>(func));
+		pTask->pfnRun = &run_functor<Functor>;
+		pTask->pGroup = this;
+		m_nPending.fetch_add(1, std::memory_order_relaxed);
+		m_scheduler.submit(pTask);
+	}
+
+	void wait();
+
+private:
+	friend class tdk_task_scheduler;
+
+	template<typename Functor>
+	static void run_functor(tdk_task* pTask)
+	{
+		Functor* pFunctor = std::launder(reinterpret_cast<Functor*>(pTask->functor));
+		(*pFunctor)();
+		pFunctor->~Functor();
+	}
+
+	tdk_task_scheduler& m_scheduler;
+	std::atomic<size_type> m_nPending;
+};
+
+//-----------------------------------------------------------------------------
+
+template<typename F>
+void tdk_task_scheduler::parallel_for(size_type nFirst, size_type nLast,
+	const F& func, size_type nGrain)
+{
+	if (nFirst >= nLast)
+		return;
+
+	if (!nGrain)
+		nGrain = tdk_max(size_type(1), (nLast - nFirst) / (8 * thread_count()));
+
+	tdk_task_group group(*this);
+	split_range(group, nFirst, nLast, nGrain, &func);
+	group.wait();
+}
+
+template<typename T, typename Allocator, typename F>
+void tdk_task_scheduler::parallel_for(tdk_darray<T, Allocator>& arr,
+	const F& func, size_type nGrain)
+{
+	T* pData = arr.begin();
+	parallel_for(0, arr.size(), [pData, &func](size_type nFirst, size_type nLast)
+	{
+		for (size_type idx = nFirst; idx < nLast; ++idx)
+			func(pData[idx]);
+	}, nGrain);
+}
+
+template<typename F>
+void tdk_task_scheduler::split_range(tdk_task_group& group, size_type nFirst,
+	size_type nLast, size_type nGrain, const F* pFunc)
+{
+	while (nLast - nFirst > nGrain)
+	{
+		size_type nMid = nFirst + (nLast - nFirst) / 2;
+		group.run([&group, nMid, nLast, nGrain, pFunc]()
+		{
+			split_range(group, nMid, nLast, nGrain, pFunc);
+		});
+		nLast = nMid;
+	}
+	(*pFunc)(nFirst, nLast);
+}
+
+#endif //TDK_TASKSCHEDULER_H
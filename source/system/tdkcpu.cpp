@@ -0,0 +1,97 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: CPU features detection.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#include "system/tdkcpu.h"
+
+#if defined(TDK_X86) && defined(_MSC_VER)
+#	include <intrin.h>
+#	include <immintrin.h>
+#endif
+
+static tdk_u32 tdk_detect_cpu_features()
+{
+	tdk_u32 nFeatures = 0;
+#if defined(TDK_X86) && defined(_MSC_VER)
+	int info[4] = {};
+	__cpuid(info, 0);
+	int nMaxLeaf = info[0];
+
+	__cpuid(info, 1);
+	if (info[3] & (1 << 26))
+		nFeatures |= kTDK_CPU_SSE2;
+	if (info[2] & (1 << 20))
+		nFeatures |= kTDK_CPU_SSE42;
+	if (info[2] & (1 << 23))
+		nFeatures |= kTDK_CPU_POPCNT;
+
+	// AVX needs OSXSAVE and the OS enabling xmm/ymm state in XCR0
+	bool bOsAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+		6 == (_xgetbv(0) & 6);
+	if (bOsAvx && nMaxLeaf >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		if (info[1] & (1 << 5))
+			nFeatures |= kTDK_CPU_AVX2;
+	}
+#elif defined(TDK_X86) && defined(TDK_GNUC_VER)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2"))
+		nFeatures |= kTDK_CPU_SSE2;
+	if (__builtin_cpu_supports("sse4.2"))
+		nFeatures |= kTDK_CPU_SSE42;
+	if (__builtin_cpu_supports("popcnt"))
+		nFeatures |= kTDK_CPU_POPCNT;
+	if (__builtin_cpu_supports("avx2"))
+		nFeatures |= kTDK_CPU_AVX2;
+#endif
+	return nFeatures;
+}
+
+tdk_u32 tdk_cpu_features()
+{
+	static const tdk_u32 s_nFeatures = tdk_detect_cpu_features();
+	return s_nFeatures;
+}
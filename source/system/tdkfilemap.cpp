@@ -0,0 +1,301 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: memory mapped files.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#include "system/tdkfilemap.h"
+#include <cassert>
+
+#ifdef _MSC_VER
+#	include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+tdk_file_mapping::tdk_file_mapping()
+	: m_pData(nullptr)
+	, m_nSize(0)
+#ifdef _MSC_VER
+	, m_hFile(INVALID_HANDLE_VALUE)
+	, m_hMapping(nullptr)
+#else
+	, m_nFile(-1)
+#endif
+	, m_bOpen(false)
+	, m_bWritable(false)
+{
+}
+
+tdk_file_mapping::~tdk_file_mapping()
+{
+	close();
+}
+
+#ifdef _MSC_VER
+
+tdk_ret tdk_file_mapping::open(const char* szPath, tdk_u32 nFlags, tdk_err* pErrorCode)
+{
+	close();
+
+	bool bWrite = 0 != (nFlags & kTDK_FILE_WRITE);
+	DWORD nAccess = bWrite ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ;
+	DWORD nDisposition = OPEN_EXISTING;
+	if (nFlags & kTDK_FILE_CREATE)
+		nDisposition = (nFlags & kTDK_FILE_TRUNCATE) ? CREATE_ALWAYS : OPEN_ALWAYS;
+	else if (nFlags & kTDK_FILE_TRUNCATE)
+		nDisposition = TRUNCATE_EXISTING;
+
+	HANDLE hFile = CreateFileA(szPath, nAccess, FILE_SHARE_READ, nullptr,
+		nDisposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+	LARGE_INTEGER nFileSize = {};
+	if (INVALID_HANDLE_VALUE == hFile || !GetFileSizeEx(hFile, &nFileSize))
+	{
+		if (INVALID_HANDLE_VALUE != hFile)
+			CloseHandle(hFile);
+		tdk_set_error_code(pErrorCode, kTDK_BAD_FILE);
+		return kTDK_ERR;
+	}
+
+	m_hFile = hFile;
+	m_nSize = tdk_size(nFileSize.QuadPart);
+	m_bOpen = true;
+	m_bWritable = bWrite;
+	if (kTDK_OK != map(pErrorCode))
+	{
+		close();
+		return kTDK_ERR;
+	}
+	return kTDK_OK;
+}
+
+void tdk_file_mapping::close()
+{
+	if (!m_bOpen)
+		return;
+
+	unmap();
+	CloseHandle(m_hFile);
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_nSize = 0;
+	m_bOpen = false;
+	m_bWritable = false;
+}
+
+tdk_ret tdk_file_mapping::resize(tdk_size nBytes, tdk_err* pErrorCode)
+{
+	assert(m_bOpen && m_bWritable);
+
+	unmap();
+	LARGE_INTEGER nPos = {};
+	nPos.QuadPart = LONGLONG(nBytes);
+	if (!SetFilePointerEx(m_hFile, nPos, nullptr, FILE_BEGIN) || !SetEndOfFile(m_hFile))
+	{
+		map(nullptr);
+		tdk_set_error_code(pErrorCode, kTDK_BAD_FILE);
+		return kTDK_ERR;
+	}
+
+	m_nSize = nBytes;
+	return map(pErrorCode);
+}
+
+tdk_ret tdk_file_mapping::flush(tdk_size nOffset, tdk_size nBytes, tdk_err* pErrorCode)
+{
+	if (!m_pData || !m_bWritable || nOffset >= m_nSize)
+		return kTDK_OK;
+
+	nBytes = tdk_min(nBytes, m_nSize - nOffset);
+	if (!FlushViewOfFile(m_pData + nOffset, nBytes) || !FlushFileBuffers(m_hFile))
+	{
+		tdk_set_error_code(pErrorCode, kTDK_BAD_FILE);
+		return kTDK_ERR;
+	}
+	return kTDK_OK;
+}
+
+tdk_ret tdk_file_mapping::map(tdk_err* pErrorCode)
+{
+	if (!m_nSize)
+		return kTDK_OK;
+
+	tdk_u64 nSize = m_nSize;
+	m_hMapping = CreateFileMappingA(m_hFile, nullptr,
+		m_bWritable ? PAGE_READWRITE : PAGE_READONLY,
+		DWORD(nSize >> 32), DWORD(nSize), nullptr);
+	if (m_hMapping)
+	{
+		m_pData = static_cast<tdk_byte*>(MapViewOfFile(m_hMapping,
+			m_bWritable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+	}
+
+	if (!m_pData)
+	{
+		unmap();
+		tdk_set_error_code(pErrorCode, kTDK_BAD_FILE);
+		return kTDK_ERR;
+	}
+	return kTDK_OK;
+}
+
+void tdk_file_mapping::unmap()
+{
+	if (m_pData)
+		UnmapViewOfFile(m_pData);
+	if (m_hMapping)
+		CloseHandle(m_hMapping);
+	m_pData = nullptr;
+	m_hMapping = nullptr;
+}
+
+#elif defined(__unix__) || defined(__APPLE__)
+
+tdk_ret tdk_file_mapping::open(const char* szPath, tdk_u32 nFlags, tdk_err* pErrorCode)
+{
+	close();
+
+	bool bWrite = 0 != (nFlags & kTDK_FILE_WRITE);
+	int nOpenFlags = bWrite ? O_RDWR : O_RDONLY;
+	if (nFlags & kTDK_FILE_CREATE)
+		nOpenFlags |= O_CREAT;
+	if (nFlags & kTDK_FILE_TRUNCATE)
+		nOpenFlags |= O_TRUNC;
+
+	int nFile = ::open(szPath, nOpenFlags | O_CLOEXEC, 0644);
+	struct stat fileStat;
+	if (nFile < 0 || 0 != fstat(nFile, &fileStat))
+	{
+		if (nFile >= 0)
+			::close(nFile);
+		tdk_set_error_code(pErrorCode, kTDK_BAD_FILE);
+		return kTDK_ERR;
+	}
+
+	m_nFile = nFile;
+	m_nSize = tdk_size(fileStat.st_size);
+	m_bOpen = true;
+	m_bWritable = bWrite;
+	if (kTDK_OK != map(pErrorCode))
+	{
+		close();
+		return kTDK_ERR;
+	}
+	return kTDK_OK;
+}
+
+void tdk_file_mapping::close()
+{
+	if (!m_bOpen)
+		return;
+
+	unmap();
+	::close(m_nFile);
+	m_nFile = -1;
+	m_nSize = 0;
+	m_bOpen = false;
+	m_bWritable = false;
+}
+
+tdk_ret tdk_file_mapping::resize(tdk_size nBytes, tdk_err* pErrorCode)
+{
+	assert(m_bOpen && m_bWritable);
+
+	unmap();
+	if (0 != ftruncate(m_nFile, off_t(nBytes)))
+	{
+		map(nullptr);
+		tdk_set_error_code(pErrorCode, kTDK_BAD_FILE);
+		return kTDK_ERR;
+	}
+
+	m_nSize = nBytes;
+	return map(pErrorCode);
+}
+
+tdk_ret tdk_file_mapping::flush(tdk_size nOffset, tdk_size nBytes, tdk_err* pErrorCode)
+{
+	if (!m_pData || !m_bWritable || nOffset >= m_nSize)
+		return kTDK_OK;
+
+	// msync wants a page aligned start
+	tdk_size nPageSize = tdk_size(sysconf(_SC_PAGESIZE));
+	tdk_size nStart = nOffset & ~(nPageSize - 1);
+	nBytes = tdk_min(nBytes, m_nSize - nOffset) + (nOffset - nStart);
+	if (0 != msync(m_pData + nStart, nBytes, MS_SYNC))
+	{
+		tdk_set_error_code(pErrorCode, kTDK_BAD_FILE);
+		return kTDK_ERR;
+	}
+	return kTDK_OK;
+}
+
+tdk_ret tdk_file_mapping::map(tdk_err* pErrorCode)
+{
+	if (!m_nSize)
+		return kTDK_OK;
+
+	void* p = mmap(nullptr, m_nSize, m_bWritable ? PROT_READ | PROT_WRITE : PROT_READ,
+		MAP_SHARED, m_nFile, 0);
+	if (MAP_FAILED == p)
+	{
+		tdk_set_error_code(pErrorCode, kTDK_BAD_FILE);
+		return kTDK_ERR;
+	}
+
+	m_pData = static_cast<tdk_byte*>(p);
+	return kTDK_OK;
+}
+
+void tdk_file_mapping::unmap()
+{
+	if (m_pData)
+		munmap(m_pData, m_nSize);
+	m_pData = nullptr;
+}
+
+#else
+#error "has not implemented yet"
+#endif
@@ -47,6 +47,12 @@ Purpose: memory management.
 #include "system/tdkmemory.h"
 #include <cstdlib>
 
+#ifdef _MSC_VER
+#	include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#	include <sys/mman.h>
+#endif
+
 
 void* tdk_allocate_memory_aligned(tdk_size nBytes, tdk_size nAlignment)
 {
@@ -55,7 +61,11 @@ void* tdk_allocate_memory_aligned(tdk_size nBytes, tdk_size nAlignment)
 #ifdef _MSC_VER
 	return _aligned_malloc(nBytes, nAlignment);
 #elif defined __GNUC__
-	return malloc(nBytes);
+	// posix_memalign wants a power of two multiple of sizeof(void*)
+	void* p = nullptr;
+	if (0 != posix_memalign(&p, tdk_max(nAlignment, sizeof(void*)), nBytes))
+		return nullptr;
+	return p;
 #else
 #error "has not implemented yet"
 #endif
@@ -74,3 +84,87 @@ void tdk_free_memory_aligned(void* p, tdk_size nAlignment)
 #error "has not implemented yet"
 #endif
 }
+
+void* tdk_allocate_memory_huge(tdk_size nBytes, tdk_err* pErrorCode)
+{
+	if (0 == nBytes)
+		return nullptr;
+
+	// the round up and the extra page for the alignment must not wrap
+	if (nBytes > tdk_size(-1) - 2 * kTDK_HUGE_PAGE_SIZE)
+	{
+		tdk_set_error_code(pErrorCode, kTDK_BAD_SIZE);
+		return nullptr;
+	}
+
+	tdk_size nMapBytes = tdk_huge_page_round_up(nBytes);
+#ifdef _MSC_VER
+	void* p = nullptr;
+	SIZE_T nLargePage = GetLargePageMinimum();
+	if (nLargePage && 0 == nMapBytes % nLargePage)
+	{
+		// needs SeLockMemoryPrivilege, quietly fails without it
+		p = VirtualAlloc(nullptr, nMapBytes,
+			MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+	}
+	if (!p)
+	{
+		p = VirtualAlloc(nullptr, nMapBytes, MEM_RESERVE | MEM_COMMIT,
+			PAGE_READWRITE);
+	}
+	if (!p)
+		tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+	return p;
+#elif defined(__unix__) || defined(__APPLE__)
+#	ifdef MAP_HUGETLB
+	// succeeds only if the admin has reserved huge pages (vm.nr_hugepages)
+	void* p = mmap(nullptr, nMapBytes, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (MAP_FAILED != p)
+		return p;
+#	endif
+
+	// Map one extra huge page and cut off head and tail to get the range
+	// aligned on kTDK_HUGE_PAGE_SIZE, otherwise the kernel cannot back it
+	// with transparent huge pages.
+	tdk_size nRawBytes = nMapBytes + kTDK_HUGE_PAGE_SIZE;
+	void* pRaw = mmap(nullptr, nRawBytes, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (MAP_FAILED == pRaw)
+	{
+		tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+		return nullptr;
+	}
+
+	tdk_byte* pRawBytes = static_cast<tdk_byte*>(pRaw);
+	tdk_size nHead = tdk_huge_page_round_up(reinterpret_cast<uintptr_t>(pRaw)) -
+		reinterpret_cast<uintptr_t>(pRaw);
+	tdk_size nTail = nRawBytes - nHead - nMapBytes;
+	if (nHead)
+		munmap(pRawBytes, nHead);
+	if (nTail)
+		munmap(pRawBytes + nHead + nMapBytes, nTail);
+
+	tdk_byte* pResult = pRawBytes + nHead;
+#	ifdef MADV_HUGEPAGE
+	madvise(pResult, nMapBytes, MADV_HUGEPAGE);
+#	endif
+	return pResult;
+#else
+#error "has not implemented yet"
+#endif
+}
+
+void tdk_free_memory_huge(void* p, tdk_size nBytes)
+{
+	if (!p)
+		return;
+#ifdef _MSC_VER
+	TDK_UNUSED(nBytes);
+	VirtualFree(p, 0, MEM_RELEASE);
+#elif defined(__unix__) || defined(__APPLE__)
+	munmap(p, tdk_huge_page_round_up(nBytes));
+#else
+#error "has not implemented yet"
+#endif
+}
@@ -0,0 +1,229 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: memory regions with byte budgets.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#include "system/tdkmemoryregion.h"
+#include "system/tdkmemory.h"
+
+#include <cassert>
+
+// Sits right before the user pointer. The raw block starts nHeaderRoom
+// bytes before the user pointer.
+struct tdk_memory_region::BlockHeader
+{
+	BlockHeader* pPrev;
+	BlockHeader* pNext;
+	size_type nBlockBytes; // counted against the budget
+	size_type nHeaderRoom;
+	size_type nAlignment; // what tdk_allocate_memory_aligned got
+};
+
+namespace
+{
+
+tdk_size round_up(tdk_size nBytes, tdk_size nAlignment)
+{
+	return (nBytes + nAlignment - 1) & ~(nAlignment - 1);
+}
+
+} // namespace
+
+tdk_memory_region::tdk_memory_region(const char* szName, size_type nBudget)
+	: m_szName(szName)
+	, m_pFirstBlock(nullptr)
+	, m_nBudget(nBudget)
+	, m_nLiveBytes(0)
+	, m_nPeakBytes(0)
+	, m_nLiveBlocks(0)
+{
+}
+
+tdk_memory_region::~tdk_memory_region()
+{
+	release_all();
+}
+
+void* tdk_memory_region::allocate(size_type nBytes, size_type nAlignment,
+	tdk_err* pErrorCode)
+{
+	assert(0 == (nAlignment & (nAlignment - 1)));
+
+	size_type nBlockAlignment = tdk_max(nAlignment, size_type(alignof(BlockHeader)));
+	size_type nHeaderRoom = round_up(sizeof(BlockHeader), nBlockAlignment);
+	if (nBytes > size_type(-1) - nHeaderRoom)
+	{
+		tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+		return nullptr;
+	}
+	size_type nBlockBytes = nHeaderRoom + nBytes;
+
+	{
+		// cheap early out, so a request far over the budget does not reach
+		// the system allocator
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!fits_budget(nBlockBytes))
+		{
+			tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+			return nullptr;
+		}
+	}
+
+	tdk_byte* pRaw = static_cast<tdk_byte*>(
+		tdk_allocate_memory_aligned(nBlockBytes, nBlockAlignment));
+	if (!pRaw)
+	{
+		tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+		return nullptr;
+	}
+
+	tdk_byte* pUser = pRaw + nHeaderRoom;
+	BlockHeader* pHeader = reinterpret_cast<BlockHeader*>(pUser) - 1;
+	pHeader->pPrev = nullptr;
+	pHeader->nBlockBytes = nBlockBytes;
+	pHeader->nHeaderRoom = nHeaderRoom;
+	pHeader->nAlignment = nBlockAlignment;
+
+	{
+		// the bytes are counted and the block linked in one step: concurrent
+		// callers cannot overshoot the budget together, and release_all()
+		// sees either both or neither
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (fits_budget(nBlockBytes))
+		{
+			m_nLiveBytes += nBlockBytes;
+			m_nPeakBytes = tdk_max(m_nPeakBytes, m_nLiveBytes);
+			pHeader->pNext = m_pFirstBlock;
+			if (m_pFirstBlock)
+				m_pFirstBlock->pPrev = pHeader;
+			m_pFirstBlock = pHeader;
+			++m_nLiveBlocks;
+			return pUser;
+		}
+	}
+
+	// another thread took the rest of the budget meanwhile
+	tdk_free_memory_aligned(pRaw, nBlockAlignment);
+	tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+	return nullptr;
+}
+
+void tdk_memory_region::free(void* p)
+{
+	if (!p)
+		return;
+
+	BlockHeader* pHeader = static_cast<BlockHeader*>(p) - 1;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (pHeader->pPrev)
+			pHeader->pPrev->pNext = pHeader->pNext;
+		else
+			m_pFirstBlock = pHeader->pNext;
+		if (pHeader->pNext)
+			pHeader->pNext->pPrev = pHeader->pPrev;
+
+		assert(m_nLiveBytes >= pHeader->nBlockBytes && m_nLiveBlocks);
+		m_nLiveBytes -= pHeader->nBlockBytes;
+		--m_nLiveBlocks;
+	}
+
+	tdk_free_memory_aligned(static_cast<tdk_byte*>(p) - pHeader->nHeaderRoom,
+		pHeader->nAlignment);
+}
+
+void tdk_memory_region::release_all()
+{
+	BlockHeader* pBlock = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		pBlock = m_pFirstBlock;
+		m_pFirstBlock = nullptr;
+		m_nLiveBytes = 0;
+		m_nLiveBlocks = 0;
+	}
+
+	while (pBlock)
+	{
+		BlockHeader* pNext = pBlock->pNext;
+		tdk_byte* pUser = reinterpret_cast<tdk_byte*>(pBlock + 1);
+		tdk_free_memory_aligned(pUser - pBlock->nHeaderRoom, pBlock->nAlignment);
+		pBlock = pNext;
+	}
+}
+
+void tdk_memory_region::set_budget(size_type nBudget)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_nBudget = nBudget;
+}
+
+tdk_memory_region::size_type tdk_memory_region::budget() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_nBudget;
+}
+
+tdk_memory_region::size_type tdk_memory_region::live_bytes() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_nLiveBytes;
+}
+
+tdk_memory_region::size_type tdk_memory_region::peak_bytes() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_nPeakBytes;
+}
+
+tdk_memory_region::size_type tdk_memory_region::live_blocks() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_nLiveBlocks;
+}
+
+bool tdk_memory_region::fits_budget(size_type nBlockBytes) const
+{
+	return nBlockBytes <= m_nBudget && m_nLiveBytes <= m_nBudget - nBlockBytes;
+}
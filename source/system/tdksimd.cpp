@@ -0,0 +1,758 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: SIMD kernels.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#include "system/tdksimd.h"
+#include "system/tdkcpu.h"
+#include "base/tdkbaseutl.h"
+
+#ifdef TDK_X86
+#	include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#	include <intrin.h>
+#endif
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// Scalar
+
+template<typename T>
+tdk_size find_scalar(const T* pData, tdk_size nCount, T val)
+{
+	for (tdk_size idx = 0; idx < nCount; ++idx)
+	{
+		if (pData[idx] == val)
+			return idx;
+	}
+	return nCount;
+}
+
+template<typename T>
+tdk_size count_scalar(const T* pData, tdk_size nCount, T val)
+{
+	tdk_size nFound = 0;
+	for (tdk_size idx = 0; idx < nCount; ++idx)
+		nFound += pData[idx] == val;
+	return nFound;
+}
+
+#ifdef TDK_X86
+//-----------------------------------------------------------------------------
+// SSE2. A lane equal to the key becomes all ones, so movemask gives sizeof(T)
+// set bits per match. The last parameter of cmpeq only selects the overload.
+
+TDK_TARGET("sse2") inline __m128i sse2_splat(tdk_byte val)
+{
+	return _mm_set1_epi8(char(val));
+}
+
+TDK_TARGET("sse2") inline __m128i sse2_splat(tdk_u16 val)
+{
+	return _mm_set1_epi16(short(val));
+}
+
+TDK_TARGET("sse2") inline __m128i sse2_splat(tdk_u32 val)
+{
+	return _mm_set1_epi32(int(val));
+}
+
+TDK_TARGET("sse2") inline __m128i sse2_splat(tdk_u64 val)
+{
+	return _mm_set1_epi64x((long long)val);
+}
+
+TDK_TARGET("sse2") inline __m128i sse2_splat(float val)
+{
+	return _mm_castps_si128(_mm_set1_ps(val));
+}
+
+TDK_TARGET("sse2") inline __m128i sse2_splat(double val)
+{
+	return _mm_castpd_si128(_mm_set1_pd(val));
+}
+
+TDK_TARGET("sse2") inline __m128i sse2_cmpeq(__m128i a, __m128i b, tdk_byte)
+{
+	return _mm_cmpeq_epi8(a, b);
+}
+
+TDK_TARGET("sse2") inline __m128i sse2_cmpeq(__m128i a, __m128i b, tdk_u16)
+{
+	return _mm_cmpeq_epi16(a, b);
+}
+
+TDK_TARGET("sse2") inline __m128i sse2_cmpeq(__m128i a, __m128i b, tdk_u32)
+{
+	return _mm_cmpeq_epi32(a, b);
+}
+
+TDK_TARGET("sse2") inline __m128i sse2_cmpeq(__m128i a, __m128i b, tdk_u64)
+{
+	// no 64-bit compare before SSE4.1: both 32-bit halves must match
+	__m128i eq32 = _mm_cmpeq_epi32(a, b);
+	return _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+TDK_TARGET("sse2") inline __m128i sse2_cmpeq(__m128i a, __m128i b, float)
+{
+	return _mm_castps_si128(_mm_cmpeq_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+}
+
+TDK_TARGET("sse2") inline __m128i sse2_cmpeq(__m128i a, __m128i b, double)
+{
+	return _mm_castpd_si128(_mm_cmpeq_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b)));
+}
+
+template<typename T>
+TDK_TARGET("sse2")
+tdk_size find_sse2(const T* pData, tdk_size nCount, T val)
+{
+	const tdk_size kLanes = sizeof(__m128i) / sizeof(T);
+	const __m128i key = sse2_splat(val);
+	tdk_size idx = 0;
+
+	// four vectors per step, a miss costs a single branch
+	for (; idx + 4 * kLanes <= nCount; idx += 4 * kLanes)
+	{
+		const __m128i* p = reinterpret_cast<const __m128i*>(pData + idx);
+		__m128i eq0 = sse2_cmpeq(_mm_loadu_si128(p), key, val);
+		__m128i eq1 = sse2_cmpeq(_mm_loadu_si128(p + 1), key, val);
+		__m128i eq2 = sse2_cmpeq(_mm_loadu_si128(p + 2), key, val);
+		__m128i eq3 = sse2_cmpeq(_mm_loadu_si128(p + 3), key, val);
+		__m128i any = _mm_or_si128(_mm_or_si128(eq0, eq1), _mm_or_si128(eq2, eq3));
+		if (!_mm_movemask_epi8(any))
+			continue;
+
+		const tdk_u32 masks[4] = {
+			tdk_u32(_mm_movemask_epi8(eq0)), tdk_u32(_mm_movemask_epi8(eq1)),
+			tdk_u32(_mm_movemask_epi8(eq2)), tdk_u32(_mm_movemask_epi8(eq3)) };
+		for (tdk_size k = 0; k < 4; ++k)
+		{
+			if (masks[k])
+				return idx + k * kLanes + tdk_count_trailing_zeros(masks[k]) / sizeof(T);
+		}
+	}
+
+	for (; idx + kLanes <= nCount; idx += kLanes)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pData + idx));
+		tdk_u32 nMask = tdk_u32(_mm_movemask_epi8(sse2_cmpeq(v, key, val)));
+		if (nMask)
+			return idx + tdk_count_trailing_zeros(nMask) / sizeof(T);
+	}
+
+	return idx + find_scalar(pData + idx, nCount - idx, val);
+}
+
+template<typename T>
+TDK_TARGET("sse2")
+tdk_size count_sse2(const T* pData, tdk_size nCount, T val)
+{
+	const tdk_size kLanes = sizeof(__m128i) / sizeof(T);
+	const __m128i key = sse2_splat(val);
+	tdk_size nBits = 0;
+	tdk_size idx = 0;
+
+	for (; idx + kLanes <= nCount; idx += kLanes)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pData + idx));
+		nBits += tdk_count_bits(tdk_u32(_mm_movemask_epi8(sse2_cmpeq(v, key, val))));
+	}
+
+	return nBits / sizeof(T) + count_scalar(pData + idx, nCount - idx, val);
+}
+
+//-----------------------------------------------------------------------------
+// AVX2, same scheme with 32-byte vectors
+
+TDK_TARGET("avx2") inline __m256i avx2_splat(tdk_byte val)
+{
+	return _mm256_set1_epi8(char(val));
+}
+
+TDK_TARGET("avx2") inline __m256i avx2_splat(tdk_u16 val)
+{
+	return _mm256_set1_epi16(short(val));
+}
+
+TDK_TARGET("avx2") inline __m256i avx2_splat(tdk_u32 val)
+{
+	return _mm256_set1_epi32(int(val));
+}
+
+TDK_TARGET("avx2") inline __m256i avx2_splat(tdk_u64 val)
+{
+	return _mm256_set1_epi64x((long long)val);
+}
+
+TDK_TARGET("avx2") inline __m256i avx2_splat(float val)
+{
+	return _mm256_castps_si256(_mm256_set1_ps(val));
+}
+
+TDK_TARGET("avx2") inline __m256i avx2_splat(double val)
+{
+	return _mm256_castpd_si256(_mm256_set1_pd(val));
+}
+
+TDK_TARGET("avx2") inline __m256i avx2_cmpeq(__m256i a, __m256i b, tdk_byte)
+{
+	return _mm256_cmpeq_epi8(a, b);
+}
+
+TDK_TARGET("avx2") inline __m256i avx2_cmpeq(__m256i a, __m256i b, tdk_u16)
+{
+	return _mm256_cmpeq_epi16(a, b);
+}
+
+TDK_TARGET("avx2") inline __m256i avx2_cmpeq(__m256i a, __m256i b, tdk_u32)
+{
+	return _mm256_cmpeq_epi32(a, b);
+}
+
+TDK_TARGET("avx2") inline __m256i avx2_cmpeq(__m256i a, __m256i b, tdk_u64)
+{
+	return _mm256_cmpeq_epi64(a, b);
+}
+
+TDK_TARGET("avx2") inline __m256i avx2_cmpeq(__m256i a, __m256i b, float)
+{
+	return _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(a),
+		_mm256_castsi256_ps(b), _CMP_EQ_OQ));
+}
+
+TDK_TARGET("avx2") inline __m256i avx2_cmpeq(__m256i a, __m256i b, double)
+{
+	return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(a),
+		_mm256_castsi256_pd(b), _CMP_EQ_OQ));
+}
+
+template<typename T>
+TDK_TARGET("avx2")
+tdk_size find_avx2(const T* pData, tdk_size nCount, T val)
+{
+	const tdk_size kLanes = sizeof(__m256i) / sizeof(T);
+	const __m256i key = avx2_splat(val);
+	tdk_size idx = 0;
+
+	for (; idx + 4 * kLanes <= nCount; idx += 4 * kLanes)
+	{
+		const __m256i* p = reinterpret_cast<const __m256i*>(pData + idx);
+		__m256i eq0 = avx2_cmpeq(_mm256_loadu_si256(p), key, val);
+		__m256i eq1 = avx2_cmpeq(_mm256_loadu_si256(p + 1), key, val);
+		__m256i eq2 = avx2_cmpeq(_mm256_loadu_si256(p + 2), key, val);
+		__m256i eq3 = avx2_cmpeq(_mm256_loadu_si256(p + 3), key, val);
+		__m256i any = _mm256_or_si256(_mm256_or_si256(eq0, eq1),
+			_mm256_or_si256(eq2, eq3));
+		if (_mm256_testz_si256(any, any))
+			continue;
+
+		const tdk_u32 masks[4] = {
+			tdk_u32(_mm256_movemask_epi8(eq0)), tdk_u32(_mm256_movemask_epi8(eq1)),
+			tdk_u32(_mm256_movemask_epi8(eq2)), tdk_u32(_mm256_movemask_epi8(eq3)) };
+		for (tdk_size k = 0; k < 4; ++k)
+		{
+			if (masks[k])
+				return idx + k * kLanes + tdk_count_trailing_zeros(masks[k]) / sizeof(T);
+		}
+	}
+
+	for (; idx + kLanes <= nCount; idx += kLanes)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pData + idx));
+		tdk_u32 nMask = tdk_u32(_mm256_movemask_epi8(avx2_cmpeq(v, key, val)));
+		if (nMask)
+			return idx + tdk_count_trailing_zeros(nMask) / sizeof(T);
+	}
+
+	return idx + find_scalar(pData + idx, nCount - idx, val);
+}
+
+template<typename T>
+TDK_TARGET("avx2")
+tdk_size count_avx2(const T* pData, tdk_size nCount, T val)
+{
+	const tdk_size kLanes = sizeof(__m256i) / sizeof(T);
+	const __m256i key = avx2_splat(val);
+	tdk_size nBits = 0;
+	tdk_size idx = 0;
+
+	for (; idx + kLanes <= nCount; idx += kLanes)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pData + idx));
+		nBits += tdk_count_bits(tdk_u32(_mm256_movemask_epi8(avx2_cmpeq(v, key, val))));
+	}
+
+	return nBits / sizeof(T) + count_scalar(pData + idx, nCount - idx, val);
+}
+#endif // TDK_X86
+
+//-----------------------------------------------------------------------------
+// Dispatch
+
+template<typename T>
+struct SearchKernels
+{
+	tdk_size (*pFind)(const T*, tdk_size, T);
+	tdk_size (*pCount)(const T*, tdk_size, T);
+};
+
+template<typename T>
+SearchKernels<T> select_search_kernels()
+{
+#ifdef TDK_X86
+	if (tdk_cpu_has(kTDK_CPU_AVX2))
+		return { &find_avx2<T>, &count_avx2<T> };
+	if (tdk_cpu_has(kTDK_CPU_SSE2))
+		return { &find_sse2<T>, &count_sse2<T> };
+#endif
+	return { &find_scalar<T>, &count_scalar<T> };
+}
+
+template<typename T>
+const SearchKernels<T>& get_search_kernels()
+{
+	static const SearchKernels<T> s_kernels = select_search_kernels<T>();
+	return s_kernels;
+}
+
+//-----------------------------------------------------------------------------
+// Bit set kernels. The scalar loops are simple enough for the compiler to
+// vectorize with the baseline instruction set.
+
+inline tdk_u64 bit_op(tdk_u64 a, tdk_u64 b, tdk_simd_bit_op op)
+{
+	switch (op)
+	{
+	case kTDK_BIT_AND:
+		return a & b;
+	case kTDK_BIT_OR:
+		return a | b;
+	case kTDK_BIT_XOR:
+		return a ^ b;
+	default:
+		return a & ~b;
+	}
+}
+
+template<tdk_simd_bit_op kOp>
+void bits_apply_scalar(tdk_u64* pDst, const tdk_u64* pSrc, tdk_size nWords)
+{
+	for (tdk_size idx = 0; idx < nWords; ++idx)
+		pDst[idx] = bit_op(pDst[idx], pSrc[idx], kOp);
+}
+
+tdk_size popcount_scalar(const tdk_u64* pWords, tdk_size nWords)
+{
+	tdk_size nBits = 0;
+	for (tdk_size idx = 0; idx < nWords; ++idx)
+		nBits += tdk_count_bits(pWords[idx]);
+	return nBits;
+}
+
+tdk_size popcount_and_scalar(const tdk_u64* pA, const tdk_u64* pB,
+	tdk_size nWords)
+{
+	tdk_size nBits = 0;
+	for (tdk_size idx = 0; idx < nWords; ++idx)
+		nBits += tdk_count_bits(pA[idx] & pB[idx]);
+	return nBits;
+}
+
+#ifdef TDK_X86
+// Without -mpopcnt the compiler emulates the builtin with shifts and masks.
+TDK_TARGET("popcnt") inline tdk_u64 popcnt64(tdk_u64 nWord)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+	return tdk_u64(_mm_popcnt_u64(nWord));
+#else
+	return tdk_u64(_mm_popcnt_u32(tdk_u32(nWord)) +
+		_mm_popcnt_u32(tdk_u32(nWord >> 32)));
+#endif
+}
+
+TDK_TARGET("popcnt")
+tdk_size popcount_popcnt(const tdk_u64* pWords, tdk_size nWords)
+{
+	tdk_size nBits = 0;
+	for (tdk_size idx = 0; idx < nWords; ++idx)
+		nBits += tdk_size(popcnt64(pWords[idx]));
+	return nBits;
+}
+
+TDK_TARGET("popcnt")
+tdk_size popcount_and_popcnt(const tdk_u64* pA, const tdk_u64* pB,
+	tdk_size nWords)
+{
+	tdk_size nBits = 0;
+	for (tdk_size idx = 0; idx < nWords; ++idx)
+		nBits += tdk_size(popcnt64(pA[idx] & pB[idx]));
+	return nBits;
+}
+
+TDK_TARGET("avx2") inline __m256i avx2_bit_op(__m256i a, __m256i b,
+	tdk_simd_bit_op op)
+{
+	switch (op)
+	{
+	case kTDK_BIT_AND:
+		return _mm256_and_si256(a, b);
+	case kTDK_BIT_OR:
+		return _mm256_or_si256(a, b);
+	case kTDK_BIT_XOR:
+		return _mm256_xor_si256(a, b);
+	default:
+		return _mm256_andnot_si256(b, a);
+	}
+}
+
+template<tdk_simd_bit_op kOp>
+TDK_TARGET("avx2")
+void bits_apply_avx2(tdk_u64* pDst, const tdk_u64* pSrc, tdk_size nWords)
+{
+	const tdk_size kLanes = sizeof(__m256i) / sizeof(tdk_u64);
+	tdk_size idx = 0;
+
+	for (; idx + 2 * kLanes <= nWords; idx += 2 * kLanes)
+	{
+		__m256i* pD = reinterpret_cast<__m256i*>(pDst + idx);
+		const __m256i* pS = reinterpret_cast<const __m256i*>(pSrc + idx);
+		__m256i r0 = avx2_bit_op(_mm256_loadu_si256(pD), _mm256_loadu_si256(pS), kOp);
+		__m256i r1 = avx2_bit_op(_mm256_loadu_si256(pD + 1),
+			_mm256_loadu_si256(pS + 1), kOp);
+		_mm256_storeu_si256(pD, r0);
+		_mm256_storeu_si256(pD + 1, r1);
+	}
+
+	bits_apply_scalar<kOp>(pDst + idx, pSrc + idx, nWords - idx);
+}
+
+// Bits per byte from two 16-entry nibble lookups (pshufb), summed into four
+// 64-bit lanes by psadbw. Byte counters stay below 256 because they are
+// flushed after every vector.
+TDK_TARGET("avx2") inline __m256i avx2_popcount_lanes(__m256i v)
+{
+	const __m256i lookup = _mm256_setr_epi8(
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i lowMask = _mm256_set1_epi8(0x0F);
+
+	__m256i lo = _mm256_and_si256(v, lowMask);
+	__m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask);
+	__m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+		_mm256_shuffle_epi8(lookup, hi));
+	return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+}
+
+TDK_TARGET("avx2") inline tdk_size avx2_sum_lanes(__m256i v)
+{
+	__m128i sum = _mm_add_epi64(_mm256_castsi256_si128(v),
+		_mm256_extracti128_si256(v, 1));
+	tdk_u64 lanes[2];
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sum);
+	return tdk_size(lanes[0] + lanes[1]);
+}
+
+TDK_TARGET("avx2")
+tdk_size popcount_avx2(const tdk_u64* pWords, tdk_size nWords)
+{
+	const tdk_size kLanes = sizeof(__m256i) / sizeof(tdk_u64);
+	__m256i acc = _mm256_setzero_si256();
+	tdk_size idx = 0;
+
+	for (; idx + kLanes <= nWords; idx += kLanes)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pWords + idx));
+		acc = _mm256_add_epi64(acc, avx2_popcount_lanes(v));
+	}
+
+	return avx2_sum_lanes(acc) + popcount_scalar(pWords + idx, nWords - idx);
+}
+
+TDK_TARGET("avx2")
+tdk_size popcount_and_avx2(const tdk_u64* pA, const tdk_u64* pB,
+	tdk_size nWords)
+{
+	const tdk_size kLanes = sizeof(__m256i) / sizeof(tdk_u64);
+	__m256i acc = _mm256_setzero_si256();
+	tdk_size idx = 0;
+
+	for (; idx + kLanes <= nWords; idx += kLanes)
+	{
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pA + idx));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pB + idx));
+		acc = _mm256_add_epi64(acc, avx2_popcount_lanes(_mm256_and_si256(a, b)));
+	}
+
+	return avx2_sum_lanes(acc) +
+		popcount_and_scalar(pA + idx, pB + idx, nWords - idx);
+}
+#endif // TDK_X86
+
+struct BitKernels
+{
+	void (*pApply[4])(tdk_u64*, const tdk_u64*, tdk_size);
+	tdk_size (*pPopcount)(const tdk_u64*, tdk_size);
+	tdk_size (*pPopcountAnd)(const tdk_u64*, const tdk_u64*, tdk_size);
+};
+
+BitKernels select_bit_kernels()
+{
+	BitKernels kernels = {
+		{ &bits_apply_scalar<kTDK_BIT_AND>, &bits_apply_scalar<kTDK_BIT_OR>,
+		  &bits_apply_scalar<kTDK_BIT_XOR>, &bits_apply_scalar<kTDK_BIT_ANDNOT> },
+		&popcount_scalar, &popcount_and_scalar };
+#ifdef TDK_X86
+	if (tdk_cpu_has(kTDK_CPU_POPCNT))
+	{
+		kernels.pPopcount = &popcount_popcnt;
+		kernels.pPopcountAnd = &popcount_and_popcnt;
+	}
+	if (tdk_cpu_has(kTDK_CPU_AVX2))
+	{
+		kernels.pApply[kTDK_BIT_AND] = &bits_apply_avx2<kTDK_BIT_AND>;
+		kernels.pApply[kTDK_BIT_OR] = &bits_apply_avx2<kTDK_BIT_OR>;
+		kernels.pApply[kTDK_BIT_XOR] = &bits_apply_avx2<kTDK_BIT_XOR>;
+		kernels.pApply[kTDK_BIT_ANDNOT] = &bits_apply_avx2<kTDK_BIT_ANDNOT>;
+		kernels.pPopcount = &popcount_avx2;
+		kernels.pPopcountAnd = &popcount_and_avx2;
+	}
+#endif
+	return kernels;
+}
+
+const BitKernels& get_bit_kernels()
+{
+	static const BitKernels s_kernels = select_bit_kernels();
+	return s_kernels;
+}
+
+//-----------------------------------------------------------------------------
+// Bit packing. Row r of the block holds values 4r .. 4r + 3, its bits start
+// at r * nWidth in every lane.
+
+enum PackConstants
+{
+	kPACK_LANES = 4,
+	kPACK_ROWS = kTDK_PACK_BLOCK / kPACK_LANES
+};
+
+inline tdk_u32 width_mask(tdk_u32 nWidth)
+{
+	return nWidth >= 32 ? ~tdk_u32(0) : (tdk_u32(1) << nWidth) - 1;
+}
+
+template<bool kDelta>
+void unpack128_scalar(const tdk_u32* pWords, tdk_u32 nWidth, tdk_u32 nBase,
+	tdk_u32* pValues)
+{
+	const tdk_u32 nMask = width_mask(nWidth);
+	tdk_u32 prev[kPACK_LANES] = { nBase, nBase, nBase, nBase };
+	for (tdk_u32 nRow = 0; nRow < kPACK_ROWS; ++nRow)
+	{
+		tdk_u32 nBit = nRow * nWidth;
+		tdk_u32 nWord = nBit / 32;
+		tdk_u32 nShift = nBit % 32;
+		for (tdk_u32 nLane = 0; nLane < kPACK_LANES; ++nLane)
+		{
+			tdk_u32 nVal = nWidth ? pWords[nWord * kPACK_LANES + nLane] >> nShift : 0;
+			if (nShift + nWidth > 32)
+				nVal |= pWords[(nWord + 1) * kPACK_LANES + nLane] << (32 - nShift);
+			nVal &= nMask;
+
+			if (kDelta)
+				prev[nLane] += nVal;
+			pValues[nRow * kPACK_LANES + nLane] = kDelta ? prev[nLane] : nBase + nVal;
+		}
+	}
+}
+
+#ifdef TDK_X86
+template<bool kDelta>
+TDK_TARGET("sse2")
+void unpack128_sse2(const tdk_u32* pWords, tdk_u32 nWidth, tdk_u32 nBase,
+	tdk_u32* pValues)
+{
+	const __m128i mask = _mm_set1_epi32(int(width_mask(nWidth)));
+	const __m128i* pIn = reinterpret_cast<const __m128i*>(pWords);
+	__m128i* pOut = reinterpret_cast<__m128i*>(pValues);
+	__m128i acc = _mm_set1_epi32(int(nBase));
+
+	if (0 == nWidth)
+	{
+		for (tdk_u32 nRow = 0; nRow < kPACK_ROWS; ++nRow)
+			_mm_storeu_si128(pOut + nRow, acc);
+		return;
+	}
+
+	for (tdk_u32 nRow = 0; nRow < kPACK_ROWS; ++nRow)
+	{
+		tdk_u32 nBit = nRow * nWidth;
+		tdk_u32 nWord = nBit / 32;
+		tdk_u32 nShift = nBit % 32;
+		__m128i v = _mm_srl_epi32(_mm_loadu_si128(pIn + nWord),
+			_mm_cvtsi32_si128(int(nShift)));
+		if (nShift + nWidth > 32)
+		{
+			v = _mm_or_si128(v, _mm_sll_epi32(_mm_loadu_si128(pIn + nWord + 1),
+				_mm_cvtsi32_si128(int(32 - nShift))));
+		}
+		v = _mm_and_si128(v, mask);
+
+		if (kDelta)
+		{
+			acc = _mm_add_epi32(acc, v);
+			_mm_storeu_si128(pOut + nRow, acc);
+		}
+		else
+		{
+			_mm_storeu_si128(pOut + nRow, _mm_add_epi32(acc, v));
+		}
+	}
+}
+#endif // TDK_X86
+
+struct PackKernels
+{
+	void (*pUnpack)(const tdk_u32*, tdk_u32, tdk_u32, tdk_u32*);
+	void (*pUnpackDelta)(const tdk_u32*, tdk_u32, tdk_u32, tdk_u32*);
+};
+
+PackKernels select_pack_kernels()
+{
+#ifdef TDK_X86
+	if (tdk_cpu_has(kTDK_CPU_SSE2))
+		return { &unpack128_sse2<false>, &unpack128_sse2<true> };
+#endif
+	return { &unpack128_scalar<false>, &unpack128_scalar<true> };
+}
+
+const PackKernels& get_pack_kernels()
+{
+	static const PackKernels s_kernels = select_pack_kernels();
+	return s_kernels;
+}
+
+} // namespace
+
+template<typename T>
+tdk_size tdk_simd_find(const T* pData, tdk_size nCount, T val)
+{
+	return get_search_kernels<T>().pFind(pData, nCount, val);
+}
+
+template<typename T>
+tdk_size tdk_simd_count(const T* pData, tdk_size nCount, T val)
+{
+	return get_search_kernels<T>().pCount(pData, nCount, val);
+}
+
+template tdk_size tdk_simd_find<tdk_byte>(const tdk_byte*, tdk_size, tdk_byte);
+template tdk_size tdk_simd_find<tdk_u16>(const tdk_u16*, tdk_size, tdk_u16);
+template tdk_size tdk_simd_find<tdk_u32>(const tdk_u32*, tdk_size, tdk_u32);
+template tdk_size tdk_simd_find<tdk_u64>(const tdk_u64*, tdk_size, tdk_u64);
+template tdk_size tdk_simd_find<float>(const float*, tdk_size, float);
+template tdk_size tdk_simd_find<double>(const double*, tdk_size, double);
+
+template tdk_size tdk_simd_count<tdk_byte>(const tdk_byte*, tdk_size, tdk_byte);
+template tdk_size tdk_simd_count<tdk_u16>(const tdk_u16*, tdk_size, tdk_u16);
+template tdk_size tdk_simd_count<tdk_u32>(const tdk_u32*, tdk_size, tdk_u32);
+template tdk_size tdk_simd_count<tdk_u64>(const tdk_u64*, tdk_size, tdk_u64);
+template tdk_size tdk_simd_count<float>(const float*, tdk_size, float);
+template tdk_size tdk_simd_count<double>(const double*, tdk_size, double);
+
+void tdk_simd_bits_apply(tdk_u64* pDst, const tdk_u64* pSrc, tdk_size nWords,
+	tdk_simd_bit_op op)
+{
+	get_bit_kernels().pApply[op](pDst, pSrc, nWords);
+}
+
+tdk_size tdk_simd_popcount(const tdk_u64* pWords, tdk_size nWords)
+{
+	return get_bit_kernels().pPopcount(pWords, nWords);
+}
+
+tdk_size tdk_simd_popcount_and(const tdk_u64* pA, const tdk_u64* pB,
+	tdk_size nWords)
+{
+	return get_bit_kernels().pPopcountAnd(pA, pB, nWords);
+}
+
+void tdk_simd_pack128(const tdk_u32* pValues, tdk_u32 nWidth, tdk_u32* pWords)
+{
+	// packing runs once per block when an array is built, scalar is enough
+	const tdk_u32 nMask = width_mask(nWidth);
+	for (tdk_u32 i = 0; i < kPACK_LANES * nWidth; ++i)
+		pWords[i] = 0;
+
+	for (tdk_u32 nRow = 0; nRow < kPACK_ROWS; ++nRow)
+	{
+		tdk_u32 nBit = nRow * nWidth;
+		tdk_u32 nWord = nBit / 32;
+		tdk_u32 nShift = nBit % 32;
+		for (tdk_u32 nLane = 0; nLane < kPACK_LANES && nWidth; ++nLane)
+		{
+			tdk_u32 nVal = pValues[nRow * kPACK_LANES + nLane] & nMask;
+			pWords[nWord * kPACK_LANES + nLane] |= nVal << nShift;
+			if (nShift + nWidth > 32)
+				pWords[(nWord + 1) * kPACK_LANES + nLane] |= nVal >> (32 - nShift);
+		}
+	}
+}
+
+void tdk_simd_unpack128(const tdk_u32* pWords, tdk_u32 nWidth, tdk_u32 nBase,
+	tdk_u32* pValues)
+{
+	get_pack_kernels().pUnpack(pWords, nWidth, nBase, pValues);
+}
+
+void tdk_simd_unpack128_delta(const tdk_u32* pWords, tdk_u32 nWidth,
+	tdk_u32 nBase, tdk_u32* pValues)
+{
+	get_pack_kernels().pUnpackDelta(pWords, nWidth, nBase, pValues);
+}
@@ -0,0 +1,355 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: binary snapshots of containers.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#include "system/tdksnapshot.h"
+#include "base/tdkhash.h"
+
+#include <cassert>
+
+#ifdef _MSC_VER
+#	include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#	include <errno.h>
+#	include <fcntl.h>
+#	include <sys/uio.h>
+#	include <unistd.h>
+#endif
+
+namespace
+{
+
+const tdk_byte g_padding[kTDK_CACHE_LINE_SIZE] = {};
+
+tdk_size padding_after(tdk_u64 nBytes)
+{
+	return tdk_size((kTDK_CACHE_LINE_SIZE - nBytes % kTDK_CACHE_LINE_SIZE) %
+		kTDK_CACHE_LINE_SIZE);
+}
+
+struct write_chunk
+{
+	const void* pData;
+	tdk_size nBytes;
+};
+
+#ifdef _MSC_VER
+
+bool write_chunks(void* hFile, const write_chunk* pChunks, tdk_size nChunks)
+{
+	for (tdk_size i = 0; i < nChunks; ++i)
+	{
+		const tdk_byte* pBytes = static_cast<const tdk_byte*>(pChunks[i].pData);
+		tdk_size nLeft = pChunks[i].nBytes;
+		while (nLeft)
+		{
+			DWORD nWritten = 0;
+			DWORD nPart = DWORD(tdk_min(nLeft, tdk_size(1) << 30));
+			if (!WriteFile(hFile, pBytes, nPart, &nWritten, nullptr))
+				return false;
+			pBytes += nWritten;
+			nLeft -= nWritten;
+		}
+	}
+	return true;
+}
+
+#elif defined(__unix__) || defined(__APPLE__)
+
+// One writev for all chunks, more only if the kernel takes a part of them.
+bool write_chunks(int nFile, const write_chunk* pChunks, tdk_size nChunks)
+{
+	enum Constants { kMAX_CHUNKS = 4 };
+	assert(nChunks <= kMAX_CHUNKS);
+
+	iovec vecs[kMAX_CHUNKS];
+	int nVecs = 0;
+	for (tdk_size i = 0; i < nChunks; ++i)
+	{
+		if (!pChunks[i].nBytes)
+			continue;
+		vecs[nVecs].iov_base = const_cast<void*>(pChunks[i].pData);
+		vecs[nVecs].iov_len = pChunks[i].nBytes;
+		++nVecs;
+	}
+
+	iovec* pVec = vecs;
+	while (nVecs)
+	{
+		ssize_t nWritten = writev(nFile, pVec, nVecs);
+		if (nWritten < 0)
+		{
+			if (EINTR == errno)
+				continue;
+			return false;
+		}
+
+		while (nVecs && tdk_size(nWritten) >= pVec->iov_len)
+		{
+			nWritten -= ssize_t(pVec->iov_len);
+			++pVec;
+			--nVecs;
+		}
+		if (nVecs)
+		{
+			pVec->iov_base = static_cast<tdk_byte*>(pVec->iov_base) + nWritten;
+			pVec->iov_len -= tdk_size(nWritten);
+		}
+	}
+	return true;
+}
+
+#else
+#error "has not implemented yet"
+#endif
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+
+tdk_snapshot_writer::tdk_snapshot_writer()
+	: m_nSectionCount(0)
+	, m_nUserVersion(0)
+	, m_bFailed(false)
+#ifdef _MSC_VER
+	, m_hFile(INVALID_HANDLE_VALUE)
+#else
+	, m_nFile(-1)
+#endif
+{
+}
+
+tdk_snapshot_writer::~tdk_snapshot_writer()
+{
+	close();
+}
+
+tdk_ret tdk_snapshot_writer::open(const char* szPath, tdk_u32 nUserVersion,
+	tdk_err* pErrorCode)
+{
+	close();
+
+	// the header stays zero, so it does not open, until close()
+	tdk_snapshot_header header = {};
+#ifdef _MSC_VER
+	HANDLE hFile = CreateFileA(szPath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (INVALID_HANDLE_VALUE == hFile)
+	{
+		tdk_set_error_code(pErrorCode, kTDK_BAD_FILE);
+		return kTDK_ERR;
+	}
+	m_hFile = hFile;
+	write_chunk chunk = { &header, sizeof(header) };
+	if (!write_chunks(m_hFile, &chunk, 1))
+#else
+	m_nFile = ::open(szPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (m_nFile < 0)
+	{
+		tdk_set_error_code(pErrorCode, kTDK_BAD_FILE);
+		return kTDK_ERR;
+	}
+	write_chunk chunk = { &header, sizeof(header) };
+	if (!write_chunks(m_nFile, &chunk, 1))
+#endif
+	{
+		close();
+		tdk_set_error_code(pErrorCode, kTDK_BAD_FILE);
+		return kTDK_ERR;
+	}
+
+	m_nSectionCount = 0;
+	m_nUserVersion = nUserVersion;
+	m_bFailed = false;
+	return kTDK_OK;
+}
+
+tdk_ret tdk_snapshot_writer::close(tdk_err* pErrorCode)
+{
+	tdk_snapshot_header header = {};
+	header.nMagic = tdk_snapshot_header::kMAGIC;
+	header.nEndianTag = tdk_snapshot_header::kENDIAN_TAG;
+	header.nFormat = tdk_snapshot_header::kFORMAT;
+	header.nUserVersion = m_nUserVersion;
+	header.nSectionCount = m_nSectionCount;
+
+	// after a failed write the zero header is left as it is, so the reader
+	// rejects the file instead of trusting a torn section
+	bool bOk = !m_bFailed;
+#ifdef _MSC_VER
+	if (INVALID_HANDLE_VALUE == m_hFile)
+		return kTDK_OK;
+
+	LARGE_INTEGER nStart = {};
+	write_chunk chunk = { &header, sizeof(header) };
+	bOk = bOk && SetFilePointerEx(m_hFile, nStart, nullptr, FILE_BEGIN) &&
+		write_chunks(m_hFile, &chunk, 1);
+	bOk = CloseHandle(m_hFile) && bOk;
+	m_hFile = INVALID_HANDLE_VALUE;
+#else
+	if (m_nFile < 0)
+		return kTDK_OK;
+
+	bOk = bOk && sizeof(header) == tdk_size(pwrite(m_nFile, &header, sizeof(header), 0));
+	bOk = 0 == ::close(m_nFile) && bOk;
+	m_nFile = -1;
+#endif
+
+	m_nSectionCount = 0;
+	m_bFailed = false;
+	if (!bOk)
+	{
+		tdk_set_error_code(pErrorCode, kTDK_BAD_FILE);
+		return kTDK_ERR;
+	}
+	return kTDK_OK;
+}
+
+tdk_ret tdk_snapshot_writer::write_section(tdk_u32 nKind, tdk_u32 nElemSize,
+	tdk_u64 nCount, const void* pPayload, tdk_size nBytes, tdk_err* pErrorCode)
+{
+	tdk_snapshot_section section = {};
+	section.nKind = nKind;
+	section.nElemSize = nElemSize;
+	section.nCount = nCount;
+	section.nBytes = nBytes;
+	section.nChecksum = tdk_hash_bytes(pPayload, nBytes);
+
+	write_chunk chunks[] =
+	{
+		{ &section, sizeof(section) },
+		{ pPayload, nBytes },
+		{ g_padding, padding_after(nBytes) }
+	};
+
+#ifdef _MSC_VER
+	bool bOk = INVALID_HANDLE_VALUE != m_hFile && !m_bFailed &&
+		write_chunks(m_hFile, chunks, 3);
+#else
+	bool bOk = m_nFile >= 0 && !m_bFailed && write_chunks(m_nFile, chunks, 3);
+#endif
+	if (!bOk)
+	{
+		// part of the section may be in the file, nothing after it can be
+		// found again
+		m_bFailed = true;
+		tdk_set_error_code(pErrorCode, kTDK_BAD_FILE);
+		return kTDK_ERR;
+	}
+
+	++m_nSectionCount;
+	return kTDK_OK;
+}
+
+//-----------------------------------------------------------------------------
+
+tdk_ret tdk_snapshot_reader::open(const char* szPath, tdk_u32 nUserVersion,
+	tdk_u32 nFlags, tdk_err* pErrorCode)
+{
+	close();
+	if (kTDK_OK != m_file.open(szPath, kTDK_FILE_READ, pErrorCode))
+		return kTDK_ERR;
+
+	const tdk_byte* pFile = m_file.data();
+	tdk_size nFileSize = m_file.size();
+	const tdk_snapshot_header* pHeader =
+		reinterpret_cast<const tdk_snapshot_header*>(pFile);
+	tdk_err nError = kTDK_BAD_FORMAT;
+	bool bValid = nFileSize >= sizeof(tdk_snapshot_header) &&
+		tdk_snapshot_header::kMAGIC == pHeader->nMagic &&
+		tdk_snapshot_header::kENDIAN_TAG == pHeader->nEndianTag &&
+		tdk_snapshot_header::kFORMAT == pHeader->nFormat &&
+		nUserVersion == pHeader->nUserVersion &&
+		kTDK_OK == m_sections.reserve(tdk_size(tdk_min(pHeader->nSectionCount,
+			tdk_u64(nFileSize / sizeof(tdk_snapshot_section)))));
+
+	tdk_size nOffset = sizeof(tdk_snapshot_header);
+	for (tdk_u64 i = 0; bValid && i < pHeader->nSectionCount; ++i)
+	{
+		const tdk_snapshot_section* pSection =
+			reinterpret_cast<const tdk_snapshot_section*>(pFile + nOffset);
+		bValid = nFileSize - nOffset >= sizeof(tdk_snapshot_section);
+		if (!bValid)
+			break;
+
+		tdk_size nPayload = nOffset + sizeof(tdk_snapshot_section);
+		// every encoded element takes at least one byte, so a larger count
+		// is corrupt and must not reach the reserve() of a load
+		bValid = pSection->nBytes <= nFileSize - nPayload &&
+			((tdk_snapshot_section::kCODEC == pSection->nKind &&
+				pSection->nCount <= pSection->nBytes) ||
+			(tdk_snapshot_section::kRAW == pSection->nKind && pSection->nElemSize &&
+				pSection->nBytes / pSection->nElemSize == pSection->nCount &&
+				0 == pSection->nBytes % pSection->nElemSize));
+		if (!bValid)
+			break;
+
+		if ((nFlags & kTDK_SNAPSHOT_VERIFY) &&
+			pSection->nChecksum != tdk_hash_bytes(pFile + nPayload, tdk_size(pSection->nBytes)))
+		{
+			nError = kTDK_BAD_CHECKSUM;
+			bValid = false;
+			break;
+		}
+
+		m_sections.push_back(nOffset);
+		nOffset = nPayload + tdk_size(pSection->nBytes);
+		nOffset += tdk_min(padding_after(pSection->nBytes), nFileSize - nOffset);
+	}
+
+	if (!bValid)
+	{
+		close();
+		tdk_set_error_code(pErrorCode, nError);
+		return kTDK_ERR;
+	}
+	return kTDK_OK;
+}
+
+void tdk_snapshot_reader::close()
+{
+	m_file.close();
+	m_sections.clear();
+}
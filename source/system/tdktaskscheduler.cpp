@@ -0,0 +1,477 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: work stealing task scheduler.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#include "system/tdktaskscheduler.h"
+#include "system/tdkmemory.h"
+#include "base/tdkmemorypool.h"
+#include "base/tdkringbuffer.h"
+
+#include <cassert>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// Chase-Lev deque of a fixed capacity (Le, Pop, Cohen, Nardelli: "Correct
+// and efficient work-stealing for weak memory models"). The owner pushes and
+// pops at the bottom, thieves take from the top. The fences of the paper are
+// expressed by seq_cst accesses to m_nBottom and m_nTop. A full deque refuses
+// the task and the caller runs it itself, so the buffer never has to grow.
+class task_deque
+{
+public:
+	enum Constants { kCAPACITY = 4096 };
+
+	task_deque()
+		: m_nTop(0)
+		, m_nBottom(0)
+	{
+		for (tdk_size i = 0; i < kCAPACITY; ++i)
+			m_tasks[i].store(nullptr, std::memory_order_relaxed);
+	}
+
+	bool push(tdk_task* pTask)
+	{
+		tdk_diff nBottom = m_nBottom.load(std::memory_order_relaxed);
+		tdk_diff nTop = m_nTop.load(std::memory_order_acquire);
+		if (nBottom - nTop >= tdk_diff(kCAPACITY))
+			return false;
+
+		m_tasks[nBottom & (kCAPACITY - 1)].store(pTask, std::memory_order_relaxed);
+		m_nBottom.store(nBottom + 1, std::memory_order_seq_cst);
+		return true;
+	}
+
+	tdk_task* pop()
+	{
+		tdk_diff nBottom = m_nBottom.load(std::memory_order_relaxed) - 1;
+		m_nBottom.store(nBottom, std::memory_order_seq_cst);
+		tdk_diff nTop = m_nTop.load(std::memory_order_seq_cst);
+
+		if (nTop > nBottom)
+		{
+			m_nBottom.store(nBottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		tdk_task* pTask = m_tasks[nBottom & (kCAPACITY - 1)].load(std::memory_order_relaxed);
+		if (nTop == nBottom)
+		{
+			// the last task, race a thief for it
+			if (!m_nTop.compare_exchange_strong(nTop, nTop + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				pTask = nullptr;
+			}
+			m_nBottom.store(nBottom + 1, std::memory_order_relaxed);
+		}
+		return pTask;
+	}
+
+	tdk_task* steal()
+	{
+		tdk_diff nTop = m_nTop.load(std::memory_order_seq_cst);
+		tdk_diff nBottom = m_nBottom.load(std::memory_order_seq_cst);
+		if (nTop >= nBottom)
+			return nullptr;
+
+		tdk_task* pTask = m_tasks[nTop & (kCAPACITY - 1)].load(std::memory_order_relaxed);
+		if (!m_nTop.compare_exchange_strong(nTop, nTop + 1,
+			std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			return nullptr;
+		}
+		return pTask;
+	}
+
+	bool empty() const
+	{
+		return m_nTop.load(std::memory_order_seq_cst) >=
+			m_nBottom.load(std::memory_order_seq_cst);
+	}
+
+private:
+	alignas(kTDK_CACHE_LINE_SIZE) std::atomic<tdk_diff> m_nTop;
+	alignas(kTDK_CACHE_LINE_SIZE) std::atomic<tdk_diff> m_nBottom;
+	alignas(kTDK_CACHE_LINE_SIZE) std::atomic<tdk_task*> m_tasks[kCAPACITY];
+};
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+
+struct alignas(kTDK_CACHE_LINE_SIZE) tdk_task_worker
+{
+	task_deque deque;
+	tdk_memorypool<sizeof(tdk_task)> taskPool;
+	tdk_u32 nRandom = 0; // xorshift state for picking victims
+	alignas(kTDK_CACHE_LINE_SIZE) std::atomic<tdk_task*> pRemoteFree{ nullptr };
+};
+
+class tdk_task_scheduler::Impl
+{
+public:
+	enum Constants
+	{
+		kINJECT_CAPACITY = 1024,
+		kSPIN_ROUNDS = 64
+	};
+
+	std::unique_ptr<tdk_task_worker[]> workers;
+	std::unique_ptr<std::thread[]> threads;
+	size_type nWorkers = 0;
+	tdk_mpmc_ringbuffer<tdk_task*> injected;
+
+	std::mutex sleepMutex;
+	std::condition_variable sleepCond;
+	std::atomic<size_type> nSleepers{ 0 };
+	tdk_u64 nWakeEpoch = 0; // guarded by sleepMutex
+	bool bStop = false; // guarded by sleepMutex
+
+	// worker of the calling thread and its scheduler, compared without
+	// touching the worker so that a stale entry is harmless
+	static thread_local const tdk_task_scheduler* s_pCurrentScheduler;
+	static thread_local tdk_task_worker* s_pCurrent;
+
+	static void set_current(const tdk_task_scheduler* pScheduler, tdk_task_worker* pWorker)
+	{
+		s_pCurrentScheduler = pScheduler;
+		s_pCurrent = pWorker;
+	}
+
+	tdk_task_worker* current(const tdk_task_scheduler* pScheduler) const
+	{
+		return s_pCurrentScheduler == pScheduler ? s_pCurrent : nullptr;
+	}
+
+	tdk_task* find_task(tdk_task_worker* pWorker)
+	{
+		tdk_task* pTask = nullptr;
+		if (pWorker && (pTask = pWorker->deque.pop()))
+			return pTask;
+
+		if (kTDK_OK == injected.pop(pTask))
+			return pTask;
+
+		size_type nStart = 0;
+		if (pWorker)
+		{
+			tdk_u32 x = pWorker->nRandom;
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			pWorker->nRandom = x;
+			nStart = x % nWorkers;
+		}
+
+		for (size_type i = 0; i < nWorkers; ++i)
+		{
+			tdk_task_worker& victim = workers[(nStart + i) % nWorkers];
+			if (&victim != pWorker && (pTask = victim.deque.steal()))
+				return pTask;
+		}
+		return nullptr;
+	}
+
+	bool has_visible_work() const
+	{
+		if (!injected.empty())
+			return true;
+		for (size_type i = 0; i < nWorkers; ++i)
+		{
+			if (!workers[i].deque.empty())
+				return true;
+		}
+		return false;
+	}
+
+	// The spawner publishes the task and then reads nSleepers, a sleeper
+	// counts itself and then looks for work: with both sides seq_cst at
+	// least one of them sees the other and no wakeup is lost.
+	void wake_one()
+	{
+		if (!nSleepers.load(std::memory_order_seq_cst))
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			++nWakeEpoch;
+		}
+		sleepCond.notify_one();
+	}
+
+	void sleep()
+	{
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		if (bStop)
+			return;
+
+		tdk_u64 nEpoch = nWakeEpoch;
+		nSleepers.fetch_add(1, std::memory_order_seq_cst);
+		if (!has_visible_work())
+			sleepCond.wait(lock, [&]() { return bStop || nWakeEpoch != nEpoch; });
+		nSleepers.fetch_sub(1, std::memory_order_relaxed);
+	}
+};
+
+thread_local const tdk_task_scheduler* tdk_task_scheduler::Impl::s_pCurrentScheduler = nullptr;
+thread_local tdk_task_worker* tdk_task_scheduler::Impl::s_pCurrent = nullptr;
+
+//-----------------------------------------------------------------------------
+
+tdk_task_scheduler::tdk_task_scheduler()
+	: m_pImpl(nullptr)
+{
+}
+
+tdk_task_scheduler::~tdk_task_scheduler()
+{
+	shutdown();
+}
+
+tdk_ret tdk_task_scheduler::initialize(size_type nThreads, tdk_err* pErrorCode)
+{
+	assert(!m_pImpl);
+
+	if (!nThreads)
+		nThreads = tdk_max(size_type(1), size_type(std::thread::hardware_concurrency()));
+
+	std::unique_ptr<Impl> pImpl(new (std::nothrow) Impl);
+	if (!pImpl)
+	{
+		tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+		return kTDK_FATAL;
+	}
+
+	pImpl->workers.reset(new (std::nothrow) tdk_task_worker[nThreads]);
+	pImpl->threads.reset(new (std::nothrow) std::thread[nThreads]);
+	if (!pImpl->workers || !pImpl->threads)
+	{
+		tdk_set_error_code(pErrorCode, kTDK_BAD_ALLOC);
+		return kTDK_FATAL;
+	}
+
+	if (kTDK_OK != pImpl->injected.initialize(Impl::kINJECT_CAPACITY, pErrorCode))
+		return kTDK_FATAL;
+
+	pImpl->nWorkers = nThreads;
+	for (size_type i = 0; i < nThreads; ++i)
+		pImpl->workers[i].nRandom = tdk_u32(i * 0x9E3779B9u + 1);
+
+	m_pImpl = pImpl.release();
+	Impl::set_current(this, &m_pImpl->workers[0]);
+
+	for (size_type i = 1; i < nThreads; ++i)
+	{
+		m_pImpl->threads[i] = std::thread([this, i]()
+		{
+			Impl& impl = *m_pImpl;
+			tdk_task_worker* pWorker = &impl.workers[i];
+			Impl::set_current(this, pWorker);
+
+			for (;;)
+			{
+				tdk_task* pTask = nullptr;
+				for (size_type nRound = 0; !pTask && nRound < Impl::kSPIN_ROUNDS; ++nRound)
+				{
+					pTask = impl.find_task(pWorker);
+					if (!pTask)
+						std::this_thread::yield();
+				}
+
+				if (pTask)
+				{
+					execute(pTask);
+					continue;
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(impl.sleepMutex);
+					if (impl.bStop)
+						break;
+				}
+				impl.sleep();
+			}
+			Impl::set_current(nullptr, nullptr);
+		});
+	}
+	return kTDK_OK;
+}
+
+void tdk_task_scheduler::shutdown()
+{
+	if (!m_pImpl)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_pImpl->sleepMutex);
+		m_pImpl->bStop = true;
+	}
+	m_pImpl->sleepCond.notify_all();
+
+	for (size_type i = 1; i < m_pImpl->nWorkers; ++i)
+		m_pImpl->threads[i].join();
+
+	if (m_pImpl->current(this))
+		Impl::set_current(nullptr, nullptr);
+
+	delete m_pImpl;
+	m_pImpl = nullptr;
+}
+
+tdk_task_scheduler::size_type tdk_task_scheduler::thread_count() const
+{
+	return m_pImpl ? m_pImpl->nWorkers : 1;
+}
+
+tdk_task* tdk_task_scheduler::allocate_task()
+{
+	if (!m_pImpl)
+		return nullptr;
+
+	tdk_task_worker* pWorker = m_pImpl->current(this);
+	if (!pWorker)
+	{
+		void* pMem = tdk_allocate_memory_aligned(sizeof(tdk_task), alignof(tdk_task));
+		if (!pMem)
+			return nullptr;
+		tdk_task* pTask = static_cast<tdk_task*>(pMem);
+		pTask->pOwner = nullptr;
+		return pTask;
+	}
+
+	// take back the tasks that thieves have finished
+	if (pWorker->pRemoteFree.load(std::memory_order_relaxed))
+	{
+		tdk_task* pFreed = pWorker->pRemoteFree.exchange(nullptr, std::memory_order_acquire);
+		while (pFreed)
+		{
+			tdk_task* pNext = pFreed->pNextFree;
+			pWorker->taskPool.free(pFreed);
+			pFreed = pNext;
+		}
+	}
+
+	void* pMem = pWorker->taskPool.allocate();
+	if (!pMem)
+		return nullptr;
+	tdk_task* pTask = static_cast<tdk_task*>(pMem);
+	pTask->pOwner = pWorker;
+	return pTask;
+}
+
+void tdk_task_scheduler::free_task(tdk_task* pTask)
+{
+	tdk_task_worker* pOwner = static_cast<tdk_task_worker*>(pTask->pOwner);
+	if (!pOwner)
+	{
+		tdk_free_memory_aligned(pTask, alignof(tdk_task));
+		return;
+	}
+
+	if (pOwner == Impl::s_pCurrent)
+	{
+		pOwner->taskPool.free(pTask);
+		return;
+	}
+
+	tdk_task* pHead = pOwner->pRemoteFree.load(std::memory_order_relaxed);
+	do
+	{
+		pTask->pNextFree = pHead;
+	} while (!pOwner->pRemoteFree.compare_exchange_weak(pHead, pTask,
+		std::memory_order_release, std::memory_order_relaxed));
+}
+
+void tdk_task_scheduler::submit(tdk_task* pTask)
+{
+	tdk_task_worker* pWorker = m_pImpl->current(this);
+	bool bQueued = pWorker ? pWorker->deque.push(pTask) :
+		kTDK_OK == m_pImpl->injected.push(pTask);
+	if (!bQueued)
+	{
+		execute(pTask);
+		return;
+	}
+	m_pImpl->wake_one();
+}
+
+void tdk_task_scheduler::execute(tdk_task* pTask)
+{
+	tdk_task_group* pGroup = pTask->pGroup;
+	pTask->pfnRun(pTask);
+	free_task(pTask);
+	// the last access to the group, wait() may return and destroy it now
+	pGroup->m_nPending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+bool tdk_task_scheduler::run_one()
+{
+	if (!m_pImpl)
+		return false;
+
+	tdk_task* pTask = m_pImpl->find_task(m_pImpl->current(this));
+	if (!pTask)
+		return false;
+
+	execute(pTask);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void tdk_task_group::wait()
+{
+	while (m_nPending.load(std::memory_order_acquire))
+	{
+		if (!m_scheduler.run_one())
+			std::this_thread::yield();
+	}
+}
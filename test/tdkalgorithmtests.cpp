@@ -0,0 +1,355 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: unit tests of the sorts, parallel algorithms and snapshots.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#include "tdktest.h"
+
+#include "base/tdkdarray.h"
+#include "base/tdkhashmap.h"
+#include "base/tdkpoddarray.h"
+#include "base/tdkradixsort.h"
+#include "system/tdkparallel.h"
+#include "system/tdksimd.h"
+#include "system/tdksnapshot.h"
+#include "system/tdktaskscheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+class Lcg
+{
+public:
+	tdk_u32 next()
+	{
+		m_nState = m_nState * 1664525u + 1013904223u;
+		return m_nState >> 8;
+	}
+
+private:
+	tdk_u32 m_nState{ 12345 };
+};
+
+struct Order
+{
+	tdk_u64 nKey;
+	tdk_u32 nSeq;
+};
+
+template<typename Array>
+bool is_sorted_array(const Array& arr)
+{
+	return std::is_sorted(arr.begin(), arr.end());
+}
+
+//-----------------------------------------------------------------------------
+// SIMD kernels
+
+TDK_TEST(simd_search)
+{
+	tdk_u32 values[1000];
+	for (tdk_u32 i = 0; i < 1000; ++i)
+		values[i] = i % 100;
+	TDK_CHECK(42 == tdk_simd_find(values, 1000, tdk_u32(42)));
+	TDK_CHECK(1000 == tdk_simd_find(values, 1000, tdk_u32(100)));
+	TDK_CHECK(10 == tdk_simd_count(values, 1000, tdk_u32(42)));
+}
+
+TDK_TEST(simd_popcount)
+{
+	tdk_u64 words[5] = { 1, 3, ~tdk_u64(0), 0, 7 };
+	TDK_CHECK(70 == tdk_simd_popcount(words, 5));
+}
+
+TDK_TEST(simd_pack128)
+{
+	tdk_u32 values[128], packed[4 * 32], out[128];
+	for (tdk_u32 i = 0; i < 128; ++i)
+		values[i] = (i * 37) & 0x7ff;
+	tdk_simd_pack128(values, 11, packed);
+	tdk_simd_unpack128(packed, 11, 0, out);
+	TDK_CHECK(std::equal(values, values + 128, out));
+}
+
+//-----------------------------------------------------------------------------
+// Radix sort
+
+TDK_TEST(radix_sort)
+{
+	for (tdk_size nCount : { tdk_size(10), tdk_size(100000) })
+	{
+		tdk_podarray<tdk_u32> arr;
+		tdk_podarray<int> signedArr;
+		tdk_podarray<float> floats;
+		Lcg rng;
+		for (tdk_size i = 0; i < nCount; ++i)
+		{
+			tdk_u32 nVal = rng.next();
+			arr.push_back(nVal);
+			signedArr.push_back(int(nVal) - (1 << 23));
+			floats.push_back(float(int(nVal) - (1 << 23)) / 7.0f);
+		}
+
+		TDK_CHECK(kTDK_OK == tdk_radix_sort(arr));
+		TDK_CHECK(nCount == arr.size() && is_sorted_array(arr));
+		TDK_CHECK(kTDK_OK == tdk_radix_sort(signedArr));
+		TDK_CHECK(is_sorted_array(signedArr));
+		TDK_CHECK(kTDK_OK == tdk_radix_sort(floats));
+		TDK_CHECK(is_sorted_array(floats));
+	}
+}
+
+TDK_TEST(radix_sort_by_key_is_stable)
+{
+	tdk_podarray<Order> orders;
+	Lcg rng;
+	for (tdk_u32 i = 0; i < 50000; ++i)
+		orders.push_back({ rng.next() % 100, i });
+
+	TDK_CHECK(kTDK_OK == tdk_radix_sort_by_key(orders,
+		[](const Order& order) { return order.nKey; }));
+	bool bStable = true;
+	for (tdk_size i = 1; i < orders.size(); ++i)
+	{
+		const Order& a = orders[i - 1];
+		const Order& b = orders[i];
+		bStable = bStable && (a.nKey < b.nKey || (a.nKey == b.nKey && a.nSeq < b.nSeq));
+	}
+	TDK_CHECK(bStable);
+}
+
+//-----------------------------------------------------------------------------
+// Task scheduler and parallel algorithms
+
+TDK_TEST(task_scheduler)
+{
+	tdk_task_scheduler scheduler;
+	TDK_CHECK(kTDK_OK == scheduler.initialize(4));
+	TDK_CHECK(4 == scheduler.thread_count());
+
+	std::vector<std::atomic<int>> hits(100000);
+	scheduler.parallel_for(0, hits.size(), [&hits](tdk_size nFirst, tdk_size nLast)
+	{
+		for (tdk_size i = nFirst; i < nLast; ++i)
+			hits[i].fetch_add(1, std::memory_order_relaxed);
+	}, 1000);
+	bool bOnce = true;
+	for (const std::atomic<int>& nHits : hits)
+		bOnce = bOnce && 1 == nHits.load();
+	TDK_CHECK(bOnce);
+
+	tdk_darray<int> arr;
+	for (int i = 0; i < 1000; ++i)
+		arr.push_back(i);
+	scheduler.parallel_for(arr, [](int& nVal) { nVal *= 2; });
+	TDK_CHECK(0 == *arr.at(0) && 1998 == *arr.at(999));
+
+	// nested groups
+	std::atomic<int> nRan{ 0 };
+	{
+		tdk_task_group group(scheduler);
+		for (int i = 0; i < 8; ++i)
+		{
+			group.run([&scheduler, &nRan]()
+			{
+				tdk_task_group inner(scheduler);
+				for (int k = 0; k < 8; ++k)
+					inner.run([&nRan]() { nRan.fetch_add(1); });
+				inner.wait();
+			});
+		}
+		group.wait();
+	}
+	TDK_CHECK(64 == nRan.load());
+	scheduler.shutdown();
+}
+
+TDK_TEST(parallel_algorithms)
+{
+	tdk_task_scheduler scheduler;
+	TDK_CHECK(kTDK_OK == scheduler.initialize(4));
+
+	tdk_podarray<tdk_u32> arr;
+	arr.resize(200000);
+	tdk_parallel_fill(scheduler, arr, tdk_u32(3));
+	TDK_CHECK(3 == arr[0] && 3 == arr[199999]);
+
+	Lcg rng;
+	for (tdk_u32& nVal : arr)
+		nVal = rng.next();
+
+	tdk_podarray<tdk_u64> wide;
+	wide.resize(arr.size());
+	tdk_parallel_transform(scheduler, arr, wide,
+		[](tdk_u32 nVal) { return tdk_u64(nVal) * 2; });
+	TDK_CHECK(tdk_u64(arr[777]) * 2 == wide[777]);
+
+	tdk_u64 nExpected = 0;
+	for (tdk_u32 nVal : arr)
+		nExpected += nVal;
+	tdk_u64 nSum = tdk_parallel_reduce(scheduler, arr, tdk_u64(0),
+		[](tdk_u64 a, tdk_u64 b) { return a + b; });
+	TDK_CHECK(nExpected == nSum);
+
+	tdk_podarray<tdk_u32> copy;
+	copy.resize(arr.size());
+	tdk_parallel_copy(scheduler, arr, copy);
+	TDK_CHECK(arr[123456] == copy[123456]);
+
+	TDK_CHECK(arr.find(arr[150000]) == tdk_parallel_find(scheduler, arr, arr[150000]));
+	TDK_CHECK(0 == tdk_parallel_find_if(scheduler, arr,
+		[&arr](tdk_u32 nVal) { return nVal == arr[0]; }));
+
+	tdk_parallel_sort(scheduler, copy);
+	TDK_CHECK(is_sorted_array(copy));
+}
+
+TDK_TEST(parallel_radix_sort)
+{
+	tdk_task_scheduler scheduler;
+	TDK_CHECK(kTDK_OK == scheduler.initialize(4));
+
+	tdk_podarray<tdk_u32> arr;
+	Lcg rng;
+	for (tdk_u32 i = 0; i < 200000; ++i)
+		arr.push_back(rng.next());
+	tdk_podarray<tdk_u32> copy(arr);
+	std::sort(copy.begin(), copy.end());
+
+	TDK_CHECK(kTDK_OK == tdk_parallel_radix_sort(scheduler, arr));
+	TDK_CHECK(is_sorted_array(arr));
+	TDK_CHECK(std::equal(arr.begin(), arr.end(), copy.begin()));
+}
+
+//-----------------------------------------------------------------------------
+// Snapshots
+
+TDK_TEST(snapshot_round_trip)
+{
+	const char* szPath = "tdk_test_snapshot.bin";
+
+	tdk_podarray<tdk_u32> ids;
+	for (tdk_u32 i = 0; i < 10000; ++i)
+		ids.push_back(i * 3);
+	tdk_darray<std::string> names;
+	for (int i = 0; i < 100; ++i)
+		names.push_back(std::string(tdk_size(i), 'n'));
+	tdk_hashmap<std::string, tdk_u32> index;
+	for (tdk_u32 i = 0; i < 100; ++i)
+		index.insert(std::to_string(i), i);
+
+	tdk_snapshot_writer writer;
+	TDK_CHECK(kTDK_OK == writer.open(szPath, 7));
+	TDK_CHECK(kTDK_OK == writer.write(ids));
+	TDK_CHECK(kTDK_OK == writer.write(names));
+	TDK_CHECK(kTDK_OK == writer.write(index));
+	TDK_CHECK(kTDK_OK == writer.close());
+
+	tdk_snapshot_reader reader;
+	tdk_err nError = kTDK_BAD_ALLOC;
+	TDK_CHECK(kTDK_OK != reader.open(szPath, 8, kTDK_SNAPSHOT_DEFAULT, &nError));
+	TDK_CHECK(kTDK_BAD_FORMAT == nError);
+	TDK_CHECK(kTDK_OK == reader.open(szPath, 7, kTDK_SNAPSHOT_VERIFY));
+	TDK_CHECK(3 == reader.section_count());
+
+	const tdk_u32* pIds = nullptr;
+	tdk_size nCount = 0;
+	TDK_CHECK(kTDK_OK == reader.view(0, pIds, nCount));
+	TDK_CHECK(10000 == nCount && 29997 == pIds[9999]);
+	TDK_CHECK(kTDK_OK != reader.view(1, pIds, nCount));
+
+	tdk_podarray<tdk_u32> idsBack;
+	TDK_CHECK(kTDK_OK == reader.load(0, idsBack));
+	TDK_CHECK(10000 == idsBack.size() && 3 == idsBack[1]);
+
+	tdk_darray<std::string> namesBack;
+	TDK_CHECK(kTDK_OK == reader.load(1, namesBack));
+	TDK_CHECK(100 == namesBack.size() && 99 == namesBack.at(99)->size());
+
+	tdk_hashmap<std::string, tdk_u32> indexBack;
+	TDK_CHECK(kTDK_OK == reader.load(2, indexBack));
+	TDK_CHECK(100 == indexBack.size() && 42 == *indexBack.at("42"));
+
+	reader.close();
+	std::remove(szPath);
+}
+
+TDK_TEST(snapshot_corrupt_codec_count)
+{
+	const char* szPath = "tdk_test_snapshot_corrupt.bin";
+
+	tdk_darray<std::string> names;
+	names.push_back("a");
+	tdk_snapshot_writer writer;
+	TDK_CHECK(kTDK_OK == writer.open(szPath));
+	TDK_CHECK(kTDK_OK == writer.write(names));
+	TDK_CHECK(kTDK_OK == writer.close());
+
+	// a huge element count in the first section header, the payload is intact
+	tdk_u64 nCount = tdk_u64(1) << 60;
+	std::FILE* pFile = std::fopen(szPath, "r+b");
+	TDK_CHECK(pFile);
+	if (pFile)
+	{
+		std::fseek(pFile, long(sizeof(tdk_snapshot_header) +
+			offsetof(tdk_snapshot_section, nCount)), SEEK_SET);
+		std::fwrite(&nCount, sizeof(nCount), 1, pFile);
+		std::fclose(pFile);
+	}
+
+	tdk_snapshot_reader reader;
+	tdk_err nError = kTDK_BAD_ALLOC;
+	TDK_CHECK(kTDK_OK != reader.open(szPath, 0, kTDK_SNAPSHOT_VERIFY, &nError));
+	TDK_CHECK(kTDK_BAD_FORMAT == nError);
+	std::remove(szPath);
+}
+
+} // namespace
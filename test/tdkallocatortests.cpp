@@ -0,0 +1,312 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: unit tests of the allocators and memory pools.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#include "tdktest.h"
+
+#include "base/tdkdarray.h"
+#include "base/tdkmemalloc.h"
+#include "base/tdkmemorypool.h"
+#include "base/tdkstaticmemorypool.h"
+#include "system/tdkmemory.h"
+#include "system/tdkmemoryregion.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+struct Object32
+{
+	tdk_byte bytes[32];
+};
+
+bool is_aligned(const void* p, tdk_size nAlignment)
+{
+	return 0 == reinterpret_cast<std::uintptr_t>(p) % nAlignment;
+}
+
+//-----------------------------------------------------------------------------
+// Raw memory
+
+TDK_TEST(memory_aligned)
+{
+	for (tdk_size nAlignment = 8; nAlignment <= 4096; nAlignment *= 2)
+	{
+		void* p = tdk_allocate_memory_aligned(100, nAlignment);
+		TDK_CHECK(p);
+		TDK_CHECK(is_aligned(p, nAlignment));
+		std::memset(p, 0xab, 100);
+		tdk_free_memory_aligned(p, nAlignment);
+	}
+}
+
+TDK_TEST(memory_huge)
+{
+	const tdk_size nBytes = 3 << 20;
+	TDK_CHECK(tdk_huge_page_round_up(nBytes) >= nBytes);
+
+	tdk_byte* p = static_cast<tdk_byte*>(tdk_allocate_memory_huge(nBytes));
+	TDK_CHECK(p);
+	p[0] = 1;
+	p[nBytes - 1] = 2;
+	TDK_CHECK(1 == p[0] && 2 == p[nBytes - 1]);
+	tdk_free_memory_huge(p, nBytes);
+
+	// rounding up would wrap around to a tiny mapping
+	tdk_err nError = kTDK_BAD_ALLOC;
+	TDK_CHECK(!tdk_allocate_memory_huge(tdk_size(-1) - 100, &nError));
+	TDK_CHECK(kTDK_BAD_SIZE == nError);
+}
+
+//-----------------------------------------------------------------------------
+// Allocators
+
+TDK_TEST(allocator_alignment)
+{
+	tdk_allocator<int> alloc;
+	int* p = alloc.allocate(1000);
+	TDK_CHECK(p);
+	TDK_CHECK(is_aligned(p, 16));
+	for (int i = 0; i < 1000; ++i)
+		p[i] = i;
+	TDK_CHECK(999 == p[999]);
+	alloc.deallocate(p, 1000);
+
+	tdk_allocator<Object32, 64> lineAlloc;
+	Object32* pObj = lineAlloc.allocate(3);
+	TDK_CHECK(is_aligned(pObj, 64));
+	lineAlloc.deallocate(pObj, 3);
+}
+
+TDK_TEST(huge_page_allocator)
+{
+	tdk_huge_page_allocator<tdk_u32> alloc;
+	// small requests come from the aligned heap, big ones from huge pages
+	for (tdk_size nCount : { tdk_size(16), tdk_size(1) << 20 })
+	{
+		tdk_u32* p = alloc.allocate(nCount);
+		TDK_CHECK(p);
+		TDK_CHECK(is_aligned(p, 16));
+		p[0] = 1;
+		p[nCount - 1] = 2;
+		TDK_CHECK(1 == p[0] && 2 == p[nCount - 1]);
+		alloc.deallocate(p, nCount);
+	}
+
+	tdk_darray<int, tdk_huge_page_allocator<int>> arr;
+	for (int i = 0; i < 10000; ++i)
+		TDK_CHECK(kTDK_OK == arr.push_back(i));
+	TDK_CHECK(10000 == arr.size() && 9999 == *arr.at(9999));
+}
+
+//-----------------------------------------------------------------------------
+// Memory pools
+
+template<typename Pool>
+void check_pool_reuse(Pool& pool, tdk_size nCount)
+{
+	std::vector<void*> ptrs;
+	for (tdk_size i = 0; i < nCount; ++i)
+	{
+		void* p = pool.allocate();
+		TDK_CHECK(p);
+		TDK_CHECK(is_aligned(p, alignof(void*)));
+		std::memset(p, int(i), sizeof(Object32));
+		ptrs.push_back(p);
+	}
+
+	// every node is distinct and kept its content
+	for (tdk_size i = 0; i < nCount; ++i)
+		TDK_CHECK(static_cast<tdk_byte*>(ptrs[i])[31] == tdk_byte(i));
+
+	for (void* p : ptrs)
+		pool.free(p);
+
+	// freed nodes come back before the pool grows
+	tdk_size nCapacity = pool.capacity();
+	for (tdk_size i = 0; i < nCount; ++i)
+		ptrs[i] = pool.allocate();
+	TDK_CHECK(nCapacity == pool.capacity());
+	for (void* p : ptrs)
+		pool.free(p);
+}
+
+TDK_TEST(memorypool)
+{
+	tdk_memorypool<sizeof(Object32)> pool;
+	TDK_CHECK(0 == pool.capacity());
+	check_pool_reuse(pool, 5000);
+	TDK_CHECK(pool.capacity() >= 5000);
+}
+
+TDK_TEST(memorypool_huge_pages)
+{
+	tdk_memorypool<sizeof(Object32)> pool(kTDK_MEMORY_HUGE_PAGES);
+	check_pool_reuse(pool, 5000);
+}
+
+TDK_TEST(memorypool_swap)
+{
+	tdk_memorypool<sizeof(Object32)> a, b;
+	void* p = a.allocate();
+	a.swap(b);
+	TDK_CHECK(0 == a.capacity());
+	TDK_CHECK(b.capacity());
+	b.free(p);
+}
+
+TDK_TEST(static_memorypool)
+{
+	tdk_static_memorypool<sizeof(Object32), 64> pool;
+	TDK_CHECK(64 == pool.capacity());
+	TDK_CHECK(0 == pool.size());
+
+	std::vector<void*> ptrs;
+	for (int i = 0; i < 64; ++i)
+	{
+		void* p = pool.allocate();
+		TDK_CHECK(p && pool.owns(p));
+		ptrs.push_back(p);
+	}
+	TDK_CHECK(pool.full());
+
+	tdk_err nError = kTDK_BAD_ALLOC;
+	TDK_CHECK(!pool.allocate(&nError));
+	TDK_CHECK(kTDK_BAD_SIZE == nError);
+
+	Object32 outside;
+	TDK_CHECK(!pool.owns(&outside));
+
+	pool.free(ptrs[10]);
+	TDK_CHECK(63 == pool.size());
+	TDK_CHECK(ptrs[10] == pool.allocate());
+	for (void* p : ptrs)
+		pool.free(p);
+	TDK_CHECK(0 == pool.size());
+}
+
+//-----------------------------------------------------------------------------
+// Memory regions
+
+struct TestRegion
+{
+	static tdk_memory_region& region()
+	{
+		static tdk_memory_region s_region("test", 1 << 20);
+		return s_region;
+	}
+};
+
+TDK_TEST(memory_region)
+{
+	tdk_memory_region region("budget", 4096);
+	TDK_CHECK(4096 == region.budget());
+
+	void* p = region.allocate(1000, 64);
+	TDK_CHECK(p && is_aligned(p, 64));
+	TDK_CHECK(1 == region.live_blocks());
+	TDK_CHECK(region.live_bytes() >= 1000);
+
+	tdk_err nError = kTDK_BAD_SIZE;
+	TDK_CHECK(!region.allocate(4000, 0, &nError));
+	TDK_CHECK(kTDK_BAD_ALLOC == nError);
+
+	region.free(p);
+	TDK_CHECK(0 == region.live_bytes());
+	TDK_CHECK(0 == region.live_blocks());
+	TDK_CHECK(region.peak_bytes() >= 1000);
+
+	region.set_budget(1 << 20);
+	for (int i = 0; i < 10; ++i)
+		TDK_CHECK(region.allocate(1000, 16));
+	TDK_CHECK(10 == region.live_blocks());
+	region.release_all();
+	TDK_CHECK(0 == region.live_blocks());
+	TDK_CHECK(0 == region.live_bytes());
+}
+
+TDK_TEST(region_allocator)
+{
+	tdk_memory_region& region = TestRegion::region();
+	{
+		tdk_darray<int, tdk_region_allocator<int, TestRegion>> arr;
+		for (int i = 0; i < 1000; ++i)
+			TDK_CHECK(kTDK_OK == arr.push_back(i));
+		TDK_CHECK(region.live_bytes() >= 1000 * sizeof(int));
+
+		// past the budget the container fails instead of the allocator
+		tdk_err nError = kTDK_BAD_SIZE;
+		TDK_CHECK(kTDK_FATAL == arr.reserve(1 << 20, &nError));
+		TDK_CHECK(kTDK_BAD_ALLOC == nError);
+		TDK_CHECK(1000 == arr.size() && 999 == *arr.at(999));
+	}
+	TDK_CHECK(0 == region.live_bytes());
+}
+
+TDK_TEST(memorypool_region)
+{
+	tdk_memory_region region("pool", 1 << 20);
+	{
+		tdk_memorypool<sizeof(Object32)> pool(region);
+		check_pool_reuse(pool, 1000);
+		TDK_CHECK(region.live_bytes());
+
+		tdk_err nError = kTDK_BAD_SIZE;
+		std::vector<void*> ptrs;
+		void* p = nullptr;
+		while ((p = pool.allocate(&nError)))
+			ptrs.push_back(p);
+		TDK_CHECK(kTDK_BAD_ALLOC == nError);
+		TDK_CHECK(region.live_bytes() <= region.budget());
+		for (void* pNode : ptrs)
+			pool.free(pNode);
+	}
+	TDK_CHECK(0 == region.live_bytes());
+}
+
+} // namespace
@@ -0,0 +1,801 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: unit tests of the arrays, bit sets, spans and strings.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#include "tdktest.h"
+
+#include "base/tdkbitset.h"
+#include "base/tdkconcurrentdarray.h"
+#include "base/tdkdarray.h"
+#include "base/tdkpackedarray.h"
+#include "base/tdkpoddarray.h"
+#include "base/tdkspan.h"
+#include "base/tdkstaticdarray.h"
+#include "base/tdkstring.h"
+#include "system/tdkmappedarray.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <initializer_list>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// tdk_darray
+
+TDK_TEST(darray_push_back)
+{
+	tdk_darray<std::string> arr;
+	TDK_CHECK(0 == arr.size());
+	for (int i = 0; i < 1000; ++i)
+		TDK_CHECK(kTDK_OK == arr.push_back(std::to_string(i)));
+	TDK_CHECK(1000 == arr.size());
+	TDK_CHECK(arr.capacity() >= arr.size());
+	for (int i = 0; i < 1000; ++i)
+		TDK_CHECK(arr.at(i) && std::to_string(i) == *arr.at(i));
+	TDK_CHECK(!arr.at(1000));
+
+	arr.clear();
+	TDK_CHECK(0 == arr.size() && !arr.at(0));
+}
+
+TDK_TEST(darray_move_pop_back)
+{
+	tdk_darray<std::string> arr;
+	TDK_CHECK(arr.empty());
+	for (int i = 0; i < 1000; ++i)
+	{
+		std::string str = std::to_string(i);
+		if (i & 1)
+			TDK_CHECK(kTDK_OK == arr.push_back(std::move(str)));
+		else
+			TDK_CHECK(kTDK_OK == arr.push_back(str));
+	}
+	TDK_CHECK(1000 == arr.size() && "999" == arr[999]);
+
+	arr.pop_back();
+	TDK_CHECK("998" == arr.back());
+	TDK_CHECK(!arr.at(999));
+	TDK_CHECK(arr.at(998) && "998" == *arr.at(998));
+	TDK_CHECK(arr.data() == arr.begin());
+}
+
+TDK_TEST(darray_insert)
+{
+	tdk_darray<std::string> arr;
+	for (int i = 0; i < 10; ++i)
+		arr.push_back(std::to_string(i));
+
+	// in place and with a reallocation
+	TDK_CHECK(kTDK_OK == arr.insert(arr.begin() + 2, std::string("a")));
+	std::string block[] = { "x", "y", "z" };
+	arr.reserve(arr.size());
+	TDK_CHECK(kTDK_OK == arr.insert(arr.begin(), block, block + 3));
+	TDK_CHECK(kTDK_OK == arr.insert(arr.end(), block, block + 1));
+
+	const char* expected[] = { "x", "y", "z", "0", "1", "a", "2", "3", "4", "5",
+		"6", "7", "8", "9", "x" };
+	TDK_CHECK(15 == arr.size());
+	for (tdk_size i = 0; i < arr.size(); ++i)
+		TDK_CHECK(expected[i] == *arr.at(i));
+}
+
+TDK_TEST(darray_grow)
+{
+	tdk_darray<int> arr;
+	TDK_CHECK(kTDK_OK == arr.grow(5));
+	TDK_CHECK(5 == arr.size() && 0 == *arr.at(4));
+	*arr.at(0) = 7;
+	TDK_CHECK(kTDK_OK == arr.reserve(100));
+	TDK_CHECK(100 <= arr.capacity() && 5 == arr.size() && 7 == *arr.at(0));
+}
+
+TDK_TEST(darray_erase_swap)
+{
+	tdk_darray<std::string> arr;
+	for (int i = 0; i < 10; ++i)
+		arr.push_back(std::to_string(i));
+
+	TDK_CHECK(arr.begin() + 1 == arr.erase(arr.begin() + 1, arr.begin() + 5));
+	TDK_CHECK(arr.begin() + 1 == arr.erase(arr.begin() + 1, arr.begin() + 1));
+	arr.erase(arr.end() - 1);
+	const char* left[] = { "0", "5", "6", "7", "8" };
+	TDK_CHECK(5 == arr.size());
+	for (tdk_size i = 0; i < arr.size(); ++i)
+		TDK_CHECK(left[i] == arr[i]);
+
+	tdk_darray<std::string> other;
+	other.push_back(std::string("x"));
+	arr.swap(other);
+	TDK_CHECK(1 == arr.size() && "x" == arr[0]);
+	TDK_CHECK(5 == other.size() && "8" == other.back());
+}
+
+TDK_TEST(darray_push_back_own_element)
+{
+	// the pushed element lives in the buffer the push reallocates
+	tdk_darray<std::string> arr;
+	arr.push_back(std::string(40, 'a'));
+	for (int i = 0; i < 100; ++i)
+	{
+		if (arr.size() == arr.capacity())
+		{
+			TDK_CHECK(kTDK_OK == arr.push_back(arr[0]));
+			TDK_CHECK(std::string(40, 'a') == arr.back());
+		}
+		else
+			arr.push_back(std::string(40, 'b'));
+	}
+	TDK_CHECK(101 == arr.size() && std::string(40, 'a') == arr[0]);
+
+	tdk_darray<std::string> moved;
+	moved.push_back(std::string(40, 'c'));
+	moved.reserve(moved.size());
+	TDK_CHECK(kTDK_OK == moved.push_back(std::move(moved[0])));
+	TDK_CHECK(2 == moved.size() && std::string(40, 'c') == moved[1]);
+}
+
+TDK_TEST(darray_insert_own_elements)
+{
+	// the inserted range lives in the buffer the insert shifts or frees
+	tdk_darray<std::string> arr;
+	for (int i = 0; i < 4; ++i)
+		arr.push_back(std::string(40, char('a' + i)));
+	arr.reserve(arr.size());
+	TDK_CHECK(kTDK_OK == arr.insert(arr.begin(), arr[3]));
+	arr.reserve(arr.size() + 4);
+	TDK_CHECK(kTDK_OK == arr.insert(arr.begin() + 1, arr.begin() + 1,
+		arr.begin() + 4));
+
+	const char expected[] = { 'd', 'a', 'b', 'c', 'a', 'b', 'c', 'd' };
+	TDK_CHECK(8 == arr.size());
+	for (tdk_size i = 0; i < arr.size(); ++i)
+		TDK_CHECK(std::string(40, expected[i]) == arr[i]);
+}
+
+// Copies throw once the budget is spent, moves are not noexcept, so the
+// containers fall back to copies and must keep the old elements on failure.
+struct ThrowingCopy
+{
+	static int s_nCopiesLeft;
+	static int s_nLive;
+
+	explicit ThrowingCopy(int nVal)
+		: nVal(nVal)
+	{
+		++s_nLive;
+	}
+
+	ThrowingCopy(const ThrowingCopy& oth)
+		: nVal(oth.nVal)
+	{
+		if (0 == s_nCopiesLeft--)
+			throw 0;
+		++s_nLive;
+	}
+
+	~ThrowingCopy()
+	{
+		--s_nLive;
+	}
+
+	ThrowingCopy& operator=(const ThrowingCopy&) = default;
+
+	int nVal;
+};
+
+int ThrowingCopy::s_nCopiesLeft = 1 << 30;
+int ThrowingCopy::s_nLive = 0;
+
+// The same with a noexcept move, so the containers shift it in place.
+struct MovableThrowingCopy : ThrowingCopy
+{
+	using ThrowingCopy::ThrowingCopy;
+
+	MovableThrowingCopy(const MovableThrowingCopy&) = default;
+
+	MovableThrowingCopy(MovableThrowingCopy&& oth) noexcept
+		: ThrowingCopy(oth.nVal)
+	{
+	}
+
+	MovableThrowingCopy& operator=(const MovableThrowingCopy&) = default;
+};
+
+// Runs fn with nCopies copies allowed and tells if it threw.
+template<typename Fn>
+bool throws_after_copies(int nCopies, Fn fn)
+{
+	ThrowingCopy::s_nCopiesLeft = nCopies;
+	bool bThrown = false;
+	try
+	{
+		fn();
+	}
+	catch (int)
+	{
+		bThrown = true;
+	}
+	ThrowingCopy::s_nCopiesLeft = 1 << 30;
+	return bThrown;
+}
+
+template<typename Array>
+bool has_values(const Array& arr, std::initializer_list<int> values)
+{
+	if (arr.size() != values.size())
+		return false;
+	return std::equal(values.begin(), values.end(), arr.begin(),
+		[](int nVal, const ThrowingCopy& elem) { return nVal == elem.nVal; });
+}
+
+TDK_TEST(darray_insert_throwing_copy)
+{
+	{
+		tdk_darray<ThrowingCopy> arr;
+		for (int i = 0; i < 4; ++i)
+			arr.push_back(ThrowingCopy(i));
+		arr.reserve(arr.size());
+
+		// the reallocation copies 0 and 1, then throws on 2
+		ThrowingCopy::s_nCopiesLeft = 2;
+		ThrowingCopy value(9);
+		bool bThrown = false;
+		try
+		{
+			arr.insert(arr.begin() + 2, value);
+		}
+		catch (int)
+		{
+			bThrown = true;
+		}
+		ThrowingCopy::s_nCopiesLeft = 1 << 30;
+
+		TDK_CHECK(bThrown);
+		TDK_CHECK(4 == arr.size() && 4 == arr.capacity());
+		TDK_CHECK(0 == arr[0].nVal && 3 == arr[3].nVal);
+		TDK_CHECK(5 == ThrowingCopy::s_nLive);
+	}
+	TDK_CHECK(0 == ThrowingCopy::s_nLive);
+}
+
+TDK_TEST(darray_insert_in_place_throwing_copy)
+{
+	{
+		// with room to spare a throwing move still goes to a new buffer
+		tdk_darray<ThrowingCopy> arr;
+		for (int i = 0; i < 4; ++i)
+			arr.push_back(ThrowingCopy(i));
+		arr.reserve(8);
+		ThrowingCopy value(9);
+		TDK_CHECK(throws_after_copies(2,
+			[&] { arr.insert(arr.begin() + 1, value); }));
+		TDK_CHECK(has_values(arr, { 0, 1, 2, 3 }) && 8 == arr.capacity());
+		TDK_CHECK(5 == ThrowingCopy::s_nLive);
+
+		arr.erase(arr.begin() + 1);
+		TDK_CHECK(has_values(arr, { 0, 2, 3 }));
+		TDK_CHECK(4 == ThrowingCopy::s_nLive);
+	}
+	TDK_CHECK(0 == ThrowingCopy::s_nLive);
+
+	{
+		// a noexcept move shifts in place and the tail comes back on a throw
+		tdk_darray<MovableThrowingCopy> arr;
+		for (int i = 0; i < 4; ++i)
+			arr.push_back(MovableThrowingCopy(i));
+		arr.reserve(8);
+		MovableThrowingCopy block[] = { MovableThrowingCopy(7), MovableThrowingCopy(8) };
+		TDK_CHECK(throws_after_copies(1,
+			[&] { arr.insert(arr.begin() + 1, block, block + 2); }));
+		TDK_CHECK(has_values(arr, { 0, 1, 2, 3 }) && 8 == arr.capacity());
+		TDK_CHECK(6 == ThrowingCopy::s_nLive);
+
+		TDK_CHECK(kTDK_OK == arr.insert(arr.begin() + 1, block, block + 2));
+		TDK_CHECK(has_values(arr, { 0, 7, 8, 1, 2, 3 }));
+	}
+	TDK_CHECK(0 == ThrowingCopy::s_nLive);
+}
+
+//-----------------------------------------------------------------------------
+// tdk_podarray
+
+TDK_TEST(podarray_basic)
+{
+	tdk_podarray<int> arr;
+	for (int i = 0; i < 1000; ++i)
+		TDK_CHECK(kTDK_OK == arr.push_back(i));
+	TDK_CHECK(1000 == arr.size());
+
+	TDK_CHECK(kTDK_OK == arr.insert(arr.begin(), -1));
+	int block[] = { 10, 11, 12 };
+	TDK_CHECK(kTDK_OK == arr.insert(arr.begin() + 1, block, block + 3));
+	TDK_CHECK(1004 == arr.size());
+	TDK_CHECK(-1 == arr[0] && 10 == arr[1] && 12 == arr[3] && 0 == arr[4]);
+
+	arr.erase(arr.begin(), arr.begin() + 4);
+	TDK_CHECK(1000 == arr.size() && 0 == arr[0] && 999 == arr.back());
+
+	tdk_podarray<int> copy(arr);
+	TDK_CHECK(copy.size() == arr.size() && 500 == copy[500]);
+
+	TDK_CHECK(kTDK_OK == arr.resize(1010, 5));
+	TDK_CHECK(5 == arr[1009]);
+	TDK_CHECK(kTDK_OK == arr.resize(10));
+	TDK_CHECK(10 == arr.size());
+	TDK_CHECK(kTDK_OK == arr.shrink_to_fit());
+	TDK_CHECK(10 == arr.capacity() && 9 == arr.back());
+}
+
+TDK_TEST(podarray_search)
+{
+	tdk_podarray<int> arr;
+	for (int i = 0; i < 1000; ++i)
+		arr.push_back(i * 2);
+
+	TDK_CHECK(250 == arr.find(500));
+	TDK_CHECK(arr.size() == arr.find(501));
+	TDK_CHECK(arr.size() == arr.find(500, 251));
+	TDK_CHECK(1 == arr.count(500));
+	TDK_CHECK(250 == arr.lower_bound(500));
+	TDK_CHECK(251 == arr.lower_bound(501));
+	TDK_CHECK(arr.size() == arr.lower_bound(5000));
+
+	tdk_podarray<tdk_size> indices;
+	*arr.at(10) = 500;
+	TDK_CHECK(kTDK_OK == arr.find_all(500, indices));
+	TDK_CHECK(2 == indices.size() && 10 == *indices.at(0) && 250 == *indices.at(1));
+}
+
+TDK_TEST(podarray_max_size)
+{
+	tdk_podarray<tdk_u32> arr;
+	arr.push_back(1);
+
+	tdk_err nError = kTDK_BAD_ALLOC;
+	TDK_CHECK(kTDK_FATAL == arr.reserve(arr.max_size() + 1, &nError));
+	TDK_CHECK(kTDK_BAD_SIZE == nError);
+	nError = kTDK_BAD_ALLOC;
+	TDK_CHECK(kTDK_FATAL == arr.resize_uninitialized(arr.max_size() + 1, &nError));
+	TDK_CHECK(kTDK_BAD_SIZE == nError);
+
+	// the capacity doubling stops at max_size(), the allocation fails
+	nError = kTDK_BAD_SIZE;
+	TDK_CHECK(kTDK_FATAL == arr.resize_uninitialized(arr.max_size() - 1, &nError));
+	TDK_CHECK(kTDK_BAD_ALLOC == nError);
+	TDK_CHECK(1 == arr.size() && 1 == arr[0]);
+}
+
+TDK_TEST(podarray_byte_max_size)
+{
+	// doubling a byte capacity past max_size() would wrap around to 0
+	tdk_podarray<char> arr;
+	arr.push_back('a');
+	tdk_err nError = kTDK_BAD_SIZE;
+	TDK_CHECK(kTDK_FATAL == arr.resize_uninitialized(arr.max_size() - 1, &nError));
+	TDK_CHECK(kTDK_BAD_ALLOC == nError);
+	TDK_CHECK(1 == arr.size());
+}
+
+//-----------------------------------------------------------------------------
+// tdk_static_darray
+
+TDK_TEST(static_darray)
+{
+	tdk_static_darray<std::string, 8> arr;
+	TDK_CHECK(8 == arr.capacity());
+	for (int i = 0; i < 6; ++i)
+		TDK_CHECK(kTDK_OK == arr.push_back(std::to_string(i)));
+
+	TDK_CHECK(kTDK_OK == arr.insert(arr.begin(), std::string("a")));
+	TDK_CHECK("a" == arr.front() && "5" == arr.back());
+	arr.erase(arr.begin() + 1, arr.begin() + 3);
+	TDK_CHECK(5 == arr.size());
+	TDK_CHECK("a" == arr[0] && "2" == arr[1] && "5" == arr[4]);
+	TDK_CHECK(arr.begin() + 1 == arr.erase(arr.begin() + 1, arr.begin() + 1));
+	TDK_CHECK(5 == arr.size() && "2" == arr[1] && "5" == arr[4]);
+
+	TDK_CHECK(kTDK_OK == arr.resize(8));
+	TDK_CHECK(arr.full() && arr[7].empty());
+
+	tdk_err nError = kTDK_BAD_ALLOC;
+	TDK_CHECK(kTDK_OK != arr.push_back("x", &nError));
+	TDK_CHECK(kTDK_BAD_SIZE == nError);
+	TDK_CHECK(kTDK_OK != arr.reserve(9));
+	TDK_CHECK(8 == arr.size());
+
+	arr.pop_back();
+	TDK_CHECK(!arr.at(7) && arr.at(6));
+	arr.clear();
+	TDK_CHECK(arr.empty());
+}
+
+TDK_TEST(static_darray_trivial)
+{
+	tdk_static_darray<int, 4> arr;
+	TDK_CHECK(kTDK_OK == arr.grow(2));
+	TDK_CHECK(0 == arr[0] && 0 == arr[1]);
+	int block[] = { 1, 2 };
+	TDK_CHECK(kTDK_OK == arr.insert(arr.begin() + 1, block, block + 2));
+	TDK_CHECK(0 == arr[0] && 1 == arr[1] && 2 == arr[2] && 0 == arr[3]);
+	TDK_CHECK(kTDK_OK != arr.grow());
+}
+
+// Builds { 0, 7, 8, 3, 0 } at compile time.
+constexpr tdk_static_darray<int, 8> make_static_darray()
+{
+	tdk_static_darray<int, 8> arr;
+	for (int i = 0; i < 4; ++i)
+		arr.push_back(i);
+	int block[] = { 7, 8 };
+	arr.insert(arr.begin() + 1, block, block + 2);
+	arr.erase(arr.begin() + 3, arr.begin() + 5);
+	arr.insert(arr.begin(), 0);
+	arr.erase(arr.begin() + 1);
+	arr.resize(5);
+	return arr;
+}
+
+static_assert(5 == make_static_darray().size());
+static_assert(7 == make_static_darray()[1] && 8 == make_static_darray()[2]);
+static_assert(3 == make_static_darray()[3] && 0 == make_static_darray().back());
+
+TDK_TEST(static_darray_insert_throwing_copy)
+{
+	{
+		tdk_static_darray<ThrowingCopy, 8> arr;
+		for (int i = 0; i < 4; ++i)
+			arr.push_back(ThrowingCopy(i));
+		ThrowingCopy block[] = { ThrowingCopy(7), ThrowingCopy(8) };
+
+		// the tail grows by one slot, then the next move throws
+		TDK_CHECK(throws_after_copies(1,
+			[&] { arr.insert(arr.begin() + 1, block, block + 2); }));
+		TDK_CHECK(5 == arr.size() && 7 == ThrowingCopy::s_nLive);
+		arr.pop_back();
+		TDK_CHECK(has_values(arr, { 0, 1, 2, 3 }));
+
+		TDK_CHECK(kTDK_OK == arr.insert(arr.begin() + 1, block, block + 2));
+		TDK_CHECK(has_values(arr, { 0, 7, 8, 1, 2, 3 }));
+		TDK_CHECK(kTDK_OK == arr.insert(arr.begin() + 5, block, block + 2));
+		TDK_CHECK(has_values(arr, { 0, 7, 8, 1, 2, 7, 8, 3 }));
+	}
+	TDK_CHECK(0 == ThrowingCopy::s_nLive);
+
+	{
+		tdk_static_darray<MovableThrowingCopy, 8> arr;
+		for (int i = 0; i < 4; ++i)
+			arr.push_back(MovableThrowingCopy(i));
+		MovableThrowingCopy block[] = { MovableThrowingCopy(7), MovableThrowingCopy(8) };
+		TDK_CHECK(throws_after_copies(1,
+			[&] { arr.insert(arr.begin() + 1, block, block + 2); }));
+		TDK_CHECK(has_values(arr, { 0, 1, 2, 3 }));
+		TDK_CHECK(6 == ThrowingCopy::s_nLive);
+	}
+	TDK_CHECK(0 == ThrowingCopy::s_nLive);
+}
+
+//-----------------------------------------------------------------------------
+// tdk_mapped_podarray
+
+TDK_TEST(mapped_podarray)
+{
+	const char* szPath = "tdk_test_mapped.bin";
+	std::remove(szPath);
+	{
+		tdk_mapped_podarray<tdk_u64> arr;
+		TDK_CHECK(kTDK_OK == arr.open_write(szPath, 3, kTDK_MAPPED_CHECKSUM));
+		for (tdk_u64 i = 0; i < 100000; ++i)
+			TDK_CHECK(kTDK_OK == arr.push_back(i * i));
+		tdk_u64 tail[] = { 1, 2, 3 };
+		TDK_CHECK(kTDK_OK == arr.append(tail, 3));
+		TDK_CHECK(kTDK_OK == arr.close());
+	}
+	{
+		tdk_mapped_podarray<tdk_u64> arr;
+		TDK_CHECK(kTDK_OK == arr.open_read(szPath, 3, kTDK_MAPPED_CHECKSUM));
+		TDK_CHECK(100003 == arr.size());
+		TDK_CHECK(99999ull * 99999ull == arr.data()[99999]);
+		TDK_CHECK(3 == arr.data()[100002]);
+	}
+	{
+		// another element type or user version does not open
+		tdk_mapped_podarray<tdk_u32> arr32;
+		tdk_err nError = kTDK_BAD_ALLOC;
+		TDK_CHECK(kTDK_OK != arr32.open_read(szPath, 3, 0, &nError));
+		TDK_CHECK(kTDK_BAD_FORMAT == nError);
+
+		tdk_mapped_podarray<tdk_u64> arr;
+		TDK_CHECK(kTDK_OK != arr.open_read(szPath, 4));
+		TDK_CHECK(kTDK_OK == arr.open_write(szPath, 3, kTDK_MAPPED_TRUNCATE));
+		TDK_CHECK(0 == arr.size());
+	}
+	std::remove(szPath);
+}
+
+//-----------------------------------------------------------------------------
+// tdk_concurrent_darray
+
+TDK_TEST(concurrent_darray)
+{
+	enum Constants { kTHREADS = 4, kPER_THREAD = 10000 };
+
+	tdk_concurrent_darray<tdk_u32> arr;
+	std::vector<std::thread> threads;
+	for (tdk_u32 t = 0; t < kTHREADS; ++t)
+	{
+		threads.emplace_back([&arr, t]()
+		{
+			tdk_u32 batch[4];
+			for (tdk_u32 i = 0; i < kPER_THREAD; i += 4)
+			{
+				for (tdk_u32 k = 0; k < 4; ++k)
+					batch[k] = t * kPER_THREAD + i + k;
+				if (i % 8)
+					arr.append(batch, 4);
+				else
+					for (tdk_u32 k = 0; k < 4; ++k)
+						arr.push_back(batch[k]);
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+		thread.join();
+
+	TDK_CHECK(kTHREADS * kPER_THREAD == arr.size());
+	tdk_bitset<> seen;
+	seen.resize(arr.size());
+	for (tdk_size i = 0; i < arr.size(); ++i)
+		seen.set(arr[i]);
+	TDK_CHECK(arr.size() == seen.count());
+
+	TDK_CHECK(kTDK_OK == arr.seal());
+	TDK_CHECK(arr.is_contiguous());
+	TDK_CHECK(arr.size() == arr.span().size());
+	TDK_CHECK(arr.data()[5] == arr[5]);
+
+	arr.clear();
+	TDK_CHECK(arr.empty());
+	TDK_CHECK(kTDK_OK == arr.push_back(1));
+	TDK_CHECK(1 == arr[0]);
+}
+
+//-----------------------------------------------------------------------------
+// Bit set
+
+TDK_TEST(bitset)
+{
+	tdk_bitset<> bits;
+	TDK_CHECK(kTDK_OK == bits.resize(200));
+	TDK_CHECK(bits.none() && bits.size() == bits.find_first());
+	bits.set(3);
+	bits.set(64);
+	bits.set(199);
+	TDK_CHECK(3 == bits.count());
+	TDK_CHECK(3 == bits.find_first() && 64 == bits.find_next(3));
+	TDK_CHECK(199 == bits.find_next(64) && 200 == bits.find_next(199));
+
+	tdk_bitset<> other;
+	other.resize(200);
+	other.set(64);
+	other.set(100);
+	TDK_CHECK(1 == bits.count_and(other));
+
+	tdk_bitset<> both(bits);
+	both &= other;
+	TDK_CHECK(1 == both.count() && both.test(64));
+	bits.and_not(other);
+	TDK_CHECK(2 == bits.count() && !bits.test(64));
+
+	bits.flip_all();
+	TDK_CHECK(198 == bits.count());
+	bits.set_all();
+	TDK_CHECK(200 == bits.count());
+
+	// growing fills with the given value, the tail stays clear
+	TDK_CHECK(kTDK_OK == bits.resize(300, false));
+	TDK_CHECK(200 == bits.count());
+	tdk_size nSum = 0;
+	other.for_each_set([&nSum](tdk_size nPos) { nSum += nPos; });
+	TDK_CHECK(164 == nSum);
+}
+
+//-----------------------------------------------------------------------------
+// Packed arrays
+
+TDK_TEST(packed_array)
+{
+	tdk_packed_array arr;
+	for (tdk_u32 i = 0; i < 1000; ++i)
+		TDK_CHECK(kTDK_OK == arr.push_back(i % 7));
+	TDK_CHECK(3 == arr.bit_width());
+	TDK_CHECK(kTDK_OK == arr.set(500, 100000));
+	TDK_CHECK(17 == arr.bit_width());
+	for (tdk_u32 i = 0; i < 1000; ++i)
+		TDK_CHECK((500 == i ? 100000 : i % 7) == arr[i]);
+
+	tdk_u32 out[4];
+	arr.unpack(498, 4, out);
+	TDK_CHECK(498 % 7 == out[0] && 100000 == out[2]);
+
+	TDK_CHECK(kTDK_OK == arr.resize(1200));
+	TDK_CHECK(0 == arr[1100]);
+
+	// shrinking clears the dropped values, growing again finds zeros
+	TDK_CHECK(kTDK_OK == arr.resize(499));
+	TDK_CHECK(kTDK_OK == arr.resize(1000));
+	bool bZero = 498 % 7 == arr[498];
+	for (tdk_u32 i = 499; i < 1000; ++i)
+		bZero = bZero && 0 == arr[i];
+	TDK_CHECK(bZero);
+
+	tdk_u32 values[] = { 5, 1, 300 };
+	TDK_CHECK(kTDK_OK == arr.assign(values, 3));
+	TDK_CHECK(3 == arr.size() && 9 == arr.bit_width() && 300 == arr[2]);
+}
+
+TDK_TEST(packed_delta_array)
+{
+	tdk_podarray<tdk_u32> ids;
+	tdk_u32 nId = 1000;
+	for (tdk_u32 i = 0; i < 5000; ++i)
+	{
+		nId += i % 13 + (i == 3000 ? 1000000 : 0);
+		ids.push_back(nId);
+	}
+
+	tdk_packed_delta_array packed;
+	TDK_CHECK(kTDK_OK == packed.build(ids.data(), ids.size()));
+	TDK_CHECK(ids.size() == packed.size());
+	TDK_CHECK(packed.byte_size() < ids.size() * sizeof(tdk_u32));
+
+	tdk_podarray<tdk_u32> out;
+	out.resize(ids.size());
+	packed.decode(0, packed.size(), out.data());
+	bool bSame = true;
+	for (tdk_size i = 0; i < ids.size(); ++i)
+		bSame = bSame && ids[i] == out[i];
+	TDK_CHECK(bSame);
+
+	packed.decode(2999, 3, out.data());
+	TDK_CHECK(ids[2999] == out[0] && ids[3001] == out[2]);
+
+	// unsorted blocks are stored without deltas
+	tdk_u32 unsorted[] = { 500, 4, 70000, 0, 9 };
+	TDK_CHECK(kTDK_OK == packed.build(unsorted, 5));
+	TDK_CHECK(5 == packed.size());
+	for (tdk_size i = 0; i < 5; ++i)
+		TDK_CHECK(unsorted[i] == packed[i]);
+}
+
+//-----------------------------------------------------------------------------
+// Spans
+
+struct Particle
+{
+	float x;
+	float y;
+	int nId;
+};
+
+TDK_TEST(span)
+{
+	int values[] = { 1, 2, 3, 4, 5 };
+	tdk_span span(values);
+	TDK_CHECK(5 == span.size() && 5 * sizeof(int) == span.size_bytes());
+	TDK_CHECK(2 == span.first(2).size() && 2 == span.first(2).back());
+	TDK_CHECK(4 == span.last(2).front());
+	TDK_CHECK(3 == span.subspan(2).size() && 3 == span.subspan(2)[0]);
+	TDK_CHECK(1 == span.subspan(1, 1).size());
+	TDK_CHECK(span.size_bytes() == tdk_as_bytes(span).size());
+
+	// a literal 0 is a count, not a null end pointer
+	TDK_CHECK(0 == tdk_span<int>(values, 0).size());
+	TDK_CHECK(3 == tdk_span<int>(values + 1, values + 4).size());
+
+	tdk_podarray<int> arr;
+	arr.push_back(7);
+	tdk_span<const int> arrSpan(arr);
+	TDK_CHECK(1 == arrSpan.size() && arr.data() == arrSpan.data());
+}
+
+TDK_TEST(strided_span)
+{
+	Particle particles[4] = { { 0, 0, 10 }, { 0, 0, 11 }, { 0, 0, 12 }, { 0, 0, 13 } };
+	auto ids = tdk_member_span(particles, &Particle::nId);
+	TDK_CHECK(4 == ids.size() && !ids.is_contiguous());
+	TDK_CHECK(10 == ids.front() && 13 == ids.back());
+
+	int nSum = 0;
+	for (int nId : ids)
+		nSum += nId;
+	TDK_CHECK(46 == nSum);
+
+	TDK_CHECK(12 == ids.step(2)[1]);
+	TDK_CHECK(13 == ids.reversed()[0]);
+	TDK_CHECK(11 == ids.subspan(1, 2).front());
+
+	int values[] = { 1, 2, 3 };
+	tdk_strided_span<int> dense(tdk_span<int>(values, 3));
+	TDK_CHECK(dense.is_contiguous() && 3 == dense.as_span().size());
+}
+
+//-----------------------------------------------------------------------------
+// tdk_string
+
+TDK_TEST(string_inline_and_heap)
+{
+	tdk_string str;
+	TDK_CHECK(str.empty() && str.is_inline() && 0 == *str.c_str());
+
+	str.assign("short");
+	TDK_CHECK(str.is_inline() && "short" == str && 5 == str.size());
+
+	std::string longStr(100, 'a');
+	TDK_CHECK(kTDK_OK == str.append(longStr));
+	TDK_CHECK(!str.is_inline() && 105 == str.size());
+	TDK_CHECK(0 == str.c_str()[str.size()]);
+
+	tdk_string copy(str);
+	TDK_CHECK(copy == str && copy.data() != str.data());
+	tdk_string moved(std::move(copy));
+	TDK_CHECK(moved == str);
+
+	TDK_CHECK(kTDK_OK == str.resize(3));
+	TDK_CHECK("sho" == str);
+	TDK_CHECK(kTDK_OK == str.push_back('!'));
+	TDK_CHECK("sho!" == str && '!' == str.back());
+	str.pop_back();
+	TDK_CHECK(tdk_string("sho") == str && tdk_string("abc") < str);
+
+	str.clear();
+	TDK_CHECK(str.empty());
+}
+
+} // namespace
@@ -0,0 +1,461 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: unit tests of the maps, sets and lists.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#include "tdktest.h"
+
+#include "base/tdkflatmap.h"
+#include "base/tdkhashmap.h"
+#include "base/tdklist.h"
+#include "base/tdkmap.h"
+#include "base/tdkslotmap.h"
+#include "base/tdksparseset.h"
+#include "base/tdkstringpool.h"
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+// Fixed pseudo-random sequence, so every run checks the same keys.
+class Lcg
+{
+public:
+	tdk_u32 next()
+	{
+		m_nState = m_nState * 1664525u + 1013904223u;
+		return m_nState >> 8;
+	}
+
+private:
+	tdk_u32 m_nState{ 12345 };
+};
+
+//-----------------------------------------------------------------------------
+// tdk_hashmap
+
+TDK_TEST(hashmap_insert_find_erase)
+{
+	tdk_hashmap<tdk_u32, tdk_u32> map;
+	std::map<tdk_u32, tdk_u32> model;
+	Lcg rng;
+	for (tdk_u32 i = 0; i < 20000; ++i)
+	{
+		tdk_u32 nKey = rng.next() % 5000;
+		bool bNew = model.emplace(nKey, i).second;
+		TDK_CHECK((bNew ? kTDK_OK : kTDK_NO) == map.insert(nKey, i));
+		if (0 == i % 3)
+		{
+			TDK_CHECK((model.erase(nKey + 1) ? kTDK_OK : kTDK_NO) ==
+				map.erase(nKey + 1));
+		}
+	}
+
+	TDK_CHECK(model.size() == map.size());
+	TDK_CHECK(map.capacity() >= map.size());
+	for (const auto& item : model)
+	{
+		const tdk_u32* pVal = map.at(item.first);
+		TDK_CHECK(pVal && *pVal == item.second);
+	}
+
+	tdk_size nVisited = 0;
+	for (const auto& slot : map)
+	{
+		++nVisited;
+		TDK_CHECK(model[slot.first] == slot.second);
+	}
+	TDK_CHECK(model.size() == nVisited);
+
+	TDK_CHECK(!map.contains(5001));
+	TDK_CHECK(map.end() == map.find(5001));
+}
+
+TDK_TEST(hashmap_assign_and_copy)
+{
+	tdk_hashmap<std::string, int> map;
+	TDK_CHECK(kTDK_OK == map.reserve(100));
+	TDK_CHECK(kTDK_OK == map.insert_or_assign(std::string("a"), 1));
+	TDK_CHECK(kTDK_NO == map.insert_or_assign(std::string("a"), 2));
+	TDK_CHECK(2 == *map.at("a"));
+
+	int* pVal = map.find_or_insert(std::string("b"));
+	TDK_CHECK(pVal && 0 == *pVal);
+	*pVal = 5;
+
+	tdk_hashmap<std::string, int> copy(map);
+	TDK_CHECK(2 == copy.size() && 5 == *copy.at("b"));
+
+	TDK_CHECK(map.find("a") != map.end());
+	std::string erased = map.cbegin()->first;
+	map.erase(map.cbegin());
+	TDK_CHECK(1 == map.size() && !map.contains(erased));
+	map.clear();
+	TDK_CHECK(map.empty() && 2 == copy.size());
+}
+
+//-----------------------------------------------------------------------------
+// tdk_map
+
+TDK_TEST(map_ordered)
+{
+	tdk_map<tdk_u32, tdk_u32> map;
+	std::map<tdk_u32, tdk_u32> model;
+	Lcg rng;
+	for (tdk_u32 i = 0; i < 20000; ++i)
+	{
+		tdk_u32 nKey = rng.next() % 5000;
+		if (i % 4)
+		{
+			bool bNew = model.emplace(nKey, i).second;
+			TDK_CHECK((bNew ? kTDK_OK : kTDK_NO) == map.insert(nKey, i));
+		}
+		else
+		{
+			TDK_CHECK((model.erase(nKey) ? kTDK_OK : kTDK_NO) == map.erase(nKey));
+		}
+	}
+
+	TDK_CHECK(model.size() == map.size());
+	auto modelIt = model.begin();
+	bool bSame = true;
+	for (const auto& item : map)
+	{
+		bSame = bSame && modelIt != model.end() &&
+			modelIt->first == item.first && modelIt->second == item.second;
+		++modelIt;
+	}
+	TDK_CHECK(bSame && model.end() == modelIt);
+
+	for (tdk_u32 nKey : { 0u, 77u, 2500u, 4999u, 6000u })
+	{
+		auto lower = model.lower_bound(nKey);
+		auto it = map.lower_bound(nKey);
+		TDK_CHECK((model.end() == lower) == (map.end() == it));
+		if (model.end() != lower && map.end() != it)
+			TDK_CHECK(lower->first == it->first);
+
+		auto upper = model.upper_bound(nKey);
+		it = map.upper_bound(nKey);
+		TDK_CHECK((model.end() == upper) == (map.end() == it));
+		if (model.end() != upper && map.end() != it)
+			TDK_CHECK(upper->first == it->first);
+	}
+}
+
+TDK_TEST(map_erase_iterator)
+{
+	tdk_map<int, std::string> map;
+	for (int i = 0; i < 100; ++i)
+		map.insert(i, std::to_string(i));
+	TDK_CHECK(kTDK_NO == map.insert_or_assign(5, std::string("five")));
+	TDK_CHECK("five" == *map.at(5));
+	TDK_CHECK(map.find_or_insert(200) && 101 == map.size());
+
+	// erase every even key through iterators
+	for (auto it = map.begin(); it != map.end();)
+		it = 0 == it->first % 2 ? map.erase(it) : ++it;
+	TDK_CHECK(50 == map.size());
+	TDK_CHECK(!map.contains(4) && map.contains(5));
+	TDK_CHECK(1 == map.begin()->first);
+
+	tdk_map<int, std::string> copy(map);
+	map.clear();
+	TDK_CHECK(map.empty() && 50 == copy.size() && "99" == *copy.at(99));
+}
+
+//-----------------------------------------------------------------------------
+// tdk_list
+
+TDK_TEST(list)
+{
+	tdk_list<std::string> list;
+	TDK_CHECK(kTDK_OK == list.push_back(std::string("b")));
+	TDK_CHECK(kTDK_OK == list.push_front(std::string("a")));
+	TDK_CHECK(kTDK_OK == list.push_back(std::string("d")));
+	auto it = list.insert(--list.end(), std::string("c"));
+	TDK_CHECK("c" == *it);
+	TDK_CHECK(4 == list.size());
+
+	std::string joined;
+	for (const std::string& str : list)
+		joined += str;
+	TDK_CHECK("abcd" == joined);
+
+	// move "a" to the end
+	list.splice(list.end(), list.begin());
+	TDK_CHECK("b" == list.front() && "a" == list.back());
+
+	list.erase(list.begin());
+	list.pop_back();
+	TDK_CHECK(2 == list.size() && "c" == list.front() && "d" == list.back());
+
+	tdk_list<std::string> copy(list);
+	list.pop_front();
+	TDK_CHECK(1 == list.size() && 2 == copy.size() && "c" == copy.front());
+	list.clear();
+	TDK_CHECK(list.empty());
+}
+
+//-----------------------------------------------------------------------------
+// tdk_flat_map, tdk_flat_set
+
+TDK_TEST(flat_map)
+{
+	tdk_flat_map<int, std::string> map;
+	TDK_CHECK(kTDK_OK == map.insert(3, "c"));
+	TDK_CHECK(kTDK_OK == map.insert(1, "a"));
+	TDK_CHECK(kTDK_NO == map.insert(3, "x"));
+	TDK_CHECK(kTDK_NO == map.insert_or_assign(3, "cc"));
+	TDK_CHECK(2 == map.size() && "cc" == *map.at(3));
+	TDK_CHECK(1 == map.keys()[0] && 3 == map.keys()[1]);
+
+	std::pair<int, std::string> items[] = { { 2, "b" }, { 5, "e" }, { 1, "z" } };
+	TDK_CHECK(kTDK_OK == map.merge(items, items + 3));
+	TDK_CHECK(4 == map.size() && "z" == *map.at(1) && "e" == map.value_at(3));
+
+	TDK_CHECK(kTDK_OK == map.erase(2));
+	TDK_CHECK(kTDK_NO == map.erase(2));
+	TDK_CHECK(map.size() == map.index_of(2) && 1 == map.lower_index(2));
+
+	std::pair<int, std::string> built[] = { { 9, "i" }, { 7, "g" }, { 9, "j" } };
+	TDK_CHECK(kTDK_OK == map.build(built, built + 3));
+	TDK_CHECK(2 == map.size() && "j" == *map.at(9) && !map.contains(1));
+}
+
+TDK_TEST(flat_map_insert_own_value)
+{
+	tdk_flat_map<int, std::string> map;
+	TDK_CHECK(kTDK_OK == map.insert(1, std::string(40, 'a')));
+	for (int i = 2; i < 40; ++i)
+		TDK_CHECK(kTDK_OK == map.insert(i, map.value_at(0)));
+	TDK_CHECK(kTDK_OK == map.insert(0, map.value_at(20)));
+
+	bool bSame = 40 == map.size();
+	for (tdk_size i = 0; i < map.size(); ++i)
+		bSame = bSame && std::string(40, 'a') == map.value_at(i);
+	TDK_CHECK(bSame);
+}
+
+TDK_TEST(flat_set)
+{
+	tdk_flat_set<int> set;
+	int keys[] = { 5, 1, 9, 1, 3 };
+	TDK_CHECK(kTDK_OK == set.build(keys, keys + 5));
+	TDK_CHECK(4 == set.size() && 1 == set.data()[0] && 9 == set.data()[3]);
+	TDK_CHECK(kTDK_OK == set.insert(4));
+	TDK_CHECK(kTDK_NO == set.insert(4));
+	TDK_CHECK(set.contains(4) && 2 == set.index_of(4));
+
+	int more[] = { 0, 10 };
+	TDK_CHECK(kTDK_OK == set.merge(more, more + 2));
+	TDK_CHECK(7 == set.size() && 0 == *set.begin() && 10 == *(set.end() - 1));
+	TDK_CHECK(kTDK_OK == set.erase(0) && kTDK_NO == set.erase(0));
+}
+
+struct DirectionLess
+{
+	bool operator()(int a, int b) const
+	{
+		return bDescending ? b < a : a < b;
+	}
+
+	bool bDescending{};
+};
+
+TDK_TEST(flat_set_stateful_less)
+{
+	// build() and merge() sort with the set's comparator, not a default one
+	tdk_flat_set<int, DirectionLess> set(DirectionLess{ true });
+	int keys[] = { 5, 1, 9 };
+	TDK_CHECK(kTDK_OK == set.build(keys, keys + 3));
+	TDK_CHECK(9 == set.data()[0] && 1 == set.data()[2]);
+
+	int more[] = { 0, 10 };
+	TDK_CHECK(kTDK_OK == set.merge(more, more + 2));
+	TDK_CHECK(5 == set.size() && 10 == *set.begin() && 0 == *(set.end() - 1));
+	TDK_CHECK(set.contains(5));
+}
+
+//-----------------------------------------------------------------------------
+// tdk_slot_map
+
+TDK_TEST(slot_map)
+{
+	tdk_slot_map<std::string> map;
+	tdk_slot_handle64 a, b, c;
+	TDK_CHECK(a.is_null());
+	TDK_CHECK(kTDK_OK == map.insert(std::string("a"), a));
+	TDK_CHECK(kTDK_OK == map.insert(std::string("b"), b));
+	TDK_CHECK(kTDK_OK == map.insert(std::string("c"), c));
+	TDK_CHECK(3 == map.size() && "b" == *map.at(b));
+
+	// the last element fills the hole, its handle stays valid
+	TDK_CHECK(kTDK_OK == map.erase(a));
+	TDK_CHECK(kTDK_NO == map.erase(a));
+	TDK_CHECK(!map.contains(a) && !map.at(a));
+	TDK_CHECK("c" == *map.at(c) && 2 == map.size());
+	TDK_CHECK(c.index() == map.handle_at(0).index());
+
+	// a reused slot gets a new generation
+	tdk_slot_handle64 d;
+	TDK_CHECK(kTDK_OK == map.insert(std::string("d"), d));
+	TDK_CHECK(d.index() == a.index() && d.generation() != a.generation());
+	TDK_CHECK(!map.contains(a) && "d" == *map.at(d));
+
+	std::string joined;
+	for (const std::string& str : map)
+		joined += str;
+	TDK_CHECK(3 == joined.size());
+
+	map.clear();
+	TDK_CHECK(map.empty() && !map.contains(b));
+}
+
+TDK_TEST(slot_map_handle32)
+{
+	tdk_slot_map<int, tdk_slot_handle32> map;
+	TDK_CHECK(kTDK_OK == map.reserve(1000));
+	std::vector<tdk_slot_handle32> handles(1000);
+	for (int i = 0; i < 1000; ++i)
+		TDK_CHECK(kTDK_OK == map.insert(i, handles[i]));
+	for (int i = 0; i < 1000; i += 2)
+		map.erase(handles[i]);
+	bool bSame = true;
+	for (int i = 1; i < 1000; i += 2)
+		bSame = bSame && map.at(handles[i]) && i == *map.at(handles[i]);
+	TDK_CHECK(bSame && 500 == map.size());
+}
+
+TDK_TEST(slot_map_generation_cap)
+{
+	// a slot whose generations run out is retired, not wrapped around
+	tdk_slot_map<int, tdk_slot_handle32> map;
+	tdk_slot_handle32 first;
+	TDK_CHECK(kTDK_OK == map.insert(0, first));
+	tdk_slot_handle32 handle = first;
+	int nCycles = 0;
+	bool bStale = false;
+	while (0 == handle.index() && nCycles < 10000)
+	{
+		TDK_CHECK(kTDK_OK == map.erase(handle));
+		bStale = bStale || map.contains(first);
+		TDK_CHECK(kTDK_OK == map.insert(++nCycles, handle));
+	}
+	TDK_CHECK(!bStale && 0 != handle.index() && nCycles < 10000);
+	TDK_CHECK(handle.generation() < tdk_slot_handle32::kMAX_GENERATION);
+
+	// the retired slot stays out of the free list
+	tdk_slot_handle32 other;
+	TDK_CHECK(kTDK_OK == map.erase(handle));
+	TDK_CHECK(kTDK_OK == map.insert(-1, other));
+	TDK_CHECK(handle.index() == other.index() && !map.contains(first));
+	TDK_CHECK(1 == map.size() && -1 == *map.at(other));
+}
+
+//-----------------------------------------------------------------------------
+// tdk_sparse_set
+
+TDK_TEST(sparse_set)
+{
+	tdk_sparse_set<> set;
+	TDK_CHECK(kTDK_OK == set.insert(5));
+	TDK_CHECK(kTDK_OK == set.insert(100000));
+	TDK_CHECK(kTDK_NO == set.insert(5));
+	TDK_CHECK(kTDK_OK == set.insert(7));
+	TDK_CHECK(3 == set.size() && set.contains(100000) && !set.contains(6));
+	TDK_CHECK(2 == set.page_count());
+
+	// the last member fills the hole, the page goes when it empties
+	TDK_CHECK(kTDK_OK == set.erase(100000));
+	TDK_CHECK(kTDK_NO == set.erase(100000));
+	TDK_CHECK(1 == set.page_count());
+	TDK_CHECK(1 == set.index_of(7) && set.size() == set.index_of(100000));
+
+	tdk_u32 nSum = 0;
+	for (tdk_u32 nId : set)
+		nSum += nId;
+	TDK_CHECK(12 == nSum);
+
+	set.clear();
+	TDK_CHECK(set.empty() && !set.contains(5));
+}
+
+//-----------------------------------------------------------------------------
+// tdk_string_pool
+
+TDK_TEST(string_pool)
+{
+	tdk_string_pool pool;
+	tdk_string_pool::id_type nA = 0, nB = 0, nAgain = 0;
+	TDK_CHECK(kTDK_OK == pool.intern("alpha", nA));
+	TDK_CHECK(kTDK_OK == pool.intern("beta", nB));
+	TDK_CHECK(kTDK_NO == pool.intern(std::string("alpha"), nAgain));
+	TDK_CHECK(nA == nAgain && nA != nB);
+	TDK_CHECK(2 == pool.size());
+	TDK_CHECK("beta" == pool.view(nB) && 0 == pool.c_str(nB)[4]);
+	TDK_CHECK(nB == pool.find("beta"));
+	TDK_CHECK(tdk_string_pool::kINVALID_ID == pool.find("gamma"));
+
+	// pooled views stay put while the pool grows
+	std::string_view pooled;
+	TDK_CHECK(kTDK_OK == pool.intern("gamma", pooled));
+	const char* pGamma = pooled.data();
+	std::string longStr(100000, 'x');
+	for (int i = 0; i < 1000; ++i)
+		pool.intern("name" + std::to_string(i), nAgain);
+	TDK_CHECK(kTDK_OK == pool.intern(longStr, nAgain));
+	TDK_CHECK(longStr == pool.view(nAgain));
+	TDK_CHECK(pGamma == pool.view(pool.find("gamma")).data());
+	TDK_CHECK(1004 == pool.size() && pool.byte_size() > longStr.size());
+
+	pool.clear();
+	TDK_CHECK(pool.empty() && tdk_string_pool::kINVALID_ID == pool.find("alpha"));
+}
+
+} // namespace
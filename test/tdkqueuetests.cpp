@@ -0,0 +1,229 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: unit tests of the priority queue and the ring buffers.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#include "tdktest.h"
+
+#include "base/tdkpriorityqueue.h"
+#include "base/tdkringbuffer.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// Fixed pseudo-random sequence, so every run checks the same values.
+class Lcg
+{
+public:
+	tdk_u32 next()
+	{
+		m_nState = m_nState * 1664525u + 1013904223u;
+		return m_nState >> 8;
+	}
+
+private:
+	tdk_u32 m_nState{ 12345 };
+};
+
+//-----------------------------------------------------------------------------
+// Ring buffers
+
+template<typename Queue>
+void check_ringbuffer_single_thread(Queue& queue)
+{
+	TDK_CHECK(kTDK_OK == queue.initialize(5));
+	TDK_CHECK(8 == queue.capacity() && queue.empty());
+	for (int i = 0; i < 8; ++i)
+		TDK_CHECK(kTDK_OK == queue.push(std::to_string(i)));
+	TDK_CHECK(kTDK_NO == queue.push(std::string("full")));
+	TDK_CHECK(8 == queue.size());
+
+	std::string str;
+	TDK_CHECK(kTDK_OK == queue.pop(str) && "0" == str);
+	std::string batch[8];
+	TDK_CHECK(7 == queue.pop_batch(batch, 8));
+	TDK_CHECK("1" == batch[0] && "7" == batch[6]);
+	TDK_CHECK(kTDK_NO == queue.pop(str));
+
+	TDK_CHECK(8 == queue.push_batch(batch, 8));
+	TDK_CHECK(0 == queue.push_batch(batch, 1));
+	// the remaining items are destroyed with the queue
+}
+
+template<typename Queue>
+void check_ringbuffer_handoff(Queue& queue, tdk_size nProducers)
+{
+	enum Constants { kPER_PRODUCER = 100000 };
+
+	TDK_CHECK(kTDK_OK == queue.initialize(64));
+	std::vector<std::thread> producers;
+	for (tdk_size p = 0; p < nProducers; ++p)
+	{
+		producers.emplace_back([&queue]()
+		{
+			for (tdk_u64 i = 1; i <= kPER_PRODUCER;)
+			{
+				if (kTDK_OK == queue.push(i))
+					++i;
+				else
+					std::this_thread::yield();
+			}
+		});
+	}
+
+	tdk_u64 nSum = 0;
+	tdk_u64 nLast = 0;
+	bool bOrdered = true;
+	for (tdk_size nPopped = 0; nPopped < nProducers * kPER_PRODUCER;)
+	{
+		tdk_u64 nVal = 0;
+		if (kTDK_OK != queue.pop(nVal))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		// one producer keeps its order
+		bOrdered = bOrdered && (nProducers > 1 || nVal == nLast + 1);
+		nLast = nVal;
+		nSum += nVal;
+		++nPopped;
+	}
+	for (std::thread& producer : producers)
+		producer.join();
+
+	TDK_CHECK(bOrdered);
+	TDK_CHECK(nProducers * kPER_PRODUCER * (kPER_PRODUCER + 1) / 2 == nSum);
+	TDK_CHECK(queue.empty());
+}
+
+TDK_TEST(spsc_ringbuffer)
+{
+	tdk_spsc_ringbuffer<std::string> queue;
+	check_ringbuffer_single_thread(queue);
+
+	tdk_spsc_ringbuffer<tdk_u64> handoff;
+	check_ringbuffer_handoff(handoff, 1);
+}
+
+TDK_TEST(mpmc_ringbuffer)
+{
+	tdk_mpmc_ringbuffer<std::string> queue;
+	check_ringbuffer_single_thread(queue);
+
+	tdk_mpmc_ringbuffer<tdk_u64> handoff;
+	check_ringbuffer_handoff(handoff, 3);
+}
+
+//-----------------------------------------------------------------------------
+// tdk_priority_queue
+
+struct Timer
+{
+	tdk_u32 nDue;
+	tdk_size* pIndex;
+
+	bool operator>(const Timer& oth) const
+	{
+		return nDue > oth.nDue;
+	}
+};
+
+struct TimerTracking
+{
+	void operator()(const Timer& timer, tdk_size nIndex) const
+	{
+		*timer.pIndex = nIndex;
+	}
+};
+
+TDK_TEST(priority_queue)
+{
+	tdk_priority_queue<tdk_u32, std::less<tdk_u32>, 4> queue;
+	std::vector<tdk_u32> sorted;
+	Lcg rng;
+	for (int i = 0; i < 1000; ++i)
+	{
+		tdk_u32 nVal = rng.next();
+		sorted.push_back(nVal);
+		TDK_CHECK(kTDK_OK == queue.push(nVal));
+	}
+	tdk_u32 more[] = { 0, 1, 2 };
+	TDK_CHECK(kTDK_OK == queue.push_range(more, more + 3));
+	sorted.insert(sorted.end(), more, more + 3);
+	std::sort(sorted.begin(), sorted.end(), std::greater<tdk_u32>());
+
+	bool bSame = queue.size() == sorted.size();
+	for (tdk_u32 nVal : sorted)
+	{
+		bSame = bSame && nVal == queue.top();
+		queue.pop();
+	}
+	TDK_CHECK(bSame && queue.empty());
+}
+
+TDK_TEST(priority_queue_tracking)
+{
+	tdk_size indices[3] = {};
+	tdk_priority_queue<Timer, std::greater<Timer>, 2, TimerTracking> queue;
+	queue.push({ 30, &indices[0] });
+	queue.push({ 10, &indices[1] });
+	queue.push({ 20, &indices[2] });
+	TDK_CHECK(10 == queue.top().nDue && 0 == indices[1]);
+
+	// move the last timer to the front, then drop the first one
+	queue.update(indices[0], { 5, &indices[0] });
+	TDK_CHECK(5 == queue.top().nDue && 0 == indices[0]);
+	queue.erase(indices[1]);
+	TDK_CHECK(2 == queue.size());
+	queue.pop();
+	TDK_CHECK(20 == queue.top().nDue && 0 == indices[2]);
+}
+
+} // namespace
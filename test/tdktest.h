@@ -0,0 +1,141 @@
+/*
+-----------------
+ Persistent info
+-----------------
+ Copyright (C) 2012-2025 Trash Team and graveman
+ This file is part of the "Trash Team Development Kit" project.
+
+....................................................
+License (is in the "TdkLicense.txt" file and below):
+....................................................
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the Software), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+......
+ Web:
+......
+
+ + https://gamedev.ru/community/trash_team/ (for questions and help)
+
+-------------
+ Description
+-------------
+Purpose: unit test harness.
+
+----------------------
+ For developers notes
+----------------------
+
+*/
+
+#ifndef TDK_TEST_H
+#define TDK_TEST_H
+
+#include "base/tdkbaseutl.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Minimal unit test harness. Every TDK_TEST registers a function, a failed
+// TDK_CHECK reports the expression and the test goes on, so one run lists
+// every broken check. The executable returns 1 if any check failed. Typical
+// use:
+//
+//	TDK_TEST(darray_push_back)
+//	{
+//		tdk_darray<int> arr;
+//		TDK_CHECK(kTDK_OK == arr.push_back(1));
+//		TDK_CHECK(1 == arr.size());
+//	}
+
+using tdk_test_func = void (*)();
+
+struct tdk_test_entry
+{
+	const char* szName;
+	tdk_test_func func;
+};
+
+inline std::vector<tdk_test_entry>& tdk_test_registry()
+{
+	static std::vector<tdk_test_entry> entries;
+	return entries;
+}
+
+inline tdk_size& tdk_test_failures()
+{
+	static tdk_size s_nFailures;
+	return s_nFailures;
+}
+
+struct tdk_test_registrar
+{
+	tdk_test_registrar(const char* szName, tdk_test_func func)
+	{
+		tdk_test_registry().push_back({ szName, func });
+	}
+};
+
+inline bool tdk_test_check(bool bPassed, const char* szExpr, const char* szFile,
+	int nLine)
+{
+	if (!bPassed)
+	{
+		++tdk_test_failures();
+		std::printf("%s(%d): check failed: %s\n", szFile, nLine, szExpr);
+	}
+	return bPassed;
+}
+
+#define TDK_TEST(name) \
+	static void name(); \
+	static tdk_test_registrar s_testRegistrar_##name(#name, name); \
+	static void name()
+
+#define TDK_CHECK(expr) tdk_test_check(bool(expr), #expr, __FILE__, __LINE__)
+
+//-----------------------------------------------------------------------------
+// Command line: tdk_tests [substring], runs the tests whose name contains it.
+
+inline int tdk_test_main(int argc, char** argv)
+{
+	const char* szFilter = argc > 1 ? argv[1] : "";
+	tdk_size nRun = 0;
+	tdk_size nFailedTests = 0;
+	for (const tdk_test_entry& entry : tdk_test_registry())
+	{
+		if (!std::strstr(entry.szName, szFilter))
+			continue;
+
+		tdk_size nFailuresBefore = tdk_test_failures();
+		entry.func();
+		++nRun;
+		bool bPassed = tdk_test_failures() == nFailuresBefore;
+		if (!bPassed)
+			++nFailedTests;
+		std::printf("%-8s %s\n", bPassed ? "ok" : "FAILED", entry.szName);
+		std::fflush(stdout);
+	}
+
+	std::printf("%zu tests, %zu failed\n", nRun, nFailedTests);
+	return nFailedTests || !nRun ? 1 : 0;
+}
+
+#endif //TDK_TEST_H